@@ -16,6 +16,8 @@ extern void APITemperatureSensor_Init( void );
 extern void APIDeviceConfig_Init( void );
 extern void API_OTA_Init( void );
 extern void API_MQTT_Init( void );
+extern void API_Events_Init( void );
+extern void APIFilter_Init( void );
 
 /* Public functions -----------------------------------------------------------*/
 
@@ -25,4 +27,6 @@ void API_Init( void )
   APIDeviceConfig_Init();
   API_OTA_Init();
   API_MQTT_Init();
+  API_Events_Init();
+  APIFilter_Init();
 }
@@ -0,0 +1,257 @@
+/**
+ *******************************************************************************
+ * @file    api_events.c
+ * @author  Dmytro Shevchenko
+ * @brief   API application events statistics
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "app_events.h"
+#include "app_timers.h"
+#include "json_parser.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define MODULE_NAME "[API Events] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_TCP_SERVER
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define ARRAY_LEN( _array ) sizeof( _array ) / sizeof( _array[0] )
+
+/* Records in one getEventTrace response, 32 hex chars each */
+#define TRACE_RECORDS_PER_RESPONSE 24
+
+/* Private functions declaration ---------------------------------------------*/
+
+static void _set_task( const char* str, size_t str_len, uint32_t iterator );
+static void _set_reset( bool value, uint32_t iterator );
+static void _set_trace_offset( int value, uint32_t iterator );
+static void _set_trace_enable( bool value, uint32_t iterator );
+
+/* Private variables ---------------------------------------------------------*/
+
+static json_parse_token_t events_tokens[] = {
+  {.string_cb = _set_task,
+   .name = "task" },
+  { .bool_cb = _set_reset,
+   .name = "reset"},
+};
+
+static json_parse_token_t timers_tokens[] = {
+  {.bool_cb = _set_reset,
+   .name = "reset"},
+};
+
+static json_parse_token_t trace_tokens[] = {
+  {.int_cb = _set_trace_offset,
+   .name = "offset"},
+  { .bool_cb = _set_trace_enable,
+   .name = "enable"},
+};
+
+static app_events_task_t selected_task;
+static bool reset_stats;
+static const char* error_msg;
+static uint32_t trace_offset;
+static bool trace_enable_set;
+static bool trace_enable;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void _init_exec_command( void )
+{
+  selected_task = APP_EVENT_LAST;
+  reset_stats = false;
+  error_msg = NULL;
+}
+
+static void _set_task( const char* str, size_t str_len, uint32_t iterator )
+{
+  for ( app_events_task_t task = 0; task < APP_EVENT_LAST; task++ )
+  {
+    const char* name = AppEventGetTaskName( task );
+    if ( strlen( name ) == str_len && 0 == strncmp( name, str, str_len ) )
+    {
+      selected_task = task;
+      return;
+    }
+  }
+  error_msg = "Unknown task";
+}
+
+static void _set_reset( bool value, uint32_t iterator )
+{
+  reset_stats = value;
+}
+
+static void _init_trace_command( void )
+{
+  trace_offset = 0;
+  trace_enable_set = false;
+}
+
+static void _set_trace_offset( int value, uint32_t iterator )
+{
+  trace_offset = (uint32_t) value;
+}
+
+static void _set_trace_enable( bool value, uint32_t iterator )
+{
+  trace_enable_set = true;
+  trace_enable = value;
+}
+
+static int _print_task_stats( char* resp, size_t respLen, app_events_task_t task, bool with_latency )
+{
+  app_event_task_stats_t stats = {};
+  AppEventGetTaskStats( task, &stats );
+
+  int len = snprintf( resp, respLen, "{\"task\":\"%s\",\"enq\":%lu,\"depth\":%u,\"len\":%u,\"ovf\":%lu,\"coal\":%lu,\"unh\":%lu",
+                      AppEventGetTaskName( task ), (unsigned long) stats.enqueue_count, stats.max_depth, stats.queue_length,
+                      (unsigned long) stats.overflow_count, (unsigned long) stats.coalesced_count, (unsigned long) stats.unhandled_count );
+
+  if ( with_latency && !CONFIG_APP_EVENT_TIMING )
+  {
+    len += snprintf( &resp[len], respLen - len, ",\"lat_us_log2\":null" );
+  }
+  else if ( with_latency )
+  {
+    len += snprintf( &resp[len], respLen - len, ",\"lat_us_log2\":[" );
+    for ( size_t i = 0; i < APP_EVENT_LATENCY_HISTOGRAM_SIZE && len < respLen; i++ )
+    {
+      len += snprintf( &resp[len], respLen - len, "%s%lu", i ? "," : "", (unsigned long) stats.latency_histogram[i] );
+    }
+    if ( len < respLen )
+    {
+      len += snprintf( &resp[len], respLen - len, "]" );
+    }
+  }
+
+  if ( len < respLen )
+  {
+    len += snprintf( &resp[len], respLen - len, "}" );
+  }
+  return len;
+}
+
+static error_code_t _get_event_stats( char* resp, size_t respLen )
+{
+  if ( NULL != error_msg )
+  {
+    snprintf( resp, respLen, "\"%s\"", error_msg );
+    return ERROR_CODE_FAIL;
+  }
+
+  int len = 0;
+  if ( selected_task < APP_EVENT_LAST )
+  {
+    len = _print_task_stats( resp, respLen, selected_task, true );
+  }
+  else
+  {
+    len = snprintf( resp, respLen, "[" );
+    for ( app_events_task_t task = 0; task < APP_EVENT_LAST && len < respLen; task++ )
+    {
+      if ( task > 0 )
+      {
+        len += snprintf( &resp[len], respLen - len, "," );
+      }
+      len += _print_task_stats( &resp[len], respLen - len, task, false );
+    }
+    if ( len < respLen )
+    {
+      len += snprintf( &resp[len], respLen - len, "]" );
+    }
+  }
+
+  if ( reset_stats )
+  {
+    AppEventResetStats();
+  }
+
+  if ( len >= respLen )
+  {
+    LOG( PRINT_ERROR, "Response buffer too small" );
+    return ERROR_CODE_FAIL;
+  }
+  return ERROR_CODE_OK;
+}
+
+static error_code_t _get_timer_stats( char* resp, size_t respLen )
+{
+  app_timers_stats_t stats = {};
+  AppTimersGetStats( &stats );
+
+  int len = snprintf( resp, respLen, "{\"fired\":%lu,\"late\":%lu,\"max_late_ms\":%lu,\"avg_late_ms\":%lu,\"overrun\":%lu,\"skipped\":%lu,\"active\":%u,\"max_active\":%u}",
+                      (unsigned long) stats.fired_count, (unsigned long) stats.late_count, (unsigned long) stats.max_lateness_ms,
+                      (unsigned long) ( stats.fired_count ? stats.total_lateness_ms / stats.fired_count : 0 ),
+                      (unsigned long) stats.overrun_count, (unsigned long) stats.skipped_count, stats.active_count, stats.max_active_count );
+
+  if ( reset_stats )
+  {
+    AppTimersResetStats();
+  }
+
+  if ( len >= respLen )
+  {
+    LOG( PRINT_ERROR, "Response buffer too small" );
+    return ERROR_CODE_FAIL;
+  }
+  return ERROR_CODE_OK;
+}
+
+static error_code_t _get_event_trace( char* resp, size_t respLen )
+{
+  if ( !CONFIG_APP_EVENT_TRACE )
+  {
+    snprintf( resp, respLen, "\"Trace is compiled out\"" );
+    return ERROR_CODE_FAIL;
+  }
+  if ( trace_enable_set )
+  {
+    AppEventTraceEnable( trace_enable );
+  }
+
+  app_event_trace_t records[TRACE_RECORDS_PER_RESPONSE];
+  uint32_t offset = trace_offset;
+  uint32_t count = AppEventTraceRead( &offset, records, ARRAY_LEN( records ) );
+
+  int len = snprintf( resp, respLen, "{\"enabled\":%s,\"head\":%lu,\"offset\":%lu,\"count\":%lu,\"data\":\"",
+                      AppEventTraceIsEnabled() ? "true" : "false", (unsigned long) AppEventTraceGetHead(), (unsigned long) offset, (unsigned long) count );
+
+  const uint8_t* data = (const uint8_t*) records;
+  for ( size_t i = 0; i < count * sizeof( app_event_trace_t ) && len < respLen; i++ )
+  {
+    len += snprintf( &resp[len], respLen - len, "%02x", data[i] );
+  }
+  if ( len < respLen )
+  {
+    len += snprintf( &resp[len], respLen - len, "\"}" );
+  }
+
+  if ( len >= respLen )
+  {
+    LOG( PRINT_ERROR, "Response buffer too small" );
+    return ERROR_CODE_FAIL;
+  }
+  return ERROR_CODE_OK;
+}
+
+/* Public functions -----------------------------------------------------------*/
+
+void API_Events_Init( void )
+{
+  JSONParser_RegisterMethod( events_tokens, ARRAY_LEN( events_tokens ), "getEventStats", _init_exec_command, _get_event_stats );
+  JSONParser_RegisterMethod( timers_tokens, ARRAY_LEN( timers_tokens ), "getTimerStats", _init_exec_command, _get_timer_stats );
+  JSONParser_RegisterMethod( trace_tokens, ARRAY_LEN( trace_tokens ), "getEventTrace", _init_trace_command, _get_event_trace );
+}
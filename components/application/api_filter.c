@@ -0,0 +1,176 @@
+/**
+ *******************************************************************************
+ * @file    api_filter.c
+ * @author  Dmytro Shevchenko
+ * @brief   Communication API of sensor filters
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "device_manager.h"
+#include "json_parser.h"
+#include "signal_filter.h"
+#include "temperature.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define MODULE_NAME "[API Filter] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_TCP_SERVER
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define ARRAY_LEN( _array ) sizeof( _array ) / sizeof( _array[0] )
+
+/* Private types -------------------------------------------------------------*/
+
+typedef enum
+{
+  FILTER_CHANNEL_TEMPERATURE,
+  FILTER_CHANNEL_ANALOG,
+  FILTER_CHANNEL_UNKNOWN,
+} filter_channel_t;
+
+typedef struct
+{
+  filter_channel_t channel;
+  int index;
+  signal_filter_stage_t stages[SIGNAL_FILTER_MAX_STAGES];
+  size_t count;
+  bool overflow;
+} filter_request_t;
+
+/* Private functions declaration ---------------------------------------------*/
+
+static void _set_channel( const char* str, size_t str_len, uint32_t iterator );
+static void _set_index( int value, uint32_t iterator );
+static void _add_median( int value, uint32_t iterator );
+static void _add_spike( int value, uint32_t iterator );
+static void _add_ema( double value, uint32_t iterator );
+static void _add_ema_int( int value, uint32_t iterator );
+static void _add_slope( int value, uint32_t iterator );
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Stages are chained in order of their keys in request */
+static json_parse_token_t filter_tokens[] = {
+  {.string_cb = _set_channel,
+   .name = "channel"},
+  {.int_cb = _set_index,
+   .name = "index"},
+  {.int_cb = _add_median,
+   .name = "median"},
+  {.int_cb = _add_spike,
+   .name = "spike"},
+  {.double_cb = _add_ema,
+   .int_cb = _add_ema_int,
+   .name = "ema"},
+  {.int_cb = _add_slope,
+   .name = "slope"},
+};
+
+static filter_request_t filter_request;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void _init_filter_command( void )
+{
+  memset( &filter_request, 0, sizeof( filter_request ) );
+  filter_request.channel = FILTER_CHANNEL_UNKNOWN;
+  filter_request.index = -1;
+}
+
+static void _add_stage( signal_filter_type_t type, int32_t param )
+{
+  if ( filter_request.count == SIGNAL_FILTER_MAX_STAGES )
+  {
+    filter_request.overflow = true;
+    return;
+  }
+  filter_request.stages[filter_request.count++] = (signal_filter_stage_t) { .type = type, .param = param };
+}
+
+static void _set_channel( const char* str, size_t str_len, uint32_t iterator )
+{
+  if ( str_len == strlen( "temperature" ) && strncmp( str, "temperature", str_len ) == 0 )
+  {
+    filter_request.channel = FILTER_CHANNEL_TEMPERATURE;
+  }
+  else if ( str_len == strlen( "analog" ) && strncmp( str, "analog", str_len ) == 0 )
+  {
+    filter_request.channel = FILTER_CHANNEL_ANALOG;
+  }
+}
+
+static void _set_index( int value, uint32_t iterator )
+{
+  filter_request.index = value;
+}
+
+static void _add_median( int value, uint32_t iterator )
+{
+  _add_stage( SIGNAL_FILTER_MEDIAN, value );
+}
+
+static void _add_spike( int value, uint32_t iterator )
+{
+  _add_stage( SIGNAL_FILTER_SPIKE, value );
+}
+
+static void _add_ema( double value, uint32_t iterator )
+{
+  /* Alpha as fraction 0..1 */
+  _add_stage( SIGNAL_FILTER_EMA, lround( value * SIGNAL_FILTER_EMA_ONE ) );
+}
+
+static void _add_ema_int( int value, uint32_t iterator )
+{
+  /* 1 is the only valid whole alpha, other values are rejected */
+  _add_stage( SIGNAL_FILTER_EMA, value == 1 ? SIGNAL_FILTER_EMA_ONE : 0 );
+}
+
+static void _add_slope( int value, uint32_t iterator )
+{
+  _add_stage( SIGNAL_FILTER_SLOPE, value );
+}
+
+static error_code_t _set_filter( char* resp, size_t respLen )
+{
+  bool result = false;
+  if ( !filter_request.overflow )
+  {
+    switch ( filter_request.channel )
+    {
+      case FILTER_CHANNEL_TEMPERATURE:
+        result = TemperatureSetFilter( filter_request.index, filter_request.stages, filter_request.count );
+        break;
+      case FILTER_CHANNEL_ANALOG:
+        result = filter_request.index >= 0 && DeviceManager_SetFilter( filter_request.index, filter_request.stages, filter_request.count );
+        break;
+      default:
+        break;
+    }
+  }
+  if ( !result )
+  {
+    LOG( PRINT_ERROR, "Invalid filter of channel %d", filter_request.channel );
+    return ERROR_CODE_FAIL;
+  }
+  snprintf( resp, respLen, "{\"stages\":%lu}", (unsigned long) filter_request.count );
+  return ERROR_CODE_OK;
+}
+
+/* Public functions -----------------------------------------------------------*/
+
+void APIFilter_Init( void )
+{
+  JSONParser_RegisterMethod( filter_tokens, ARRAY_LEN( filter_tokens ), "setFilter", _init_filter_command, _set_filter );
+}
@@ -7,10 +7,13 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
 
 #include "app_config.h"
 #include "json_parser.h"
 #include "temperature.h"
+#include "temperature_history.h"
 
 /* Private macros ------------------------------------------------------------*/
 #define MODULE_NAME "[API Temp] "
@@ -25,11 +28,39 @@
 
 #define ARRAY_LEN( _array ) sizeof( _array ) / sizeof( _array[0] )
 
+/* Room left in response for end of samples array and next page */
+#define HISTORY_RESP_TAIL_SIZE 32
+
 /* Private types -------------------------------------------------------------*/
 
+typedef struct
+{
+  uint32_t sensor;
+  int64_t from_us;
+  int64_t to_us;
+  int64_t step_us;
+} history_request_t;
+
+typedef struct
+{
+  char* resp;
+  size_t resp_len;
+  int len;
+  uint32_t count;
+  int64_t next_us;
+} history_response_t;
+
 /* Private functions declaration ---------------------------------------------*/
 
 static void _set_temperature_sensor( int sensor_number, uint32_t iterator );
+static void _set_threshold_low( double value, uint32_t iterator );
+static void _set_threshold_low_int( int value, uint32_t iterator );
+static void _set_threshold_high( double value, uint32_t iterator );
+static void _set_threshold_high_int( int value, uint32_t iterator );
+static void _set_history_sensor( int value, uint32_t iterator );
+static void _set_history_from( int64_t value, uint32_t iterator );
+static void _set_history_to( int64_t value, uint32_t iterator );
+static void _set_history_step( int value, uint32_t iterator );
 
 /* Private variables ---------------------------------------------------------*/
 
@@ -38,6 +69,30 @@ static json_parse_token_t temperature_sensor_tokens[] = {
    .name = "sensor"},
 };
 
+static json_parse_token_t thresholds_tokens[] = {
+  {.double_cb = _set_threshold_low,
+   .int_cb = _set_threshold_low_int,
+   .name = "low"},
+  {.double_cb = _set_threshold_high,
+   .int_cb = _set_threshold_high_int,
+   .name = "high"},
+};
+
+static json_parse_token_t history_tokens[] = {
+  {.int_cb = _set_history_sensor,
+   .name = "sensor"},
+  {.int64_cb = _set_history_from,
+   .name = "from"},
+  {.int64_cb = _set_history_to,
+   .name = "to"},
+  {.int_cb = _set_history_step,
+   .name = "step"},
+};
+
+static float thresholds[TEMP_THRESHOLDS_COUNT];
+static uint32_t thresholds_count;
+static history_request_t history_request;
+
 /* Private functions ---------------------------------------------------------*/
 
 static void _set_temperature_sensor( int sensor_number, uint32_t iterator )
@@ -45,9 +100,194 @@ static void _set_temperature_sensor( int sensor_number, uint32_t iterator )
   LOG( PRINT_INFO, "%s %d", __func__, sensor_number );
 }
 
+static void _init_thresholds_command( void )
+{
+  thresholds_count = 0;
+}
+
+static void _add_threshold( float value )
+{
+  if ( thresholds_count < TEMP_THRESHOLDS_COUNT )
+  {
+    thresholds[thresholds_count++] = value;
+  }
+}
+
+static void _set_threshold_low( double value, uint32_t iterator )
+{
+  _add_threshold( value );
+}
+
+static void _set_threshold_low_int( int value, uint32_t iterator )
+{
+  _add_threshold( value );
+}
+
+static void _set_threshold_high( double value, uint32_t iterator )
+{
+  _add_threshold( value );
+}
+
+static void _set_threshold_high_int( int value, uint32_t iterator )
+{
+  _add_threshold( value );
+}
+
+static error_code_t _set_thresholds( char* resp, size_t respLen )
+{
+  TemperatureSetThresholds( thresholds, thresholds_count );
+  snprintf( resp, respLen, "{\"thresholds\":%lu}", (unsigned long) thresholds_count );
+  return ERROR_CODE_OK;
+}
+
+static error_code_t _get_temperature( char* resp, size_t respLen )
+{
+  temp_status_t status = {};
+  TemperatureGetStatus( &status );
+
+  /* Temperatures in m'C, rate and slope in m'C/s */
+  int len = snprintf( resp, respLen, "{\"avg\":%ld,\"period_ms\":%lu,\"first_ms\":%lu,\"sensors\":[",
+                      lroundf( status.avg_temp * 1000 ), (unsigned long) status.sample_period_ms, (unsigned long) status.first_sample_ms );
+  for ( uint32_t i = 0; i < status.sensors_count && len < respLen; i++ )
+  {
+    len += snprintf( &resp[len], respLen - len, "%s{\"t\":%ld,\"rate\":%ld,\"res\":%u,\"bus\":%u,\"period_ms\":%lu,\"age_ms\":%lu,\"f\":%ld,\"slope\":%ld,\"valid\":%s}", i ? "," : "",
+                     lroundf( status.sensors[i].temp * 1000 ), lroundf( status.sensors[i].rate * 1000 ),
+                     status.sensors[i].resolution, status.sensors[i].bus, (unsigned long) status.sensors[i].period_ms,
+                     (unsigned long) status.sensors[i].age_ms, lroundf( status.sensors[i].filtered * 1000 ),
+                     lroundf( status.sensors[i].slope * 1000 ),
+                     status.sensors[i].valid ? "true" : "false" );
+  }
+  if ( len < respLen )
+  {
+    len += snprintf( &resp[len], respLen - len, "]}" );
+  }
+
+  if ( len >= respLen )
+  {
+    LOG( PRINT_ERROR, "Response buffer too small" );
+    return ERROR_CODE_FAIL;
+  }
+  return ERROR_CODE_OK;
+}
+
+static error_code_t _get_bus_health( char* resp, size_t respLen )
+{
+  temp_status_t status = {};
+  TemperatureGetStatus( &status );
+
+  int len = snprintf( resp, respLen, "{\"sensors\":[" );
+  for ( uint32_t i = 0; i < status.sensors_count && len < respLen; i++ )
+  {
+    const temp_sensor_health_t* health = &status.sensors[i].health;
+    len += snprintf( &resp[len], respLen - len, "%s{\"bus\":%u,\"crc\":%lu,\"presence\":%lu,\"retries\":%lu,\"last_good_ms\":%lu}", i ? "," : "",
+                     status.sensors[i].bus, (unsigned long) health->crc_errors, (unsigned long) health->presence_errors,
+                     (unsigned long) health->retries, (unsigned long) health->last_good_ms );
+  }
+  if ( len < respLen )
+  {
+    len += snprintf( &resp[len], respLen - len, "]}" );
+  }
+
+  if ( len >= respLen )
+  {
+    LOG( PRINT_ERROR, "Response buffer too small" );
+    return ERROR_CODE_FAIL;
+  }
+  return ERROR_CODE_OK;
+}
+
+static void _init_history_command( void )
+{
+  history_request = (history_request_t) {
+    .sensor = 0,
+    .from_us = 0,
+    .to_us = INT64_MAX,
+    .step_us = 0,
+  };
+}
+
+static void _set_history_sensor( int value, uint32_t iterator )
+{
+  history_request.sensor = value;
+}
+
+/* Time since boot in ms passes 32 bits after 24.8 days, so range and "next" use 64 bits */
+static int64_t _ms_to_us( int64_t value )
+{
+  if ( value > INT64_MAX / 1000 )
+  {
+    return INT64_MAX;
+  }
+  return value < INT64_MIN / 1000 ? INT64_MIN : value * 1000;
+}
+
+static void _set_history_from( int64_t value, uint32_t iterator )
+{
+  history_request.from_us = _ms_to_us( value );
+}
+
+static void _set_history_to( int64_t value, uint32_t iterator )
+{
+  history_request.to_us = _ms_to_us( value );
+}
+
+static void _set_history_step( int value, uint32_t iterator )
+{
+  history_request.step_us = value > 0 ? (int64_t) value * 1000 : 0;
+}
+
+static bool _write_history_sample( const temp_history_sample_t* sample, void* user_data )
+{
+  history_response_t* history = user_data;
+  size_t space = history->resp_len - HISTORY_RESP_TAIL_SIZE - history->len;
+  int len = snprintf( &history->resp[history->len], space, "%s[%lld,%d]", history->count ? "," : "",
+                      (long long) ( sample->time_us / 1000 ), sample->temp );
+  if ( len < 0 || (size_t) len >= space )
+  {
+    /* Client asks for next page from this sample */
+    history->resp[history->len] = '\0';
+    history->next_us = sample->time_us;
+    return false;
+  }
+  history->len += len;
+  history->count++;
+  return true;
+}
+
+static error_code_t _get_temperature_history( char* resp, size_t respLen )
+{
+  if ( history_request.sensor >= TEMP_NUMBER_OF_SENSORS || respLen <= HISTORY_RESP_TAIL_SIZE )
+  {
+    return ERROR_CODE_FAIL;
+  }
+
+  /* Samples are formatted straight from history, time in ms, temperature in 1/16 C */
+  history_response_t history = {
+    .resp = resp,
+    .resp_len = respLen,
+    .next_us = -1,
+  };
+  history.len = snprintf( resp, respLen - HISTORY_RESP_TAIL_SIZE, "{\"sensor\":%lu,\"samples\":[", (unsigned long) history_request.sensor );
+  TempHistoryRead( history_request.sensor, history_request.from_us, history_request.to_us, history_request.step_us, _write_history_sample, &history );
+
+  if ( history.next_us >= 0 )
+  {
+    snprintf( &resp[history.len], respLen - history.len, "],\"next\":%lld}", (long long) ( history.next_us / 1000 ) );
+  }
+  else
+  {
+    snprintf( &resp[history.len], respLen - history.len, "]}" );
+  }
+  return ERROR_CODE_OK;
+}
+
 /* Public functions -----------------------------------------------------------*/
 
 void APITemperatureSensor_Init( void )
 {
   JSONParser_RegisterMethod( temperature_sensor_tokens, ARRAY_LEN( temperature_sensor_tokens ), "setTemperatureSensor", NULL, NULL );
+  JSONParser_RegisterMethod( thresholds_tokens, ARRAY_LEN( thresholds_tokens ), "setTemperatureThresholds", _init_thresholds_command, _set_thresholds );
+  JSONParser_RegisterMethod( NULL, 0, "getTemperature", NULL, _get_temperature );
+  JSONParser_RegisterMethod( NULL, 0, "getBusHealth", NULL, _get_bus_health );
+  JSONParser_RegisterMethod( history_tokens, ARRAY_LEN( history_tokens ), "getTemperatureHistory", _init_history_command, _get_temperature_history );
 }
@@ -12,6 +12,7 @@
 
 #include "app_config.h"
 #include "app_events.h"
+#include "app_fsm.h"
 #include "app_timers.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
@@ -33,15 +34,15 @@
 /* Private types -------------------------------------------------------------*/
 
 /** @brief  Array with defined states */
-#define STATE_HANDLER_ARRAY                        \
-  STATE( DISABLED, _disabled_state_handler_array ) \
-  STATE( INIT, _init_state_handler_array )         \
-  STATE( IDLE, _idle_state_handler_array )
+#define STATE_HANDLER_ARRAY                                        \
+  STATE( DISABLED, _disabled_state_handler_array, NULL, NULL )     \
+  STATE( INIT, _init_state_handler_array, NULL, _state_init_exit ) \
+  STATE( IDLE, _idle_state_handler_array, NULL, NULL )
 
 /** @brief  Private types */
 typedef enum
 {
-#define STATE( _state, _event_handler_array ) _state,
+#define STATE APP_FSM_STATE_ENUM
   STATE_HANDLER_ARRAY
 #undef STATE
     STATE_TOP,
@@ -49,9 +50,7 @@ typedef enum
 
 typedef struct
 {
-  module_state_t state;
   uint32_t modules_init;
-  QueueHandle_t queue;
 } module_ctx_t;
 
 typedef enum
@@ -65,100 +64,70 @@ typedef enum
 static module_ctx_t ctx;
 
 /* Private functions declaration ---------------------------------------------*/
-static void _timeout_init_cb( TimerHandle_t xTimer );
-
 static void _state_common_temp_sensor_scan_res( const app_event_t* event );
+static void _state_common_temp_bus_failed( const app_event_t* event );
 
 static void _state_disabled_event_init_request( const app_event_t* event );
 
+static void _state_init_exit( void );
 static void _state_init_event_init_request( const app_event_t* event );
 static void _state_init_event_init_response( const app_event_t* event );
 static void _state_init_event_init_module_response( const app_event_t* event );
 
 /* Status callbacks declaration. ---------------------------------------------*/
-static const struct app_events_handler _disabled_state_handler_array[] =
+static const app_events_handler_table_t _disabled_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_APP_MANAGER_INIT_REQ, _state_disabled_event_init_request ),
 };
 
-static const struct app_events_handler _init_state_handler_array[] =
+static const app_events_handler_table_t _init_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_APP_MANAGER_INIT_REQ, _state_init_event_init_request ),
     EVENT_ITEM( MSG_ID_APP_MANAGER_INIT_RES, _state_init_event_init_response ),
     EVENT_ITEM( MSG_ID_INIT_RES, _state_init_event_init_module_response ),
 };
 
-static const struct app_events_handler _idle_state_handler_array[] =
+static const app_events_handler_table_t _idle_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_disabled_event_init_request ),
     EVENT_ITEM( MSG_ID_APP_MANAGER_TEMP_SENSORS_SCAN_RES, _state_common_temp_sensor_scan_res ),
+    EVENT_ITEM( MSG_ID_APP_MANAGER_TEMP_BUS_FAILED, _state_common_temp_bus_failed ),
 };
 
-struct state_context
-{
-  const module_state_t state;
-  const char* name;
-  const struct app_events_handler* event_handler_array;
-  uint8_t event_handler_array_size;
-};
-
-static const struct state_context module_state[STATE_TOP] =
+static const app_fsm_state_t module_state[STATE_TOP] =
   {
-#define STATE( _state, _event_handler_array )    \
-  {                                              \
-    .state = _state,                             \
-    .name = #_state,                             \
-    .event_handler_array = _event_handler_array, \
-    .event_handler_array_size = ARRAY_SIZE( _event_handler_array ) },
+#define STATE APP_FSM_STATE_ITEM
     STATE_HANDLER_ARRAY
 #undef STATE
 };
 
-static app_timer_t timers[] =
+static app_fsm_t fsm =
   {
-    TIMER_ITEM( TIMER_ID_TIMEOUT_INIT, _timeout_init_cb, 1500, "AppTimeoutInit" ),
+    .name = "app_manager_task",
+    .task = APP_EVENT_APP_MANAGER,
+    .states = module_state,
+    .states_count = STATE_TOP,
+    .queue_length = 16,
+    .worker = APP_EXECUTOR_WORKER_CONTROL,
+    .stack_size = 2048,
 };
 
-/* Private functions ---------------------------------------------------------*/
-
-/** @brief  States functions. */
-static const char* _get_state_name( const module_state_t state )
-{
-  return module_state[state].name;
-}
-
-static void _change_state( module_state_t new_state )
-{
-  LOG( PRINT_INFO, "State: %s -> %s", _get_state_name( ctx.state ), _get_state_name( new_state ) );
-  ctx.state = new_state;
-}
-
-static void _send_internal_event( app_msg_id_t id, const void* data, uint32_t data_size )
-{
-  app_event_t event = {};
-  if ( data_size == 0 )
-  {
-    AppEventPrepareNoData( &event, id, APP_EVENT_APP_MANAGER, APP_EVENT_APP_MANAGER );
-  }
-  else
+static app_timer_t timers[] =
   {
-    AppEventPrepareWithData( &event, id, APP_EVENT_APP_MANAGER, APP_EVENT_APP_MANAGER, data, data_size );
-  }
+    TIMER_ITEM( TIMER_ID_TIMEOUT_INIT, MSG_ID_APP_MANAGER_TIMEOUT_INIT, 1500, "AppTimeoutInit" ),
+};
 
-  AppManagerPostMsg( &event );
-}
+/* State machine functions ---------------------------------------------------*/
 
-static void _timeout_init_cb( TimerHandle_t xTimer )
+static void _state_disabled_event_init_request( const app_event_t* event )
 {
-  _send_internal_event( MSG_ID_APP_MANAGER_TIMEOUT_INIT, NULL, 0 );
+  AppFsmChangeState( &fsm, INIT );
+  AppFsmPostInternal( &fsm, MSG_ID_APP_MANAGER_INIT_REQ, NULL, 0 );
 }
 
-/* State machine functions ---------------------------------------------------*/
-
-static void _state_disabled_event_init_request( const app_event_t* event )
+static void _state_init_exit( void )
 {
-  _change_state( INIT );
-  _send_internal_event( MSG_ID_APP_MANAGER_INIT_REQ, NULL, 0 );
+  AppTimerStop( timers, TIMER_ID_TIMEOUT_INIT );
 }
 
 static void _state_init_event_init_request( const app_event_t* event )
@@ -182,17 +151,11 @@ static void _state_init_event_init_response( const app_event_t* event )
     return;
   }
 
-  AppTimerStop( timers, TIMER_ID_TIMEOUT_INIT );
-
   if ( err_code == APP_MANAGER_ERR_OK )
   {
-    /* For tests */
-    app_event_t event_send = { 0 };
-    AppEventPrepareNoData( &event_send, MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV );
-    TemperaturePostMsg( &event_send );
-    // _send_internal_event( MSG_ID_APP_MANAGER_TEMP_WPS_TEST, NULL, 0 );
-    /* --------- */
-    _change_state( IDLE );
+    /* Temperature driver starts measuring by itself with sensors found at init */
+    // AppFsmPostInternal( &fsm, MSG_ID_APP_MANAGER_TEMP_WPS_TEST, NULL, 0 );
+    AppFsmChangeState( &fsm, IDLE );
     return;
   }
   assert( 0 );
@@ -225,7 +188,7 @@ static void _state_init_event_init_module_response( const app_event_t* event )
       result &= modules[i].init_result;
     }
     app_manager_err_t err_code = result ? APP_MANAGER_ERR_OK : APP_MANAGER_FAIL_OPERATION;
-    _send_internal_event( MSG_ID_APP_MANAGER_INIT_RES, &err_code, sizeof( err_code ) );
+    AppFsmPostInternal( &fsm, MSG_ID_APP_MANAGER_INIT_RES, &err_code, sizeof( err_code ) );
   }
 }
 
@@ -234,34 +197,26 @@ static void _state_common_temp_sensor_scan_res( const app_event_t* event )
   /* ToDo: process event data */
 }
 
-static void _task( void* pv )
+static void _state_common_temp_bus_failed( const app_event_t* event )
 {
-  _send_internal_event( MSG_ID_APP_MANAGER_INIT_REQ, NULL, 0 );
-  while ( 1 )
-  {
-    app_event_t event = { 0 };
-    if ( xQueueReceive( ctx.queue, &( event ), portMAX_DELAY ) == pdPASS )
-    {
-      AppEventSearchAndExecute( &event, module_state[ctx.state].event_handler_array, module_state[ctx.state].event_handler_array_size );
-      AppEventDelete( &event );
-    }
-  }
+  temp_bus_failed_t failed = {};
+  AppEventGetData( event, &failed, sizeof( failed ) );
+
+  /* Bus keeps measuring and retrying by itself, only reported here */
+  LOG( PRINT_WARNING, "Temperature bus %d failed %lu cycles", failed.bus, (unsigned long) failed.failed_cycles );
 }
 
 /* Public functions -----------------------------------------------------------*/
 
 void AppManagerPostMsg( app_event_t* event )
 {
-  if ( xQueueSend( ctx.queue, (void*) event, 0 ) != pdPASS )
-  {
-    assert( 0 );
-  }
+  AppEventPost( event );
 }
 
 void AppManagerInit( void )
 {
-  ctx.queue = xQueueCreate( 16, sizeof( app_event_t ) );
-  assert( ctx.queue );
-  AppTimersInit( timers, TIMER_ID_LAST );
-  xTaskCreate( _task, "app_manager_task", 2048, NULL, NORMALPRIOR, NULL );
+  AppFsmInit( &fsm );
+  AppTimersInit( APP_EVENT_APP_MANAGER, timers, TIMER_ID_LAST );
+  AppFsmStart( &fsm );
+  AppFsmPostInternal( &fsm, MSG_ID_APP_MANAGER_INIT_REQ, NULL, 0 );
 }
@@ -15,6 +15,7 @@
 #include "analog_in.h"
 #include "app_config.h"
 #include "app_events.h"
+#include "app_fsm.h"
 #include "app_timers.h"
 #include "digital_in_out.h"
 #include "freertos/FreeRTOS.h"
@@ -22,6 +23,8 @@
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "mqtt_app.h"
+#include "mqtt_json_parser.h"
+#include "temperature.h"
 #include "water_flow_sensor.h"
 
 /* Private macros ------------------------------------------------------------*/
@@ -38,13 +41,13 @@
 /* Private types -------------------------------------------------------------*/
 
 /** @brief  Array with defined states */
-#define STATE_HANDLER_ARRAY                        \
-  STATE( DISABLED, _disabled_state_handler_array ) \
-  STATE( IDLE, _idle_state_handler_array )
+#define STATE_HANDLER_ARRAY                                    \
+  STATE( DISABLED, _disabled_state_handler_array, NULL, NULL ) \
+  STATE( IDLE, _idle_state_handler_array, _state_idle_entry, NULL )
 
 typedef enum
 {
-#define STATE( _state, _event_handler_array ) _state,
+#define STATE APP_FSM_STATE_ENUM
   STATE_HANDLER_ARRAY
 #undef STATE
     STATE_TOP,
@@ -55,13 +58,19 @@ typedef struct
   digital_in_t digital_inputs[2];
   digital_out_t digital_outs[2];
   analog_in_t analog_inputs[2];
+  signal_filter_t analog_filters[2];
   water_flow_sensor_t water_flow[1];
 } devices_t;
 
 typedef struct
 {
-  module_state_t state;
-  QueueHandle_t queue;
+  uint32_t input;
+  size_t count;
+  signal_filter_stage_t stages[SIGNAL_FILTER_MAX_STAGES];
+} filter_request_t;
+
+typedef struct
+{
   uint32_t measure_interval_ms;
   uint32_t post_data_interval_ms;
   devices_t devices;
@@ -78,93 +87,55 @@ typedef enum
 } timer_id;
 
 /* Private functions declaration ---------------------------------------------*/
-static void _timer_measure( TimerHandle_t xTimer );
-static void _timer_post( TimerHandle_t xTimer );
-
 static void _state_disabled_init( const app_event_t* event );
 
+static void _state_idle_entry( void );
 static void _state_idle_event_measure( const app_event_t* event );
 static void _state_idle_event_post( const app_event_t* event );
+static void _state_idle_event_set_filter( const app_event_t* event );
 
 /* Status callbacks declaration. ---------------------------------------------*/
-static const struct app_events_handler _disabled_state_handler_array[] =
+static const app_events_handler_table_t _disabled_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_disabled_init ),
 };
 
-static const struct app_events_handler _idle_state_handler_array[] =
+static const app_events_handler_table_t _idle_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_DEV_MANAGER_MEASURE, _state_idle_event_measure ),
     EVENT_ITEM( MSG_ID_DEV_MANAGER_POST, _state_idle_event_post ),
+    EVENT_ITEM( MSG_ID_DEV_MANAGER_SET_FILTER, _state_idle_event_set_filter ),
 };
 
 /* Private variables ---------------------------------------------------------*/
 
 static module_ctx_t ctx;
 
-struct state_context
-{
-  const module_state_t state;
-  const char* name;
-  const struct app_events_handler* event_handler_array;
-  uint8_t event_handler_array_size;
-};
-
-static const struct state_context module_state[STATE_TOP] =
+static const app_fsm_state_t module_state[STATE_TOP] =
   {
-#define STATE( _state, _event_handler_array )    \
-  {                                              \
-    .state = _state,                             \
-    .name = #_state,                             \
-    .event_handler_array = _event_handler_array, \
-    .event_handler_array_size = ARRAY_SIZE( _event_handler_array ) },
+#define STATE APP_FSM_STATE_ITEM
     STATE_HANDLER_ARRAY
 #undef STATE
 };
 
-static app_timer_t timers[] =
+static app_fsm_t fsm =
   {
-    TIMER_ITEM( TIMER_ID_MEASURE, _timer_measure, 1000, "dm_meas" ),
-    TIMER_ITEM( TIMER_ID_POST, _timer_post, 10000, "dm_post" ),
+    .name = "device_manager",
+    .task = APP_EVENT_DEV_MANAGER,
+    .states = module_state,
+    .states_count = STATE_TOP,
+    .queue_length = 8,
+    .worker = APP_EXECUTOR_WORKER_IO,
+    .stack_size = 3072,
 };
 
-/* Private functions ---------------------------------------------------------*/
-
-static const char* _get_state_name( const module_state_t state )
-{
-  return module_state[state].name;
-}
-
-static void _change_state( module_state_t new_state )
-{
-  LOG( PRINT_INFO, "State: %s -> %s", _get_state_name( ctx.state ), _get_state_name( new_state ) );
-  ctx.state = new_state;
-}
-
-static void _send_internal_event( app_msg_id_t id, const void* data, uint32_t data_size )
-{
-  app_event_t event = {};
-  if ( data_size == 0 )
-  {
-    AppEventPrepareNoData( &event, id, APP_EVENT_DEV_MANAGER, APP_EVENT_DEV_MANAGER );
-  }
-  else
+static app_timer_t timers[] =
   {
-    AppEventPrepareWithData( &event, id, APP_EVENT_DEV_MANAGER, APP_EVENT_DEV_MANAGER, data, data_size );
-  }
-
-  DeviceManager_PostMsg( &event );
-}
-
-static void _timer_measure( TimerHandle_t xTimer )
-{
-  _send_internal_event( MSG_ID_DEV_MANAGER_MEASURE, NULL, 0 );
-}
+    PERIODIC_TIMER_ITEM( TIMER_ID_MEASURE, MSG_ID_DEV_MANAGER_MEASURE, 1000, "dm_meas" ),
+    PERIODIC_TIMER_ITEM( TIMER_ID_POST, MSG_ID_DEV_MANAGER_POST, 10000, "dm_post" ),
+};
 
-static void _timer_post( TimerHandle_t xTimer )
-{
-  _send_internal_event( MSG_ID_DEV_MANAGER_POST, NULL, 0 );
-}
+/* Private functions ---------------------------------------------------------*/
 
 static error_code_t valve1_set( bool value )
 {
@@ -219,14 +190,22 @@ static void _init_devices( void )
   AnalogIn_Init( &ctx.devices.analog_inputs[0], "t1", "'C", analog1_init, analog1_read, analog1_deinit );
   AnalogIn_Init( &ctx.devices.analog_inputs[1], "t2", "m", analog1_init, analog2_read, analog1_deinit );
   WaterFlowSensor_Init( &ctx.devices.water_flow[0], "v1_flow", "l", _alert_water_flow, 18 );
+  /* All topics of devices are registered, MQTT messages are parsed without lock from now */
+  MQTTJsonParser_Seal();
 }
 
 static void _state_disabled_init( const app_event_t* event )
 {
-  _change_state( IDLE );
+  AppFsmChangeState( &fsm, IDLE );
+}
+
+static void _state_idle_entry( void )
+{
   _init_devices();
-  _send_internal_event( MSG_ID_DEV_MANAGER_MEASURE, NULL, 0 );
-  _send_internal_event( MSG_ID_DEV_MANAGER_POST, NULL, 0 );
+  AppTimerStart( timers, TIMER_ID_MEASURE );
+  AppTimerStart( timers, TIMER_ID_POST );
+  AppFsmPostInternal( &fsm, MSG_ID_DEV_MANAGER_MEASURE, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_DEV_MANAGER_POST, NULL, 0 );
 }
 
 static void _state_idle_event_measure( const app_event_t* event )
@@ -241,6 +220,7 @@ static void _state_idle_event_measure( const app_event_t* event )
       break;
     }
   }
+  uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
   for ( int i = 0; i < ARRAY_SIZE( ctx.devices.analog_inputs ); i++ )
   {
     error = AnalogIn_ReadValue( &ctx.devices.analog_inputs[i] );
@@ -249,8 +229,8 @@ static void _state_idle_event_measure( const app_event_t* event )
       ctx.measure_result = error;
       break;
     }
+    SignalFilterProcess( &ctx.devices.analog_filters[i], now_ms, ctx.devices.analog_inputs[i].value );
   }
-  AppTimerStart( timers, TIMER_ID_MEASURE );
 }
 
 static void _state_idle_event_post( const app_event_t* event )
@@ -267,6 +247,12 @@ static void _state_idle_event_post( const app_event_t* event )
   {
     offset += snprintf( &ctx.buffer[offset], sizeof( ctx.buffer ) - offset, ",\"%s\":%ld",
                         ctx.devices.analog_inputs[i].name, ctx.devices.analog_inputs[i].value );
+    if ( ctx.devices.analog_filters[i].stages_count > 0 )
+    {
+      offset += snprintf( &ctx.buffer[offset], sizeof( ctx.buffer ) - offset, ",\"%s_f\":%ld,\"%s_slope\":%ld",
+                          ctx.devices.analog_inputs[i].name, (long) ctx.devices.analog_filters[i].value,
+                          ctx.devices.analog_inputs[i].name, (long) ctx.devices.analog_filters[i].slope );
+    }
   }
   for ( int i = 0; i < ARRAY_SIZE( ctx.devices.digital_outs ); i++ )
   {
@@ -277,39 +263,53 @@ static void _state_idle_event_post( const app_event_t* event )
   {
     offset += WaterFlowSensor_GetStr( &ctx.devices.water_flow[i], &ctx.buffer[offset], sizeof( ctx.buffer ) - offset, true );
   }
+
+  temp_status_t temp = {};
+  TemperatureGetStatus( &temp );
+  offset += snprintf( &ctx.buffer[offset], sizeof( ctx.buffer ) - offset, ",\"temp_period_ms\":%lu,\"temp_res\":[", (unsigned long) temp.sample_period_ms );
+  for ( int i = 0; i < temp.sensors_count; i++ )
+  {
+    offset += snprintf( &ctx.buffer[offset], sizeof( ctx.buffer ) - offset, "%s%u", i ? "," : "", temp.sensors[i].resolution );
+  }
+  offset += snprintf( &ctx.buffer[offset], sizeof( ctx.buffer ) - offset, "]" );
   offset += snprintf( &ctx.buffer[offset], sizeof( ctx.buffer ) - offset, "}" );
   MqttApp_PostData( "test", ctx.buffer );
-  AppTimerStart( timers, TIMER_ID_POST );
 }
 
-static void _task( void* pv )
+static void _state_idle_event_set_filter( const app_event_t* event )
 {
-  _send_internal_event( MSG_ID_INIT_REQ, NULL, 0 );
-  while ( 1 )
+  filter_request_t request = {};
+  if ( AppEventGetData( event, &request, sizeof( request ) ) == false )
   {
-    app_event_t event = { 0 };
-    if ( xQueueReceive( ctx.queue, &( event ), portMAX_DELAY ) == pdPASS )
-    {
-      AppEventSearchAndExecute( &event, module_state[ctx.state].event_handler_array, module_state[ctx.state].event_handler_array_size );
-      AppEventDelete( &event );
-    }
+    assert( 0 );
+    return;
   }
+  SignalFilterInit( &ctx.devices.analog_filters[request.input], request.stages, request.count );
 }
 
 /* Public functions -----------------------------------------------------------*/
 
 void DeviceManager_PostMsg( app_event_t* event )
 {
-  if ( xQueueSend( ctx.queue, (void*) event, 0 ) != pdPASS )
+  AppEventPost( event );
+}
+
+bool DeviceManager_SetFilter( uint32_t input, const signal_filter_stage_t* stages, size_t count )
+{
+  if ( input >= ARRAY_SIZE( ctx.devices.analog_filters ) || !SignalFilterIsValid( stages, count ) )
   {
-    assert( 0 );
+    return false;
   }
+
+  filter_request_t request = { .input = input, .count = count };
+  memcpy( request.stages, stages, count * sizeof( stages[0] ) );
+  return AppFsmPostInternal( &fsm, MSG_ID_DEV_MANAGER_SET_FILTER, &request, sizeof( request ) );
 }
 
 void DeviceManager_Init( void )
 {
-  ctx.queue = xQueueCreate( 8, sizeof( app_event_t ) );
-  assert( ctx.queue );
-  AppTimersInit( timers, TIMER_ID_LAST );
-  xTaskCreate( _task, "device_manager", 3072, NULL, NORMALPRIOR, NULL );
-}
\ No newline at end of file
+  AppFsmInit( &fsm );
+  AppTimersInit( APP_EVENT_DEV_MANAGER, timers, TIMER_ID_LAST );
+  AppFsmStart( &fsm );
+  AppFsmPostInternal( &fsm, MSG_ID_INIT_REQ, NULL, 0 );
+}
@@ -14,6 +14,7 @@
 #include <stdbool.h>
 
 #include "app_events.h"
+#include "signal_filter.h"
 
 /* Public functions ----------------------------------------------------------*/
 
@@ -27,4 +28,13 @@ void DeviceManager_Init( void );
  */
 void DeviceManager_PostMsg( app_event_t* event );
 
+/**
+ * @brief   Set filter chain of analog input, filter is changed by device manager task.
+ * @param   [in] input - analog input index.
+ * @param   [in] stages - filter stages in order.
+ * @param   [in] count - number of stages, 0 disables filtering.
+ * @return  false - invalid input or stages
+ */
+bool DeviceManager_SetFilter( uint32_t input, const signal_filter_stage_t* stages, size_t count );
+
 #endif
\ No newline at end of file
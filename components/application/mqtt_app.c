@@ -14,6 +14,7 @@
 
 #include "app_config.h"
 #include "app_events.h"
+#include "app_fsm.h"
 #include "app_timers.h"
 #include "esp_event.h"
 #include "esp_wifi.h"
@@ -40,15 +41,15 @@
 /* Private types -------------------------------------------------------------*/
 
 /** @brief  Array with defined states */
-#define STATE_HANDLER_ARRAY                        \
-  STATE( DISABLED, _disabled_state_handler_array ) \
-  STATE( IDLE, _idle_state_handler_array )         \
-  STATE( CONNECT, _connect_state_handler_array )   \
-  STATE( WORK, _work_state_handler_array )
+#define STATE_HANDLER_ARRAY                                    \
+  STATE( DISABLED, _disabled_state_handler_array, NULL, NULL ) \
+  STATE( IDLE, _idle_state_handler_array, NULL, NULL )         \
+  STATE( CONNECT, _connect_state_handler_array, NULL, NULL )   \
+  STATE( WORK, _work_state_handler_array, NULL, NULL )
 
 typedef enum
 {
-#define STATE( _state, _event_handler_array ) _state,
+#define STATE APP_FSM_STATE_ENUM
   STATE_HANDLER_ARRAY
 #undef STATE
     STATE_TOP,
@@ -56,8 +57,6 @@ typedef enum
 
 typedef struct
 {
-  module_state_t state;
-  QueueHandle_t queue;
   esp_mqtt_client_handle_t client;
 
   bool is_eth_connected;
@@ -73,9 +72,6 @@ typedef enum
 } timer_id;
 
 /* Private functions declaration ---------------------------------------------*/
-static void _timer_try_reconnect( TimerHandle_t xTimer );
-static void _timer_timeout_connect( TimerHandle_t xTimer );
-
 static void _state_common_eth_connect( const app_event_t* event );
 static void _state_common_eth_disconnect( const app_event_t* event );
 static void _state_common_mqtt_disconnect( const app_event_t* event );
@@ -93,33 +89,33 @@ static void _state_work_event_update_config( const app_event_t* event );
 static void _state_work_event_post_data( const app_event_t* event );
 
 /* Status callbacks declaration. ---------------------------------------------*/
-static const struct app_events_handler _disabled_state_handler_array[] =
+static const app_events_handler_table_t _disabled_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_disabled_init ),
 };
 
-static const struct app_events_handler _idle_state_handler_array[] =
+static const app_events_handler_table_t _idle_state_handler_array =
   {
-    EVENT_ITEM( MSG_ID_MQTT_ETH_CONNECTED, _state_common_eth_connect ),
-    EVENT_ITEM( MSG_ID_MQTT_ETH_DISCONNECTED, _state_common_eth_disconnect ),
+    EVENT_ITEM( MSG_ID_NETWORK_LINK_UP, _state_common_eth_connect ),
+    EVENT_ITEM( MSG_ID_NETWORK_LINK_DOWN, _state_common_eth_disconnect ),
     // EVENT_ITEM( MSG_ID_MQTT_APP_UPDATE_CONFIG, _state_idle_event_update_config ),
     EVENT_ITEM( MSG_ID_MQTT_APP_CONNECT, _state_idle_event_connect ),
     EVENT_ITEM( MSG_ID_MQTT_APP_DISCONNECT, _state_common_mqtt_disconnect ),
 };
 
-static const struct app_events_handler _connect_state_handler_array[] =
+static const app_events_handler_table_t _connect_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_MQTT_APP_CONNECT, _state_connect_event_connect ),
-    EVENT_ITEM( MSG_ID_MQTT_ETH_DISCONNECTED, _state_common_eth_disconnect ),
+    EVENT_ITEM( MSG_ID_NETWORK_LINK_DOWN, _state_common_eth_disconnect ),
     EVENT_ITEM( MSG_ID_MQTT_APP_UPDATE_CONFIG, _state_connect_event_update_config ),
     EVENT_ITEM( MSG_ID_MQTT_APP_DISCONNECT, _state_common_mqtt_disconnect ),
     // EVENT_ITEM( MSG_ID_MQTT_APP_SUBSCRIBE, _state_connect_event_subscribe ),
 };
 
-static const struct app_events_handler _work_state_handler_array[] =
+static const app_events_handler_table_t _work_state_handler_array =
   {
-    EVENT_ITEM( MSG_ID_MQTT_ETH_CONNECTED, _state_common_eth_connect ),
-    EVENT_ITEM( MSG_ID_MQTT_ETH_DISCONNECTED, _state_common_eth_disconnect ),
+    EVENT_ITEM( MSG_ID_NETWORK_LINK_UP, _state_common_eth_connect ),
+    EVENT_ITEM( MSG_ID_NETWORK_LINK_DOWN, _state_common_eth_disconnect ),
     EVENT_ITEM( MSG_ID_MQTT_APP_UPDATE_CONFIG, _state_work_event_update_config ),
     EVENT_ITEM( MSG_ID_MQTT_APP_POST_DATA, _state_work_event_post_data ),
     EVENT_ITEM( MSG_ID_MQTT_APP_DISCONNECT, _state_common_mqtt_disconnect ),
@@ -129,59 +125,31 @@ static const struct app_events_handler _work_state_handler_array[] =
 
 static module_ctx_t ctx;
 
-struct state_context
-{
-  const module_state_t state;
-  const char* name;
-  const struct app_events_handler* event_handler_array;
-  uint8_t event_handler_array_size;
-};
-
-static const struct state_context module_state[STATE_TOP] =
+static const app_fsm_state_t module_state[STATE_TOP] =
   {
-#define STATE( _state, _event_handler_array )    \
-  {                                              \
-    .state = _state,                             \
-    .name = #_state,                             \
-    .event_handler_array = _event_handler_array, \
-    .event_handler_array_size = ARRAY_SIZE( _event_handler_array ) },
+#define STATE APP_FSM_STATE_ITEM
     STATE_HANDLER_ARRAY
 #undef STATE
 };
 
-static app_timer_t timers[] =
+static app_fsm_t fsm =
   {
-    TIMER_ITEM( TIMER_ID_TRY_RECONNECT, _timer_try_reconnect, 30000, "MqttReconnect" ),
-    TIMER_ITEM( TIMER_ID_TIMEOUT_CONNECT, _timer_timeout_connect, 10000, "MqttTimeoutConn" ),
+    .name = "mqtt_app",
+    .task = APP_EVENT_MQTT_APP,
+    .queue_length = 8,
+    .worker = APP_EXECUTOR_WORKER_IO,
+    .stack_size = 3072,
+    .states = module_state,
+    .states_count = STATE_TOP,
 };
 
-/* Private functions ---------------------------------------------------------*/
-
-static const char* _get_state_name( const module_state_t state )
-{
-  return module_state[state].name;
-}
-
-static void _change_state( module_state_t new_state )
-{
-  LOG( PRINT_INFO, "State: %s -> %s", _get_state_name( ctx.state ), _get_state_name( new_state ) );
-  ctx.state = new_state;
-}
-
-static void _send_internal_event( app_msg_id_t id, const void* data, uint32_t data_size )
-{
-  app_event_t event = {};
-  if ( data_size == 0 )
-  {
-    AppEventPrepareNoData( &event, id, APP_EVENT_MQTT_APP, APP_EVENT_MQTT_APP );
-  }
-  else
+static app_timer_t timers[] =
   {
-    AppEventPrepareWithData( &event, id, APP_EVENT_MQTT_APP, APP_EVENT_MQTT_APP, data, data_size );
-  }
+    TIMER_ITEM( TIMER_ID_TRY_RECONNECT, MSG_ID_MQTT_APP_CONNECT, 30000, "MqttReconnect" ),
+    TIMER_ITEM( TIMER_ID_TIMEOUT_CONNECT, MSG_ID_MQTT_APP_DISCONNECT, 10000, "MqttTimeoutConn" ),
+};
 
-  MQTTApp_PostMsg( &event );
-}
+/* Private functions ---------------------------------------------------------*/
 
 static bool _subscribe( void )
 {
@@ -217,23 +185,23 @@ static void _mqtt_event_handler( void* handler_args, esp_event_base_t base, int3
     case MQTT_EVENT_CONNECTED:
       if ( false == _subscribe() )
       {
-        _send_internal_event( MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
+        AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
       }
       break;
     case MQTT_EVENT_DISCONNECTED:
-      _send_internal_event( MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
+      AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
       break;
 
     case MQTT_EVENT_SUBSCRIBED:
       ctx.is_mqtt_connected = true;
       AppTimerStop( timers, TIMER_ID_TIMEOUT_CONNECT );
-      _change_state( WORK );
-      _send_internal_event( MSG_ID_MQTT_APP_POST_DATA, NULL, 0 );
+      AppFsmChangeState( &fsm, WORK );
+      AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_POST_DATA, NULL, 0 );
       break;
     case MQTT_EVENT_UNSUBSCRIBED:
       // if ( false == _subscribe() )
       // {
-      //   _send_internal_event( MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
+      //   AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
       // }
       LOG( PRINT_WARNING, "MQTT_EVENT_UNSUBSCRIBED ToDo test this event" );
       break;
@@ -259,7 +227,7 @@ static void _mqtt_event_handler( void* handler_args, esp_event_base_t base, int3
         log_error_if_nonzero( "reported from tls stack", event->error_handle->esp_tls_stack_err );
         log_error_if_nonzero( "captured as transport's socket errno", event->error_handle->esp_transport_sock_errno );
         LOG( PRINT_INFO, "Last errno string (%s)", strerror( event->error_handle->esp_transport_sock_errno ) );
-        _send_internal_event( MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
+        AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
       }
       break;
     default:
@@ -268,26 +236,16 @@ static void _mqtt_event_handler( void* handler_args, esp_event_base_t base, int3
   }
 }
 
-static void _timer_try_reconnect( TimerHandle_t xTimer )
-{
-  _send_internal_event( MSG_ID_MQTT_APP_CONNECT, NULL, 0 );
-}
-
-static void _timer_timeout_connect( TimerHandle_t xTimer )
-{
-  _send_internal_event( MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
-}
-
 static void _state_common_eth_connect( const app_event_t* event )
 {
   ctx.is_eth_connected = true;
-  _send_internal_event( MSG_ID_MQTT_APP_CONNECT, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_CONNECT, NULL, 0 );
 }
 
 static void _state_common_eth_disconnect( const app_event_t* event )
 {
   ctx.is_eth_connected = false;
-  _send_internal_event( MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
 }
 
 static void _state_common_mqtt_disconnect( const app_event_t* event )
@@ -303,24 +261,24 @@ static void _state_common_mqtt_disconnect( const app_event_t* event )
     AppTimerStart( timers, TIMER_ID_TRY_RECONNECT );
   }
   ctx.is_mqtt_connected = false;
-  _change_state( IDLE );
+  AppFsmChangeState( &fsm, IDLE );
 }
 
 static void _state_disabled_init( const app_event_t* event )
 {
-  _change_state( IDLE );
+  AppFsmChangeState( &fsm, IDLE );
 
   if ( ctx.is_eth_connected )
   {
-    _send_internal_event( MSG_ID_MQTT_APP_CONNECT, NULL, 0 );
+    AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_CONNECT, NULL, 0 );
   }
 }
 
 static void _state_idle_event_connect( const app_event_t* event )
 {
   assert( false == ctx.is_mqtt_connected );
-  _change_state( CONNECT );
-  _send_internal_event( MSG_ID_MQTT_APP_CONNECT, NULL, 0 );
+  AppFsmChangeState( &fsm, CONNECT );
+  AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_CONNECT, NULL, 0 );
   AppTimerStop( timers, TIMER_ID_TRY_RECONNECT );
 }
 
@@ -365,7 +323,7 @@ static void _state_connect_event_connect( const app_event_t* event )
 
 static void _state_connect_event_update_config( const app_event_t* event )
 {
-  _send_internal_event( MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
 }
 
 // static void _state_connect_event_subscribe( const app_event_t* event )
@@ -375,7 +333,7 @@ static void _state_connect_event_update_config( const app_event_t* event )
 
 static void _state_work_event_update_config( const app_event_t* event )
 {
-  _send_internal_event( MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_DISCONNECT, NULL, 0 );
 }
 
 static void _state_work_event_post_data( const app_event_t* event )
@@ -389,50 +347,35 @@ static void _state_work_event_post_data( const app_event_t* event )
   }
 }
 
-static void _task( void* pv )
-{
-  _send_internal_event( MSG_ID_INIT_REQ, NULL, 0 );
-  while ( 1 )
-  {
-    app_event_t event = { 0 };
-    if ( xQueueReceive( ctx.queue, &( event ), portMAX_DELAY ) == pdPASS )
-    {
-      AppEventSearchAndExecute( &event, module_state[ctx.state].event_handler_array, module_state[ctx.state].event_handler_array_size );
-      AppEventDelete( &event );
-    }
-  }
-}
-
 static void _update_config_cb( void )
 {
-  _send_internal_event( MSG_ID_MQTT_APP_UPDATE_CONFIG, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_MQTT_APP_UPDATE_CONFIG, NULL, 0 );
 }
 
 /* Public functions -----------------------------------------------------------*/
 
 void MQTTApp_PostMsg( app_event_t* event )
 {
-  if ( xQueueSend( ctx.queue, (void*) event, 0 ) != pdPASS )
-  {
-    assert( 0 );
-  }
+  AppEventPost( event );
 }
 
 void MQTTApp_Init( void )
 {
   MQTTConfig_Init();
   MQTTConfig_SetCallback( _update_config_cb );
-  ctx.queue = xQueueCreate( 8, sizeof( app_event_t ) );
-  assert( ctx.queue );
-  AppTimersInit( timers, TIMER_ID_LAST );
-  xTaskCreate( _task, "mqtt_app", 3072, NULL, NORMALPRIOR, NULL );
+  AppFsmInit( &fsm );
+  AppEventSubscribe( MSG_ID_NETWORK_LINK_UP, APP_EVENT_MQTT_APP );
+  AppEventSubscribe( MSG_ID_NETWORK_LINK_DOWN, APP_EVENT_MQTT_APP );
+  AppTimersInit( APP_EVENT_MQTT_APP, timers, TIMER_ID_LAST );
+  AppFsmStart( &fsm );
+  AppFsmPostInternal( &fsm, MSG_ID_INIT_REQ, NULL, 0 );
 }
 
 bool MqttApp_PostData( const char* topic, const char* msg )
 {
   assert( topic );
   assert( msg );
-  if ( ctx.state != WORK )
+  if ( fsm.state != WORK )
   {
     return false;
   }
@@ -12,16 +12,15 @@
 
 #include "app_config.h"
 #include "app_events.h"
+#include "app_fsm.h"
 #include "app_manager.h"
 #include "app_timers.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
-#include "ota.h"
 #include "tcp_server.h"
 #include "wifidrv.h"
-#include "mqtt_app.h"
 
 /* Private macros ------------------------------------------------------------*/
 #define MODULE_NAME "[NetworkManager] "
@@ -37,15 +36,15 @@
 /* Private types -------------------------------------------------------------*/
 
 /** @brief  Array with defined states */
-#define STATE_HANDLER_ARRAY                        \
-  STATE( DISABLED, _disabled_state_handler_array ) \
-  STATE( INIT, _init_state_handler_array )         \
-  STATE( IDLE, _idle_state_handler_array )
+#define STATE_HANDLER_ARRAY                                        \
+  STATE( DISABLED, _disabled_state_handler_array, NULL, NULL )     \
+  STATE( INIT, _init_state_handler_array, NULL, _state_init_exit ) \
+  STATE( IDLE, _idle_state_handler_array, NULL, NULL )
 
 /** @brief  Private types */
 typedef enum
 {
-#define STATE( _state, _event_handler_array ) _state,
+#define STATE APP_FSM_STATE_ENUM
   STATE_HANDLER_ARRAY
 #undef STATE
     STATE_TOP,
@@ -53,12 +52,10 @@ typedef enum
 
 typedef struct
 {
-  module_state_t state;
   uint32_t modules_init;
 
   bool wifi_init_status;
   bool wifi_is_connected;
-  QueueHandle_t queue;
 } module_ctx_t;
 
 typedef enum
@@ -72,10 +69,9 @@ typedef enum
 static module_ctx_t ctx;
 
 /* Private functions declaration ---------------------------------------------*/
-static void _timeout_init_cb( TimerHandle_t xTimer );
-
 static void _state_disabled_event_init_request( const app_event_t* event );
 
+static void _state_init_exit( void );
 static void _state_init_event_init_request( const app_event_t* event );
 static void _state_init_event_init_response( const app_event_t* event );
 static void _state_init_event_init_module_response( const app_event_t* event );
@@ -84,12 +80,12 @@ static void _state_init_event_timeout_init( const app_event_t* event );
 static void _state_idle_event_wifi_connect_status( const app_event_t* event );
 
 /* Status callbacks declaration. ---------------------------------------------*/
-static const struct app_events_handler _disabled_state_handler_array[] =
+static const app_events_handler_table_t _disabled_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_disabled_event_init_request ),
 };
 
-static const struct app_events_handler _init_state_handler_array[] =
+static const app_events_handler_table_t _init_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_init_event_init_request ),
     EVENT_ITEM( MSG_ID_NETWORK_MANAGER_INIT_RES, _state_init_event_init_response ),
@@ -97,76 +93,45 @@ static const struct app_events_handler _init_state_handler_array[] =
     EVENT_ITEM( MSG_ID_INIT_RES, _state_init_event_init_module_response ),
 };
 
-static const struct app_events_handler _idle_state_handler_array[] =
+static const app_events_handler_table_t _idle_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_disabled_event_init_request ),
     EVENT_ITEM( MSG_ID_NETWORK_MANAGER_WIFI_CONNECT_STATUS, _state_idle_event_wifi_connect_status ),
 };
 
-struct state_context
-{
-  const module_state_t state;
-  const char* name;
-  const struct app_events_handler* event_handler_array;
-  uint8_t event_handler_array_size;
-};
-
-static const struct state_context module_state[STATE_TOP] =
+static const app_fsm_state_t module_state[STATE_TOP] =
   {
-#define STATE( _state, _event_handler_array )    \
-  {                                              \
-    .state = _state,                             \
-    .name = #_state,                             \
-    .event_handler_array = _event_handler_array, \
-    .event_handler_array_size = ARRAY_SIZE( _event_handler_array ) },
+#define STATE APP_FSM_STATE_ITEM
     STATE_HANDLER_ARRAY
 #undef STATE
 };
 
-static app_timer_t timers[] =
+static app_fsm_t fsm =
   {
-    TIMER_ITEM( TIMER_ID_TIMEOUT_INIT, _timeout_init_cb, 1000, "NetworkTimeoutInit" ) };
-
-/* Private functions ---------------------------------------------------------*/
-
-/** @brief  States functions. */
-static const char* _get_state_name( const module_state_t state )
-{
-  return module_state[state].name;
-}
-
-static void _change_state( module_state_t new_state )
-{
-  LOG( PRINT_INFO, "State: %s -> %s", _get_state_name( ctx.state ), _get_state_name( new_state ) );
-  ctx.state = new_state;
-}
+    .name = "network_manager_task",
+    .task = APP_EVENT_NETWORK_MANAGER,
+    .states = module_state,
+    .states_count = STATE_TOP,
+    .queue_length = 16,
+    .worker = APP_EXECUTOR_WORKER_CONTROL,
+    .stack_size = 4096,
+};
 
-static void _send_internal_event( app_msg_id_t id, const void* data, uint32_t data_size )
-{
-  app_event_t event = {};
-  if ( data_size == 0 )
-  {
-    AppEventPrepareNoData( &event, id, APP_EVENT_NETWORK_MANAGER, APP_EVENT_NETWORK_MANAGER );
-  }
-  else
+static app_timer_t timers[] =
   {
-    AppEventPrepareWithData( &event, id, APP_EVENT_NETWORK_MANAGER, APP_EVENT_NETWORK_MANAGER, data, data_size );
-  }
+    TIMER_ITEM( TIMER_ID_TIMEOUT_INIT, MSG_ID_NETWORK_MANAGER_TIMEOUT_INIT, 1000, "NetworkTimeoutInit" ) };
 
-  NetworkManagerPostMsg( &event );
-}
+/* Sate machine functions ---------------------------------------------------*/
 
-static void _timeout_init_cb( TimerHandle_t xTimer )
+static void _state_disabled_event_init_request( const app_event_t* event )
 {
-  _send_internal_event( MSG_ID_NETWORK_MANAGER_TIMEOUT_INIT, NULL, 0 );
+  AppFsmChangeState( &fsm, INIT );
+  AppFsmPostInternal( &fsm, MSG_ID_INIT_REQ, NULL, 0 );
 }
 
-/* Sate machine functions ---------------------------------------------------*/
-
-static void _state_disabled_event_init_request( const app_event_t* event )
+static void _state_init_exit( void )
 {
-  _change_state( INIT );
-  _send_internal_event( MSG_ID_INIT_REQ, NULL, 0 );
+  AppTimerStop( timers, TIMER_ID_TIMEOUT_INIT );
 }
 
 static void _state_init_event_init_request( const app_event_t* event )
@@ -191,19 +156,17 @@ static void _state_init_event_init_response( const app_event_t* event )
   app_event_t response = { 0 };
   if ( ctx.wifi_init_status )
   {
-    _change_state( IDLE );
+    AppFsmChangeState( &fsm, IDLE );
     result = true;
   }
   else
   {
-    _change_state( DISABLED );
+    AppFsmChangeState( &fsm, DISABLED );
     AppEventPrepareNoData( &response, MSG_ID_DEINIT_REQ, APP_EVENT_NETWORK_MANAGER, APP_EVENT_WIFI_DRV );
     WifiDrvPostMsg( &response );
   }
   AppEventPrepareWithData( &response, MSG_ID_INIT_RES, APP_EVENT_NETWORK_MANAGER, APP_EVENT_APP_MANAGER, &result, sizeof( result ) );
   AppManagerPostMsg( &response );
-
-  AppTimerStop( timers, TIMER_ID_TIMEOUT_INIT );
 }
 
 static void _state_init_event_init_module_response( const app_event_t* event )
@@ -215,7 +178,7 @@ static void _state_init_event_init_module_response( const app_event_t* event )
     if ( AppEventGetData( event, &err, sizeof( err ) ) == false )
     {
       LOG( PRINT_ERROR, "%s Cannot get data from event", __func__ );
-      _change_state( DISABLED );
+      AppFsmChangeState( &fsm, DISABLED );
       return;
     }
 
@@ -228,13 +191,13 @@ static void _state_init_event_init_module_response( const app_event_t* event )
 
   if ( ctx.modules_init == 2 )
   {
-    _send_internal_event( MSG_ID_NETWORK_MANAGER_INIT_RES, NULL, 0 );
+    AppFsmPostInternal( &fsm, MSG_ID_NETWORK_MANAGER_INIT_RES, NULL, 0 );
   }
 }
 
 static void _state_init_event_timeout_init( const app_event_t* event )
 {
-  _send_internal_event( MSG_ID_NETWORK_MANAGER_INIT_RES, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_NETWORK_MANAGER_INIT_RES, NULL, 0 );
 }
 
 static void _state_idle_event_wifi_connect_status( const app_event_t* event )
@@ -243,62 +206,34 @@ static void _state_idle_event_wifi_connect_status( const app_event_t* event )
   if ( AppEventGetData( event, &err, sizeof( err ) ) == false )
   {
     LOG( PRINT_ERROR, "%s Cannot get data from event", __func__ );
-    _change_state( DISABLED );
+    AppFsmChangeState( &fsm, DISABLED );
     return;
   }
 
-  app_event_t tcp_event = { 0 };
-  app_event_t ota_event = { 0 };
-  app_event_t mqtt_event = { 0 };
-
   if ( err == WIFI_DRV_ERR_CONNECTED )
   {
-    AppEventPrepareNoData( &tcp_event, MSG_ID_TCP_SERVER_ETHERNET_CONNECTED, APP_EVENT_NETWORK_MANAGER, APP_EVENT_TCP_SERVER );
-    AppEventPrepareNoData( &ota_event, MSG_ID_OTA_POLL_SERVER, APP_EVENT_NETWORK_MANAGER, APP_EVENT_OTA );
-    AppEventPrepareNoData( &mqtt_event, MSG_ID_MQTT_ETH_CONNECTED, APP_EVENT_NETWORK_MANAGER, APP_EVENT_MQTT_APP );
+    AppEventPublish( MSG_ID_NETWORK_LINK_UP, APP_EVENT_NETWORK_MANAGER, NULL, 0 );
   }
   else if ( err == WIFI_DRV_ERR_DISCONNECTED )
   {
-    AppEventPrepareNoData( &tcp_event, MSG_ID_TCP_SERVER_ETHERNET_DISCONNECTED, APP_EVENT_NETWORK_MANAGER, APP_EVENT_TCP_SERVER );
-    AppEventPrepareNoData( &ota_event, MSG_ID_OTA_STOP_POLL_SERVER, APP_EVENT_NETWORK_MANAGER, APP_EVENT_OTA );
-    AppEventPrepareNoData( &mqtt_event, MSG_ID_MQTT_ETH_DISCONNECTED, APP_EVENT_NETWORK_MANAGER, APP_EVENT_MQTT_APP );
+    AppEventPublish( MSG_ID_NETWORK_LINK_DOWN, APP_EVENT_NETWORK_MANAGER, NULL, 0 );
   }
   else
   {
     assert( 0 );
   }
-  TCPServer_PostMsg( &tcp_event );
-  OTA_PostMsg( &ota_event );
-  MQTTApp_PostMsg( &mqtt_event );
-}
-
-static void _task( void* pv )
-{
-  while ( 1 )
-  {
-    app_event_t event = { 0 };
-    if ( xQueueReceive( ctx.queue, &( event ), portMAX_DELAY ) == pdPASS )
-    {
-      AppEventSearchAndExecute( &event, module_state[ctx.state].event_handler_array, module_state[ctx.state].event_handler_array_size );
-      AppEventDelete( &event );
-    }
-  }
 }
 
 /* Public functions -----------------------------------------------------------*/
 
 void NetworkManagerPostMsg( app_event_t* event )
 {
-  if ( xQueueSend( ctx.queue, (void*) event, 0 ) != pdPASS )
-  {
-    assert( 0 );
-  }
+  AppEventPost( event );
 }
 
 void NetworkManagerInit( void )
 {
-  ctx.queue = xQueueCreate( 16, sizeof( app_event_t ) );
-  assert( ctx.queue );
-  AppTimersInit( timers, TIMER_ID_LAST );
-  xTaskCreate( _task, "network_manager_task", 4096, NULL, NORMALPRIOR, NULL );
+  AppFsmInit( &fsm );
+  AppTimersInit( APP_EVENT_NETWORK_MANAGER, timers, TIMER_ID_LAST );
+  AppFsmStart( &fsm );
 }
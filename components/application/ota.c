@@ -17,6 +17,7 @@
 
 #include "app_config.h"
 #include "app_events.h"
+#include "app_fsm.h"
 #include "app_timers.h"
 #include "dev_config.h"
 #include "esp_crt_bundle.h"
@@ -50,14 +51,14 @@ extern const uint8_t server_cert_pem_end[] asm( "_binary_ca_cert_pem_end" );
 /* Private types -------------------------------------------------------------*/
 
 /** @brief  Array with defined states */
-#define STATE_HANDLER_ARRAY                        \
-  STATE( DISABLED, _disabled_state_handler_array ) \
-  STATE( IDLE, _idle_state_handler_array )         \
-  STATE( DOWNLOADED, _downloaded_state_handler_array )
+#define STATE_HANDLER_ARRAY                                        \
+  STATE( DISABLED, _disabled_state_handler_array, NULL, NULL )     \
+  STATE( IDLE, _idle_state_handler_array, NULL, NULL )             \
+  STATE( DOWNLOADED, _downloaded_state_handler_array, NULL, NULL )
 
 typedef enum
 {
-#define STATE( _state, _event_handler_array ) _state,
+#define STATE APP_FSM_STATE_ENUM
   STATE_HANDLER_ARRAY
 #undef STATE
     STATE_TOP,
@@ -73,8 +74,6 @@ typedef enum
 typedef struct
 
 {
-  module_state_t state;
-  QueueHandle_t queue;
   ota_update_result_t ota_update_result;
   char update_result_details[256];
   char action_id[32];
@@ -97,8 +96,6 @@ typedef enum
 } timer_id;
 
 /* Private functions declaration ---------------------------------------------*/
-static void _timer_polling( TimerHandle_t xTimer );
-
 static void _state_disabled_init( const app_event_t* event );
 
 static void _state_idle_event_polling( const app_event_t* event );
@@ -107,20 +104,21 @@ static void _state_idle_event_ota_download_image( const app_event_t* event );
 static void _state_idle_event_post_ota_result( const app_event_t* event );
 
 /* Status callbacks declaration. ---------------------------------------------*/
-static const struct app_events_handler _disabled_state_handler_array[] =
+static const app_events_handler_table_t _disabled_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_disabled_init ),
 };
 
-static const struct app_events_handler _idle_state_handler_array[] =
+static const app_events_handler_table_t _idle_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_OTA_POLL_SERVER, _state_idle_event_polling ),
+    EVENT_ITEM( MSG_ID_NETWORK_LINK_UP, _state_idle_event_polling ),
     EVENT_ITEM( MSG_ID_OTA_POST_CONFIG_DATA, _state_idle_event_post_config_data ),
     EVENT_ITEM( MSG_ID_OTA_DOWNLOAD_IMAGE, _state_idle_event_ota_download_image ),
     EVENT_ITEM( MSG_ID_OTA_POST_OTA_RESULT, _state_idle_event_post_ota_result ),
 };
 
-static const struct app_events_handler _downloaded_state_handler_array[] =
+static const app_events_handler_table_t _downloaded_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_DEINIT_REQ, _state_idle_event_polling ),
 };
@@ -134,58 +132,30 @@ static ota_deployment_t otaDeployment;
 
 static module_ctx_t ctx;
 
-struct state_context
-{
-  const module_state_t state;
-  const char* name;
-  const struct app_events_handler* event_handler_array;
-  uint8_t event_handler_array_size;
-};
-
-static const struct state_context module_state[STATE_TOP] =
+static const app_fsm_state_t module_state[STATE_TOP] =
   {
-#define STATE( _state, _event_handler_array )    \
-  {                                              \
-    .state = _state,                             \
-    .name = #_state,                             \
-    .event_handler_array = _event_handler_array, \
-    .event_handler_array_size = ARRAY_SIZE( _event_handler_array ) },
+#define STATE APP_FSM_STATE_ITEM
     STATE_HANDLER_ARRAY
 #undef STATE
 };
 
-static app_timer_t timers[] =
+static app_fsm_t fsm =
   {
-    TIMER_ITEM( TIMER_ID_POLLING, _timer_polling, 300000, "AppTimeoutInit" ),
+    .name = "_ota_task",
+    .task = APP_EVENT_OTA,
+    .queue_length = 8,
+    .worker = APP_FSM_OWN_TASK,
+    .stack_size = 1024 * 6,
+    .states = module_state,
+    .states_count = STATE_TOP,
 };
 
-/* Private functions ---------------------------------------------------------*/
-
-static const char* _get_state_name( const module_state_t state )
-{
-  return module_state[state].name;
-}
-
-static void _change_state( module_state_t new_state )
-{
-  LOG( PRINT_INFO, "State: %s -> %s", _get_state_name( ctx.state ), _get_state_name( new_state ) );
-  ctx.state = new_state;
-}
-
-static void _send_internal_event( app_msg_id_t id, const void* data, uint32_t data_size )
-{
-  app_event_t event = {};
-  if ( data_size == 0 )
-  {
-    AppEventPrepareNoData( &event, id, APP_EVENT_OTA, APP_EVENT_OTA );
-  }
-  else
+static app_timer_t timers[] =
   {
-    AppEventPrepareWithData( &event, id, APP_EVENT_OTA, APP_EVENT_OTA, data, data_size );
-  }
+    TIMER_ITEM( TIMER_ID_POLLING, MSG_ID_OTA_POLL_SERVER, 300000, "AppTimeoutInit" ),
+};
 
-  OTA_PostMsg( &event );
-}
+/* Private functions ---------------------------------------------------------*/
 
 esp_err_t ota_bundle_attach( void* conf )
 {
@@ -223,11 +193,6 @@ bool _find_action_id( const char* str, char* id, size_t id_len )
   return result;
 }
 
-static void _timer_polling( TimerHandle_t xTimer )
-{
-  _send_internal_event( MSG_ID_OTA_POLL_SERVER, NULL, 0 );
-}
-
 esp_err_t _http_event_handler( esp_http_client_event_t* evt )
 {
   static char* output_buffer;    // Buffer to store response of http request from event handler
@@ -402,7 +367,7 @@ static void _set_update_error( void )
 {
   LOG( PRINT_ERROR, "%s", ctx.update_result_details );
   ctx.ota_update_result = OTA_UPDATE_RESULT_FAILED;
-  _send_internal_event( MSG_ID_OTA_POST_OTA_RESULT, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_OTA_POST_OTA_RESULT, NULL, 0 );
 }
 
 esp_http_client_handle_t _init_http_client( const char* url, esp_http_client_method_t method, const char* data, int len, const char* accept )
@@ -581,7 +546,7 @@ static void _download_and_update_firmware( const char* url )
     if ( ( err == ESP_OK ) && ( ota_finish_err == ESP_OK ) )
     {
       LOG( PRINT_INFO, "ESP_HTTPS_OTA upgrade successful. Wait rebooting ..." );
-      _change_state( DOWNLOADED );
+      AppFsmChangeState( &fsm, DOWNLOADED );
       return;
     }
     else
@@ -596,7 +561,7 @@ static void _download_and_update_firmware( const char* url )
       }
       LOG( PRINT_ERROR, "%s", ctx.update_result_details );
       ctx.ota_update_result = OTA_UPDATE_RESULT_FAILED;
-      _send_internal_event( MSG_ID_OTA_POST_OTA_RESULT, NULL, 0 );
+      AppFsmPostInternal( &fsm, MSG_ID_OTA_POST_OTA_RESULT, NULL, 0 );
     }
   }
 
@@ -615,7 +580,7 @@ static void _ota_process( ota_artifacts_t* artifact )
 
 void _ota_apply_callback( void )
 {
-  _send_internal_event( MSG_ID_OTA_POLL_SERVER, NULL, 0 );
+  AppFsmPostInternal( &fsm, MSG_ID_OTA_POLL_SERVER, NULL, 0 );
 }
 
 /* State machine functions -----------------------------------------------------*/
@@ -640,7 +605,7 @@ static void _state_disabled_init( const app_event_t* event )
       }
     }
   }
-  _change_state( IDLE );
+  AppFsmChangeState( &fsm, IDLE );
 }
 
 static void _state_idle_event_polling( const app_event_t* event )
@@ -678,7 +643,7 @@ static void _state_idle_event_polling( const app_event_t* event )
 
   if ( strlen( urlConfigData ) != 0 )
   {
-    _send_internal_event( MSG_ID_OTA_POST_CONFIG_DATA, NULL, 0 );
+    AppFsmPostInternal( &fsm, MSG_ID_OTA_POST_CONFIG_DATA, NULL, 0 );
   }
 
   if ( strlen( urlDeploymentBase ) != 0 )
@@ -687,11 +652,11 @@ static void _state_idle_event_polling( const app_event_t* event )
 
     if ( ctx.ota_update_result != OTA_UPDATE_RESULT_NONE )
     {
-      _send_internal_event( MSG_ID_OTA_POST_OTA_RESULT, NULL, 0 );
+      AppFsmPostInternal( &fsm, MSG_ID_OTA_POST_OTA_RESULT, NULL, 0 );
     }
     else
     {
-      _send_internal_event( MSG_ID_OTA_DOWNLOAD_IMAGE, NULL, 0 );
+      AppFsmPostInternal( &fsm, MSG_ID_OTA_DOWNLOAD_IMAGE, NULL, 0 );
     }
   }
 
@@ -790,38 +755,18 @@ static void _state_idle_event_post_ota_result( const app_event_t* event )
   }
 }
 
-static void _ota_task( void* pvParameter )
-{
-  LOG( PRINT_INFO, "Starting Advanced OTA example" );
-  _send_internal_event( MSG_ID_INIT_REQ, NULL, 0 );
-  while ( 1 )
-  {
-    app_event_t event = { 0 };
-    if ( xQueueReceive( ctx.queue, &( event ), portMAX_DELAY ) == pdPASS )
-    {
-      if ( false == AppEventSearchAndExecute( &event, module_state[ctx.state].event_handler_array, module_state[ctx.state].event_handler_array_size ) )
-      {
-        LOG( PRINT_INFO, "State: %s %d", _get_state_name( ctx.state ), module_state[ctx.state].event_handler_array_size );
-      }
-      AppEventDelete( &event );
-    }
-  }
-}
-
 void OTA_PostMsg( app_event_t* event )
 {
-  if ( xQueueSend( ctx.queue, (void*) event, 0 ) != pdPASS )
-  {
-    assert( 0 );
-  }
+  AppEventPost( event );
 }
 
 void OTA_Init( void )
 {
   OTAConfig_Init();
   OTAConfig_SetCallback( _ota_apply_callback );
-  ctx.queue = xQueueCreate( 8, sizeof( app_event_t ) );
-  assert( ctx.queue );
-  AppTimersInit( timers, TIMER_ID_LAST );
-  xTaskCreate( &_ota_task, "_ota_task", 1024 * 6, NULL, 5, NULL );
+  AppFsmInit( &fsm );
+  AppEventSubscribe( MSG_ID_NETWORK_LINK_UP, APP_EVENT_OTA );
+  AppTimersInit( APP_EVENT_OTA, timers, TIMER_ID_LAST );
+  AppFsmStart( &fsm );
+  AppFsmPostInternal( &fsm, MSG_ID_INIT_REQ, NULL, 0 );
 }
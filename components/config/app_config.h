@@ -14,6 +14,7 @@
 
 #define CONFIG_DEBUG_WIFI            0
 #define CONFIG_DEBUG_APP_EVENT       0
+#define CONFIG_DEBUG_APP_FSM         0
 #define CONFIG_DEBUG_APP_MANAGER     0
 #define CONFIG_DEBUG_NETWORK_MANAGER 0
 #define CONFIG_DEBUG_TEMPERATURE     0
@@ -23,11 +24,100 @@
 #define CONFIG_DEBUG_MQTT_APP        1
 #define CONFIG_DEBUG_DEVICE_MANAGER  1
 
+//////////////  CONFIG EVENTS  //////////////////
+#define APP_EVENT_OVERFLOW_ASSERT 0
+#define APP_EVENT_OVERFLOW_DROP   1
+
+/* Action when event is posted to full queue */
+#define CONFIG_APP_EVENT_OVERFLOW_POLICY APP_EVENT_OVERFLOW_DROP
+
+/* Latency histogram of dispatched events, costs clock read per prepare and dispatch.
+ * getEventStats reports "lat_us_log2":null when disabled */
+#ifndef CONFIG_APP_EVENT_TIMING
+#define CONFIG_APP_EVENT_TIMING 1
+#endif
+
+/* Record dispatched events to binary ring, dumped by getEventTrace. Recording is
+ * started at runtime by getEventTrace "enable", it costs second clock read per dispatch */
+#ifndef CONFIG_APP_EVENT_TRACE
+#define CONFIG_APP_EVENT_TRACE 1
+#endif
+#define CONFIG_APP_EVENT_TRACE_SIZE 128
+
+/* Run module state machines on shared executor workers instead of own tasks */
+#define CONFIG_APP_EXECUTOR 1
+
+#define APP_EXECUTOR_WORKER_CONTROL 0
+#define APP_EXECUTOR_WORKER_IO      1
+
+#define CONFIG_APP_EXECUTOR_WORKERS    2
+#define CONFIG_APP_EXECUTOR_STACK_SIZE 4096
+/* Sum of queue lengths of modules registered on one worker */
+#define CONFIG_APP_EXECUTOR_SET_LENGTH 64
+
+/* Timer wheel tick and size, wheel covers TICK_MS << ( WHEEL_BITS * WHEEL_LEVELS ) */
+#define CONFIG_APP_TIMERS_TICK_MS      10
+#define CONFIG_APP_TIMERS_WHEEL_BITS   4
+#define CONFIG_APP_TIMERS_WHEEL_LEVELS 4
+
 //////////////  CONFIG MODULES  //////////////////
 #define DEV_CONFIG_TCP_SERVER_PORT 1234
 
+/* Longest JSON request of TCP API, frames split over reads are reassembled in buffer of this size */
+#define CONFIG_TCP_SERVER_MAX_FRAME 4096
+
+/* Token arenas shared by JSON parsers as JSON_ARENA( tokens ), one arena per parse running at the same time.
+ * Parse takes smallest free arena with tokens it needs, so TCP request of 128 values and MQTT request
+ * are parsed at once in 192 tokens, as much as former parsers kept. */
+#define CONFIG_JSON_ARENA_LIST \
+  JSON_ARENA( 64 )             \
+  JSON_ARENA( 128 )
+
+/* Values of one request, top object is not counted */
+#define CONFIG_JSON_PARSER_TOKENS      128
+#define CONFIG_MQTT_JSON_PARSER_TOKENS 64
+
 #define NORMALPRIOR 5
 
+/* 1-Wire buses of temperature sensors as OW_BUS( uart, tx_pin, rx_pin ), up to 2.
+ * Every bus is measured by own worker, so slow sensors don't delay other buses. */
+#define CONFIG_TEMPERATURE_BUS_LIST \
+  OW_BUS( 1, 37, 18 )
+
+/* DS18B20 resolution 9..12 bits, conversion takes 93.75 ms << ( bits - 9 ) */
+#define CONFIG_TEMPERATURE_RESOLUTION 12
+
+/* Adaptive resolution per sensor: one bit less for every doubling of rate of change,
+ * 9 bits from FAST_RATE C/s. Within BAND C of threshold, widened by distance covered
+ * in LOOKAHEAD_MS, sensor stays at 12 bits. Rate is low pass filtered with RATE_TAU_MS. */
+#define CONFIG_TEMPERATURE_ADAPTIVE_RESOLUTION 1
+#define CONFIG_TEMPERATURE_FAST_RATE           0.5f
+#define CONFIG_TEMPERATURE_THRESHOLD_BAND      1.0f
+#define CONFIG_TEMPERATURE_LOOKAHEAD_MS        5000
+#define CONFIG_TEMPERATURE_RATE_TAU_MS         2000
+
+/* Monitoring mode: every DS18B20 gets alarm levels WINDOW C around its last value, after
+ * conversion only sensors found by alarm search are read, others keep cached value.
+ * All sensors are read every FULL_READ_CYCLES cycles. */
+#define CONFIG_TEMPERATURE_ALARM_MONITOR    0
+#define CONFIG_TEMPERATURE_ALARM_WINDOW     1
+#define CONFIG_TEMPERATURE_FULL_READ_CYCLES 10
+
+/* Hot-plug: every measure cycle walks one branch of ROM search tree after reads. Up to
+ * HOTPLUG_ROMS ROMs per bus are kept, ROM missing in HOTPLUG_MISSES whole walks is removed.
+ * Changes are published as MSG_ID_TEMPERATURE_SENSOR_ADDED/REMOVED. */
+#define CONFIG_TEMPERATURE_HOTPLUG        1
+#define CONFIG_TEMPERATURE_HOTPLUG_ROMS   64
+#define CONFIG_TEMPERATURE_HOTPLUG_MISSES 3
+
+/* Bus without valid read in FAIL_CYCLES cycles in a row is reported to app manager once.
+ * Failed bus keeps measuring, next cycle starts RETRY_MS after failed one. */
+#define CONFIG_TEMPERATURE_BUS_FAIL_CYCLES 3
+#define CONFIG_TEMPERATURE_BUS_RETRY_MS    1000
+
+/* Samples kept per sensor, power of 2. Full history of sensor takes 10 bytes per sample */
+#define CONFIG_TEMPERATURE_HISTORY_SIZE 128
+
 #ifndef BOARD_NAME
 #define BOARD_NAME "ESP-WROOM-32"
 #endif
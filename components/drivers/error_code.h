@@ -24,6 +24,7 @@ typedef enum
   ERROR_CODE_FAIL,
   ERROR_CODE_ERROR_PARSING,
   ERROR_CODE_UNKNOWN_MQTT_TOPIC_TYPE,
+  ERROR_CODE_BUSY,
   ERROR_CODE_LAST
 } error_code_t;
 
@@ -0,0 +1,117 @@
+/**
+ *******************************************************************************
+ * @file    json_arena.c
+ * @author  Dmytro Shevchenko
+ * @brief   Token arenas of JSON parsers. Parsers of TCP, MQTT and other requests
+ *          borrow arenas from one small pool instead of each keeping own token
+ *          array, so requests of different tasks are parsed concurrently.
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "json_arena.h"
+
+#include <string.h>
+
+#include "app_config.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define MODULE_NAME "[JSON] "
+#define DEBUG_LVL   PRINT_DEBUG
+
+#if CONFIG_DEBUG_JSON
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+enum
+{
+#define JSON_ARENA( _tokens ) +1
+  POOL_SIZE = 0 CONFIG_JSON_ARENA_LIST,
+#undef JSON_ARENA
+#define JSON_ARENA( _tokens ) +( _tokens )
+  POOL_TOKENS = 0 CONFIG_JSON_ARENA_LIST,
+#undef JSON_ARENA
+};
+
+#define POOL_MASK ( ( 1UL << POOL_SIZE ) - 1 )
+
+_Static_assert( POOL_SIZE > 0 && POOL_SIZE < 32, "Pool size must fit free_mask" );
+
+/* Private variables ---------------------------------------------------------*/
+static const size_t pool_sizes[POOL_SIZE] = {
+#define JSON_ARENA( _tokens ) ( _tokens ),
+  CONFIG_JSON_ARENA_LIST
+#undef JSON_ARENA
+};
+/* Arenas take consecutive parts of one array */
+static lwjson_token_t pool_tokens[POOL_TOKENS];
+static json_arena_t pool[POOL_SIZE];
+/* Each set bit is one free arena */
+static uint32_t free_mask = POOL_MASK;
+
+/* Private functions ---------------------------------------------------------*/
+
+static int _find_smallest( uint32_t mask, size_t tokens_len )
+{
+  int found = -1;
+  for ( ; mask != 0; mask &= mask - 1 )
+  {
+    int index = __builtin_ctz( mask );
+    if ( pool_sizes[index] >= tokens_len && ( found < 0 || pool_sizes[index] < pool_sizes[found] ) )
+    {
+      found = index;
+    }
+  }
+  return found;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void JSONArena_Init( json_arena_t* arena, lwjson_token_t* tokens, size_t tokens_len )
+{
+  assert( arena );
+  assert( tokens );
+  memset( arena, 0, sizeof( *arena ) );
+  arena->tokens = tokens;
+  arena->tokens_len = tokens_len;
+}
+
+json_arena_t* JSONArena_Take( size_t tokens_len )
+{
+  /* Lock-free as event pool, taking clears bit of smallest free arena with enough tokens */
+  uint32_t mask = __atomic_load_n( &free_mask, __ATOMIC_RELAXED );
+  int index;
+  do
+  {
+    index = _find_smallest( mask, tokens_len );
+    if ( index < 0 )
+    {
+      LOG( PRINT_WARNING, "All arenas of %d tokens are in use", (int) tokens_len );
+      return NULL;
+    }
+  } while ( !__atomic_compare_exchange_n( &free_mask, &mask, mask & ~( 1UL << index ), false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) );
+
+  size_t offset = 0;
+  for ( int i = 0; i < index; i++ )
+  {
+    offset += pool_sizes[i];
+  }
+  JSONArena_Init( &pool[index], &pool_tokens[offset], pool_sizes[index] );
+  return &pool[index];
+}
+
+void JSONArena_Give( json_arena_t* arena )
+{
+  size_t index = arena - pool;
+  if ( arena < pool || index >= POOL_SIZE )
+  {
+    assert( 0 );
+    return;
+  }
+  assert( ( __atomic_load_n( &free_mask, __ATOMIC_RELAXED ) & ( 1UL << index ) ) == 0 );
+  __atomic_fetch_or( &free_mask, 1UL << index, __ATOMIC_RELEASE );
+}
@@ -0,0 +1,51 @@
+/**
+ *******************************************************************************
+ * @file    json_arena.h
+ * @author  Dmytro Shevchenko
+ * @brief   Token arenas of JSON parsers, one arena is used by one parse at time
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+
+#ifndef _JSON_ARENA_H_
+#define _JSON_ARENA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lwjson.h"
+
+/* Public macro --------------------------------------------------------------*/
+
+/* Public types --------------------------------------------------------------*/
+typedef struct
+{
+  lwjson_t lwjson;
+  lwjson_token_t* tokens;
+  size_t tokens_len;
+} json_arena_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief   Init arena on tokens of caller, e.g. task which parses requests often.
+ * @param   [out] arena - arena.
+ * @param   [in] tokens - tokens, length limits number of values in JSON.
+ * @param   [in] tokens_len - number of tokens.
+ */
+void JSONArena_Init( json_arena_t* arena, lwjson_token_t* tokens, size_t tokens_len );
+
+/**
+ * @brief   Borrow smallest free arena of shared pool with enough tokens, doesn't block.
+ * @param   [in] tokens_len - tokens needed by parse.
+ * @return  arena or NULL when all arenas with enough tokens are in use
+ */
+json_arena_t* JSONArena_Take( size_t tokens_len );
+
+/**
+ * @brief   Return arena borrowed by JSONArena_Take.
+ */
+void JSONArena_Give( json_arena_t* arena );
+
+#endif
@@ -13,6 +13,7 @@
 #include <string.h>
 
 #include "app_config.h"
+#include "json_arena.h"
 #include "lwjson.h"
 
 /* Private macros ------------------------------------------------------------*/
@@ -28,25 +29,43 @@
 
 #define METHOD_NAME_MAX_SIZE    32
 #define ARRAY_SIZE( _array )    sizeof( _array ) / sizeof( _array[0] )
-#define JSON_PARSER_MAX_METHODS 12
+#define JSON_PARSER_MAX_METHODS 24
+
+/* Open addressing tables, size is power of 2 and at least twice number of names */
+#define JSON_PARSER_METHOD_SLOTS 64
+#define JSON_PARSER_TOKEN_SLOTS  256
+#define FNV_OFFSET_BASIS         2166136261u
+#define FNV_PRIME                16777619u
 
 /* Private types -------------------------------------------------------------*/
 
+typedef struct
+{
+  uint32_t hash;
+  uint8_t index; /* index + 1, 0 is empty slot */
+} json_parser_slot_t;
+
 typedef struct
 {
   const char* name;
+  size_t name_len;
   json_parse_token_t* tokens;
   size_t tokens_length;
+  json_parser_slot_t* token_slots;
+  uint32_t token_slots_mask;
   json_parser_cb init_cb;
   json_parser_get_err_code_cb get_error_code_cb;
 } json_parse_method_t;
 
+/* Registry is shared by all parses and only read after JSONParser_Seal */
 typedef struct
 {
-  lwjson_token_t tokens[128];
-  lwjson_t lwjson;
   json_parse_method_t methods[JSON_PARSER_MAX_METHODS];
   size_t methods_length;
+  json_parser_slot_t method_slots[JSON_PARSER_METHOD_SLOTS];
+  json_parser_slot_t token_slots[JSON_PARSER_TOKEN_SLOTS];
+  size_t token_slots_used;
+  bool sealed;
 } json_parser_ctx_t;
 
 /* Private variables ---------------------------------------------------------*/
@@ -54,29 +73,76 @@ static json_parser_ctx_t ctx;
 
 /* Private functions ---------------------------------------------------------*/
 
-static json_parse_method_t* _GetMethod( lwjson_token_t* token, lwjson_token_t** method_token_p )
+static uint32_t _Hash( const char* name, size_t len )
 {
-  if ( token->type != LWJSON_TYPE_STRING && ( 0 == strncmp( "method", token->token_name, token->token_name_len ) ) )
+  uint32_t hash = FNV_OFFSET_BASIS;
+  for ( size_t i = 0; i < len; i++ )
   {
-    return NULL;
+    hash = ( hash ^ (uint8_t) name[i] ) * FNV_PRIME;
   }
-  *method_token_p = token;
+  return hash;
+}
+
+static bool _IsName( const char* name, size_t len, const char* expected )
+{
+  /* Whole name must match, getTemperature is prefix of getTemperatureHistory */
+  return ( strncmp( name, expected, len ) == 0 ) && ( expected[len] == '\0' );
+}
+
+static void _InsertSlot( json_parser_slot_t* slots, uint32_t mask, uint32_t hash, size_t index )
+{
+  uint32_t pos = hash & mask;
+  while ( slots[pos].index != 0 )
+  {
+    pos = ( pos + 1 ) & mask;
+  }
+  slots[pos].hash = hash;
+  slots[pos].index = index + 1;
+}
+
+static json_parse_method_t* _GetMethod( lwjson_token_t* token )
+{
   size_t str_len = 0;
   const char* method_read = lwjson_get_val_string( token, &str_len );
-  for ( size_t i = 0; i < ctx.methods_length; i++ )
+  uint32_t hash = _Hash( method_read, str_len );
+  for ( uint32_t pos = hash & ( JSON_PARSER_METHOD_SLOTS - 1 ); ctx.method_slots[pos].index != 0; pos = ( pos + 1 ) & ( JSON_PARSER_METHOD_SLOTS - 1 ) )
   {
-    if ( 0 == strncmp( ctx.methods[i].name, method_read, str_len ) )
+    json_parse_method_t* method = &ctx.methods[ctx.method_slots[pos].index - 1];
+    if ( ( ctx.method_slots[pos].hash == hash ) && ( method->name_len == str_len ) && ( 0 == memcmp( method->name, method_read, str_len ) ) )
     {
-      return &ctx.methods[i];
+      return method;
     }
   }
-  LOG( PRINT_ERROR, "Don't found method: %.*s", token->token_name_len, token->token_name );
+  LOG( PRINT_ERROR, "Don't found method: %.*s", str_len, method_read );
   return NULL;
 }
 
+static json_parse_token_t* _GetToken( json_parse_method_t* method, lwjson_token_t* token )
+{
+  if ( method->token_slots == NULL )
+  {
+    return NULL;
+  }
+  uint32_t hash = _Hash( token->token_name, token->token_name_len );
+  for ( uint32_t pos = hash & method->token_slots_mask; method->token_slots[pos].index != 0; pos = ( pos + 1 ) & method->token_slots_mask )
+  {
+    json_parse_token_t* parse_token = &method->tokens[method->token_slots[pos].index - 1];
+    if ( ( method->token_slots[pos].hash == hash ) && _IsName( token->token_name, token->token_name_len, parse_token->name ) )
+    {
+      return parse_token;
+    }
+  }
+  return NULL;
+}
+
+static bool _isMethodToken( lwjson_token_t* token )
+{
+  return ( token->type == LWJSON_TYPE_STRING ) && _IsName( token->token_name, token->token_name_len, "method" );
+}
+
 static bool _GetIterator( lwjson_token_t* token, uint32_t* iterator )
 {
-  if ( ( token->type == LWJSON_TYPE_NUM_INT ) && ( 0 == strncmp( "i", token->token_name, token->token_name_len ) ) )
+  if ( ( token->type == LWJSON_TYPE_NUM_INT ) && _IsName( token->token_name, token->token_name_len, "i" ) )
   {
     *iterator = lwjson_get_val_int( token );
     return true;
@@ -86,96 +152,103 @@ static bool _GetIterator( lwjson_token_t* token, uint32_t* iterator )
 
 static bool _isDataToken( lwjson_token_t* token )
 {
-  if ( ( token->type == LWJSON_TYPE_OBJECT ) && ( 0 == strncmp( "data", token->token_name, token->token_name_len ) ) )
+  if ( ( token->type == LWJSON_TYPE_OBJECT ) && _IsName( token->token_name, token->token_name_len, "data" ) )
   {
     return true;
   }
   return false;
 }
 
-static void _ParseTokensFromMethod( lwjson_token_t* token, json_parse_method_t* method, uint32_t iterator )
+static void _ParseToken( lwjson_token_t* token, json_parse_token_t* parse_token, uint32_t iterator )
 {
-  for ( size_t i = 0; i < method->tokens_length; i++ )
+  switch ( token->type )
   {
-    if ( strncmp( token->token_name, method->tokens[i].name, token->token_name_len ) == 0 )
-    {
-      switch ( token->type )
+    case LWJSON_TYPE_TRUE:
+      if ( parse_token->bool_cb != NULL )
       {
-        case LWJSON_TYPE_TRUE:
-          if ( method->tokens[i].bool_cb != NULL )
-          {
-            method->tokens[i].bool_cb( true, iterator );
-          }
-          break;
-
-        case LWJSON_TYPE_FALSE:
-          if ( method->tokens[i].bool_cb != NULL )
-          {
-            method->tokens[i].bool_cb( false, iterator );
-          }
-          break;
-
-        case LWJSON_TYPE_NUM_INT:
-          if ( method->tokens[i].int_cb != NULL )
-          {
-            method->tokens[i].int_cb( token->u.num_int, iterator );
-          }
-          break;
-
-        case LWJSON_TYPE_NUM_REAL:
-          if ( method->tokens[i].double_cb != NULL )
-          {
-            method->tokens[i].double_cb( token->u.num_real, iterator );
-          }
-          break;
-
-        case LWJSON_TYPE_STRING:
-          if ( method->tokens[i].string_cb != NULL )
-          {
-            method->tokens[i].string_cb( token->u.str.token_value, token->u.str.token_value_len, iterator );
-          }
-          break;
-
-        case LWJSON_TYPE_NULL:
-          if ( method->tokens[i].null_cb != NULL )
-          {
-            method->tokens[i].null_cb( iterator );
-          }
-          break;
-
-        default:
-          break;
+        parse_token->bool_cb( true, iterator );
       }
       break;
-    }
+
+    case LWJSON_TYPE_FALSE:
+      if ( parse_token->bool_cb != NULL )
+      {
+        parse_token->bool_cb( false, iterator );
+      }
+      break;
+
+    case LWJSON_TYPE_NUM_INT:
+      if ( parse_token->int64_cb != NULL )
+      {
+        parse_token->int64_cb( token->u.num_int, iterator );
+      }
+      else if ( parse_token->int_cb != NULL )
+      {
+        parse_token->int_cb( token->u.num_int, iterator );
+      }
+      break;
+
+    case LWJSON_TYPE_NUM_REAL:
+      if ( parse_token->double_cb != NULL )
+      {
+        parse_token->double_cb( token->u.num_real, iterator );
+      }
+      break;
+
+    case LWJSON_TYPE_STRING:
+      if ( parse_token->string_cb != NULL )
+      {
+        parse_token->string_cb( token->u.str.token_value, token->u.str.token_value_len, iterator );
+      }
+      break;
+
+    case LWJSON_TYPE_NULL:
+      if ( parse_token->null_cb != NULL )
+      {
+        parse_token->null_cb( iterator );
+      }
+      break;
+
+    default:
+      break;
   }
-  if ( token->next != NULL )
+}
+
+static void _ParseTokensFromMethod( lwjson_token_t* token, json_parse_method_t* method, uint32_t iterator )
+{
+  /* Siblings are walked in loop, stack doesn't grow with size of data object */
+  for ( ; token != NULL; token = token->next )
   {
-    _ParseTokensFromMethod( token->next, method, iterator );
+    json_parse_token_t* parse_token = _GetToken( method, token );
+    if ( parse_token != NULL )
+    {
+      _ParseToken( token, parse_token, iterator );
+    }
   }
 }
 
 /* Public functions ----------------------------------------------------------*/
 
-error_code_t JSONParse( const char* json_string, size_t jsonLen, uint32_t* iterator, char* response, size_t responseLen )
+error_code_t JSONParser_Parse( json_arena_t* arena, const char* json_string, size_t jsonLen, uint32_t* iterator, char* response, size_t responseLen )
 {
+  assert( arena );
   assert( json_string );
   assert( iterator );
   error_code_t error_code = ERROR_CODE_ERROR_PARSING;
   memset( response, 0, responseLen );
-  lwjson_init( &ctx.lwjson, ctx.tokens, LWJSON_ARRAYSIZE( ctx.tokens ) );
+  lwjson_init( &arena->lwjson, arena->tokens, arena->tokens_len );
 
-  if ( lwjson_parse_ex( &ctx.lwjson, json_string, jsonLen ) == lwjsonOK )
+  if ( lwjson_parse_ex( &arena->lwjson, json_string, jsonLen ) == lwjsonOK )
   {
     lwjson_token_t* t;
     LOG( PRINT_INFO, "JSON parsed.." );
 
     /* Get very first token as top object */
-    t = lwjson_get_first_token( &ctx.lwjson );
+    t = lwjson_get_first_token( &arena->lwjson );
     if ( t->type != LWJSON_TYPE_OBJECT )
     {
       LOG( PRINT_ERROR, "Invalid json" );
-      lwjson_free( &ctx.lwjson );
+      lwjson_free( &arena->lwjson );
       return error_code;
     }
 
@@ -188,9 +261,10 @@ error_code_t JSONParse( const char* json_string, size_t jsonLen, uint32_t* itera
     for ( lwjson_token_t* tkn = (lwjson_token_t*) lwjson_get_first_child( t ); tkn != NULL; tkn = tkn->next )
     {
       LOG( PRINT_DEBUG, "Token: %.*s", (int) tkn->token_name_len, tkn->token_name );
-      if ( method_token == NULL )
+      if ( ( method_token == NULL ) && _isMethodToken( tkn ) )
       {
-        method = _GetMethod( tkn, &method_token );
+        method_token = tkn;
+        method = _GetMethod( tkn );
         continue;
       }
       if ( is_iterator_read == false )
@@ -231,30 +305,87 @@ error_code_t JSONParse( const char* json_string, size_t jsonLen, uint32_t* itera
         strncpy( response, ErrorCode_GetStr( error_code ), responseLen - 1 );
       }
     }
-    lwjson_free( &ctx.lwjson );
+    lwjson_free( &arena->lwjson );
   }
   return error_code;
 }
 
+error_code_t JSONParse( const char* json_string, size_t jsonLen, uint32_t* iterator, char* response, size_t responseLen )
+{
+  json_arena_t* arena = JSONArena_Take( CONFIG_JSON_PARSER_TOKENS );
+  if ( arena == NULL )
+  {
+    memset( response, 0, responseLen );
+    return ERROR_CODE_BUSY;
+  }
+  error_code_t error_code = JSONParser_Parse( arena, json_string, jsonLen, iterator, response, responseLen );
+  JSONArena_Give( arena );
+  return error_code;
+}
+
 bool JSONParser_RegisterMethod( json_parse_token_t* tokens, size_t tokens_length, const char* method_name, json_parser_cb init_cb, json_parser_get_err_code_cb get_error_code_cb )
 {
   assert( ( method_name != NULL ) );
   assert( ( tokens != NULL ) || ( tokens_length == 0 ) );
 
+  assert( tokens_length < UINT8_MAX );
+
+  if ( ctx.sealed )
+  {
+    LOG( PRINT_ERROR, "Registry is sealed, %s not registered", method_name );
+    return false;
+  }
   if ( ctx.methods_length == JSON_PARSER_MAX_METHODS )
   {
     LOG( PRINT_ERROR, "Methods array is full" );
     return false;
   }
-  ctx.methods[ctx.methods_length].name = method_name;
-  ctx.methods[ctx.methods_length].tokens = tokens;
-  ctx.methods[ctx.methods_length].tokens_length = tokens_length;
-  ctx.methods[ctx.methods_length].init_cb = init_cb;
-  ctx.methods[ctx.methods_length].get_error_code_cb = get_error_code_cb;
+
+  /* Hashes of names are computed once here, parsing only probes tables */
+  uint32_t slots_count = 0;
+  if ( tokens_length > 0 )
+  {
+    slots_count = 2;
+    while ( slots_count < 2 * tokens_length )
+    {
+      slots_count *= 2;
+    }
+    if ( ctx.token_slots_used + slots_count > JSON_PARSER_TOKEN_SLOTS )
+    {
+      LOG( PRINT_ERROR, "Token table is full" );
+      return false;
+    }
+  }
+
+  json_parse_method_t* method = &ctx.methods[ctx.methods_length];
+  method->name = method_name;
+  method->name_len = strlen( method_name );
+  method->tokens = tokens;
+  method->tokens_length = tokens_length;
+  method->init_cb = init_cb;
+  method->get_error_code_cb = get_error_code_cb;
+  method->token_slots = NULL;
+  method->token_slots_mask = 0;
+  if ( slots_count > 0 )
+  {
+    method->token_slots = &ctx.token_slots[ctx.token_slots_used];
+    method->token_slots_mask = slots_count - 1;
+    ctx.token_slots_used += slots_count;
+    for ( size_t i = 0; i < tokens_length; i++ )
+    {
+      _InsertSlot( method->token_slots, method->token_slots_mask, _Hash( tokens[i].name, strlen( tokens[i].name ) ), i );
+    }
+  }
+  _InsertSlot( ctx.method_slots, JSON_PARSER_METHOD_SLOTS - 1, _Hash( method_name, method->name_len ), ctx.methods_length );
   ctx.methods_length++;
   return true;
 }
 
+void JSONParser_Seal( void )
+{
+  ctx.sealed = true;
+}
+
 void JSONParser_Init( void )
 {
   memset( &ctx, 0, sizeof( ctx ) );
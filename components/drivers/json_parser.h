@@ -13,8 +13,10 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "error_code.h"
+#include "json_arena.h"
 #include "lwjson.h"
 
 /* Public macro --------------------------------------------------------------*/
@@ -24,6 +26,7 @@ typedef void ( *json_parser_cb )( void );
 typedef error_code_t ( *json_parser_get_err_code_cb )( char* response, size_t responseLen );
 typedef void ( *method_bool_cb )( bool value, uint32_t iterator );
 typedef void ( *method_int_cb )( int value, uint32_t iterator );
+typedef void ( *method_int64_cb )( int64_t value, uint32_t iterator );
 typedef void ( *method_null_cb )( uint32_t iterator );
 typedef void ( *method_double_cb )( double value, uint32_t iterator );
 typedef void ( *method_string_cb )( const char* str, size_t str_len, uint32_t iterator );
@@ -33,6 +36,7 @@ typedef struct
   const char* name;
   method_bool_cb bool_cb;
   method_int_cb int_cb;
+  method_int64_cb int64_cb; /* Used instead of int_cb for values past int range, e.g. time in ms */
   method_null_cb null_cb;
   method_double_cb double_cb;
   method_string_cb string_cb;
@@ -40,10 +44,24 @@ typedef struct
 
 /* Public functions ----------------------------------------------------------*/
 
+/**
+ * @brief   Parse request on arena of caller, parses of different arenas may run
+ *          in parallel once registry is sealed.
+ */
+error_code_t JSONParser_Parse( json_arena_t* arena, const char* json_string, size_t jsonLen, uint32_t* iterator, char* response, size_t responseLen );
+
+/**
+ * @brief   Parse request on arena borrowed from pool, ERROR_CODE_BUSY when pool is empty.
+ */
 error_code_t JSONParse( const char* json_string, size_t jsonLen, uint32_t* iterator, char *response, size_t responseLen );
 
 bool JSONParser_RegisterMethod( json_parse_token_t* tokens, size_t tokens_length, const char* method_name, json_parser_cb init_cb, json_parser_get_err_code_cb get_error_code_cb );
 
+/**
+ * @brief   Make registry read-only, call when all modules registered their methods.
+ */
+void JSONParser_Seal( void );
+
 void JSONParser_Init( void );
 
 #endif
\ No newline at end of file
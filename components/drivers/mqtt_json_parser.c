@@ -13,6 +13,7 @@
 #include <string.h>
 
 #include "app_config.h"
+#include "json_arena.h"
 #include "lwjson.h"
 
 /* Private macros ------------------------------------------------------------*/
@@ -43,12 +44,12 @@ typedef struct
   void* user_data;
 } json_parse_method_t;
 
+/* Registry is shared by all parses and only read after MQTTJsonParser_Seal */
 typedef struct
 {
-  lwjson_token_t tokens[64];
-  lwjson_t lwjson;
   json_parse_method_t methods[JSON_PARSER_MAX_METHODS];
   size_t methods_length;
+  bool sealed;
 } json_parser_ctx_t;
 
 /* Private variables ---------------------------------------------------------*/
@@ -56,11 +57,12 @@ static json_parser_ctx_t ctx;
 
 /* Private functions ---------------------------------------------------------*/
 
-static void _ParseTokensFromMethod( lwjson_token_t* token, json_parse_method_t* method )
+static void _ParseToken( lwjson_token_t* token, json_parse_method_t* method )
 {
   for ( size_t i = 0; i < method->tokens_length; i++ )
   {
-    if ( strncmp( token->token_name, method->tokens[i].name, token->token_name_len ) == 0 )
+    /* Whole name must match, not only its prefix */
+    if ( ( strncmp( token->token_name, method->tokens[i].name, token->token_name_len ) == 0 ) && ( method->tokens[i].name[token->token_name_len] == '\0' ) )
     {
       switch ( token->type )
       {
@@ -112,10 +114,6 @@ static void _ParseTokensFromMethod( lwjson_token_t* token, json_parse_method_t*
       break;
     }
   }
-  if ( token->next != NULL )
-  {
-    _ParseTokensFromMethod( token->next, method );
-  }
 }
 
 typedef struct mqtt_json_parser
@@ -145,9 +143,10 @@ static mqtt_topic_type_t _get_topic_type( const char* topic )
 
 /* Public functions ----------------------------------------------------------*/
 
-error_code_t MQTTJsonParse( const char* topic, size_t topic_len, const char* json_string,
-                            size_t json_len, char* response, size_t responseLen )
+error_code_t MQTTJsonParser_Parse( json_arena_t* arena, const char* topic, size_t topic_len, const char* json_string,
+                                   size_t json_len, char* response, size_t responseLen )
 {
+  assert( arena );
   assert( json_string );
   assert( topic );
   mqtt_topic_type_t topic_type = _get_topic_type( topic );
@@ -158,7 +157,7 @@ error_code_t MQTTJsonParse( const char* topic, size_t topic_len, const char* jso
 
   uint32_t topic_offset = strlen( topic_types[topic_type] );
   json_parse_method_t* method = NULL;
-  for ( int i = 0; i < ARRAY_SIZE( ctx.methods ); i++ )
+  for ( int i = 0; i < ctx.methods_length; i++ )
   {
     if ( ctx.methods[i].type != topic_type )
     {
@@ -182,32 +181,45 @@ error_code_t MQTTJsonParse( const char* topic, size_t topic_len, const char* jso
   }
 
   memset( response, 0, responseLen );
-  lwjson_init( &ctx.lwjson, ctx.tokens, LWJSON_ARRAYSIZE( ctx.tokens ) );
+  lwjson_init( &arena->lwjson, arena->tokens, arena->tokens_len );
 
-  if ( lwjson_parse_ex( &ctx.lwjson, json_string, json_len ) == lwjsonOK )
+  if ( lwjson_parse_ex( &arena->lwjson, json_string, json_len ) == lwjsonOK )
   {
     lwjson_token_t* t;
     LOG( PRINT_DEBUG, "JSON parsed.." );
 
-    t = lwjson_get_first_token( &ctx.lwjson );
+    t = lwjson_get_first_token( &arena->lwjson );
     if ( t->type != LWJSON_TYPE_OBJECT )
     {
       LOG( PRINT_ERROR, "Invalid json" );
-      lwjson_free( &ctx.lwjson );
+      lwjson_free( &arena->lwjson );
       return ERROR_CODE_ERROR_PARSING;
     }
 
     for ( lwjson_token_t* tkn = (lwjson_token_t*) lwjson_get_first_child( t ); tkn != NULL; tkn = tkn->next )
     {
       LOG( PRINT_DEBUG, "Token: %.*s", (int) tkn->token_name_len, tkn->token_name );
-      _ParseTokensFromMethod( tkn, method );
+      _ParseToken( tkn, method );
     }
 
-    lwjson_free( &ctx.lwjson );
+    lwjson_free( &arena->lwjson );
   }
   return ERROR_CODE_OK;
 }
 
+error_code_t MQTTJsonParse( const char* topic, size_t topic_len, const char* json_string,
+                            size_t json_len, char* response, size_t responseLen )
+{
+  json_arena_t* arena = JSONArena_Take( CONFIG_MQTT_JSON_PARSER_TOKENS );
+  if ( arena == NULL )
+  {
+    return ERROR_CODE_BUSY;
+  }
+  error_code_t error_code = MQTTJsonParser_Parse( arena, topic, topic_len, json_string, json_len, response, responseLen );
+  JSONArena_Give( arena );
+  return error_code;
+}
+
 bool MQTTJsonParser_RegisterMethod( json_parse_token_t* tokens, size_t tokens_length, mqtt_topic_type_t type,
                                     const char* topic, void* user_data, mqtt_parser_cb init_cb,
                                     mqtt_parser_get_err_code_cb get_error_code_cb )
@@ -215,6 +227,11 @@ bool MQTTJsonParser_RegisterMethod( json_parse_token_t* tokens, size_t tokens_le
   assert( ( topic != NULL ) );
   assert( ( tokens != NULL ) || ( tokens_length == 0 ) );
 
+  if ( ctx.sealed )
+  {
+    LOG( PRINT_ERROR, "Registry is sealed, %s not registered", topic );
+    return false;
+  }
   if ( ctx.methods_length == JSON_PARSER_MAX_METHODS )
   {
     LOG( PRINT_ERROR, "Methods array is full" );
@@ -231,6 +248,11 @@ bool MQTTJsonParser_RegisterMethod( json_parse_token_t* tokens, size_t tokens_le
   return true;
 }
 
+void MQTTJsonParser_Seal( void )
+{
+  ctx.sealed = true;
+}
+
 void MQTTJsonParser_Init( void )
 {
   memset( &ctx, 0, sizeof( ctx ) );
@@ -15,6 +15,7 @@
 #include <stddef.h>
 
 #include "error_code.h"
+#include "json_arena.h"
 #include "lwjson.h"
 
 /* Public macro --------------------------------------------------------------*/
@@ -49,6 +50,16 @@ typedef enum
 
 /* Public functions ----------------------------------------------------------*/
 
+/**
+ * @brief   Parse message on arena of caller, parses of different arenas may run
+ *          in parallel once registry is sealed.
+ */
+error_code_t MQTTJsonParser_Parse( json_arena_t* arena, const char* topic, size_t topic_len, const char* json_string,
+                                   size_t json_len, char* response, size_t responseLen );
+
+/**
+ * @brief   Parse message on arena borrowed from pool, ERROR_CODE_BUSY when pool is empty.
+ */
 error_code_t MQTTJsonParse( const char* topic, size_t topic_len, const char* json_string,
                             size_t json_len, char* response, size_t responseLen );
 
@@ -56,6 +67,11 @@ bool MQTTJsonParser_RegisterMethod( json_parse_token_t* tokens, size_t tokens_le
                                     const char* topic, void* user_data, mqtt_parser_cb init_cb,
                                     mqtt_parser_get_err_code_cb get_error_code_cb );
 
+/**
+ * @brief   Make registry read-only, call when all modules registered their topics.
+ */
+void MQTTJsonParser_Seal( void );
+
 void MQTTJsonParser_Init( void );
 
 #endif
\ No newline at end of file
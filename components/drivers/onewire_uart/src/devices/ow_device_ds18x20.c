@@ -33,6 +33,66 @@
  */
 #include "ow/ow.h"
 #include "ow/devices/ow_device_ds18x20.h"
+#include <string.h>
+
+/**
+ * \brief           Select device (or all devices) and send command in one transfer
+ * \param[in]       ow: 1-Wire handle
+ * \param[in]       rom_id: 1-Wire device address to select. Set to `NULL` to select all devices
+ * \param[in]       cmd: Command to send to selected devices
+ * \return          \ref owOK on success, member of \ref owr_t otherwise
+ */
+static owr_t
+select_and_send_cmd(ow_t* const ow, const ow_rom_t* const rom_id, uint8_t cmd) {
+    uint8_t data[1 + sizeof(rom_id->rom) + 1];
+    size_t len = 0;
+
+    if (rom_id == NULL) {                       /* Check for ROM id */
+        data[len++] = OW_CMD_SKIPROM;           /* Skip ROM, send to all devices */
+    } else {
+        data[len++] = OW_CMD_MATCHROM;          /* Select exact device by ROM address */
+        memcpy(&data[len], rom_id->rom, sizeof(rom_id->rom));
+        len += sizeof(rom_id->rom);
+    }
+    data[len++] = cmd;
+    return ow_write_bytes_raw(ow, data, len);
+}
+
+/**
+ * \brief           Read whole scratchpad of device and check it
+ * \param[in]       ow: 1-Wire handle
+ * \param[in]       rom_id: 1-Wire device address to read from. Set to `NULL` to skip ROM
+ * \param[out]      data: Output array of `9` bytes
+ * \return          \ref owOK on success, \ref owERRPRESENCE when device didn't answer,
+ *                  \ref owERR when line is held low or transfer failed,
+ *                  \ref owERRCRC on corrupted data
+ */
+static owr_t
+read_scratchpad(ow_t* const ow, const ow_rom_t* const rom_id, uint8_t* const data) {
+    uint8_t answered = 0, released = 0;
+
+    if (ow_reset_raw(ow) != owOK) {
+        return owERRPRESENCE;
+    }
+    if (select_and_send_cmd(ow, rom_id, OW_CMD_RSCRATCHPAD) != owOK   /* Send command to read scratchpad */
+        || ow_read_bytes_raw(ow, data, 9) != owOK) {    /* Read plain data from device */
+        return owERR;
+    }
+    for (size_t i = 0; i < 9; ++i) {
+        answered |= data[i] != 0xFF;            /* Line stays high when nobody answers */
+        released |= data[i] != 0x00;
+    }
+    if (!answered) {
+        return owERRPRESENCE;
+    }
+    if (!released) {                            /* Line held low passes CRC check too */
+        return owERR;
+    }
+    if (ow_crc(data, 0x09) != 0) {              /* Result must be 0 to match the CRC */
+        return owERRCRC;
+    }
+    return owOK;
+}
 
 /**
  * \brief           Start temperature conversion on specific (or all) devices
@@ -47,13 +107,8 @@ ow_ds18x20_start_raw(ow_t* const ow, const ow_rom_t* const rom_id) {
 
     OW_ASSERT0("ow != NULL", ow != NULL);
 
-    if (ow_reset_raw(ow) == owOK) {
-        if (rom_id == NULL) {                   /* Check for ROM id */
-            ow_skip_rom_raw(ow);                /* Skip ROM, send to all devices */
-        } else {
-            ow_match_rom_raw(ow, rom_id);       /* Select exact device by ROM address */
-        }
-        ow_write_byte_raw(ow, 0x44);            /* Start temperature conversion */
+    if (ow_reset_raw(ow) == owOK
+        && select_and_send_cmd(ow, rom_id, 0x44) == owOK) { /* Start temperature conversion */
         ret = 1;
     }
     return ret;
@@ -77,64 +132,98 @@ ow_ds18x20_start(ow_t* const ow, const ow_rom_t* const rom_id) {
 
 /**
  * \brief           Read temperature previously started with \ref ow_ds18x20_start
+ *                  and report why read failed
  * \param[in]       ow: 1-Wire handle
  * \param[in]       rom_id: 1-Wire device address to read data from
  * \param[out]      t: Pointer to output float variable to save temperature
- * \return          `1` on success, `0` otherwise
+ * \return          \ref owOK on success, \ref owERR when conversion is not completed,
+ *                  \ref owERRPRESENCE when device didn't answer, \ref owERRCRC on corrupted data
  */
-uint8_t
-ow_ds18x20_read_raw(ow_t* const ow, const ow_rom_t* const rom_id, float* const t) {
+owr_t
+ow_ds18x20_read_ex_raw(ow_t* const ow, const ow_rom_t* const rom_id, float* const t) {
     float dec;
     uint16_t temp;
-    uint8_t ret = 0, data[9], crc, resolution, m = 0;
+    uint8_t data[9], resolution, m = 0;
     int8_t digit;
+    owr_t res;
 
-    OW_ASSERT0("ow != NULL", ow != NULL);
-    OW_ASSERT0("t != NULL", t != NULL);
-    OW_ASSERT0("ow_ds18x20_is_b(ow, rom_id) || ow_ds18x20_is_s(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id) || ow_ds18x20_is_s(ow, rom_id));
+    OW_ASSERT("ow != NULL", ow != NULL);
+    OW_ASSERT("t != NULL", t != NULL);
+    OW_ASSERT("ow_ds18x20_is_b(ow, rom_id) || ow_ds18x20_is_s(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id) || ow_ds18x20_is_s(ow, rom_id));
 
     /*
      * First read bit and check if all devices completed with conversion.
      * If everything ready, try to reset the network and continue
      */
-    if (ow_read_bit_raw(ow) && ow_reset_raw(ow) == owOK) {
-        if (rom_id == NULL) {                   /* Check for ROM id */
-            ow_skip_rom_raw(ow);                /* Skip ROM, send to all devices */
+    if (!ow_read_bit_raw(ow)) {
+        return owERR;
+    }
+    if ((res = read_scratchpad(ow, rom_id, data)) != owOK) {
+        return res;
+    }
+
+    temp = (data[1] << 0x08) | data[0];         /* Format data in integer format */
+    if (ow_ds18x20_is_s(ow, rom_id)) {
+        /*
+         * DS18S20 reports 0.5 degree steps, count registers give extended resolution:
+         * T = TEMP_READ - 0.25 + (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C
+         */
+        if (data[7] != 0) {
+            *t = (float)((int16_t)temp >> 0x01) - 0.25f + (float)(data[7] - data[6]) / data[7];
         } else {
-            ow_match_rom_raw(ow, rom_id);       /* Select exact device by ROM address */
+            *t = (int16_t)temp * 0.5f;
         }
-        ow_write_byte_raw(ow, OW_CMD_RSCRATCHPAD);  /* Send command to read scratchpad */
+        return owOK;
+    }
 
-        /* Read plain data from device */
-        for (uint8_t i = 0; i < 9; ++i) {
-            data[i] = ow_read_byte_raw(ow);     /* Read byte */
-        }
-        crc = ow_crc(data, 0x09);               /* Calculate CRC */
-        if (crc == 0) {                         /* Result must be 0 to match the CRC */
-            temp = (data[1] << 0x08) | data[0]; /* Format data in integer format */
-            resolution = ((data[4] & 0x60) >> 0x05) + 0x09; /* Set resolution in units of bits */
-            if (temp & 0x8000) {                /* Check for negative temperature */
-                temp = ~temp + 1;               /* Perform two's complement */
-                m = 1;
-            }
-            digit = (temp >> 0x04) | (((temp >> 0x08) & 0x07) << 0x04);
-            switch (resolution) {               /* Check for resolution settings */
-                case 9:  dec = ((temp >> 0x03) & 0x01) * 0.5f; break;
-                case 10: dec = ((temp >> 0x02) & 0x03) * 0.25f; break;
-                case 11: dec = ((temp >> 0x01) & 0x07) * 0.125f; break;
-                case 12: dec = (temp & 0x0F) * 0.0625f; break;
-                default: dec = 0xFF, digit = 0;
-            }
-            dec += digit;
-            if (m) {
-                dec = -dec;
-            }
-            *t = dec;
-            ret = 1;
-        }
+    resolution = ((data[4] & 0x60) >> 0x05) + 0x09; /* Set resolution in units of bits */
+    if (temp & 0x8000) {                        /* Check for negative temperature */
+        temp = ~temp + 1;                       /* Perform two's complement */
+        m = 1;
+    }
+    digit = (temp >> 0x04) | (((temp >> 0x08) & 0x07) << 0x04);
+    switch (resolution) {                       /* Check for resolution settings */
+        case 9:  dec = ((temp >> 0x03) & 0x01) * 0.5f; break;
+        case 10: dec = ((temp >> 0x02) & 0x03) * 0.25f; break;
+        case 11: dec = ((temp >> 0x01) & 0x07) * 0.125f; break;
+        case 12: dec = (temp & 0x0F) * 0.0625f; break;
+        default: dec = 0xFF, digit = 0;
     }
+    dec += digit;
+    if (m) {
+        dec = -dec;
+    }
+    *t = dec;
+    return owOK;
+}
 
-    return ret;
+/**
+ * \copydoc         ow_ds18x20_read_ex_raw
+ * \note            This function is thread-safe
+ */
+owr_t
+ow_ds18x20_read_ex(ow_t* const ow, const ow_rom_t* const rom_id, float* const t) {
+    owr_t res;
+
+    OW_ASSERT("ow != NULL", ow != NULL);
+    OW_ASSERT("t != NULL", t != NULL);
+
+    ow_protect(ow, 1);
+    res = ow_ds18x20_read_ex_raw(ow, rom_id, t);
+    ow_unprotect(ow, 1);
+    return res;
+}
+
+/**
+ * \brief           Read temperature previously started with \ref ow_ds18x20_start
+ * \param[in]       ow: 1-Wire handle
+ * \param[in]       rom_id: 1-Wire device address to read data from
+ * \param[out]      t: Pointer to output float variable to save temperature
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ow_ds18x20_read_raw(ow_t* const ow, const ow_rom_t* const rom_id, float* const t) {
+    return ow_ds18x20_read_ex_raw(ow, rom_id, t) == owOK;
 }
 
 /**
@@ -155,6 +244,41 @@ ow_ds18x20_read(ow_t* const ow, const ow_rom_t* const rom_id, float* const t) {
     return res;
 }
 
+/**
+ * \brief           Check that device with known ROM is still on the bus.
+ *                  Device is selected with match ROM and its scratchpad is read,
+ *                  which is much shorter than search of the whole bus
+ * \param[in]       ow: 1-Wire handle
+ * \param[in]       rom_id: 1-Wire device address to check
+ * \return          `1` when device answered with valid scratchpad, `0` otherwise
+ */
+uint8_t
+ow_ds18x20_verify_raw(ow_t* const ow, const ow_rom_t* const rom_id) {
+    uint8_t data[9];
+
+    OW_ASSERT0("ow != NULL", ow != NULL);
+    OW_ASSERT0("rom_id != NULL", rom_id != NULL);
+
+    return read_scratchpad(ow, rom_id, data) == owOK;
+}
+
+/**
+ * \copydoc         ow_ds18x20_verify_raw
+ * \note            This function is thread-safe
+ */
+uint8_t
+ow_ds18x20_verify(ow_t* const ow, const ow_rom_t* const rom_id) {
+    uint8_t res;
+
+    OW_ASSERT0("ow != NULL", ow != NULL);
+    OW_ASSERT0("rom_id != NULL", rom_id != NULL);
+
+    ow_protect(ow, 1);
+    res = ow_ds18x20_verify_raw(ow, rom_id);
+    ow_unprotect(ow, 1);
+    return res;
+}
+
 /**
  * \brief           Get resolution for `DS18B20` device
  * \param[in]       ow: 1-Wire handle
@@ -163,23 +287,14 @@ ow_ds18x20_read(ow_t* const ow, const ow_rom_t* const rom_id, float* const t) {
  */
 uint8_t
 ow_ds18x20_get_resolution_raw(ow_t* const ow, const ow_rom_t* const rom_id) {
-    uint8_t res = 0;
+    uint8_t data[9], res = 0;
 
     OW_ASSERT0("ow != NULL", ow != NULL);
     OW_ASSERT0("rom_id != NULL", rom_id != NULL);
     OW_ASSERT0("ow_ds18x20_is_b(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id));
 
-    if (ow_reset_raw(ow) == owOK) {             /* Reset bus */
-        ow_match_rom_raw(ow, rom_id);           /* Select device */
-        ow_write_byte_raw(ow, OW_CMD_RSCRATCHPAD);  /* Read scratchpad command */
-
-        /* Read and ignore bytes */
-        ow_read_byte_raw(ow);
-        ow_read_byte_raw(ow);
-        ow_read_byte_raw(ow);
-        ow_read_byte_raw(ow);
-
-        res = ((ow_read_byte_raw(ow) & 0x60) >> 0x05) + 9;  /* Read configuration byte and calculate bits */
+    if (read_scratchpad(ow, rom_id, data) == owOK) {
+        res = ((data[4] & 0x60) >> 0x05) + 9;   /* Calculate bits from configuration byte */
     }
 
     return res;
@@ -204,65 +319,61 @@ ow_ds18x20_get_resolution(ow_t* const ow, const ow_rom_t* const rom_id) {
 }
 
 /**
- * \brief           Set resolution for `DS18B20` sensor
- * \note            `DS18S20` has fixed `9-bit` resolution
+ * \brief           Write resolution to scratchpad and optionally copy it to EEPROM
  * \param[in]       ow: 1-Wire handle
- * \param[in]       rom_id: 1-Wire device address to set resolution
+ * \param[in]       rom_id: 1-Wire device address. Set to `NULL` to set the only device,
+ *                      scratchpads of several devices collide and fail CRC check
  * \param[in]       bits: Number of resolution bits. Possible values are `9 - 12`
- * \return          `1` on success, `0` otherwise
+ * \param[in]       copy: Set to `1` to copy scratchpad to non-volatile memory
+ * \return          `1` on success, `0` otherwise. Nothing is written when scratchpad
+ *                  can't be read with valid CRC, so alarm levels are never corrupted
  */
-uint8_t
-ow_ds18x20_set_resolution_raw(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits) {
-    uint8_t th, tl, conf, res = 0;
-
-    OW_ASSERT0("ow != NULL", ow != NULL);
-    OW_ASSERT0("bits >= 9 && bits <= 12", bits >= 9 && bits <= 12);
-    OW_ASSERT0("ow_ds18x20_is_b(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id));
-
-    if (ow_reset_raw(ow) == owOK) {
-        if (rom_id == NULL) {
-            ow_match_rom_raw(ow, rom_id);
-        } else {
-            ow_skip_rom_raw(ow);
-        }
-        ow_write_byte_raw(ow, OW_CMD_RSCRATCHPAD);
-
-        /* Read and ignore bytes */
-        ow_read_byte_raw(ow);
-        ow_read_byte_raw(ow);
-
-        /* Read important data */
-        th = ow_read_byte_raw(ow);
-        tl = ow_read_byte_raw(ow);
-        conf = ow_read_byte_raw(ow) & ~0x60;    /* Remove configuration bits for temperature resolution */
+static uint8_t
+write_resolution(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits, const uint8_t copy) {
+    uint8_t data[9], res = 0;
 
+    if (read_scratchpad(ow, rom_id, data) == owOK) {    /* Temperature is ignored, keep alarm levels */
+        data[4] &= ~0x60;                       /* Remove configuration bits for temperature resolution */
         switch (bits) {                         /* Check bits configuration */
-            case 10: conf |= 0x20; break;       /* 10-bits configuration */
-            case 11: conf |= 0x40; break;       /* 11-bits configuration */
-            case 12: conf |= 0x60; break;       /* 12-bits configuration */
-            default: conf |= 0x00; break;       /* 9-bits configuration */
+            case 10: data[4] |= 0x20; break;    /* 10-bits configuration */
+            case 11: data[4] |= 0x40; break;    /* 11-bits configuration */
+            case 12: data[4] |= 0x60; break;    /* 12-bits configuration */
+            default: data[4] |= 0x00; break;    /* 9-bits configuration */
         }
 
-        /* Write data back to device */
-        if (ow_reset_raw(ow) == owOK) {
-            ow_match_rom_raw(ow, rom_id);
-            ow_write_byte_raw(ow, OW_CMD_WSCRATCHPAD);
-
-            ow_write_byte_raw(ow, th);
-            ow_write_byte_raw(ow, tl);
-            ow_write_byte_raw(ow, conf);
+        /* Write TH, TL and configuration back to device */
+        if (ow_reset_raw(ow) == owOK
+            && select_and_send_cmd(ow, rom_id, OW_CMD_WSCRATCHPAD) == owOK
+            && ow_write_bytes_raw(ow, &data[2], 3) == owOK) {
+            res = 1;
 
             /* Copy scratchpad to non-volatile memory */
-            if (ow_reset_raw(ow) == owOK) {
-                ow_match_rom_raw(ow, rom_id);
-                ow_write_byte_raw(ow, OW_CMD_CPYSCRATCHPAD);
-                res = 1;
+            if (copy) {
+                res = ow_reset_raw(ow) == owOK
+                    && select_and_send_cmd(ow, rom_id, OW_CMD_CPYSCRATCHPAD) == owOK;
             }
         }
     }
     return res;
 }
 
+/**
+ * \brief           Set resolution for `DS18B20` sensor
+ * \note            `DS18S20` has fixed `9-bit` resolution
+ * \param[in]       ow: 1-Wire handle
+ * \param[in]       rom_id: 1-Wire device address to set resolution. Set to `NULL` to set all devices
+ * \param[in]       bits: Number of resolution bits. Possible values are `9 - 12`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ow_ds18x20_set_resolution_raw(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits) {
+    OW_ASSERT0("ow != NULL", ow != NULL);
+    OW_ASSERT0("bits >= 9 && bits <= 12", bits >= 9 && bits <= 12);
+    OW_ASSERT0("rom_id == NULL || ow_ds18x20_is_b(ow, rom_id)", rom_id == NULL || ow_ds18x20_is_b(ow, rom_id));
+
+    return write_resolution(ow, rom_id, bits, 1);
+}
+
 /**
  * \copydoc         ow_ds18x20_set_resolution_raw
  * \note            This function is thread-safe
@@ -272,8 +383,6 @@ ow_ds18x20_set_resolution(ow_t* const ow, const ow_rom_t* const rom_id, const ui
     uint8_t res;
 
     OW_ASSERT0("ow != NULL", ow != NULL);
-    OW_ASSERT0("bits >= 9 && bits <= 12", bits >= 9 && bits <= 12);
-    OW_ASSERT0("ow_ds18x20_is_b(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id));
 
     ow_protect(ow, 1);
     res = ow_ds18x20_set_resolution_raw(ow, rom_id, bits);
@@ -282,37 +391,55 @@ ow_ds18x20_set_resolution(ow_t* const ow, const ow_rom_t* const rom_id, const ui
 }
 
 /**
- * \brief           Set/clear temperature alarm high/low levels in units of degree Celcius
- * \note            `temp_h` and `temp_l` are high and low temperature alarms and can accept different values:
- *                      - `-55 % 125`, valid temperature range
- *                      - \ref OW_DS18X20_ALARM_DISABLE to disable temperature alarm (either high or low)
- *                      - \ref OW_DS18X20_ALARM_NOCHANGE to keep current alarm temperature (either high or low)
- *
- * Example usage would look something similar to:
- * \code{c}
-//Set alarm temperature; low = 10°C, high = 30°C
-ow_ds18x20_set_alarm_temp(&ow, dev_id, 10, 30);
-//Set alarm temperature; low = disable, high = no change
-ow_ds18x20_set_alarm_temp(&ow, dev_id, OW_DS18X20_ALARM_DISABLE, OW_DS18X20_ALARM_NOCHANGE);
-//Set alarm temperature; low = no change, high = disable
-ow_ds18x20_set_alarm_temp(&ow, dev_id, OW_DS18X20_ALARM_NOCHANGE, OW_DS18X20_ALARM_DISABLE);
-//Set alarm temperature; low = 10°C, high = 30°C
-ow_ds18x20_set_alarm_temp(&ow, dev_id, 10, 30);
-\endcode
+ * \brief           Write resolution for `DS18B20` sensor to scratchpad only
  *
+ * Resolution is not copied to EEPROM, so it can be changed often without
+ * wearing EEPROM. Device falls back to stored resolution after power cycle.
  *
  * \param[in]       ow: 1-Wire handle
- * \param[in]       rom_id: 1-Wire device address
- * \param[in]       temp_l: Alarm low temperature
- * \param[in]       temp_h: Alarm high temperature
+ * \param[in]       rom_id: 1-Wire device address to set resolution. Set to `NULL` to set all devices
+ * \param[in]       bits: Number of resolution bits. Possible values are `9 - 12`
  * \return          `1` on success, `0` otherwise
  */
 uint8_t
-ow_ds18x20_set_alarm_temp_raw(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h) {
-    uint8_t res = 0, conf, th, tl;
+ow_ds18x20_write_resolution_raw(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits) {
+    OW_ASSERT0("ow != NULL", ow != NULL);
+    OW_ASSERT0("bits >= 9 && bits <= 12", bits >= 9 && bits <= 12);
+    OW_ASSERT0("rom_id == NULL || ow_ds18x20_is_b(ow, rom_id)", rom_id == NULL || ow_ds18x20_is_b(ow, rom_id));
+
+    return write_resolution(ow, rom_id, bits, 0);
+}
+
+/**
+ * \copydoc         ow_ds18x20_write_resolution_raw
+ * \note            This function is thread-safe
+ */
+uint8_t
+ow_ds18x20_write_resolution(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits) {
+    uint8_t res;
 
     OW_ASSERT0("ow != NULL", ow != NULL);
-    OW_ASSERT0("ow_ds18x20_is_b(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id));
+
+    ow_protect(ow, 1);
+    res = ow_ds18x20_write_resolution_raw(ow, rom_id, bits);
+    ow_unprotect(ow, 1);
+    return res;
+}
+
+/**
+ * \brief           Write alarm levels to scratchpad and optionally copy them to EEPROM
+ * \param[in]       ow: 1-Wire handle
+ * \param[in]       rom_id: 1-Wire device address. Set to `NULL` to set the only device,
+ *                      scratchpads of several devices collide and fail CRC check
+ * \param[in]       temp_l: Alarm low temperature
+ * \param[in]       temp_h: Alarm high temperature
+ * \param[in]       copy: Set to `1` to copy scratchpad to non-volatile memory
+ * \return          `1` on success, `0` otherwise. Nothing is written when scratchpad
+ *                  can't be read with valid CRC, so configuration is never corrupted
+ */
+static uint8_t
+write_alarm_temp(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h, const uint8_t copy) {
+    uint8_t data[9], res = 0;
 
     /* Check if there is need to do anything */
     if (temp_l == OW_DS18X20_ALARM_NOCHANGE && temp_h == OW_DS18X20_ALARM_NOCHANGE) {
@@ -335,49 +462,62 @@ ow_ds18x20_set_alarm_temp_raw(ow_t* const ow, const ow_rom_t* const rom_id, int8
         }
     }
 
-    if (ow_reset_raw(ow) == owOK) {
-        if (rom_id == NULL) {
-            ow_skip_rom_raw(ow);
-        } else {
-            ow_match_rom_raw(ow, rom_id);
-        }
-        ow_write_byte_raw(ow, OW_CMD_RSCRATCHPAD);
-
-        /* Read and ignore 2 bytes */
-        ow_read_byte_raw(ow);
-        ow_read_byte_raw(ow);
-
-        /* Read important data */
-        th = ow_read_byte_raw(ow);
-        tl = ow_read_byte_raw(ow);
-        conf = ow_read_byte_raw(ow);
+    if (read_scratchpad(ow, rom_id, data) == owOK) {    /* Temperature is ignored, keep configuration */
 
         /* Fill new values */
-        th = temp_h == OW_DS18X20_ALARM_NOCHANGE ? (uint8_t)th : (uint8_t)temp_h;
-        tl = temp_l == OW_DS18X20_ALARM_NOCHANGE ? (uint8_t)tl : (uint8_t)temp_l;
+        data[2] = temp_h == OW_DS18X20_ALARM_NOCHANGE ? data[2] : (uint8_t)temp_h;
+        data[3] = temp_l == OW_DS18X20_ALARM_NOCHANGE ? data[3] : (uint8_t)temp_l;
 
-        /* Write scratchpad */
-        if (ow_reset_raw(ow) == owOK) {
-            ow_match_rom_raw(ow, rom_id);
-            ow_write_byte_raw(ow, OW_CMD_WSCRATCHPAD);
+        /* Write TH, TL and configuration back to device */
+        if (ow_reset_raw(ow) == owOK
+            && select_and_send_cmd(ow, rom_id, OW_CMD_WSCRATCHPAD) == owOK
+            && ow_write_bytes_raw(ow, &data[2], 3) == owOK) {
+            res = 1;
 
-            /* Write configuration register */
-            ow_write_byte_raw(ow, th);
-            ow_write_byte_raw(ow, tl);
-            ow_write_byte_raw(ow, conf);
-
-            /* Copy scratchpad to memory */
-            if (ow_reset_raw(ow) == owOK) {
-                ow_match_rom_raw(ow, rom_id);
-                ow_write_byte_raw(ow, OW_CMD_CPYSCRATCHPAD);
-
-                res = 1;
+            /* Copy scratchpad to non-volatile memory */
+            if (copy) {
+                res = ow_reset_raw(ow) == owOK
+                    && select_and_send_cmd(ow, rom_id, OW_CMD_CPYSCRATCHPAD) == owOK;
             }
         }
     }
     return res;
 }
 
+/**
+ * \brief           Set/clear temperature alarm high/low levels in units of degree Celcius
+ * \note            `temp_h` and `temp_l` are high and low temperature alarms and can accept different values:
+ *                      - `-55 % 125`, valid temperature range
+ *                      - \ref OW_DS18X20_ALARM_DISABLE to disable temperature alarm (either high or low)
+ *                      - \ref OW_DS18X20_ALARM_NOCHANGE to keep current alarm temperature (either high or low)
+ *
+ * Example usage would look something similar to:
+ * \code{c}
+//Set alarm temperature; low = 10°C, high = 30°C
+ow_ds18x20_set_alarm_temp(&ow, dev_id, 10, 30);
+//Set alarm temperature; low = disable, high = no change
+ow_ds18x20_set_alarm_temp(&ow, dev_id, OW_DS18X20_ALARM_DISABLE, OW_DS18X20_ALARM_NOCHANGE);
+//Set alarm temperature; low = no change, high = disable
+ow_ds18x20_set_alarm_temp(&ow, dev_id, OW_DS18X20_ALARM_NOCHANGE, OW_DS18X20_ALARM_DISABLE);
+//Set alarm temperature; low = 10°C, high = 30°C
+ow_ds18x20_set_alarm_temp(&ow, dev_id, 10, 30);
+\endcode
+ *
+ *
+ * \param[in]       ow: 1-Wire handle
+ * \param[in]       rom_id: 1-Wire device address
+ * \param[in]       temp_l: Alarm low temperature
+ * \param[in]       temp_h: Alarm high temperature
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ow_ds18x20_set_alarm_temp_raw(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h) {
+    OW_ASSERT0("ow != NULL", ow != NULL);
+    OW_ASSERT0("ow_ds18x20_is_b(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id));
+
+    return write_alarm_temp(ow, rom_id, temp_l, temp_h, 1);
+}
+
 /**
  * \copydoc         ow_ds18x20_set_alarm_temp_raw
  * \note            This function is thread-safe
@@ -395,6 +535,43 @@ ow_ds18x20_set_alarm_temp(ow_t* const ow, const ow_rom_t* const rom_id, int8_t t
     return res;
 }
 
+/**
+ * \brief           Write alarm levels for `DS18B20` sensor to scratchpad only
+ *
+ * Alarm levels are not copied to EEPROM, so they can follow measured temperature
+ * every conversion without wearing EEPROM. Device falls back to stored levels after power cycle.
+ *
+ * \param[in]       ow: 1-Wire handle
+ * \param[in]       rom_id: 1-Wire device address
+ * \param[in]       temp_l: Alarm low temperature
+ * \param[in]       temp_h: Alarm high temperature
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ow_ds18x20_write_alarm_temp_raw(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h) {
+    OW_ASSERT0("ow != NULL", ow != NULL);
+    OW_ASSERT0("ow_ds18x20_is_b(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id));
+
+    return write_alarm_temp(ow, rom_id, temp_l, temp_h, 0);
+}
+
+/**
+ * \copydoc         ow_ds18x20_write_alarm_temp_raw
+ * \note            This function is thread-safe
+ */
+uint8_t
+ow_ds18x20_write_alarm_temp(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h) {
+    uint8_t res;
+
+    OW_ASSERT0("ow != NULL", ow != NULL);
+    OW_ASSERT0("ow_ds18x20_is_b(ow, rom_id)", ow_ds18x20_is_b(ow, rom_id));
+
+    ow_protect(ow, 1);
+    res = ow_ds18x20_write_alarm_temp_raw(ow, rom_id, temp_l, temp_h);
+    ow_unprotect(ow, 1);
+    return res;
+}
+
 /**
  * \brief           Search for `DS18x20` devices with alarm flag
  * \note            To reset search, use \ref ow_search_reset function
@@ -60,15 +60,25 @@ uint8_t     ow_ds18x20_start(ow_t* const ow, const ow_rom_t* const rom_id);
 
 uint8_t     ow_ds18x20_read_raw(ow_t* const ow, const ow_rom_t* const rom_id, float* const t);
 uint8_t     ow_ds18x20_read(ow_t* const ow, const ow_rom_t* const rom_id, float* const t);
+owr_t       ow_ds18x20_read_ex_raw(ow_t* const ow, const ow_rom_t* const rom_id, float* const t);
+owr_t       ow_ds18x20_read_ex(ow_t* const ow, const ow_rom_t* const rom_id, float* const t);
+
+uint8_t     ow_ds18x20_verify_raw(ow_t* const ow, const ow_rom_t* const rom_id);
+uint8_t     ow_ds18x20_verify(ow_t* const ow, const ow_rom_t* const rom_id);
 
 uint8_t     ow_ds18x20_set_resolution_raw(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits);
 uint8_t     ow_ds18x20_set_resolution(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits);
 
+uint8_t     ow_ds18x20_write_resolution_raw(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits);
+uint8_t     ow_ds18x20_write_resolution(ow_t* const ow, const ow_rom_t* const rom_id, const uint8_t bits);
+
 uint8_t     ow_ds18x20_get_resolution_raw(ow_t* const ow, const ow_rom_t* const rom_id);
 uint8_t     ow_ds18x20_get_resolution(ow_t* const ow, const ow_rom_t* const rom_id);
 
 uint8_t     ow_ds18x20_set_alarm_temp_raw(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h);
 uint8_t     ow_ds18x20_set_alarm_temp(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h);
+uint8_t     ow_ds18x20_write_alarm_temp_raw(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h);
+uint8_t     ow_ds18x20_write_alarm_temp(ow_t* const ow, const ow_rom_t* const rom_id, int8_t temp_l, int8_t temp_h);
 
 owr_t       ow_ds18x20_search_alarm_raw(ow_t* const ow, ow_rom_t* const rom_id);
 owr_t       ow_ds18x20_search_alarm(ow_t* const ow, ow_rom_t* const rom_id);
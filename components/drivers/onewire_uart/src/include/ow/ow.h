@@ -61,6 +61,7 @@ typedef enum {
     owERRNODEV = -2,                            /*!< No device connected, maybe device removed during scan? */
     owPARERR = -3,                              /*!< Parameter error */
     owERR,                                      /*!< General-Purpose error */
+    owERRCRC = -5,                              /*!< Received data failed CRC check */
 } owr_t;
 
 /**
@@ -222,6 +223,12 @@ uint8_t     ow_write_byte(ow_t* const ow, const uint8_t b);
 uint8_t     ow_read_byte_raw(ow_t* const ow);
 uint8_t     ow_read_byte(ow_t* const ow);
 
+owr_t       ow_write_bytes_raw(ow_t* const ow, const uint8_t* const data, const size_t len);
+owr_t       ow_write_bytes(ow_t* const ow, const uint8_t* const data, const size_t len);
+
+owr_t       ow_read_bytes_raw(ow_t* const ow, uint8_t* const data, const size_t len);
+owr_t       ow_read_bytes(ow_t* const ow, uint8_t* const data, const size_t len);
+
 uint8_t     ow_read_bit_raw(ow_t* const ow);
 uint8_t     ow_read_bit(ow_t* const ow);
 
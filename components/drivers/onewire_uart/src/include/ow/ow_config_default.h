@@ -64,6 +64,27 @@ extern "C" {
 #define OW_CFG_OS_MUTEX_HANDLE                  void *
 #endif
 
+/**
+ * \brief           Maximal number of 1-Wire bytes exchanged with single low-level `tx_rx` call
+ *
+ * Multi-byte functions expand every 1-Wire byte to `8` UART bytes in buffer on stack.
+ * Longer data is split into more calls. Default covers match ROM with command.
+ */
+#ifndef OW_CFG_MAX_BYTES_PER_TRANSFER
+#define OW_CFG_MAX_BYTES_PER_TRANSFER           10
+#endif
+
+/**
+ * \brief           CRC-8 implementation used by \ref ow_crc
+ *
+ *  - `0`: Bit by bit, no table
+ *  - `1`: Nibble at once with `16` bytes table
+ *  - `2`: Byte at once with `256` bytes table
+ */
+#ifndef OW_CFG_CRC_TABLE
+#define OW_CFG_CRC_TABLE                        1
+#endif
+
 /**
  * \}
  */
@@ -44,6 +44,33 @@
 
 #endif /* !__DOXYGEN__ */
 
+#if OW_CFG_CRC_TABLE == 1
+/* CRC of every nibble value shifted through 4 zero bits, polynomial 0x8C */
+static const uint8_t crc_table[16] = {
+    0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8, 0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74
+};
+#elif OW_CFG_CRC_TABLE == 2
+/* CRC of every byte value shifted through 8 zero bits, polynomial 0x8C */
+static const uint8_t crc_table[256] = {
+    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+    0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E, 0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+    0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0, 0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+    0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D, 0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+    0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5, 0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+    0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58, 0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+    0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6, 0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+    0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B, 0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+    0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F, 0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+    0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92, 0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+    0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C, 0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+    0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1, 0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+    0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49, 0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+    0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4, 0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+    0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A, 0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+    0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
+};
+#endif /* OW_CFG_CRC_TABLE == 2 */
+
 /**
  * \brief           Send single bit to OneWire port
  * \param[in]       ow: OneWire instance
@@ -66,6 +93,51 @@ send_bit(ow_t* const ow, uint8_t v) {
     return 0;
 }
 
+/**
+ * \brief           Exchange multiple bytes with single low-level transfer per chunk
+ * \param[in]       ow: OneWire instance
+ * \param[in]       tx: Bytes to send. Set to `NULL` to send all bits as `1` (read)
+ * \param[out]      rx: Output buffer for received bytes. Set to `NULL` if not used
+ * \param[in]       len: Number of bytes
+ * \return          \ref owOK on success, \ref owERR when low-level transfer failed
+ */
+static owr_t
+send_bytes(ow_t* const ow, const uint8_t* tx, uint8_t* rx, size_t len) {
+    uint8_t tr[8 * OW_CFG_MAX_BYTES_PER_TRANSFER];
+
+    while (len > 0) {
+        size_t cnt = len > OW_CFG_MAX_BYTES_PER_TRANSFER ? OW_CFG_MAX_BYTES_PER_TRANSFER : len;
+
+        /* Each 1-Wire bit is one UART byte, see ow_write_byte_raw */
+        for (size_t i = 0; i < cnt; ++i) {
+            uint8_t b = tx != NULL ? tx[i] : 0xFF;
+            for (uint8_t j = 0; j < 8; ++j) {
+                tr[8 * i + j] = (b & (1 << j)) ? 0xFF : 0x00;
+            }
+        }
+        if (!ow->ll_drv->tx_rx(tr, tr, 8 * cnt, ow->arg)) {
+            return owERR;
+        }
+        if (rx != NULL) {
+            for (size_t i = 0; i < cnt; ++i) {
+                uint8_t r = 0;
+                for (uint8_t j = 0; j < 8; ++j) {
+                    if (tr[8 * i + j] == 0xFF) {
+                        r |= 0x01 << j;
+                    }
+                }
+                rx[i] = r;
+            }
+            rx += cnt;
+        }
+        if (tx != NULL) {
+            tx += cnt;
+        }
+        len -= cnt;
+    }
+    return owOK;
+}
+
 /**
  * \brief           Initialize OneWire instance
  * \param[in]       ow: OneWire instance
@@ -299,6 +371,76 @@ ow_read_byte(ow_t* const ow) {
     return res;
 }
 
+/**
+ * \brief           Write multiple bytes over 1-wire protocol
+ *
+ * Bytes are exchanged with one low-level transfer of `8 * len` UART bytes,
+ * split by \ref OW_CFG_MAX_BYTES_PER_TRANSFER
+ *
+ * \param[in,out]   ow: 1-Wire handle
+ * \param[in]       data: Bytes to write
+ * \param[in]       len: Number of bytes to write
+ * \return          \ref owOK on success, member of \ref owr_t otherwise
+ */
+owr_t
+ow_write_bytes_raw(ow_t* const ow, const uint8_t* const data, const size_t len) {
+    OW_ASSERT("ow != NULL", ow != NULL);
+    OW_ASSERT("data != NULL", data != NULL);
+
+    return send_bytes(ow, data, NULL, len);
+}
+
+/**
+ * \copydoc         ow_write_bytes_raw
+ * \note            This function is thread-safe
+ */
+owr_t
+ow_write_bytes(ow_t* const ow, const uint8_t* const data, const size_t len) {
+    owr_t res;
+
+    OW_ASSERT("ow != NULL", ow != NULL);
+
+    ow_protect(ow, 1);
+    res = ow_write_bytes_raw(ow, data, len);
+    ow_unprotect(ow, 1);
+    return res;
+}
+
+/**
+ * \brief           Read multiple bytes over 1-wire protocol
+ *
+ * Bytes are exchanged with one low-level transfer of `8 * len` UART bytes,
+ * split by \ref OW_CFG_MAX_BYTES_PER_TRANSFER
+ *
+ * \param[in,out]   ow: 1-Wire handle
+ * \param[out]      data: Output buffer for read bytes
+ * \param[in]       len: Number of bytes to read
+ * \return          \ref owOK on success, member of \ref owr_t otherwise
+ */
+owr_t
+ow_read_bytes_raw(ow_t* const ow, uint8_t* const data, const size_t len) {
+    OW_ASSERT("ow != NULL", ow != NULL);
+    OW_ASSERT("data != NULL", data != NULL);
+
+    return send_bytes(ow, NULL, data, len);
+}
+
+/**
+ * \copydoc         ow_read_bytes_raw
+ * \note            This function is thread-safe
+ */
+owr_t
+ow_read_bytes(ow_t* const ow, uint8_t* const data, const size_t len) {
+    owr_t res;
+
+    OW_ASSERT("ow != NULL", ow != NULL);
+
+    ow_protect(ow, 1);
+    res = ow_read_bytes_raw(ow, data, len);
+    ow_unprotect(ow, 1);
+    return res;
+}
+
 /**
  * \brief           Read single bit on 1-Wire network
  * \param[in,out]   ow: 1-Wire handle
@@ -510,12 +652,11 @@ ow_match_rom_raw(ow_t* const ow, const ow_rom_t* const rom_id) {
     OW_ASSERT0("ow != NULL", ow != NULL);
     OW_ASSERT0("rom_id != NULL", rom_id != NULL);
 
-    ow_write_byte_raw(ow, OW_CMD_MATCHROM);     /* Write byte to match rom exactly */
-    for (uint8_t i = 0; i < 8; ++i) {           /* Send 8 bytes representing ROM address */
-        ow_write_byte_raw(ow, rom_id->rom[i]);  /* Send ROM bytes */
-    }
+    uint8_t cmd[1 + sizeof(rom_id->rom)];
 
-    return 1;
+    cmd[0] = OW_CMD_MATCHROM;                   /* Write byte to match rom exactly */
+    memcpy(&cmd[1], rom_id->rom, sizeof(rom_id->rom));  /* Followed by 8 bytes representing ROM address */
+    return ow_write_bytes_raw(ow, cmd, sizeof(cmd)) == owOK;
 }
 
 /**
@@ -544,8 +685,8 @@ uint8_t
 ow_skip_rom_raw(ow_t* const ow) {
     OW_ASSERT0("ow != NULL", ow != NULL);
 
-    ow_write_byte_raw(ow, OW_CMD_SKIPROM);      /* Write byte to match rom exactly */
-    return 1;
+    const uint8_t cmd = OW_CMD_SKIPROM;         /* Write byte to skip rom and select all devices */
+    return ow_write_bytes_raw(ow, &cmd, 1) == owOK;
 }
 
 /**
@@ -574,7 +715,7 @@ ow_skip_rom(ow_t* const ow) {
 uint8_t
 ow_crc(const void* in, const size_t len) {
     size_t i;
-    uint8_t crc = 0, inbyte, mix;
+    uint8_t crc = 0;
     const uint8_t* d = in;
 
     if (in == NULL || len == 0) {
@@ -582,7 +723,14 @@ ow_crc(const void* in, const size_t len) {
     }
 
     for (i = 0; i < len; ++i, ++d) {
-        inbyte = *d;
+#if OW_CFG_CRC_TABLE == 1
+        crc ^= *d;
+        crc = (crc >> 4) ^ crc_table[crc & 0x0F];   /* Low nibble */
+        crc = (crc >> 4) ^ crc_table[crc & 0x0F];   /* High nibble */
+#elif OW_CFG_CRC_TABLE == 2
+        crc = crc_table[crc ^ *d];
+#else
+        uint8_t inbyte = *d, mix;
         for (uint8_t i = 8; i > 0; --i) {
             mix = (crc ^ inbyte) & 0x01;
             crc >>= 1;
@@ -591,6 +739,7 @@ ow_crc(const void* in, const size_t len) {
             }
             inbyte >>= 0x01;
         }
+#endif /* OW_CFG_CRC_TABLE */
     }
     return crc;
 }
@@ -2,7 +2,9 @@
  *******************************************************************************
  * @file    temperature.c
  * @author  Dmytro Shevchenko
- * @brief   Temperature driver
+ * @brief   Temperature driver. Every 1-Wire bus is measured by own worker, so
+ *          sensors of different buses don't wait on each other. Driver scans
+ *          buses and merges results of workers into one snapshot.
  *******************************************************************************
  */
 
@@ -10,13 +12,21 @@
 
 #include "temperature.h"
 
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+
 #include "app_config.h"
 #include "app_events.h"
+#include "app_fsm.h"
 #include "app_manager.h"
 #include "app_timers.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "nvs.h"
 #include "nvs_flash.h"
@@ -24,6 +34,8 @@
 #include "ow/ow.h"
 #include "ow_esp32.h"
 #include "pcf8574.h"
+#include "signal_filter.h"
+#include "temperature_history.h"
 
 /* Private macros ------------------------------------------------------------*/
 #define MODULE_NAME "[Temp] "
@@ -39,49 +51,152 @@
 #define CONFIG_THD_SIZE   4096
 #define STORAGE_NAMESPACE "storage"
 #define STORAGE_BLOB_NAME "temperature"
-#define SENSORS_COUNT     5
+#define STORAGE_VERSION   1
+#define SENSORS_COUNT     TEMP_NUMBER_OF_SENSORS
+#define BUS_WORKERS_COUNT ( APP_EVENT_TEMP_BUS_1 - APP_EVENT_TEMP_BUS_0 + 1 )
+
+/* Max conversion time of DS18B20, 750 ms at 12 bits halves with every bit less */
+#define DS18B20_CONVERSION_MS( _bits ) ( ( 750 + ( 1 << ( 12 - ( _bits ) ) ) - 1 ) >> ( 12 - ( _bits ) ) )
+#define DS18S20_CONVERSION_MS          750
 
 /* Private types -------------------------------------------------------------*/
 
 /** @brief  Array with defined states */
-#define STATE_HANDLER_ARRAY                        \
-  STATE( DISABLED, _disabled_state_handler_array ) \
-  STATE( INIT, _init_state_handler_array )         \
-  STATE( IDLE, _idle_state_handler_array )         \
-  STATE( SCANNING, _scanning_state_handler_array ) \
-  STATE( WORKING, _working_state_handler_array )
+#define STATE_HANDLER_ARRAY                                                                \
+  STATE( DISABLED, _disabled_state_handler_array, NULL, NULL )                             \
+  STATE( INIT, _init_state_handler_array, NULL, NULL )                                     \
+  STATE( IDLE, _idle_state_handler_array, NULL, NULL )                                     \
+  STATE( SCANNING, _scanning_state_handler_array, NULL, NULL )                             \
+  STATE( WORKING, _working_state_handler_array, _state_working_entry, _state_working_exit )
+
+/** @brief  Array with defined states of bus worker */
+#define BUS_STATE_HANDLER_ARRAY                                 \
+  STATE( BUS_IDLE, _bus_idle_state_handler_array, NULL, NULL ) \
+  STATE( BUS_MEASURING, _bus_measuring_state_handler_array, NULL, NULL )
 
 /** @brief  Private types */
 typedef enum
 {
-#define STATE( _state, _event_handler_array ) _state,
+#define STATE APP_FSM_STATE_ENUM
   STATE_HANDLER_ARRAY
 #undef STATE
     STATE_TOP,
 } drv_state_t;
 
+typedef enum
+{
+#define STATE APP_FSM_STATE_ENUM
+  BUS_STATE_HANDLER_ARRAY
+#undef STATE
+    BUS_STATE_TOP,
+} bus_state_t;
+
+enum
+{
+#define OW_BUS( _uart, _tx, _rx ) +1
+  BUS_COUNT = 0 CONFIG_TEMPERATURE_BUS_LIST
+#undef OW_BUS
+};
+
+typedef enum
+{
+  TIMER_ID_CONVERSION_DONE,
+  TIMER_ID_RETRY,
+  TIMER_ID_LAST
+} timer_id;
+
+typedef struct
+{
+  float temp;
+  float rate;
+  uint32_t time_ms;
+  uint8_t resolution;
+  bool valid;
+  int8_t alarm_l;
+  int8_t alarm_h;
+  bool alarm_set;
+  temp_sensor_health_t health;
+} sensor_t;
+
+typedef struct
+{
+  ow_rom_t rom;
+  uint8_t misses;
+  bool seen;
+} registry_entry_t;
+
+/** @brief  Bus is owned by its worker, driver touches it only when worker is idle */
 typedef struct
 {
-  drv_state_t state;
   ow_t ow;
   ow_rom_t rom_ids[SENSORS_COUNT];
   size_t rom_found;
-  float avg_temp;
-  size_t avg_temp_count;
-  QueueHandle_t queue;
+  sensor_t sensors[SENSORS_COUNT];
+  uint32_t first;
+  uint32_t cycle_start_ms;
+  uint32_t sample_period_ms;
+  uint32_t cycles_to_full;
+  uint32_t failed_cycles;
+  uint32_t history_stale; /* Bit per sensor, ROM changed on rescan and worker drops its history */
+#if CONFIG_TEMPERATURE_HOTPLUG
+  /* ROMs seen by background search, walk position is kept apart from alarm search */
+  registry_entry_t registry[CONFIG_TEMPERATURE_HOTPLUG_ROMS];
+  size_t registry_count;
+  ow_rom_t walk_rom;
+  uint8_t walk_disrepancy;
+#endif
+  char name[16];
+  app_fsm_t fsm;
+  app_timer_t timers[TIMER_ID_LAST];
+} bus_t;
 
-  bool is_ready_to_work;
-} drv_ctx_t;
+typedef struct
+{
+  uint8_t bus;
+  temp_drv_err_t err;
+} bus_result_t;
 
-typedef enum
+/** @brief  ROM table kept in NVS, sensors are stored in order of their indexes */
+typedef struct
 {
-  TIMER_ID_SCAN_TIMEOUT,
-  TIMER_ID_MEASURE_REQ,
-  TIMER_ID_LAST
-} timer_id;
+  uint8_t version;
+  uint8_t count;
+  uint8_t bus[SENSORS_COUNT];
+  ow_rom_t rom_ids[SENSORS_COUNT];
+  uint32_t crc;
+} sensors_table_t;
+
+typedef struct
+{
+  bus_t buses[BUS_COUNT];
+  size_t sensors_count;
+  ow_rom_t history_roms[SENSORS_COUNT];
+  uint32_t scans_pending;
+  temp_drv_err_t scan_err;
+
+  /* Shared with API and bus workers, guarded by mutex */
+  SemaphoreHandle_t mutex;
+  temp_status_t status;
+  float thresholds[TEMP_THRESHOLDS_COUNT];
+  uint32_t thresholds_count;
+  signal_filter_t filters[SENSORS_COUNT];
+
+  int64_t init_time_us;
+  uint32_t first_sample_ms;
+  bool is_ready_to_work;
+} drv_ctx_t;
 
 /* Private variables ---------------------------------------------------------*/
 
+static const ow_uart_config_t bus_config[] = {
+#define OW_BUS( _uart, _tx, _rx ) { .uart_num = ( _uart ), .tx_pin = ( _tx ), .rx_pin = ( _rx ) },
+  CONFIG_TEMPERATURE_BUS_LIST
+#undef OW_BUS
+};
+
+_Static_assert( BUS_COUNT <= BUS_WORKERS_COUNT, "Every bus needs own TEMP_BUS event task" );
+_Static_assert( SENSORS_COUNT <= 32, "Stale history of bus is bit mask of sensors" );
+
 static drv_ctx_t ctx;
 
 const ow_ll_drv_t ow_ll_drv_esp32 = {
@@ -92,9 +207,6 @@ const ow_ll_drv_t ow_ll_drv_esp32 = {
 };
 
 /* Private functions declaration ---------------------------------------------*/
-static void _timeout_scan_cb( TimerHandle_t xTimer );
-static void _measure_req_cb( TimerHandle_t xTimer );
-
 static void _state_common_event_deinit_request( const app_event_t* event );
 
 static void _state_disabled_event_init_request( const app_event_t* event );
@@ -109,31 +221,39 @@ static void _state_idle_event_start_measure( const app_event_t* event );
 static void _state_scanning_event_scan_devices_req( const app_event_t* event );
 static void _state_scanning_event_scan_devices_res( const app_event_t* event );
 
+static void _state_working_entry( void );
+static void _state_working_exit( void );
 static void _state_working_event_scan_devices_req( const app_event_t* event );
 static void _state_working_event_stop_measure( const app_event_t* event );
-static void _state_working_event_measure_req( const app_event_t* event );
+static void _state_working_event_bus_failed( const app_event_t* event );
+
+static void _bus_common_event_scan_devices_req( const app_event_t* event );
+static void _bus_idle_event_start_measure( const app_event_t* event );
+static void _bus_measuring_event_stop_measure( const app_event_t* event );
+static void _bus_measuring_event_measure_req( const app_event_t* event );
+static void _bus_measuring_event_conversion_done( const app_event_t* event );
 
 /* Status callbacks declaration. ---------------------------------------------*/
-static const struct app_events_handler _disabled_state_handler_array[] =
+static const app_events_handler_table_t _disabled_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_disabled_event_init_request ),
 };
 
-static const struct app_events_handler _init_state_handler_array[] =
+static const app_events_handler_table_t _init_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_init_event_init_request ),
     EVENT_ITEM( MSG_ID_INIT_RES, _state_init_event_init_response ),
     EVENT_ITEM( MSG_ID_DEINIT_REQ, _state_common_event_deinit_request ),
 };
 
-static const struct app_events_handler _idle_state_handler_array[] =
+static const app_events_handler_table_t _idle_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_DEINIT_REQ, _state_common_event_deinit_request ),
     EVENT_ITEM( MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, _state_idle_event_scan_device_req ),
     EVENT_ITEM( MSG_ID_TEMPERATURE_START_MEASURE, _state_idle_event_start_measure ),
 };
 
-static const struct app_events_handler _scanning_state_handler_array[] =
+static const app_events_handler_table_t _scanning_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_DEINIT_REQ, _state_common_event_deinit_request ),
     // EVENT_ITEM( MSG_ID_TEMPERATURE_START_MEASURE, _state_scanning_event_start_measure ),
@@ -141,72 +261,85 @@ static const struct app_events_handler _scanning_state_handler_array[] =
     EVENT_ITEM( MSG_ID_TEMPERATURE_SCAN_DEVICES_RES, _state_scanning_event_scan_devices_res ),
 };
 
-static const struct app_events_handler _working_state_handler_array[] =
+static const app_events_handler_table_t _working_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_DEINIT_REQ, _state_common_event_deinit_request ),
     EVENT_ITEM( MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, _state_working_event_scan_devices_req ),
     EVENT_ITEM( MSG_ID_TEMPERATURE_STOP_MEASURE, _state_working_event_stop_measure ),
-    EVENT_ITEM( MSG_ID_TEMPERATURE_MEASURE_REQ, _state_working_event_measure_req ),
+    EVENT_ITEM( MSG_ID_TEMPERATURE_BUS_FAILED, _state_working_event_bus_failed ),
 };
 
-struct state_context
-{
-  const drv_state_t state;
-  const char* name;
-  const struct app_events_handler* event_handler_array;
-  uint8_t event_handler_array_size;
+static const app_events_handler_table_t _bus_idle_state_handler_array =
+  {
+    EVENT_ITEM( MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, _bus_common_event_scan_devices_req ),
+    EVENT_ITEM( MSG_ID_TEMPERATURE_START_MEASURE, _bus_idle_event_start_measure ),
 };
 
-static const struct state_context drv_state[STATE_TOP] =
+static const app_events_handler_table_t _bus_measuring_state_handler_array =
   {
-#define STATE( _state, _event_handler_array )    \
-  {                                              \
-    .state = _state,                             \
-    .name = #_state,                             \
-    .event_handler_array = _event_handler_array, \
-    .event_handler_array_size = ARRAY_SIZE( _event_handler_array ) },
+    EVENT_ITEM( MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, _bus_common_event_scan_devices_req ),
+    EVENT_ITEM( MSG_ID_TEMPERATURE_STOP_MEASURE, _bus_measuring_event_stop_measure ),
+    EVENT_ITEM( MSG_ID_TEMPERATURE_MEASURE_REQ, _bus_measuring_event_measure_req ),
+    EVENT_ITEM( MSG_ID_TEMPERATURE_CONVERSION_DONE, _bus_measuring_event_conversion_done ),
+};
+
+static const app_fsm_state_t drv_state[STATE_TOP] =
+  {
+#define STATE APP_FSM_STATE_ITEM
     STATE_HANDLER_ARRAY
 #undef STATE
 };
 
-static app_timer_t timers[] =
+static const app_fsm_state_t bus_state[BUS_STATE_TOP] =
   {
-    TIMER_ITEM( TIMER_ID_SCAN_TIMEOUT, _timeout_scan_cb, 1500, "ScanTimeout" ),
-    TIMER_ITEM( TIMER_ID_MEASURE_REQ, _measure_req_cb, 1000, "MeasureReq" ) };
+#define STATE APP_FSM_STATE_ITEM
+    BUS_STATE_HANDLER_ARRAY
+#undef STATE
+};
 
-/* Private functions ---------------------------------------------------------*/
+static app_fsm_t fsm =
+  {
+    .name = "temperature",
+    .task = APP_EVENT_TEMP_DRV,
+    .queue_length = 8,
+    .worker = APP_EXECUTOR_WORKER_IO,
+    .stack_size = 3072,
+    .states = drv_state,
+    .states_count = STATE_TOP,
+};
 
-/** @brief  States functions. */
-static const char* _get_state_name( const drv_state_t state )
-{
-  return drv_state[state].name;
-}
+static const app_timer_t bus_timers[] =
+  {
+    TIMER_ITEM( TIMER_ID_CONVERSION_DONE, MSG_ID_TEMPERATURE_CONVERSION_DONE, DS18S20_CONVERSION_MS, "Conversion" ),
+    TIMER_ITEM( TIMER_ID_RETRY, MSG_ID_TEMPERATURE_MEASURE_REQ, CONFIG_TEMPERATURE_BUS_RETRY_MS, "Retry" ),
+};
 
-static void _change_state( drv_state_t new_state )
-{
-  LOG( PRINT_INFO, "State: %s -> %s", _get_state_name( ctx.state ), _get_state_name( new_state ) );
-  ctx.state = new_state;
-}
+/* Private functions ---------------------------------------------------------*/
 
-static void _send_internal_event( app_msg_id_t id, const void* data, uint32_t data_size )
+static uint32_t _get_table_crc( const sensors_table_t* table )
 {
-  app_event_t event = {};
-  if ( data_size == 0 )
-  {
-    AppEventPrepareNoData( &event, id, APP_EVENT_TEMP_DRV, APP_EVENT_TEMP_DRV );
-  }
-  else
-  {
-    AppEventPrepareWithData( &event, id, APP_EVENT_TEMP_DRV, APP_EVENT_TEMP_DRV, data, data_size );
-  }
-
-  TemperaturePostMsg( &event );
+  return esp_rom_crc32_le( 0, (const uint8_t*) table, offsetof( sensors_table_t, crc ) );
 }
 
 static bool _save_sensors( void )
 {
   nvs_handle_t my_handle;
   esp_err_t err;
+  sensors_table_t table;
+
+  /* Padding is covered by CRC too */
+  memset( &table, 0, sizeof( table ) );
+  table.version = STORAGE_VERSION;
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
+  {
+    for ( size_t i = 0; i < ctx.buses[b].rom_found; i++ )
+    {
+      table.bus[table.count] = b;
+      table.rom_ids[table.count] = ctx.buses[b].rom_ids[i];
+      table.count++;
+    }
+  }
+  table.crc = _get_table_crc( &table );
 
   err = nvs_open( STORAGE_NAMESPACE, NVS_READWRITE, &my_handle );
   if ( err != ESP_OK )
@@ -214,7 +347,7 @@ static bool _save_sensors( void )
     return false;
   }
 
-  err = nvs_set_blob( my_handle, STORAGE_BLOB_NAME, (void*) ctx.rom_ids, ARRAY_SIZE( ctx.rom_ids ) );
+  err = nvs_set_blob( my_handle, STORAGE_BLOB_NAME, (void*) &table, sizeof( table ) );
   if ( err != ESP_OK )
   {
     nvs_close( my_handle );
@@ -231,7 +364,7 @@ static bool _save_sensors( void )
   return true;
 }
 
-static bool _read_sensors( void )
+static bool _read_sensors( sensors_table_t* table )
 {
   nvs_handle_t my_handle;
   esp_err_t err;
@@ -241,64 +374,505 @@ static bool _read_sensors( void )
   {
     return false;
   }
-  size_t length = 0;
-  err = nvs_get_blob( my_handle, STORAGE_BLOB_NAME, (void*) ctx.rom_ids, &length );
+  size_t length = sizeof( *table );
+  err = nvs_get_blob( my_handle, STORAGE_BLOB_NAME, (void*) table, &length );
   nvs_close( my_handle );
-  if ( err != ESP_OK || ARRAY_SIZE( ctx.rom_ids ) != length )
+  if ( err != ESP_OK || length != sizeof( *table ) || table->version != STORAGE_VERSION || table->crc != _get_table_crc( table ) )
   {
     return false;
   }
+  if ( table->count == 0 || table->count > SENSORS_COUNT )
+  {
+    return false;
+  }
+  for ( size_t i = 0; i < table->count; i++ )
+  {
+    if ( table->bus[i] >= BUS_COUNT )
+    {
+      return false;
+    }
+  }
   return true;
 }
 
-static bool _check_read_sensors( void )
+static void _assign_sensors( void )
 {
-  ow_rom_t scan_rom_ids[SENSORS_COUNT];
-  memset( scan_rom_ids, 0xff, sizeof( scan_rom_ids ) );
-  if ( owOK != ow_search_devices( &ctx.ow, scan_rom_ids, OW_ARRAYSIZE( scan_rom_ids ), &ctx.rom_found ) )
+  /* Buses take consecutive sensor indexes, sensors over TEMP_NUMBER_OF_SENSORS are not measured */
+  ctx.sensors_count = 0;
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
   {
-    return false;
+    bus_t* bus = &ctx.buses[b];
+    bus->first = ctx.sensors_count;
+    if ( bus->rom_found > SENSORS_COUNT - bus->first )
+    {
+      LOG( PRINT_WARNING, "Bus %d: %d sensors over limit", (int) b, (int) ( bus->rom_found - ( SENSORS_COUNT - bus->first ) ) );
+      bus->rom_found = SENSORS_COUNT - bus->first;
+    }
+    ctx.sensors_count += bus->rom_found;
+    for ( size_t i = 0; i < SENSORS_COUNT; i++ )
+    {
+      memset( &bus->sensors[i].health, 0, sizeof( bus->sensors[i].health ) );
+    }
   }
-  LOG( PRINT_INFO, "Devices scanned, found %d devices!\r\n", (int) ctx.rom_found );
-  if ( ctx.rom_found != SENSORS_COUNT )
+
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  memset( &ctx.status, 0, sizeof( ctx.status ) );
+  ctx.status.sensors_count = ctx.sensors_count;
+  for ( size_t i = 0; i < SENSORS_COUNT; i++ )
   {
-    return false;
+    SignalFilterReset( &ctx.filters[i] );
   }
-  for ( int i = 0; i < SENSORS_COUNT; i++ )
+  ctx.status.first_sample_ms = ctx.first_sample_ms;
+  xSemaphoreGive( ctx.mutex );
+}
+
+static void _mark_stale_history( void )
+{
+  /* History of index is kept while same sensor stays on it, worker as its only writer drops the rest */
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
   {
-    bool is_sensor_in_list = false;
-    for ( int j = 0; j < SENSORS_COUNT; j++ )
+    bus_t* bus = &ctx.buses[b];
+    bus->history_stale = 0;
+    for ( size_t i = 0; i < bus->rom_found; i++ )
     {
-      if ( memcmp( &ctx.rom_ids[i], &scan_rom_ids[j], sizeof( ctx.rom_ids[i] ) ) )
+      if ( memcmp( &ctx.history_roms[bus->first + i], &bus->rom_ids[i], sizeof( ow_rom_t ) ) != 0 )
       {
-        is_sensor_in_list = true;
-        break;
+        ctx.history_roms[bus->first + i] = bus->rom_ids[i];
+        bus->history_stale |= 1UL << i;
       }
     }
-    if ( is_sensor_in_list == false )
+  }
+}
+
+static bool _verify_sensors( const sensors_table_t* table )
+{
+  /* Match ROM of every known sensor is much shorter than search of whole bus */
+  for ( size_t i = 0; i < table->count; i++ )
+  {
+    if ( !ow_ds18x20_verify( &ctx.buses[table->bus[i]].ow, &table->rom_ids[i] ) )
     {
+      LOG( PRINT_INFO, "Sensor %d not found on bus %d", (int) i, table->bus[i] );
       return false;
     }
   }
+
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
+  {
+    ctx.buses[b].rom_found = 0;
+  }
+  for ( size_t i = 0; i < table->count; i++ )
+  {
+    bus_t* bus = &ctx.buses[table->bus[i]];
+    bus->rom_ids[bus->rom_found++] = table->rom_ids[i];
+  }
+  _assign_sensors();
   return true;
 }
 
-static void _timeout_scan_cb( TimerHandle_t xTimer )
+static bool _search_sensors( void )
+{
+  /* Called before workers measure, so driver searches buses itself */
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
+  {
+    bus_t* bus = &ctx.buses[b];
+    if ( owOK != ow_search_devices( &bus->ow, bus->rom_ids, OW_ARRAYSIZE( bus->rom_ids ), &bus->rom_found ) )
+    {
+      bus->rom_found = 0;
+    }
+    LOG( PRINT_INFO, "Bus %d scanned, found %d devices!\r\n", (int) b, (int) bus->rom_found );
+  }
+  _assign_sensors();
+  return ctx.sensors_count > 0;
+}
+
+static uint32_t _get_time_ms( void )
+{
+  return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static int64_t _get_time_us( void )
+{
+  return esp_timer_get_time();
+}
+
+static uint32_t _get_boot_time_ms( void )
+{
+  return ( _get_time_us() - ctx.init_time_us ) / 1000;
+}
+
+static bus_t* _get_bus( const app_event_t* event )
+{
+  return &ctx.buses[event->dst - APP_EVENT_TEMP_BUS_0];
+}
+
+static void _post_to_buses( app_msg_id_t msg_id )
+{
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
+  {
+    app_event_t event = {};
+    AppEventPrepareNoData( &event, msg_id, APP_EVENT_TEMP_DRV, ctx.buses[b].fsm.task );
+    AppEventPost( &event );
+  }
+}
+
+static void _post_bus_result( bus_t* bus, app_msg_id_t msg_id, temp_drv_err_t err )
 {
-  // _send_internal_event( MSG_ID_WIFI_TIMEOUT_CONNECT, NULL, 0 );
+  bus_result_t result = { .bus = bus - ctx.buses, .err = err };
+  app_event_t event = {};
+  AppEventPrepareWithData( &event, msg_id, bus->fsm.task, APP_EVENT_TEMP_DRV, &result, sizeof( result ) );
+  AppEventPost( &event );
 }
 
-static void _measure_req_cb( TimerHandle_t xTimer )
+static uint32_t _get_conversion_time_ms( bus_t* bus )
 {
-  _send_internal_event( MSG_ID_TEMPERATURE_MEASURE_REQ, NULL, 0 );
+  /* All sensors of bus convert at once, so sweep lasts as long as the slowest one */
+  uint32_t conversion_ms = 0;
+  for ( size_t i = 0; i < bus->rom_found; i++ )
+  {
+    uint32_t sensor_ms = ow_ds18x20_is_s( &bus->ow, &bus->rom_ids[i] ) ? DS18S20_CONVERSION_MS : DS18B20_CONVERSION_MS( bus->sensors[i].resolution );
+    if ( sensor_ms > conversion_ms )
+    {
+      conversion_ms = sensor_ms;
+    }
+  }
+  return conversion_ms;
+}
+
+static void _update_sensor( sensor_t* sensor, float temp, uint32_t now_ms )
+{
+  uint32_t dt_ms = now_ms - sensor->time_ms;
+  if ( sensor->valid && dt_ms > 0 )
+  {
+    /* Low pass, single difference is dominated by quantization step at 9 bits */
+    float rate = ( temp - sensor->temp ) * 1000.0f / dt_ms;
+    sensor->rate += ( rate - sensor->rate ) * dt_ms / ( CONFIG_TEMPERATURE_RATE_TAU_MS + dt_ms );
+  }
+  sensor->temp = temp;
+  sensor->time_ms = now_ms;
+  sensor->valid = true;
+}
+
+static uint8_t _select_resolution( const sensor_t* sensor )
+{
+#if CONFIG_TEMPERATURE_ADAPTIVE_RESOLUTION
+  float rate = fabsf( sensor->rate );
+  float band = CONFIG_TEMPERATURE_THRESHOLD_BAND + rate * CONFIG_TEMPERATURE_LOOKAHEAD_MS / 1000.0f;
+
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  for ( uint32_t i = 0; i < ctx.thresholds_count; i++ )
+  {
+    if ( fabsf( sensor->temp - ctx.thresholds[i] ) <= band )
+    {
+      xSemaphoreGive( ctx.mutex );
+      return 12;
+    }
+  }
+  xSemaphoreGive( ctx.mutex );
+
+  uint8_t bits = 12;
+  float limit = CONFIG_TEMPERATURE_FAST_RATE / 4;
+  while ( bits > 9 && rate >= limit )
+  {
+    bits--;
+    limit *= 2;
+  }
+  return bits;
+#else
+  return CONFIG_TEMPERATURE_RESOLUTION;
+#endif
+}
+
+static void _set_resolution( bus_t* bus, size_t idx, uint8_t bits )
+{
+  if ( !ow_ds18x20_is_b( &bus->ow, &bus->rom_ids[idx] ) )
+  {
+    /* DS18S20 has fixed resolution */
+    bus->sensors[idx].resolution = 9;
+    return;
+  }
+
+  /* Scratchpad only, resolution changes too often for EEPROM */
+  if ( ow_ds18x20_write_resolution( &bus->ow, &bus->rom_ids[idx], bits ) )
+  {
+    LOG( PRINT_DEBUG, "Sensor %d: %d -> %d bits", (int) ( bus->first + idx ), bus->sensors[idx].resolution, bits );
+    bus->sensors[idx].resolution = bits;
+  }
+}
+
+static void _set_alarm_window( bus_t* bus, size_t idx )
+{
+#if CONFIG_TEMPERATURE_ALARM_MONITOR
+  sensor_t* sensor = &bus->sensors[idx];
+  if ( !ow_ds18x20_is_b( &bus->ow, &bus->rom_ids[idx] ) )
+  {
+    return;
+  }
+
+  /* Sensor compares integer part of temperature, alarm is set at TL and below or TH and above */
+  int8_t base = (int8_t) floorf( sensor->temp );
+  int8_t temp_l = base - CONFIG_TEMPERATURE_ALARM_WINDOW;
+  int8_t temp_h = base + CONFIG_TEMPERATURE_ALARM_WINDOW;
+  if ( sensor->alarm_set && sensor->alarm_l == temp_l && sensor->alarm_h == temp_h )
+  {
+    return;
+  }
+  sensor->alarm_set = ow_ds18x20_write_alarm_temp( &bus->ow, &bus->rom_ids[idx], temp_l, temp_h );
+  sensor->alarm_l = temp_l;
+  sensor->alarm_h = temp_h;
+#endif
+}
+
+static owr_t _read_temp( bus_t* bus, size_t idx, float* temp )
+{
+  temp_sensor_health_t* health = &bus->sensors[idx].health;
+  owr_t res = ow_ds18x20_read_ex( &bus->ow, &bus->rom_ids[idx], temp );
+  if ( res == owERRCRC )
+  {
+    health->crc_errors++;
+  }
+  else if ( res == owERRPRESENCE )
+  {
+    health->presence_errors++;
+  }
+  return res;
+}
+
+static bool _read_sensor( bus_t* bus, size_t idx, uint32_t now_ms, int64_t now_us )
+{
+  float temp = 0;
+  owr_t res = _read_temp( bus, idx, &temp );
+  if ( res == owERRCRC || res == owERRPRESENCE )
+  {
+    /* Conversion result stays in scratchpad, single glitch doesn't cost sample of cycle */
+    bus->sensors[idx].health.retries++;
+    res = _read_temp( bus, idx, &temp );
+  }
+  if ( res != owOK )
+  {
+    LOG( PRINT_WARNING, "Read sensor %d failed: %d", (int) ( bus->first + idx ), res );
+    return false;
+  }
+  bus->sensors[idx].health.last_good_ms = now_ms;
+  _update_sensor( &bus->sensors[idx], temp, now_ms );
+  TempHistoryAdd( bus->first + idx, now_us, TEMP_HISTORY_FROM_C( temp ) );
+
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  SignalFilterProcess( &ctx.filters[bus->first + idx], now_ms, lroundf( temp * 1000 ) );
+  xSemaphoreGive( ctx.mutex );
+  _set_alarm_window( bus, idx );
+  return true;
+}
+
+static bool _is_full_read( bus_t* bus )
+{
+#if CONFIG_TEMPERATURE_ALARM_MONITOR
+  if ( bus->cycles_to_full == 0 )
+  {
+    return true;
+  }
+  for ( size_t i = 0; i < bus->rom_found; i++ )
+  {
+    if ( !bus->sensors[i].valid || ( !bus->sensors[i].alarm_set && ow_ds18x20_is_b( &bus->ow, &bus->rom_ids[i] ) ) )
+    {
+      return true;
+    }
+  }
+  return false;
+#else
+  return true;
+#endif
+}
+
+static int _read_changed( bus_t* bus, uint32_t now_ms, int64_t now_us )
+{
+  /* Sensors without alarm levels are read every cycle, DS18B20 only when found by alarm search */
+  bool changed[SENSORS_COUNT] = {};
+  for ( size_t i = 0; i < bus->rom_found; i++ )
+  {
+    changed[i] = !ow_ds18x20_is_b( &bus->ow, &bus->rom_ids[i] );
+  }
+
+  ow_rom_t rom_id;
+  owr_t res = owERRNODEV;
+  ow_search_reset( &bus->ow );
+  for ( size_t n = 0; n <= bus->rom_found; n++ )
+  {
+    /* More alarms than devices means broken search */
+    res = ow_ds18x20_search_alarm( &bus->ow, &rom_id );
+    if ( res != owOK )
+    {
+      break;
+    }
+    for ( size_t i = 0; i < bus->rom_found; i++ )
+    {
+      if ( memcmp( &rom_id, &bus->rom_ids[i], sizeof( rom_id ) ) == 0 )
+      {
+        changed[i] = true;
+        break;
+      }
+    }
+  }
+  if ( res != owERRNODEV )
+  {
+    LOG( PRINT_WARNING, "%s alarm search failed", bus->name );
+    return -1;
+  }
+
+  int read_count = 0;
+  for ( size_t i = 0; i < bus->rom_found; i++ )
+  {
+    if ( changed[i] && _read_sensor( bus, i, now_ms, now_us ) )
+    {
+      read_count++;
+    }
+  }
+  return read_count;
+}
+
+#if CONFIG_TEMPERATURE_HOTPLUG
+static void _publish_sensor_change( bus_t* bus, app_msg_id_t msg_id, const ow_rom_t* rom_id )
+{
+  temp_sensor_event_t data = { .bus = bus - ctx.buses, .sensor = -1 };
+  memcpy( data.rom, rom_id->rom, sizeof( data.rom ) );
+  for ( size_t i = 0; i < bus->rom_found; i++ )
+  {
+    if ( memcmp( rom_id, &bus->rom_ids[i], sizeof( *rom_id ) ) == 0 )
+    {
+      data.sensor = bus->first + i;
+      break;
+    }
+  }
+  LOG( PRINT_INFO, "%s: sensor %02x%02x%02x%02x%02x%02x%02x%02x %s", bus->name, data.rom[0], data.rom[1], data.rom[2], data.rom[3],
+       data.rom[4], data.rom[5], data.rom[6], data.rom[7], msg_id == MSG_ID_TEMPERATURE_SENSOR_ADDED ? "added" : "removed" );
+  AppEventPublish( msg_id, bus->fsm.task, &data, sizeof( data ) );
+}
+
+static void _registry_init( bus_t* bus )
+{
+  /* Measured sensors are known, only changes against them are published */
+  bus->registry_count = 0;
+  for ( size_t i = 0; i < bus->rom_found && i < CONFIG_TEMPERATURE_HOTPLUG_ROMS; i++ )
+  {
+    bus->registry[bus->registry_count++] = (registry_entry_t) { .rom = bus->rom_ids[i] };
+  }
+  ow_search_reset( &bus->ow );
+  bus->walk_rom = bus->ow.rom;
+  bus->walk_disrepancy = bus->ow.disrepancy;
+}
+
+static void _registry_mark( bus_t* bus, const ow_rom_t* rom_id )
+{
+  for ( size_t i = 0; i < bus->registry_count; i++ )
+  {
+    if ( memcmp( rom_id, &bus->registry[i].rom, sizeof( *rom_id ) ) == 0 )
+    {
+      bus->registry[i].seen = true;
+      return;
+    }
+  }
+  if ( bus->registry_count == CONFIG_TEMPERATURE_HOTPLUG_ROMS )
+  {
+    LOG( PRINT_WARNING, "%s: registry full", bus->name );
+    return;
+  }
+  bus->registry[bus->registry_count++] = (registry_entry_t) { .rom = *rom_id, .seen = true };
+  _publish_sensor_change( bus, MSG_ID_TEMPERATURE_SENSOR_ADDED, rom_id );
+}
+
+static void _registry_end_walk( bus_t* bus )
+{
+  /* Single missed walk can be a glitch or device removed in the middle of it */
+  for ( size_t i = 0; i < bus->registry_count; )
+  {
+    registry_entry_t* entry = &bus->registry[i];
+    entry->misses = entry->seen ? 0 : entry->misses + 1;
+    entry->seen = false;
+    if ( entry->misses < CONFIG_TEMPERATURE_HOTPLUG_MISSES )
+    {
+      i++;
+      continue;
+    }
+    ow_rom_t rom_id = entry->rom;
+    *entry = bus->registry[--bus->registry_count];
+    _publish_sensor_change( bus, MSG_ID_TEMPERATURE_SENSOR_REMOVED, &rom_id );
+  }
+}
+#endif
+
+static void _hotplug_step( bus_t* bus )
+{
+#if CONFIG_TEMPERATURE_HOTPLUG
+  /* One ROM per cycle, about 200 time slots, measured sensors are not delayed by whole search */
+  ow_rom_t rom_id;
+  bus->ow.rom = bus->walk_rom;
+  bus->ow.disrepancy = bus->walk_disrepancy;
+  owr_t res = ow_search( &bus->ow, &rom_id );
+  if ( res == owOK && ow_crc( &rom_id, sizeof( rom_id ) ) == 0 )
+  {
+    _registry_mark( bus, &rom_id );
+  }
+  else if ( res != owOK )
+  {
+    /* Last device was found, nobody answered or walk broke */
+    _registry_end_walk( bus );
+    ow_search_reset( &bus->ow );
+  }
+  bus->walk_rom = bus->ow.rom;
+  bus->walk_disrepancy = bus->ow.disrepancy;
+#endif
+}
+
+static void _publish_status( const bus_t* bus )
+{
+  uint32_t now_ms = _get_time_ms();
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  for ( size_t i = 0; i < bus->rom_found; i++ )
+  {
+    temp_sensor_status_t* status = &ctx.status.sensors[bus->first + i];
+    status->temp = bus->sensors[i].temp;
+    status->rate = bus->sensors[i].rate;
+    status->resolution = bus->sensors[i].resolution;
+    status->valid = bus->sensors[i].valid;
+    status->bus = bus - ctx.buses;
+    status->period_ms = bus->sample_period_ms;
+    status->age_ms = now_ms - bus->sensors[i].time_ms;
+    status->filtered = ctx.filters[bus->first + i].value / 1000.0f;
+    status->slope = ctx.filters[bus->first + i].slope / 1000.0f;
+    status->health = bus->sensors[i].health;
+  }
+
+  /* Snapshot merges all buses, period is the one of slowest bus */
+  float sum = 0;
+  uint32_t count = 0;
+  ctx.status.sample_period_ms = 0;
+  for ( size_t i = 0; i < ctx.status.sensors_count; i++ )
+  {
+    if ( ctx.status.sensors[i].valid )
+    {
+      sum += ctx.status.sensors[i].temp;
+      count++;
+    }
+    if ( ctx.status.sensors[i].period_ms > ctx.status.sample_period_ms )
+    {
+      ctx.status.sample_period_ms = ctx.status.sensors[i].period_ms;
+    }
+  }
+  ctx.status.avg_temp = count ? sum / count : 0;
+  if ( ctx.first_sample_ms == 0 && count > 0 )
+  {
+    ctx.first_sample_ms = _get_boot_time_ms();
+    LOG( PRINT_INFO, "First temperature %lu ms after init", (unsigned long) ctx.first_sample_ms );
+  }
+  ctx.status.first_sample_ms = ctx.first_sample_ms;
+  xSemaphoreGive( ctx.mutex );
 }
 
 /* Sate machine functions ---------------------------------------------------*/
 
 static void _state_disabled_event_init_request( const app_event_t* event )
 {
-  _change_state( INIT );
-  _send_internal_event( MSG_ID_INIT_REQ, NULL, 0 );
+  AppFsmChangeState( &fsm, INIT );
+  AppFsmPostInternal( &fsm, MSG_ID_INIT_REQ, NULL, 0 );
 }
 
 static void _state_common_event_deinit_request( const app_event_t* event )
@@ -308,19 +882,38 @@ static void _state_common_event_deinit_request( const app_event_t* event )
 static void _state_init_event_init_request( const app_event_t* event )
 {
   temp_drv_err_t err = TEMP_DRV_ERR_OK;
-  if ( owOK == ow_init( &ctx.ow, &ow_ll_drv_esp32, NULL ) )
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
   {
-    if ( _read_sensors() )
+    if ( owOK != ow_init( &ctx.buses[b].ow, &ow_ll_drv_esp32, (void*) &bus_config[b] ) )
     {
-      ctx.is_ready_to_work = _check_read_sensors();
+      err = TEMP_DRV_ERR_FAIL;
+      LOG( PRINT_ERROR, "Init one wire driver of bus %d failed", (int) b );
     }
   }
-  else
+  if ( err == TEMP_DRV_ERR_OK )
   {
-    err = TEMP_DRV_ERR_FAIL;
-    LOG( PRINT_ERROR, "Init one wire driver failed" );
+    /* Known sensors are confirmed one by one, whole buses are searched only when some is missing */
+    sensors_table_t table = {};
+    if ( _read_sensors( &table ) && _verify_sensors( &table ) )
+    {
+      ctx.is_ready_to_work = true;
+      LOG( PRINT_INFO, "%d known sensors verified in %lu ms", (int) ctx.sensors_count, (unsigned long) _get_boot_time_ms() );
+    }
+    else if ( _search_sensors() )
+    {
+      ctx.is_ready_to_work = true;
+      LOG( PRINT_INFO, "%d sensors searched in %lu ms", (int) ctx.sensors_count, (unsigned long) _get_boot_time_ms() );
+      if ( !_save_sensors() )
+      {
+        LOG( PRINT_WARNING, "Save sensors failed" );
+      }
+    }
+    if ( ctx.is_ready_to_work )
+    {
+      _mark_stale_history();
+    }
   }
-  _send_internal_event( MSG_ID_INIT_RES, &err, sizeof( err ) );
+  AppFsmPostInternal( &fsm, MSG_ID_INIT_RES, &err, sizeof( err ) );
 }
 
 static void _state_init_event_init_response( const app_event_t* event )
@@ -336,24 +929,23 @@ static void _state_init_event_init_response( const app_event_t* event )
   {
     if ( ctx.is_ready_to_work )
     {
-      _change_state( WORKING );
-      AppTimerStart( timers, TIMER_ID_MEASURE_REQ );
+      AppFsmChangeState( &fsm, WORKING );
     }
     else
     {
-      _change_state( IDLE );
+      AppFsmChangeState( &fsm, IDLE );
     }
   }
   else
   {
-    _change_state( DISABLED );
+    AppFsmChangeState( &fsm, DISABLED );
   }
 }
 
 static void _state_idle_event_scan_device_req( const app_event_t* event )
 {
-  _change_state( SCANNING );
-  _send_internal_event( MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, NULL, 0 );
+  AppFsmChangeState( &fsm, SCANNING );
+  AppFsmPostInternal( &fsm, MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, NULL, 0 );
 }
 
 static void _state_idle_event_start_measure( const app_event_t* event )
@@ -366,94 +958,301 @@ static void _state_idle_event_start_measure( const app_event_t* event )
 
 static void _state_scanning_event_scan_devices_req( const app_event_t* event )
 {
-  temp_drv_err_t err = TEMP_DRV_ERR_OK;
-  ow_rom_t scan_rom_ids[SENSORS_COUNT] = {};
-  if ( owOK == ow_search_devices( &ctx.ow, scan_rom_ids, OW_ARRAYSIZE( scan_rom_ids ), &ctx.rom_found ) )
-  {
-    temp_drv_err_t err = TEMP_DRV_ERR_FAIL;
-    LOG( PRINT_INFO, "Devices scanned, found %d devices!\r\n", (int) ctx.rom_found );
-  }
-  /* Sprawdzenie wszytkich czujników pokolei */
-  _send_internal_event( MSG_ID_TEMPERATURE_SCAN_DEVICES_RES, &err, sizeof( err ) );
+  /* Every worker stops measuring and searches own bus */
+  ctx.scans_pending = BUS_COUNT;
+  ctx.scan_err = TEMP_DRV_ERR_OK;
+  _post_to_buses( MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ );
 }
 
 static void _state_scanning_event_scan_devices_res( const app_event_t* event )
 {
-  temp_drv_err_t err = TEMP_DRV_ERR_OK;
-  AppEventGetData( event, &err, sizeof( temp_drv_err_t ) );
+  bus_result_t result = {};
+  AppEventGetData( event, &result, sizeof( result ) );
+  if ( result.err != TEMP_DRV_ERR_OK )
+  {
+    ctx.scan_err = result.err;
+  }
+  if ( ctx.scans_pending == 0 || --ctx.scans_pending > 0 )
+  {
+    return;
+  }
+
+  _assign_sensors();
+  LOG( PRINT_INFO, "Devices scanned, found %d devices on %d buses!\r\n", (int) ctx.sensors_count, (int) BUS_COUNT );
+  if ( ctx.sensors_count == 0 )
+  {
+    ctx.scan_err = TEMP_DRV_ERR_FAIL;
+  }
+
+  temp_drv_err_t err = ctx.scan_err;
   app_event_t response = {};
 
   AppEventPrepareWithData( &response, MSG_ID_APP_MANAGER_TEMP_SENSORS_SCAN_RES, APP_EVENT_TEMP_DRV, APP_EVENT_APP_MANAGER, &err, sizeof( err ) );
   AppManagerPostMsg( &response );
   if ( err == TEMP_DRV_ERR_OK )
   {
-    // _send_internal_event( MSG_ID_TEMPERATURE_MEASURE_REQ, NULL, 0 );
-    _change_state( WORKING );
+    _mark_stale_history();
+    if ( !_save_sensors() )
+    {
+      LOG( PRINT_WARNING, "Save sensors failed" );
+    }
+    // AppFsmPostInternal( &fsm, MSG_ID_TEMPERATURE_MEASURE_REQ, NULL, 0 );
+    AppFsmChangeState( &fsm, WORKING );
   }
   else
   {
-    _change_state( IDLE );
+    AppFsmChangeState( &fsm, IDLE );
+  }
+}
+
+static void _state_working_entry( void )
+{
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
+  {
+    if ( ctx.buses[b].rom_found > 0 )
+    {
+      app_event_t event = {};
+      AppEventPrepareNoData( &event, MSG_ID_TEMPERATURE_START_MEASURE, APP_EVENT_TEMP_DRV, ctx.buses[b].fsm.task );
+      AppEventPost( &event );
+    }
   }
 }
 
+static void _state_working_exit( void )
+{
+  _post_to_buses( MSG_ID_TEMPERATURE_STOP_MEASURE );
+}
+
 static void _state_working_event_scan_devices_req( const app_event_t* event )
 {
-  _change_state( SCANNING );
-  _send_internal_event( MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, NULL, 0 );
+  AppFsmChangeState( &fsm, SCANNING );
+  AppFsmPostInternal( &fsm, MSG_ID_TEMPERATURE_SCAN_DEVICES_REQ, NULL, 0 );
 }
 
 static void _state_working_event_stop_measure( const app_event_t* event )
 {
-  _change_state( IDLE );
-  AppTimerStop( timers, TIMER_ID_MEASURE_REQ );
+  AppFsmChangeState( &fsm, IDLE );
+}
+
+static void _state_working_event_bus_failed( const app_event_t* event )
+{
+  temp_bus_failed_t failed = {};
+  AppEventGetData( event, &failed, sizeof( failed ) );
+  app_event_t notify = {};
+
+  /* Failed bus keeps retrying, app manager decides about rescan */
+  LOG( PRINT_ERROR, "Bus %d failed %lu cycles", failed.bus, (unsigned long) failed.failed_cycles );
+  AppEventPrepareWithData( &notify, MSG_ID_APP_MANAGER_TEMP_BUS_FAILED, APP_EVENT_TEMP_DRV, APP_EVENT_APP_MANAGER, &failed, sizeof( failed ) );
+  AppManagerPostMsg( &notify );
 }
 
-static void _state_working_event_measure_req( const app_event_t* event )
+/* Bus worker functions -----------------------------------------------------*/
+
+static void _bus_stop( bus_t* bus )
+{
+  AppTimerStop( bus->timers, TIMER_ID_CONVERSION_DONE );
+  AppTimerStop( bus->timers, TIMER_ID_RETRY );
+  AppFsmChangeState( &bus->fsm, BUS_IDLE );
+}
+
+static void _bus_cycle_failed( bus_t* bus )
 {
-  /* Start measure */
+  /* Bus keeps measuring, driver is told once when failures don't stop */
+  bus->failed_cycles++;
+  if ( bus->failed_cycles == CONFIG_TEMPERATURE_BUS_FAIL_CYCLES )
+  {
+    temp_bus_failed_t failed = { .bus = bus - ctx.buses, .failed_cycles = bus->failed_cycles };
+    app_event_t event = {};
+    AppEventPrepareWithData( &event, MSG_ID_TEMPERATURE_BUS_FAILED, bus->fsm.task, APP_EVENT_TEMP_DRV, &failed, sizeof( failed ) );
+    AppEventPost( &event );
+  }
+  AppTimerStart( bus->timers, TIMER_ID_RETRY );
+}
+
+static void _bus_common_event_scan_devices_req( const app_event_t* event )
+{
+  bus_t* bus = _get_bus( event );
   temp_drv_err_t err = TEMP_DRV_ERR_OK;
-  app_event_t response = {};
 
-  AppEventPrepareWithData( &response, MSG_ID_APP_MANAGER_TEMP_SENSORS_SCAN_RES, APP_EVENT_TEMP_DRV, APP_EVENT_APP_MANAGER, &err, sizeof( err ) );
-  AppManagerPostMsg( &response );
+  _bus_stop( bus );
+  if ( owOK != ow_search_devices( &bus->ow, bus->rom_ids, OW_ARRAYSIZE( bus->rom_ids ), &bus->rom_found ) )
+  {
+    bus->rom_found = 0;
+    err = TEMP_DRV_ERR_FAIL;
+  }
+  LOG( PRINT_INFO, "%s scanned, found %d devices!\r\n", bus->name, (int) bus->rom_found );
+  _post_bus_result( bus, MSG_ID_TEMPERATURE_SCAN_DEVICES_RES, err );
+}
 
-  if ( err == TEMP_DRV_ERR_OK )
+static void _bus_idle_event_start_measure( const app_event_t* event )
+{
+  bus_t* bus = _get_bus( event );
+  for ( size_t i = 0; i < bus->rom_found; i++ )
   {
-    AppTimerStart( timers, TIMER_ID_MEASURE_REQ );
+    bus->sensors[i].valid = false;
+    bus->sensors[i].rate = 0;
+    bus->sensors[i].alarm_set = false;
+    _set_resolution( bus, i, CONFIG_TEMPERATURE_RESOLUTION );
+    if ( bus->history_stale & ( 1UL << i ) )
+    {
+      TempHistoryClear( bus->first + i );
+    }
   }
-  else
+  bus->history_stale = 0;
+  bus->cycle_start_ms = _get_time_ms();
+  bus->cycles_to_full = 0;
+  bus->failed_cycles = 0;
+#if CONFIG_TEMPERATURE_HOTPLUG
+  _registry_init( bus );
+#endif
+  AppFsmChangeState( &bus->fsm, BUS_MEASURING );
+  AppFsmPostInternal( &bus->fsm, MSG_ID_TEMPERATURE_MEASURE_REQ, NULL, 0 );
+}
+
+static void _bus_measuring_event_stop_measure( const app_event_t* event )
+{
+  _bus_stop( _get_bus( event ) );
+}
+
+static void _bus_measuring_event_measure_req( const app_event_t* event )
+{
+  bus_t* bus = _get_bus( event );
+
+  /* One skip ROM command starts conversion on all sensors of bus, result is read when conversion time passed */
+  uint32_t now_ms = _get_time_ms();
+  bus->sample_period_ms = now_ms - bus->cycle_start_ms;
+  bus->cycle_start_ms = now_ms;
+  if ( ow_ds18x20_start( &bus->ow, NULL ) == 0 )
   {
-    _change_state( IDLE );
+    LOG( PRINT_ERROR, "%s start conversion failed", bus->name );
+    _bus_cycle_failed( bus );
+    return;
   }
+
+  bus->timers[TIMER_ID_CONVERSION_DONE].timeout_ms = _get_conversion_time_ms( bus );
+  AppTimerStart( bus->timers, TIMER_ID_CONVERSION_DONE );
 }
 
-static void _event_task( void* pv )
+static void _bus_measuring_event_conversion_done( const app_event_t* event )
 {
-  while ( 1 )
+  bus_t* bus = _get_bus( event );
+  uint32_t now_ms = _get_time_ms();
+  int64_t now_us = _get_time_us();
+  int read_count = -1;
+
+  if ( !_is_full_read( bus ) )
+  {
+    read_count = _read_changed( bus, now_ms, now_us );
+    bus->cycles_to_full--;
+  }
+  if ( read_count < 0 )
   {
-    app_event_t event = { 0 };
-    if ( xQueueReceive( ctx.queue, &( event ), portMAX_DELAY ) == pdPASS )
+    /* Sensor with missed alarm gets fresh value at latest with full read */
+    read_count = 0;
+    for ( size_t i = 0; i < bus->rom_found; i++ )
     {
-      AppEventSearchAndExecute( &event, drv_state[ctx.state].event_handler_array, drv_state[ctx.state].event_handler_array_size );
-      AppEventDelete( &event );
+      if ( _read_sensor( bus, i, now_ms, now_us ) )
+      {
+        read_count++;
+      }
     }
+    if ( read_count == 0 )
+    {
+      _bus_cycle_failed( bus );
+      return;
+    }
+    bus->cycles_to_full = CONFIG_TEMPERATURE_FULL_READ_CYCLES - 1;
+  }
+
+  if ( bus->failed_cycles >= CONFIG_TEMPERATURE_BUS_FAIL_CYCLES )
+  {
+    LOG( PRINT_INFO, "%s recovered after %lu failed cycles", bus->name, (unsigned long) bus->failed_cycles );
   }
+  bus->failed_cycles = 0;
+
+  /* New resolution takes effect with next conversion, so measure period follows it */
+  for ( size_t i = 0; i < bus->rom_found; i++ )
+  {
+    uint8_t bits = _select_resolution( &bus->sensors[i] );
+    if ( bus->sensors[i].valid && bits != bus->sensors[i].resolution )
+    {
+      _set_resolution( bus, i, bits );
+    }
+  }
+  _publish_status( bus );
+  _hotplug_step( bus );
+  AppFsmPostInternal( &bus->fsm, MSG_ID_TEMPERATURE_MEASURE_REQ, NULL, 0 );
 }
 
 /* Public functions -----------------------------------------------------------*/
 
 void TemperaturePostMsg( app_event_t* event )
 {
-  if ( xQueueSend( ctx.queue, (void*) event, 0 ) != pdPASS )
+  AppEventPost( event );
+}
+
+void TemperatureGetStatus( temp_status_t* status )
+{
+  assert( status );
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  *status = ctx.status;
+  xSemaphoreGive( ctx.mutex );
+}
+
+void TemperatureSetThresholds( const float* thresholds, uint32_t count )
+{
+  assert( thresholds || count == 0 );
+  assert( count <= TEMP_THRESHOLDS_COUNT );
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  memcpy( ctx.thresholds, thresholds, count * sizeof( float ) );
+  ctx.thresholds_count = count;
+  xSemaphoreGive( ctx.mutex );
+}
+
+bool TemperatureSetFilter( int sensor, const signal_filter_stage_t* stages, size_t count )
+{
+  if ( sensor >= SENSORS_COUNT || !SignalFilterIsValid( stages, count ) )
   {
-    assert( 0 );
+    return false;
   }
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  for ( size_t i = 0; i < SENSORS_COUNT; i++ )
+  {
+    if ( sensor < 0 || i == sensor )
+    {
+      SignalFilterInit( &ctx.filters[i], stages, count );
+    }
+  }
+  xSemaphoreGive( ctx.mutex );
+  return true;
 }
 
 void TemperatureInit( void )
 {
-  ctx.queue = xQueueCreate( 8, sizeof( app_event_t ) );
-  assert( ctx.queue );
-  AppTimersInit( timers, TIMER_ID_LAST );
-  xTaskCreate( _event_task, "temperature", 3072, NULL, NORMALPRIOR, NULL );
+  ctx.init_time_us = _get_time_us();
+  ctx.mutex = xSemaphoreCreateMutex();
+  assert( ctx.mutex );
+  TempHistoryInit();
+  AppFsmInit( &fsm );
+
+  /* Bus I/O blocks until UART transfer is done, so every bus has own task */
+  for ( size_t b = 0; b < BUS_COUNT; b++ )
+  {
+    bus_t* bus = &ctx.buses[b];
+    snprintf( bus->name, sizeof( bus->name ), "temp_bus%d", (int) b );
+    bus->fsm = (app_fsm_t) {
+      .name = bus->name,
+      .task = APP_EVENT_TEMP_BUS_0 + b,
+      .queue_length = 4,
+      .worker = APP_FSM_OWN_TASK,
+      .stack_size = 3072,
+      .states = bus_state,
+      .states_count = BUS_STATE_TOP,
+    };
+    memcpy( bus->timers, bus_timers, sizeof( bus_timers ) );
+    AppFsmInit( &bus->fsm );
+    AppTimersInit( bus->fsm.task, bus->timers, TIMER_ID_LAST );
+    AppFsmStart( &bus->fsm );
+  }
+  AppFsmStart( &fsm );
 }
@@ -14,9 +14,11 @@
 #include <stdbool.h>
 
 #include "app_events.h"
+#include "signal_filter.h"
 
 /* Public macro --------------------------------------------------------------*/
-#define TEMP_NUMBER_OF_SENSORS
+#define TEMP_NUMBER_OF_SENSORS 5
+#define TEMP_THRESHOLDS_COUNT  2
 
 /* Public types --------------------------------------------------------------*/
 
@@ -33,6 +35,54 @@ typedef struct
   uint32_t rom[TEMP_NUMBER_OF_SENSORS];
 }temp_drv_scan_response;
 
+/** @brief  Data of published MSG_ID_TEMPERATURE_SENSOR_ADDED and MSG_ID_TEMPERATURE_SENSOR_REMOVED */
+typedef struct
+{
+  uint8_t bus;
+  uint8_t rom[8];
+  int8_t sensor; /* Index of measured sensor, -1 when ROM is not measured */
+} temp_sensor_event_t;
+
+/** @brief  Data of MSG_ID_APP_MANAGER_TEMP_BUS_FAILED, sent once when bus had no valid read
+ *          for CONFIG_TEMPERATURE_BUS_FAIL_CYCLES cycles in a row */
+typedef struct
+{
+  uint8_t bus;
+  uint32_t failed_cycles;
+} temp_bus_failed_t;
+
+/** @brief  Bus health of sensor, counted since sensor was assigned to its index */
+typedef struct
+{
+  uint32_t crc_errors;
+  uint32_t presence_errors;
+  uint32_t retries;
+  uint32_t last_good_ms; /* Tick time of last valid read, 0 until read */
+} temp_sensor_health_t;
+
+typedef struct
+{
+  float temp;
+  float rate;
+  uint8_t resolution;
+  uint8_t bus;
+  bool valid;
+  uint32_t period_ms;
+  uint32_t age_ms; /* Time since sensor was read, cached value in monitoring mode */
+  float filtered;  /* Output of sensor filter chain */
+  float slope;     /* C/s, 0 without slope stage in chain */
+  temp_sensor_health_t health;
+} temp_sensor_status_t;
+
+typedef struct
+{
+  float avg_temp;
+  uint32_t sample_period_ms;
+  uint32_t sensors_count;
+  uint32_t first_sample_ms; /* Time from driver init to first temperature, 0 until measured */
+  temp_sensor_status_t sensors[TEMP_NUMBER_OF_SENSORS];
+} temp_status_t;
+
 
 /* Public functions ----------------------------------------------------------*/
 
@@ -46,4 +96,30 @@ void TemperatureInit( void );
  */
 void TemperaturePostMsg( app_event_t* event );
 
+/**
+ * @brief   Get last measurement of all sensors.
+ * @param   [out] status - measured temperatures, rate of change in C/s, resolution
+ *          and sample period of sensor bus. Sample period of snapshot is the
+ *          period of slowest bus.
+ */
+void TemperatureGetStatus( temp_status_t* status );
+
+/**
+ * @brief   Set temperatures where sensors need full resolution. Sensor close
+ *          to threshold measures with 12 bits regardless of rate of change.
+ * @param   [in] thresholds - thresholds in C.
+ * @param   [in] count - number of thresholds, up to TEMP_THRESHOLDS_COUNT.
+ */
+void TemperatureSetThresholds( const float* thresholds, uint32_t count );
+
+/**
+ * @brief   Set filter chain of sensor, samples are filtered in m'C.
+ *          State of filter starts over.
+ * @param   [in] sensor - sensor index, negative sets all sensors.
+ * @param   [in] stages - filter stages in order.
+ * @param   [in] count - number of stages, 0 disables filtering.
+ * @return  false - invalid sensor or stages
+ */
+bool TemperatureSetFilter( int sensor, const signal_filter_stage_t* stages, size_t count );
+
 #endif
\ No newline at end of file
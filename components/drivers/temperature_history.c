@@ -0,0 +1,147 @@
+/**
+ *******************************************************************************
+ * @file    temperature_history.c
+ * @author  Dmytro Shevchenko
+ * @brief   History of temperature samples. Bus worker of sensor is only writer,
+ *          readers (API, telemetry) copy samples without lock and check with sequence
+ *          counter, that writer didn't overwrite them meanwhile.
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "temperature_history.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "temperature.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define HISTORY_MASK ( TEMP_HISTORY_SIZE - 1 )
+
+_Static_assert( ( TEMP_HISTORY_SIZE & HISTORY_MASK ) == 0, "History size must be power of 2" );
+_Static_assert( sizeof( temp_history_sample_t ) == 10, "Sample must not be padded" );
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  temp_history_sample_t samples[TEMP_HISTORY_SIZE];
+
+  /* Sample n is kept in samples[n & HISTORY_MASK]. Samples below count are
+   * complete, claimed is raised before writer overwrites slot. */
+  uint32_t count;
+  uint32_t claimed;
+  uint32_t first;
+} history_t;
+
+/* Private variables ---------------------------------------------------------*/
+static history_t history[TEMP_NUMBER_OF_SENSORS];
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint32_t _get_oldest( const history_t* h, uint32_t count )
+{
+  uint32_t first = __atomic_load_n( &h->first, __ATOMIC_RELAXED );
+  return count - first > TEMP_HISTORY_SIZE ? count - TEMP_HISTORY_SIZE : first;
+}
+
+static bool _read_sample( const history_t* h, uint32_t n, temp_history_sample_t* sample )
+{
+  *sample = h->samples[n & HISTORY_MASK];
+  __atomic_thread_fence( __ATOMIC_ACQUIRE );
+
+  /* Writing sample n + TEMP_HISTORY_SIZE makes copy possibly torn */
+  return __atomic_load_n( &h->claimed, __ATOMIC_RELAXED ) - n <= TEMP_HISTORY_SIZE;
+}
+
+static uint32_t _find_first( const history_t* h, uint32_t lo, uint32_t hi, int64_t from_us )
+{
+  temp_history_sample_t sample;
+  while ( lo != hi )
+  {
+    uint32_t mid = lo + ( hi - lo ) / 2;
+    if ( !_read_sample( h, mid, &sample ) || sample.time_us < from_us )
+    {
+      /* Overwritten sample was older than all kept */
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void TempHistoryInit( void )
+{
+  memset( history, 0, sizeof( history ) );
+}
+
+void TempHistoryClear( uint32_t sensor )
+{
+  assert( sensor < TEMP_NUMBER_OF_SENSORS );
+  __atomic_store_n( &history[sensor].first, history[sensor].count, __ATOMIC_RELAXED );
+}
+
+void TempHistoryAdd( uint32_t sensor, int64_t time_us, int16_t temp )
+{
+  assert( sensor < TEMP_NUMBER_OF_SENSORS );
+  history_t* h = &history[sensor];
+  uint32_t n = h->count;
+
+  __atomic_store_n( &h->claimed, n + 1, __ATOMIC_RELAXED );
+  __atomic_thread_fence( __ATOMIC_RELEASE );
+  h->samples[n & HISTORY_MASK].time_us = time_us;
+  h->samples[n & HISTORY_MASK].temp = temp;
+  __atomic_store_n( &h->count, n + 1, __ATOMIC_RELEASE );
+}
+
+uint32_t TempHistoryRead( uint32_t sensor, int64_t from_us, int64_t to_us, int64_t step_us, temp_history_cb cb, void* user_data )
+{
+  assert( sensor < TEMP_NUMBER_OF_SENSORS );
+  assert( cb );
+  const history_t* h = &history[sensor];
+  uint32_t count = __atomic_load_n( &h->count, __ATOMIC_ACQUIRE );
+  uint32_t reported = 0;
+  int64_t next_us = from_us;
+
+  for ( uint32_t n = _find_first( h, _get_oldest( h, count ), count, from_us ); n != count; n++ )
+  {
+    temp_history_sample_t sample;
+    if ( !_read_sample( h, n, &sample ) )
+    {
+      continue;
+    }
+    if ( sample.time_us > to_us )
+    {
+      break;
+    }
+    if ( sample.time_us < next_us )
+    {
+      continue;
+    }
+    if ( step_us > 0 )
+    {
+      next_us = sample.time_us - ( sample.time_us - from_us ) % step_us + step_us;
+    }
+
+    if ( !cb( &sample, user_data ) )
+    {
+      break;
+    }
+    reported++;
+  }
+  return reported;
+}
+
+uint32_t TempHistoryGetCount( uint32_t sensor )
+{
+  assert( sensor < TEMP_NUMBER_OF_SENSORS );
+  const history_t* h = &history[sensor];
+  uint32_t count = __atomic_load_n( &h->count, __ATOMIC_ACQUIRE );
+  return count - _get_oldest( h, count );
+}
@@ -0,0 +1,84 @@
+/**
+ *******************************************************************************
+ * @file    temperature_history.h
+ * @author  Dmytro Shevchenko
+ * @brief   History of temperature samples, ring buffer per sensor
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+
+#ifndef _TEMPERATURE_HISTORY_H_
+#define _TEMPERATURE_HISTORY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+/* Public macro --------------------------------------------------------------*/
+#define TEMP_HISTORY_SIZE CONFIG_TEMPERATURE_HISTORY_SIZE
+
+/** @brief  Temperature in C to fixed point 1/16 C, native DS18B20 resolution */
+#define TEMP_HISTORY_FROM_C( _temp ) ( (int16_t) ( ( _temp ) * 16.0f + ( ( _temp ) < 0 ? -0.5f : 0.5f ) ) )
+#define TEMP_HISTORY_TO_C( _temp )   ( ( _temp ) / 16.0f )
+
+/* Public types --------------------------------------------------------------*/
+/** @brief  Packed, ring keeps 10 bytes per sample instead of 16 */
+typedef struct __attribute__( ( __packed__ ) )
+{
+  int64_t time_us;
+  int16_t temp;
+} temp_history_sample_t;
+
+/**
+ * @brief   Called for every sample of range in time order.
+ * @return  false - to stop reading
+ */
+typedef bool ( *temp_history_cb )( const temp_history_sample_t* sample, void* user_data );
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @brief   Clear history of all sensors.
+ */
+void TempHistoryInit( void );
+
+/**
+ * @brief   Drop samples of sensor, e.g. when other device took its place.
+ *          Must be called by writer, bus worker of sensor.
+ * @param   [in] sensor - sensor index.
+ */
+void TempHistoryClear( uint32_t sensor );
+
+/**
+ * @brief   Add sample, oldest sample is overwritten when history is full.
+ *          Single writer, doesn't block readers.
+ * @param   [in] sensor - sensor index.
+ * @param   [in] time_us - monotonic time of sample, not older than previous one.
+ * @param   [in] temp - temperature in 1/16 C.
+ */
+void TempHistoryAdd( uint32_t sensor, int64_t time_us, int16_t temp );
+
+/**
+ * @brief   Read samples of time range straight from history without lock.
+ *          Sample overwritten while reading is skipped, samples added
+ *          after call started are not reported.
+ * @param   [in] sensor - sensor index.
+ * @param   [in] from_us - start of range, inclusive.
+ * @param   [in] to_us - end of range, inclusive.
+ * @param   [in] step_us - report first sample of every step_us from from_us,
+ *          0 reports all samples.
+ * @param   [in] cb - called for every reported sample.
+ * @param   [in] user_data - passed to cb.
+ * @return  number of samples passed to cb
+ */
+uint32_t TempHistoryRead( uint32_t sensor, int64_t from_us, int64_t to_us, int64_t step_us, temp_history_cb cb, void* user_data );
+
+/**
+ * @brief   Get number of samples kept for sensor.
+ * @param   [in] sensor - sensor index.
+ * @return  number of samples
+ */
+uint32_t TempHistoryGetCount( uint32_t sensor );
+
+#endif
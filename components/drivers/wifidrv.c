@@ -12,6 +12,7 @@
 
 #include "app_config.h"
 #include "app_events.h"
+#include "app_fsm.h"
 #include "app_timers.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
@@ -37,14 +38,14 @@
 /* Private types -------------------------------------------------------------*/
 
 /** @brief  Array with defined states */
-#define STATE_HANDLER_ARRAY                             \
-  STATE( DISABLED, _wifi_disabled_state_handler_array ) \
-  STATE( IDLE, _wifi_idle_state_handler_array )
+#define STATE_HANDLER_ARRAY                                         \
+  STATE( DISABLED, _wifi_disabled_state_handler_array, NULL, NULL ) \
+  STATE( IDLE, _wifi_idle_state_handler_array, NULL, NULL )
 
 /** @brief  Private types */
 typedef enum
 {
-#define STATE( _state, _event_handler_array ) _state,
+#define STATE APP_FSM_STATE_ENUM
   STATE_HANDLER_ARRAY
 #undef STATE
     STATE_TOP,
@@ -52,7 +53,6 @@ typedef enum
 
 typedef struct
 {
-  wifi_drv_state_t state;
   wifiType_t type;
   int retry;
   bool is_power_save;
@@ -64,7 +64,6 @@ typedef struct
   uint32_t reason_disconnect;
   wifiConData_t wifi_con_data;
   int8_t rssi;
-  QueueHandle_t queue;
 } wifi_drv_ctx_t;
 
 typedef enum
@@ -79,9 +78,6 @@ typedef enum
 static wifi_drv_ctx_t ctx;
 
 /* Private functions declaration ---------------------------------------------*/
-static void _timeout_connect_cb( TimerHandle_t xTimer );
-static void _update_wifi_info_cb( TimerHandle_t xTimer );
-
 static void _state_common_event_deinit_request( const app_event_t* event );
 
 static void _state_disabled_event_init_request( const app_event_t* event );
@@ -89,69 +85,40 @@ static void _state_disabled_event_init_request( const app_event_t* event );
 static void _state_idle_event_update_wifi_info( const app_event_t* event );
 
 /* Status callbacks declaration. ---------------------------------------------*/
-static const struct app_events_handler _wifi_disabled_state_handler_array[] =
+static const app_events_handler_table_t _wifi_disabled_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_INIT_REQ, _state_disabled_event_init_request ),
 };
 
-static const struct app_events_handler _wifi_idle_state_handler_array[] =
+static const app_events_handler_table_t _wifi_idle_state_handler_array =
   {
     EVENT_ITEM( MSG_ID_WIFI_UPDATE_WIFI_INFO, _state_idle_event_update_wifi_info ),
     EVENT_ITEM( MSG_ID_DEINIT_REQ, _state_common_event_deinit_request ),
 };
 
-struct state_context
-{
-  const wifi_drv_state_t state;
-  const char* name;
-  const struct app_events_handler* event_handler_array;
-  uint8_t event_handler_array_size;
-};
-
-static const struct state_context wifi_drv_state[STATE_TOP] =
+static const app_fsm_state_t wifi_drv_state[STATE_TOP] =
   {
-#define STATE( _state, _event_handler_array )    \
-  {                                              \
-    .state = _state,                             \
-    .name = #_state,                             \
-    .event_handler_array = _event_handler_array, \
-    .event_handler_array_size = ARRAY_SIZE( _event_handler_array ) },
+#define STATE APP_FSM_STATE_ITEM
     STATE_HANDLER_ARRAY
 #undef STATE
 };
 
-static app_timer_t timers[] =
+static app_fsm_t fsm =
   {
-    TIMER_ITEM( TIMER_ID_UPDATE_WIFI_INFO, _update_wifi_info_cb, 1000, "WiFiUpdate" ) };
-
-/* Private functions ---------------------------------------------------------*/
-
-/** @brief  States functions. */
-static const char* _get_state_name( const wifi_drv_state_t state )
-{
-  return wifi_drv_state[state].name;
-}
-
-static void _change_state( wifi_drv_state_t new_state )
-{
-  LOG( PRINT_INFO, "State: %s -> %s", _get_state_name( ctx.state ), _get_state_name( new_state ) );
-  ctx.state = new_state;
-}
+    .name = "wifi_event_task",
+    .task = APP_EVENT_WIFI_DRV,
+    .queue_length = 8,
+    .worker = APP_EXECUTOR_WORKER_CONTROL,
+    .stack_size = CONFIG_TCPIP_EVENT_THD_WA_SIZE,
+    .states = wifi_drv_state,
+    .states_count = STATE_TOP,
+};
 
-static void _send_internal_event( app_msg_id_t id, const void* data, uint32_t data_size )
-{
-  app_event_t event = {};
-  if ( data_size == 0 )
-  {
-    AppEventPrepareNoData( &event, id, APP_EVENT_WIFI_DRV, APP_EVENT_WIFI_DRV );
-  }
-  else
+static app_timer_t timers[] =
   {
-    AppEventPrepareWithData( &event, id, APP_EVENT_WIFI_DRV, APP_EVENT_WIFI_DRV, data, data_size );
-  }
+    TIMER_ITEM( TIMER_ID_UPDATE_WIFI_INFO, MSG_ID_WIFI_UPDATE_WIFI_INFO, 1000, "WiFiUpdate" ) };
 
-  WifiDrvPostMsg( &event );
-}
+/* Private functions ---------------------------------------------------------*/
 
 static void _wifi_get_ip_address_cb(void * arg)
 {
@@ -169,11 +136,6 @@ static void _wifi_get_disconnected_cb(void * arg)
   NetworkManagerPostMsg( &response );
 }
 
-static void _update_wifi_info_cb( TimerHandle_t xTimer )
-{
-  _send_internal_event( MSG_ID_WIFI_UPDATE_WIFI_INFO, NULL, 0 );
-}
-
 /* Sate machine functions ---------------------------------------------------*/
 
 static void _state_disabled_event_init_request( const app_event_t* event )
@@ -186,7 +148,7 @@ static void _state_disabled_event_init_request( const app_event_t* event )
   app_event_t response = { 0 };
   AppEventPrepareWithData( &response, MSG_ID_INIT_RES, APP_EVENT_WIFI_DRV, APP_EVENT_NETWORK_MANAGER, &err, sizeof( err ) );
   NetworkManagerPostMsg( &response );
-  _change_state( IDLE );
+  AppFsmChangeState( &fsm, IDLE );
 }
 
 static void _state_idle_event_update_wifi_info( const app_event_t* event )
@@ -198,38 +160,21 @@ static void _state_idle_event_update_wifi_info( const app_event_t* event )
 static void _state_common_event_deinit_request( const app_event_t* event )
 {
   assert( WiFiDeinit() == WIFI_ERR_OK );
-  _change_state( DISABLED );
-}
-
-static void wifi_event_task( void* pv )
-{
-  while ( 1 )
-  {
-    app_event_t event = { 0 };
-    if ( xQueueReceive( ctx.queue, &( event ), portMAX_DELAY ) == pdPASS )
-    {
-      AppEventSearchAndExecute( &event, wifi_drv_state[ctx.state].event_handler_array, wifi_drv_state[ctx.state].event_handler_array_size );
-      AppEventDelete( &event );
-    }
-  }
+  AppFsmChangeState( &fsm, DISABLED );
 }
 
 /* Public functions -----------------------------------------------------------*/
 
 void WifiDrvPostMsg( app_event_t* event )
 {
-  if ( xQueueSend( ctx.queue, (void*) event, 0 ) != pdPASS )
-  {
-    assert( 0 );
-  }
+  AppEventPost( event );
 }
 
 void wifiDrvInit( wifiType_t type )
 {
   assert( type < WIFI_TYPE_LAST );
   ctx.type = type;
-  ctx.queue = xQueueCreate( 8, sizeof( app_event_t ) );
-  assert( ctx.queue );
-  AppTimersInit( timers, TIMER_ID_LAST );
-  xTaskCreate( wifi_event_task, "wifi_event_task", CONFIG_TCPIP_EVENT_THD_WA_SIZE, NULL, NORMALPRIOR, NULL );
+  AppFsmInit( &fsm );
+  AppTimersInit( APP_EVENT_WIFI_DRV, timers, TIMER_ID_LAST );
+  AppFsmStart( &fsm );
 }
@@ -15,6 +15,7 @@
 #include "driver/uart.h"
 #include "esp_log.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "hal/uart_hal.h"
 #include "hal/uart_ll.h"
 
@@ -45,90 +46,112 @@
     .source_clk = UART_SCLK_APB,           \
   }
 
-#define OW_UART_NUM      UART_NUM_1
-#define OW_UART_TXD      GPIO_NUM_37
-#define OW_UART_RXD      GPIO_NUM_18
 #define OW_9600_BAUDRATE 9600
-#define OW_UNUSED( x )   ( (void) ( x ) ) /*!< Unused variable macro */
+
+/* Whole transfer is preloaded to FIFO, longer transfers are split into chunks.
+ * RX full threshold field is 7 bits wide, so chunk is one byte less than FIFO. */
+#define OW_UART_CHUNK_SIZE ( UART_LL_FIFO_DEF_LEN - 1 )
+
+/* Time of transfer, 10 UART bits per byte, with margin for interrupt latency */
+#define OW_TRANSFER_TIMEOUT( _len, _baud ) ( pdMS_TO_TICKS( ( ( _len ) * 10 * 1000 ) / ( _baud ) + 1 ) + 2 )
 
 /* Private types -------------------------------------------------------------*/
 typedef struct
 {
+  uart_port_t uart_num;
   uart_dev_t* dev;
   uint32_t rx_fifo_addr;
   uint32_t tx_fifo_addr;
   uint32_t last_baud_rate;
   intr_handle_t handle_ow_uart;
-  int tx_pin;
-  int rx_pin;
 
-  uint8_t* tx;
+  /* Shared with interrupt, changed only under lock */
+  portMUX_TYPE lock;
   uint8_t* rx;
   size_t len;
-  size_t rx_len;
-  size_t tx_len;
-  bool tx_done;
-  bool rx_done;
+  volatile size_t rx_len;
+  volatile bool rx_done;
+  TaskHandle_t waiting_task;
 } ow_ctx_t;
 
 /* Private variables ---------------------------------------------------------*/
-static ow_ctx_t ctx = {
-  .rx_pin = OW_UART_RXD,
-  .tx_pin = OW_UART_TXD };
+/* Context of bus is selected by UART, so independent buses transfer in parallel */
+static ow_ctx_t ow_ctx[UART_NUM_MAX];
 
 /* Private functions ---------------------------------------------------------*/
+static ow_ctx_t* _get_ctx( void* arg )
+{
+  const ow_uart_config_t* config = arg;
+  assert( config && config->uart_num < UART_NUM_MAX );
+  return &ow_ctx[config->uart_num];
+}
+
 static void IRAM_ATTR _uart_intr_handle( void* arg )
 {
-  uint16_t _len = uart_ll_get_rxfifo_len( ctx.dev );
-  uint32_t uart_intr_status = uart_ll_get_intsts_mask( ctx.dev );
-  if ( uart_intr_status & UART_INTR_TX_DONE )
-  {
-    if ( ctx.tx_len == ctx.len )
-    {
-      ctx.tx_done = true;
-    }
-    else
-    {
-      WRITE_PERI_REG( ctx.tx_fifo_addr, ctx.tx[ctx.tx_len] );
-      ctx.tx_len++;
-    }
-    uart_clear_intr_status( OW_UART_NUM, UART_INTR_TX_DONE );
-  }
+  ow_ctx_t* ctx = arg;
+  BaseType_t task_woken = pdFALSE;
+  uint16_t _len = uart_ll_get_rxfifo_len( ctx->dev );
+  uint32_t uart_intr_status = uart_ll_get_intsts_mask( ctx->dev );
   if ( uart_intr_status & UART_INTR_RXFIFO_FULL )
   {
-    while ( _len && ( ctx.rx_done == false ) && ctx.rx_len < ctx.len )
+    portENTER_CRITICAL_ISR( &ctx->lock );
+    while ( _len && ( ctx->rx_done == false ) && ctx->rx_len < ctx->len )
     {
-      ctx.rx[ctx.rx_len] = READ_PERI_REG( ctx.rx_fifo_addr );
-      ctx.rx_len++;
+      ctx->rx[ctx->rx_len] = READ_PERI_REG( ctx->rx_fifo_addr );
+      ctx->rx_len++;
       _len -= 1;
     }
-    if ( ctx.rx_len == ctx.len )
+    if ( ctx->rx_len == ctx->len && ctx->rx_done == false )
     {
-      ctx.rx_done = true;
+      ctx->rx_done = true;
+      vTaskNotifyGiveFromISR( ctx->waiting_task, &task_woken );
     }
-    uart_clear_intr_status( OW_UART_NUM, UART_INTR_RXFIFO_FULL );
+    portEXIT_CRITICAL_ISR( &ctx->lock );
+    uart_clear_intr_status( ctx->uart_num, UART_INTR_RXFIFO_FULL );
+  }
+  if ( task_woken == pdTRUE )
+  {
+    portYIELD_FROM_ISR();
   }
 }
 
-/* Public functions ---------------------------------------------------------*/
-void OWUart_SetPin( int rx, int tx )
+static uint8_t _transfer_chunk( ow_ctx_t* ctx, const uint8_t* tx, uint8_t* rx, size_t len )
 {
-  ctx.tx_pin = tx;
-  ctx.rx_pin = rx;
+  uart_ll_rxfifo_rst( ctx->dev );
+  ctx->rx = rx;
+  ctx->len = len;
+  ctx->rx_len = 0;
+  ctx->waiting_task = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake( pdTRUE, 0 );
+
+  /* Interrupt comes once, when echo of last byte is received */
+  uart_ll_set_rxfifo_full_thr( ctx->dev, len );
+  uart_clear_intr_status( ctx->uart_num, UART_INTR_RXFIFO_FULL );
+  ctx->rx_done = false;
+  for ( size_t i = 0; i < len; i++ )
+  {
+    WRITE_PERI_REG( ctx->tx_fifo_addr, tx[i] );
+  }
+
+  if ( ulTaskNotifyTake( pdTRUE, OW_TRANSFER_TIMEOUT( len, ctx->last_baud_rate ) ) == 0 )
+  {
+    /* Interrupt can still be receiving, after rx_done under lock it leaves buffer alone */
+    portENTER_CRITICAL( &ctx->lock );
+    ctx->rx_done = true;
+    size_t rx_len = ctx->rx_len;
+    portEXIT_CRITICAL( &ctx->lock );
+
+    /* Missing echo reads as released bus, so library sees no presence */
+    memmove( &rx[rx_len], &tx[rx_len], len - rx_len );
+    LOG( PRINT_ERROR, "UART%d transfer timeout, received %d of %d", ctx->uart_num, (int) rx_len, (int) len );
+    return 0;
+  }
+  return 1;
 }
 
-uint8_t OWUart_init( void* arg )
+/* Public functions ---------------------------------------------------------*/
+void OWUart_BoardInit( void )
 {
-  ctx.dev = UART_LL_GET_HW( OW_UART_NUM );
-  ctx.last_baud_rate = OW_9600_BAUDRATE;
-  ctx.rx = 0x00;
-  ctx.handle_ow_uart = NULL;
-  ctx.tx_done = true;
-  ctx.rx_done = true;
-  assert( ctx.tx_done );
-  assert( ctx.rx_done );
-  uart_config_t uart_config = OW_UART_CONFIG( ctx.last_baud_rate );
-
   ///////////////////////
   //zero-initialize the config structure.
   gpio_config_t io_conf = {};
@@ -149,62 +172,66 @@ uint8_t OWUart_init( void* arg )
   gpio_set_level( 34, 0 );
   gpio_set_level( 33, 0 );
   ///////////////////////
+}
 
-  OW_ERROR_CHECK( uart_param_config( OW_UART_NUM, &uart_config ) );
-  OW_ERROR_CHECK( uart_set_pin( OW_UART_NUM, OW_UART_TXD, OW_UART_RXD, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE ) );
-
-  uart_ll_ena_intr_mask( ctx.dev, UART_INTR_TX_DONE | UART_INTR_RXFIFO_FULL );
-  int ret = esp_intr_alloc( uart_periph_signal[OW_UART_NUM].irq, ESP_INTR_FLAG_LOWMED | ESP_INTR_FLAG_IRAM, _uart_intr_handle, NULL, &ctx.handle_ow_uart );
+uint8_t OWUart_init( void* arg )
+{
+  const ow_uart_config_t* config = arg;
+  ow_ctx_t* ctx = _get_ctx( arg );
+  ctx->uart_num = config->uart_num;
+  ctx->dev = UART_LL_GET_HW( ctx->uart_num );
+  ctx->last_baud_rate = OW_9600_BAUDRATE;
+  ctx->rx = 0x00;
+  portMUX_INITIALIZE( &ctx->lock );
+  ctx->handle_ow_uart = NULL;
+  ctx->rx_done = true;
+  ctx->rx_fifo_addr = UART_FIFO_AHB_REG( ctx->uart_num );
+  ctx->tx_fifo_addr = UART_FIFO_AHB_REG( ctx->uart_num );
+  uart_config_t uart_config = OW_UART_CONFIG( ctx->last_baud_rate );
+
+  OW_ERROR_CHECK( uart_param_config( ctx->uart_num, &uart_config ) );
+  OW_ERROR_CHECK( uart_set_pin( ctx->uart_num, config->tx_pin, config->rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE ) );
+
+  uart_ll_set_rxfifo_full_thr( ctx->dev, 1 );
+  uart_ll_ena_intr_mask( ctx->dev, UART_INTR_RXFIFO_FULL );
+  int ret = esp_intr_alloc( uart_periph_signal[ctx->uart_num].irq, ESP_INTR_FLAG_LOWMED | ESP_INTR_FLAG_IRAM, _uart_intr_handle, ctx, &ctx->handle_ow_uart );
   if ( ret != ESP_OK )
   {
     return 0;
   }
-  ctx.rx_fifo_addr = ( ctx.dev == &UART0 ) ? UART_FIFO_AHB_REG( 0 ) : UART_FIFO_AHB_REG( 1 );
-  ctx.tx_fifo_addr = ( ctx.dev == &UART0 ) ? UART_FIFO_AHB_REG( 0 ) : UART_FIFO_AHB_REG( 1 );
-  uart_ll_set_rxfifo_full_thr( ctx.dev, 1 );
-  OW_UNUSED( arg );
 
   return 1;
 }
 
 uint8_t OWUart_deinit( void* arg )
 {
-  esp_intr_free( ctx.handle_ow_uart );
-  uart_disable_rx_intr( OW_UART_NUM );
-  uart_disable_tx_intr( OW_UART_NUM );
-  OW_UNUSED( arg );
+  ow_ctx_t* ctx = _get_ctx( arg );
+  esp_intr_free( ctx->handle_ow_uart );
+  uart_disable_rx_intr( ctx->uart_num );
+  uart_disable_tx_intr( ctx->uart_num );
   return 1;
 }
 
 uint8_t OWUart_setBaudrate( uint32_t baud, void* arg )
 {
-  uart_set_baudrate( OW_UART_NUM, baud );
-  OW_UNUSED( arg );
+  ow_ctx_t* ctx = _get_ctx( arg );
+  uart_set_baudrate( ctx->uart_num, baud );
+  ctx->last_baud_rate = baud;
 
   return 1;
 }
 
 uint8_t OWUart_transmitReceive( const uint8_t* tx, uint8_t* rx, size_t len, void* arg )
 {
-  ctx.tx_done = false;
-  ctx.rx_done = false;
-  ctx.len = len;
-  ctx.rx = rx;
-  ctx.tx = (uint8_t*) tx;
-  ctx.rx_len = 0;
-  ctx.tx_len = 0;
-
-  WRITE_PERI_REG( ctx.tx_fifo_addr, tx[ctx.tx_len] );
-  ctx.tx_len++;
-
-  uint32_t wait = 0xfffff;
-  while ( ( !ctx.rx_done ) && ( wait > 0 ) )
+  ow_ctx_t* ctx = _get_ctx( arg );
+  uint8_t res = 1;
+  for ( size_t offset = 0; offset < len && res; offset += OW_UART_CHUNK_SIZE )
   {
-    wait--;
+    size_t chunk = len - offset < OW_UART_CHUNK_SIZE ? len - offset : OW_UART_CHUNK_SIZE;
+    res = _transfer_chunk( ctx, &tx[offset], &rx[offset], chunk );
   }
 
-  OW_UNUSED( arg );
-  return 1;
+  return res;
 }
 
 #if 0
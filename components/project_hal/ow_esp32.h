@@ -14,11 +14,26 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* Public types --------------------------------------------------------------*/
+/** @brief  1-Wire bus on UART, passed as user argument to ow_init. Every bus needs own UART. */
+typedef struct
+{
+  int uart_num;
+  int tx_pin;
+  int rx_pin;
+} ow_uart_config_t;
+
 /* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief   Board setup of GPIO 33..36 as floating inputs. It is done once at boot, before
+ *          any bus is initialized, so init of one bus never overwrites pins of another bus.
+ */
+void OWUart_BoardInit( void );
+
 uint8_t OWUart_init( void* arg );
 uint8_t OWUart_deinit( void* arg );
 uint8_t OWUart_setBaudrate( uint32_t baud, void* arg );
 uint8_t OWUart_transmitReceive( const uint8_t* tx, uint8_t* rx, size_t len, void* arg );
-void OWUart_SetPin( int rx, int tx );
 
 #endif
\ No newline at end of file
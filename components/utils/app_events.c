@@ -12,9 +12,16 @@
 #include <freertos/FreeRTOS.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "app_config.h"
 
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
 /* Private macros ------------------------------------------------------------*/
 #define MODULE_NAME "[AppEvent] "
 #define DEBUG_LVL   PRINT_INFO
@@ -26,8 +33,72 @@
 #define LOG( PRINT_INFO, ... )
 #endif
 
+#define TRACE_MASK ( CONFIG_APP_EVENT_TRACE_SIZE - 1 )
+
+#define POOL_MASK( _blocks_count ) ( ( _blocks_count ) >= 32 ? UINT32_MAX : ( 1UL << ( _blocks_count ) ) - 1 )
+
+/* Private types -------------------------------------------------------------*/
+struct event_pool
+{
+  uint8_t* storage;
+  uint8_t* refs;
+  uint32_t free_mask;
+  app_event_pool_stats_t stats;
+};
+
+struct event_task
+{
+  QueueHandle_t queue;
+  bool in_set;
+  app_event_task_stats_t stats;
+  uint16_t pending[MSG_ID_LAST];
+};
+
+struct post_policy
+{
+  app_event_post_policy_t policy;
+  uint32_t timeout_ms;
+};
+
 /* Private variables ---------------------------------------------------------*/
+#define POOL( _block_size, _blocks_count )                                                                   \
+  _Static_assert( ( _blocks_count ) <= 32, "Pool free mask supports up to 32 blocks" );                      \
+  _Static_assert( ( ( _block_size ) & ( ( _block_size ) - 1 ) ) == 0, "Pool block size must be power of 2" ); \
+  static uint8_t pool_##_block_size##_storage[_blocks_count][_block_size] __attribute__( ( aligned( 4 ) ) ); \
+  static uint8_t pool_##_block_size##_refs[_blocks_count];
+APP_EVENT_POOL_LIST
+#undef POOL
+
+static struct event_pool pools[] =
+  {
+#define POOL( _block_size, _blocks_count )          \
+  [APP_EVENT_POOL_##_block_size] = {                \
+    .storage = &pool_##_block_size##_storage[0][0], \
+    .refs = pool_##_block_size##_refs,              \
+    .free_mask = POOL_MASK( _blocks_count ),        \
+    .stats = { .block_size = _block_size, .blocks_count = _blocks_count } },
+    APP_EVENT_POOL_LIST
+#undef POOL
+};
+
+static struct event_task tasks[APP_EVENT_LAST];
+static uint32_t subscribers[MSG_ID_LAST];
+static struct post_policy post_policies[MSG_ID_LAST] =
+  {
+#define POST_POLICY( _id, _policy, _timeout_ms ) \
+  [MSG_ID_##_id] = { .policy = _policy, .timeout_ms = _timeout_ms },
+    APP_EVENT_POST_POLICY_LIST
+#undef POST_POLICY
+};
 static uint32_t events_counter;
+
+#if CONFIG_APP_EVENT_TRACE
+_Static_assert( ( CONFIG_APP_EVENT_TRACE_SIZE & TRACE_MASK ) == 0, "Trace size must be power of 2" );
+static app_event_trace_t trace[CONFIG_APP_EVENT_TRACE_SIZE];
+static uint32_t trace_head;
+static bool trace_enabled;
+#endif
+
 static const char* msg_id_name[] =
   {
 #define MSG( _id ) [MSG_ID_##_id] = #_id,
@@ -42,6 +113,258 @@ static const char* event_task_name[] =
 #undef EVENT_TASK
 };
 
+/* Private functions ---------------------------------------------------------*/
+
+static uint32_t _get_time_us( void )
+{
+#ifdef ESP_PLATFORM
+  return (uint32_t) esp_timer_get_time();
+#else
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint32_t) ( ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000 );
+#endif
+}
+
+static uint32_t _get_prepare_time_us( void )
+{
+  /* Prepare time is used only by latency histogram */
+  return CONFIG_APP_EVENT_TIMING ? _get_time_us() : 0;
+}
+
+static void _update_max( uint16_t* max, uint16_t value )
+{
+  uint16_t current = __atomic_load_n( max, __ATOMIC_RELAXED );
+  while ( value > current && !__atomic_compare_exchange_n( max, &current, value, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+  {
+  }
+}
+
+#if CONFIG_APP_EVENT_TIMING
+static uint32_t _get_latency_bucket( uint32_t latency_us )
+{
+  if ( latency_us < 2 )
+  {
+    return 0;
+  }
+
+  uint32_t bucket = 31 - __builtin_clz( latency_us );
+  return bucket < APP_EVENT_LATENCY_HISTOGRAM_SIZE ? bucket : APP_EVENT_LATENCY_HISTOGRAM_SIZE - 1;
+}
+#endif
+
+static void _update_latency( struct event_task* task, const app_event_t* event, uint32_t end_us )
+{
+#if CONFIG_APP_EVENT_TIMING
+  task->stats.latency_histogram[_get_latency_bucket( end_us - event->timestamp_us )]++;
+#endif
+}
+
+static bool _is_trace_enabled( void )
+{
+#if CONFIG_APP_EVENT_TRACE
+  return __atomic_load_n( &trace_enabled, __ATOMIC_RELAXED );
+#else
+  return false;
+#endif
+}
+
+static void _trace( const app_event_t* event, uint32_t start_us, uint32_t end_us, uint8_t flags )
+{
+#if CONFIG_APP_EVENT_TRACE
+  /* Slot is reserved atomically, so workers can trace concurrently */
+  app_event_trace_t* record = &trace[__atomic_fetch_add( &trace_head, 1, __ATOMIC_RELAXED ) & TRACE_MASK];
+  record->timestamp_us = start_us;
+  record->event_number = event->event_number;
+  record->duration_us = end_us - start_us;
+  record->src = event->src;
+  record->dst = event->dst;
+  record->msg_id = event->msg_id;
+  record->flags = flags;
+#endif
+}
+
+static struct event_pool* _get_pool( uint32_t data_size )
+{
+  for ( size_t i = 0; i < ARRAY_SIZE( pools ); i++ )
+  {
+    if ( data_size <= pools[i].stats.block_size )
+    {
+      return &pools[i];
+    }
+  }
+
+  return NULL;
+}
+
+static void* _pool_alloc( uint32_t data_size )
+{
+  struct event_pool* pool = _get_pool( data_size );
+  if ( pool == NULL )
+  {
+    return NULL;
+  }
+
+  /* Lock-free: each set bit of free_mask is one free block, allocation clears the lowest one */
+  uint32_t mask = __atomic_load_n( &pool->free_mask, __ATOMIC_RELAXED );
+  uint32_t index;
+  do
+  {
+    if ( mask == 0 )
+    {
+      __atomic_fetch_add( &pool->stats.fail_count, 1, __ATOMIC_RELAXED );
+      return NULL;
+    }
+    index = __builtin_ctz( mask );
+  } while ( !__atomic_compare_exchange_n( &pool->free_mask, &mask, mask & ~( 1UL << index ), false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) );
+
+  _update_max( &pool->stats.high_water_mark, pool->stats.blocks_count - __builtin_popcount( mask ) + 1 );
+  __atomic_fetch_add( &pool->stats.alloc_count, 1, __ATOMIC_RELAXED );
+  __atomic_store_n( &pool->refs[index], 1, __ATOMIC_RELAXED );
+
+  return &pool->storage[index * pool->stats.block_size];
+}
+
+static struct event_pool* _get_pool_block( const void* data, uint32_t data_size, uint32_t* index )
+{
+  struct event_pool* pool = _get_pool( data_size );
+  if ( pool == NULL || (const uint8_t*) data < pool->storage )
+  {
+    assert( 0 );
+    return NULL;
+  }
+
+  /* Block size is power of 2, shift instead of division on release path */
+  size_t offset = (const uint8_t*) data - pool->storage;
+  uint32_t shift = __builtin_ctz( pool->stats.block_size );
+  if ( ( offset & ( pool->stats.block_size - 1 ) ) != 0 || ( offset >> shift ) >= pool->stats.blocks_count )
+  {
+    assert( 0 );
+    return NULL;
+  }
+
+  *index = offset >> shift;
+  return pool;
+}
+
+static void _pool_retain( const void* data, uint32_t data_size, uint8_t count )
+{
+  uint32_t index = 0;
+  struct event_pool* pool = _get_pool_block( data, data_size, &index );
+  if ( pool != NULL )
+  {
+    __atomic_fetch_add( &pool->refs[index], count, __ATOMIC_RELAXED );
+  }
+}
+
+static void _pool_release( const void* data, uint32_t data_size )
+{
+  uint32_t index = 0;
+  struct event_pool* pool = _get_pool_block( data, data_size, &index );
+  if ( pool == NULL )
+  {
+    return;
+  }
+
+  /* Block shared by published event returns to pool with the last reference. Sole
+   * owner can't race with other holders, so common unshared case skips atomic decrement */
+  if ( __atomic_load_n( &pool->refs[index], __ATOMIC_ACQUIRE ) == 1 || __atomic_sub_fetch( &pool->refs[index], 1, __ATOMIC_ACQ_REL ) == 0 )
+  {
+    __atomic_fetch_or( &pool->free_mask, 1UL << index, __ATOMIC_RELEASE );
+  }
+}
+
+static const void* _get_data_ptr( const app_event_t* event )
+{
+  if ( event->data_size <= APP_EVENT_INLINE_DATA_SIZE )
+  {
+    return event->inline_data;
+  }
+
+  return event->data;
+}
+
+static bool _post( app_event_t* event, bool may_block )
+{
+  if ( event == NULL || event->msg_id >= MSG_ID_LAST || event->dst >= APP_EVENT_LAST || tasks[event->dst].queue == NULL )
+  {
+    LOG( PRINT_ERROR, "%s() Bad input arguments", __func__ );
+    assert( 0 );
+    return false;
+  }
+
+  struct event_task* task = &tasks[event->dst];
+  struct post_policy* policy = &post_policies[event->msg_id];
+  TickType_t timeout = 0;
+  bool counted = false;
+
+  switch ( policy->policy )
+  {
+    case APP_EVENT_POST_COALESCE:
+      /* Check and count in one step, so two posters can't both see nothing pending.
+       * Pending event will be handled, so this one is merged into it */
+      if ( __atomic_fetch_add( &task->pending[event->msg_id], 1, __ATOMIC_RELAXED ) > 0 )
+      {
+        __atomic_fetch_sub( &task->pending[event->msg_id], 1, __ATOMIC_RELAXED );
+        __atomic_fetch_add( &task->stats.coalesced_count, 1, __ATOMIC_RELAXED );
+        AppEventDelete( event );
+        return true;
+      }
+      counted = true;
+      break;
+
+    case APP_EVENT_POST_DROP_OLDEST:
+      /* Receive outside of queue set leaves stale handle in set, newest is dropped instead */
+      if ( task->in_set )
+      {
+        LOG( PRINT_ERROR, "Drop oldest %s on executor queue %s", msg_id_name[event->msg_id], event_task_name[event->dst] );
+        assert( 0 );
+        break;
+      }
+      if ( uxQueueSpacesAvailable( task->queue ) == 0 )
+      {
+        app_event_t oldest = {};
+        if ( xQueueReceive( task->queue, &oldest, 0 ) == pdPASS )
+        {
+          LOG( PRINT_ERROR, "Queue %s is full, drop oldest %s", event_task_name[oldest.dst], msg_id_name[oldest.msg_id] );
+          __atomic_fetch_add( &task->stats.overflow_count, 1, __ATOMIC_RELAXED );
+          __atomic_fetch_sub( &task->pending[oldest.msg_id], 1, __ATOMIC_RELAXED );
+          AppEventDelete( &oldest );
+        }
+      }
+      break;
+
+    case APP_EVENT_POST_BLOCK:
+      timeout = may_block ? pdMS_TO_TICKS( policy->timeout_ms ) : 0;
+      break;
+
+    default:
+      break;
+  }
+
+  /* Counted before send, receiver can dispatch event before xQueueSend returns */
+  if ( !counted )
+  {
+    __atomic_fetch_add( &task->pending[event->msg_id], 1, __ATOMIC_RELAXED );
+  }
+
+  if ( xQueueSend( task->queue, (void*) event, timeout ) != pdPASS )
+  {
+    __atomic_fetch_sub( &task->pending[event->msg_id], 1, __ATOMIC_RELAXED );
+    __atomic_fetch_add( &task->stats.overflow_count, 1, __ATOMIC_RELAXED );
+    LOG( PRINT_ERROR, "Queue %s is full, drop %s", event_task_name[event->dst], msg_id_name[event->msg_id] );
+#if CONFIG_APP_EVENT_OVERFLOW_POLICY == APP_EVENT_OVERFLOW_ASSERT
+    assert( 0 );
+#endif
+    AppEventDelete( event );
+    return false;
+  }
+
+  __atomic_fetch_add( &task->stats.enqueue_count, 1, __ATOMIC_RELAXED );
+  _update_max( &task->stats.max_depth, uxQueueMessagesWaiting( task->queue ) );
+  return true;
+}
+
 /* Public functions ----------------------------------------------------------*/
 
 bool AppEventPrepareNoData( app_event_t* event, app_msg_id_t msg_id, app_events_task_t src, app_events_task_t dst )
@@ -57,6 +380,7 @@ bool AppEventPrepareNoData( app_event_t* event, app_msg_id_t msg_id, app_events_
   event->src = src;
   event->dst = dst;
   event->event_number = events_counter++;
+  event->timestamp_us = _get_prepare_time_us();
 
   event->data = NULL;
   event->data_size = 0;
@@ -71,88 +395,334 @@ bool AppEventPrepareWithData( app_event_t* event, app_msg_id_t msg_id, app_event
     assert( 0 );
     return false;
   }
-  void* m_data = malloc( data_size );
-  if ( m_data == NULL )
+
+  if ( data_size <= APP_EVENT_INLINE_DATA_SIZE )
   {
-    LOG( PRINT_ERROR, "%s() Cannot allocate data %d", __func__, data_size );
-    assert( 0 );
-    return false;
+    memcpy( event->inline_data, data, data_size );
+  }
+  else
+  {
+    void* m_data = _pool_alloc( data_size );
+    if ( m_data == NULL )
+    {
+      LOG( PRINT_ERROR, "%s() Cannot allocate data %d", __func__, data_size );
+      assert( 0 );
+      return false;
+    }
+    memcpy( m_data, data, data_size );
+    event->data = m_data;
   }
-  memcpy( m_data, data, data_size );
 
   event->data_size = data_size;
-  event->data = m_data;
   event->msg_id = msg_id;
   event->src = src;
   event->dst = dst;
   event->event_number = events_counter++;
+  event->timestamp_us = _get_prepare_time_us();
 
   return true;
 }
 
+void AppEventRegisterQueue( app_events_task_t task, QueueHandle_t queue )
+{
+  if ( task >= APP_EVENT_LAST || queue == NULL )
+  {
+    assert( 0 );
+    return;
+  }
+
+  tasks[task].queue = queue;
+  tasks[task].in_set = false;
+  memset( tasks[task].pending, 0, sizeof( tasks[task].pending ) );
+  tasks[task].stats.queue_length = uxQueueSpacesAvailable( queue ) + uxQueueMessagesWaiting( queue );
+}
+
+bool AppEventPost( app_event_t* event )
+{
+  return _post( event, true );
+}
+
+bool AppEventTryPost( app_event_t* event )
+{
+  return _post( event, false );
+}
+
+bool AppEventSetPostPolicy( app_msg_id_t msg_id, app_event_post_policy_t policy, uint32_t timeout_ms )
+{
+  if ( msg_id >= MSG_ID_LAST || policy > APP_EVENT_POST_BLOCK )
+  {
+    assert( 0 );
+    return false;
+  }
+
+  if ( policy == APP_EVENT_POST_DROP_OLDEST )
+  {
+    for ( uint8_t task = 0; task < APP_EVENT_LAST; task++ )
+    {
+      if ( tasks[task].in_set && ( subscribers[msg_id] & ( 1UL << task ) ) )
+      {
+        LOG( PRINT_ERROR, "Drop oldest %s on executor queue %s", msg_id_name[msg_id], event_task_name[task] );
+        assert( 0 );
+        return false;
+      }
+    }
+  }
+
+  post_policies[msg_id].policy = policy;
+  post_policies[msg_id].timeout_ms = timeout_ms;
+  return true;
+}
+
+void AppEventSetQueueInSet( app_events_task_t task, bool in_set )
+{
+  assert( task < APP_EVENT_LAST );
+  tasks[task].in_set = in_set;
+}
+
+bool AppEventSubscribe( app_msg_id_t msg_id, app_events_task_t task )
+{
+  if ( msg_id >= MSG_ID_LAST || task >= APP_EVENT_LAST )
+  {
+    assert( 0 );
+    return false;
+  }
+
+  __atomic_fetch_or( &subscribers[msg_id], 1UL << task, __ATOMIC_RELAXED );
+  return true;
+}
+
+bool AppEventUnsubscribe( app_msg_id_t msg_id, app_events_task_t task )
+{
+  if ( msg_id >= MSG_ID_LAST || task >= APP_EVENT_LAST )
+  {
+    assert( 0 );
+    return false;
+  }
+
+  __atomic_fetch_and( &subscribers[msg_id], ~( 1UL << task ), __ATOMIC_RELAXED );
+  return true;
+}
+
+bool AppEventPublish( app_msg_id_t msg_id, app_events_task_t src, const void* data, uint32_t data_size )
+{
+  if ( msg_id >= MSG_ID_LAST )
+  {
+    assert( 0 );
+    return false;
+  }
+
+  uint32_t mask = __atomic_load_n( &subscribers[msg_id], __ATOMIC_RELAXED );
+  if ( mask == 0 )
+  {
+    LOG( PRINT_INFO, "No subscribers for %s", msg_id_name[msg_id] );
+    return true;
+  }
+
+  app_event_t event = {};
+  if ( data_size == 0 )
+  {
+    AppEventPrepareNoData( &event, msg_id, src, src );
+  }
+  else if ( AppEventPrepareWithData( &event, msg_id, src, src, data, data_size ) == false )
+  {
+    return false;
+  }
+
+  /* Payload from pool is shared: one reference per subscriber, released by AppEventDelete */
+  uint8_t receivers = __builtin_popcount( mask );
+  if ( APP_EVENT_INLINE_DATA_SIZE < event.data_size && receivers > 1 )
+  {
+    _pool_retain( event.data, event.data_size, receivers - 1 );
+  }
+
+  bool result = true;
+  while ( mask != 0 )
+  {
+    app_events_task_t task = __builtin_ctz( mask );
+    mask &= mask - 1;
+
+    app_event_t receiver_event = event;
+    receiver_event.dst = task;
+    result &= AppEventPost( &receiver_event );
+  }
+
+  return result;
+}
+
 bool AppEventGetData( const app_event_t* event, void* data, uint32_t data_size )
 {
-  if ( event == NULL || event->data == NULL || event->data_size == 0 || data == NULL || data_size != event->data_size )
+  if ( event == NULL || event->data_size == 0 || data == NULL || data_size != event->data_size )
   {
     assert( 0 );
     return false;
   }
 
-  memcpy( data, event->data, data_size );
+  memcpy( data, _get_data_ptr( event ), data_size );
 
   return true;
 }
 
 void AppEventDelete( app_event_t* event )
 {
-  if ( 0 < event->data_size )
+  if ( APP_EVENT_INLINE_DATA_SIZE < event->data_size )
   {
     if ( NULL != event->data )
     {
-      free( event->data );
+      _pool_release( event->data, event->data_size );
       event->data = NULL;
     }
-    event->data_size = 0;
   }
+  event->data_size = 0;
   event->src = 0;
 }
 
-bool AppEventSearchAndExecute( const app_event_t* event, const struct app_events_handler* handlers, const uint8_t handlers_length )
+bool AppEventDispatch( const app_event_t* event, const event_callback_t* handlers )
 {
-  if ( ( event == NULL ) || ( handlers == NULL ) || ( handlers_length == 0 ) )
+  if ( ( event == NULL ) || ( handlers == NULL ) || ( event->msg_id >= MSG_ID_LAST ) || ( event->dst >= APP_EVENT_LAST ) )
   {
     assert( 0 );
     return false;
   }
 
-  bool found_id = false;
+  event_callback_t callback = handlers[event->msg_id];
+
+  struct event_task* task = &tasks[event->dst];
 
-  for ( uint8_t i = 0; i < handlers_length; i++ )
+  /* Handler duration of trace costs second clock read, only while recording is on */
+  bool traced = _is_trace_enabled();
+  uint32_t start_us = traced ? _get_time_us() : 0;
+
+  /* Event is out of queue, handler can post the same message again */
+  if ( __atomic_load_n( &task->pending[event->msg_id], __ATOMIC_RELAXED ) > 0 )
   {
-    if ( handlers[i].id == event->msg_id )
+    __atomic_fetch_sub( &task->pending[event->msg_id], 1, __ATOMIC_RELAXED );
+  }
+
+  if ( callback == NULL )
+  {
+    LOG( PRINT_INFO, "Could not run %s: %s", event_task_name[event->dst], msg_id_name[event->msg_id] );
+    task->stats.unhandled_count++;
+    if ( traced )
     {
-      found_id = true;
+      _trace( event, start_us, start_us, APP_EVENT_TRACE_FLAG_UNHANDLED );
+    }
+    return false;
+  }
 
-      if ( handlers[i].callback != NULL )
-      {
-        LOG( PRINT_INFO, "%s -> %s: %s", event_task_name[event->src], event_task_name[event->dst], msg_id_name[event->msg_id] );
-        handlers[i].callback( event );
-        return true;
-      }
-      else
-      {
-        LOG( PRINT_ERROR, "%s: callback is NULL", __func__ );
-        assert( 0 );
-      }
+  LOG( PRINT_INFO, "%s -> %s: %s", event_task_name[event->src], event_task_name[event->dst], msg_id_name[event->msg_id] );
+  callback( event );
 
-      break;
-    }
+  /* Latency is counted from prepare to handler completion, one clock read per dispatch */
+  uint32_t end_us = ( CONFIG_APP_EVENT_TIMING || traced ) ? _get_time_us() : 0;
+  _update_latency( task, event, end_us );
+  if ( traced )
+  {
+    _trace( event, start_us, end_us, 0 );
+  }
+  return true;
+}
+
+bool AppEventIsPending( app_events_task_t task, app_msg_id_t msg_id )
+{
+  if ( task >= APP_EVENT_LAST || msg_id >= MSG_ID_LAST )
+  {
+    return false;
   }
 
-  if (found_id == false)
+  return __atomic_load_n( &tasks[task].pending[msg_id], __ATOMIC_RELAXED ) > 0;
+}
+
+bool AppEventGetPoolStats( app_event_pool_t pool, app_event_pool_stats_t* stats )
+{
+  if ( pool >= APP_EVENT_POOL_LAST || stats == NULL )
   {
-    LOG( PRINT_INFO, "Could not run %s: %s", event_task_name[event->dst], msg_id_name[event->msg_id] );
+    return false;
+  }
+
+  stats->block_size = pools[pool].stats.block_size;
+  stats->blocks_count = pools[pool].stats.blocks_count;
+  stats->used = pools[pool].stats.blocks_count - __builtin_popcount( __atomic_load_n( &pools[pool].free_mask, __ATOMIC_RELAXED ) );
+  stats->high_water_mark = __atomic_load_n( &pools[pool].stats.high_water_mark, __ATOMIC_RELAXED );
+  stats->alloc_count = __atomic_load_n( &pools[pool].stats.alloc_count, __ATOMIC_RELAXED );
+  stats->fail_count = __atomic_load_n( &pools[pool].stats.fail_count, __ATOMIC_RELAXED );
+
+  return true;
+}
+
+bool AppEventGetTaskStats( app_events_task_t task, app_event_task_stats_t* stats )
+{
+  if ( task >= APP_EVENT_LAST || stats == NULL )
+  {
+    return false;
   }
 
-  return found_id;
+  *stats = tasks[task].stats;
+  return true;
+}
+
+void AppEventResetStats( void )
+{
+  for ( size_t i = 0; i < ARRAY_SIZE( tasks ); i++ )
+  {
+    uint16_t queue_length = tasks[i].stats.queue_length;
+    memset( &tasks[i].stats, 0, sizeof( tasks[i].stats ) );
+    tasks[i].stats.queue_length = queue_length;
+  }
+}
+
+const char* AppEventGetTaskName( app_events_task_t task )
+{
+  if ( task >= APP_EVENT_LAST )
+  {
+    return NULL;
+  }
+
+  return event_task_name[task];
+}
+
+uint32_t AppEventTraceRead( uint32_t* offset, app_event_trace_t* records, uint32_t count )
+{
+#if CONFIG_APP_EVENT_TRACE
+  if ( offset == NULL || records == NULL )
+  {
+    return 0;
+  }
+
+  uint32_t head = __atomic_load_n( &trace_head, __ATOMIC_ACQUIRE );
+  uint32_t available = head < CONFIG_APP_EVENT_TRACE_SIZE ? head : CONFIG_APP_EVENT_TRACE_SIZE;
+  if ( head - *offset > available )
+  {
+    *offset = head - available;
+  }
+
+  uint32_t copied = 0;
+  for ( uint32_t i = *offset; i != head && copied < count; i++ )
+  {
+    records[copied++] = trace[i & TRACE_MASK];
+  }
+  return copied;
+#else
+  return 0;
+#endif
+}
+
+void AppEventTraceEnable( bool enable )
+{
+#if CONFIG_APP_EVENT_TRACE
+  __atomic_store_n( &trace_enabled, enable, __ATOMIC_RELAXED );
+#endif
+}
+
+bool AppEventTraceIsEnabled( void )
+{
+  return _is_trace_enabled();
+}
+
+uint32_t AppEventTraceGetHead( void )
+{
+#if CONFIG_APP_EVENT_TRACE
+  return __atomic_load_n( &trace_head, __ATOMIC_RELAXED );
+#else
+  return 0;
+#endif
 }
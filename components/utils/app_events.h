@@ -14,6 +14,8 @@
 #include <stdint.h>
 
 #include "app_msg_id.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 
 #define EVENTS_TASK_LIST        \
   EVENT_TASK( APP_MANAGER )     \
@@ -23,15 +25,38 @@
   EVENT_TASK( OTA )             \
   EVENT_TASK( MQTT_APP )        \
   EVENT_TASK( DEV_MANAGER )     \
-  EVENT_TASK( TEMP_DRV )
+  EVENT_TASK( TEMP_DRV )        \
+  EVENT_TASK( TEMP_BUS_0 )      \
+  EVENT_TASK( TEMP_BUS_1 )
+
+/** @brief  Slab pool size classes for event data: POOL( block_size, blocks_count ) */
+#define APP_EVENT_POOL_LIST \
+  POOL( 32, 8 )             \
+  POOL( 64, 8 )             \
+  POOL( 128, 4 )            \
+  POOL( 256, 4 )
+
+/** @brief  Post policy of messages different than default: POST_POLICY( msg, policy, timeout_ms ) */
+#define APP_EVENT_POST_POLICY_LIST                                     \
+  POST_POLICY( TCP_SERVER_WAIT_CLIENT_DATA, APP_EVENT_POST_COALESCE, 0 ) \
+  POST_POLICY( DEV_MANAGER_MEASURE, APP_EVENT_POST_COALESCE, 0 )         \
+  POST_POLICY( DEV_MANAGER_POST, APP_EVENT_POST_COALESCE, 0 )            \
+  POST_POLICY( TEMPERATURE_MEASURE_REQ, APP_EVENT_POST_COALESCE, 0 )     \
+  POST_POLICY( INIT_RES, APP_EVENT_POST_BLOCK, 100 )
 
 /* Public macro --------------------------------------------------------------*/
 #define ARRAY_SIZE( _array ) ( sizeof( _array ) / sizeof( ( _array )[0] ) )
 
-#define EVENT_ITEM( _id, _callback )         \
-  {                                          \
-    .id = ( _id ), .callback = ( _callback ) \
-  }
+/** @brief  Data up to this size is stored inside event, larger data is taken from slab pool */
+#define APP_EVENT_INLINE_DATA_SIZE 16
+
+/** @brief  Latency histogram bucket n counts events handled in [2^n, 2^(n+1)) us from prepare to handler completion, last bucket counts all longer */
+#define APP_EVENT_LATENCY_HISTOGRAM_SIZE 16
+
+/** @brief  Trace record flag: no handler for message in current state */
+#define APP_EVENT_TRACE_FLAG_UNHANDLED 0x01
+
+#define EVENT_ITEM( _id, _callback ) [( _id )] = ( _callback )
 
 /* Public types --------------------------------------------------------------*/
 
@@ -43,23 +68,82 @@ typedef enum
     APP_EVENT_LAST
 } app_events_task_t;
 
+_Static_assert( APP_EVENT_LAST <= 32, "Subscribers are stored as 32-bit mask" );
+
+typedef enum
+{
+  /** Full queue is handled by CONFIG_APP_EVENT_OVERFLOW_POLICY */
+  APP_EVENT_POST_DEFAULT,
+  /** Message already pending in destination queue is not enqueued again */
+  APP_EVENT_POST_COALESCE,
+  /** Full queue drops its oldest event to make room */
+  APP_EVENT_POST_DROP_OLDEST,
+  /** Poster waits up to timeout for free space in queue */
+  APP_EVENT_POST_BLOCK,
+} app_event_post_policy_t;
+
+typedef enum
+{
+#define POOL( _block_size, _blocks_count ) APP_EVENT_POOL_##_block_size,
+  APP_EVENT_POOL_LIST
+#undef POOL
+    APP_EVENT_POOL_LAST
+} app_event_pool_t;
+
 typedef struct
 {
   app_events_task_t src;
   app_events_task_t dst;
   app_msg_id_t msg_id;
   uint32_t event_number;
+  uint32_t timestamp_us;
   uint32_t data_size;
-  void* data;
+  union
+  {
+    void* data;
+    uint8_t inline_data[APP_EVENT_INLINE_DATA_SIZE];
+  };
 } app_event_t;
 
+typedef struct
+{
+  uint16_t block_size;
+  uint16_t blocks_count;
+  uint16_t used;
+  uint16_t high_water_mark;
+  uint32_t alloc_count;
+  uint32_t fail_count;
+} app_event_pool_stats_t;
+
 typedef void ( *event_callback_t )( const app_event_t* );
 
-struct app_events_handler
+typedef struct
 {
-  const uint32_t id;
-  const event_callback_t callback;
-};
+  uint32_t enqueue_count;
+  uint32_t overflow_count;
+  uint32_t coalesced_count;
+  uint32_t unhandled_count;
+  uint16_t max_depth;
+  uint16_t queue_length;
+  uint32_t latency_histogram[APP_EVENT_LATENCY_HISTOGRAM_SIZE];
+} app_event_task_stats_t;
+
+/** @brief  Binary trace record of dispatched event, stored little endian */
+typedef struct
+{
+  uint32_t timestamp_us;
+  uint32_t event_number;
+  uint32_t duration_us;
+  uint8_t src;
+  uint8_t dst;
+  uint8_t msg_id;
+  uint8_t flags;
+} app_event_trace_t;
+
+_Static_assert( sizeof( app_event_trace_t ) == 16, "Trace record size is part of dump format" );
+
+/** @brief  Handler table of one state indexed by message id, filled by EVENT_ITEM */
+typedef event_callback_t app_events_handler_table_t[MSG_ID_LAST];
 
 /* Public functions ----------------------------------------------------------*/
 /**
@@ -79,11 +163,81 @@ bool AppEventPrepareNoData( app_event_t* event, app_msg_id_t msg_id, app_events_
  * @param   [in] src - Source module id.
  * @param   [in] dst - Destination module id.
  * @param   [in] data - Data to send.
- * @param   [in] data_size - Data size for malloc memory.
+ * @param   [in] data_size - Data size. Up to APP_EVENT_INLINE_DATA_SIZE data is copied into event,
+ *                               larger data is copied into block from slab pool.
  * @return  true - if event ready to send, otherwise false
  */
 bool AppEventPrepareWithData( app_event_t* event, app_msg_id_t msg_id, app_events_task_t src, app_events_task_t dst, const void* data, uint32_t data_size );
 
+/**
+ * @brief   Registers queue of module, events are posted to it by AppEventPost.
+ * @param   [in] task - Module id.
+ * @param   [in] queue - Module queue.
+ */
+void AppEventRegisterQueue( app_events_task_t task, QueueHandle_t queue );
+
+/**
+ * @brief   Sends event to queue of destination module. When queue is full,
+ *          event is dropped and counted or asserted depending on CONFIG_APP_EVENT_OVERFLOW_POLICY.
+ * @param   [in] event - Prepared event.
+ * @return  true - if event sent, otherwise false
+ */
+bool AppEventPost( app_event_t* event );
+
+/**
+ * @brief   Sends event as AppEventPost, but never waits on full queue, APP_EVENT_POST_BLOCK
+ *          policy is handled as default one. Used from timer tick, which must not block.
+ * @param   [in] event - Prepared event.
+ * @return  true - if event sent, otherwise false
+ */
+bool AppEventTryPost( app_event_t* event );
+
+/**
+ * @brief   Changes post policy of message, defaults are set by APP_EVENT_POST_POLICY_LIST.
+ *          APP_EVENT_POST_DROP_OLDEST is rejected for message subscribed by module
+ *          with queue in executor queue set.
+ * @param   [in] msg_id - Message id.
+ * @param   [in] policy - Post policy.
+ * @param   [in] timeout_ms - Timeout for APP_EVENT_POST_BLOCK policy.
+ * @return  true - if successful set, otherwise false
+ */
+bool AppEventSetPostPolicy( app_msg_id_t msg_id, app_event_post_policy_t policy, uint32_t timeout_ms );
+
+/**
+ * @brief   Marks module queue as member of executor queue set. Such queue is read
+ *          only through the set, so APP_EVENT_POST_DROP_OLDEST is not allowed for it.
+ * @param   [in] task - Module id.
+ * @param   [in] in_set - true if queue is in queue set.
+ */
+void AppEventSetQueueInSet( app_events_task_t task, bool in_set );
+
+/**
+ * @brief   Subscribes module to message, published message is posted to module queue.
+ * @param   [in] msg_id - Message id.
+ * @param   [in] task - Subscriber module id.
+ * @return  true - if successful subscribe, otherwise false
+ */
+bool AppEventSubscribe( app_msg_id_t msg_id, app_events_task_t task );
+
+/**
+ * @brief   Removes module subscription of message.
+ * @param   [in] msg_id - Message id.
+ * @param   [in] task - Subscriber module id.
+ * @return  true - if successful unsubscribe, otherwise false
+ */
+bool AppEventUnsubscribe( app_msg_id_t msg_id, app_events_task_t task );
+
+/**
+ * @brief   Posts message to all subscribed modules. Data is copied once and
+ *          shared by all receivers, it is released by the last AppEventDelete.
+ * @param   [in] msg_id - Message id.
+ * @param   [in] src - Source module id.
+ * @param   [in] data - Data to send, NULL if message has no data.
+ * @param   [in] data_size - Data size.
+ * @return  true - if event sent to all subscribers, otherwise false
+ */
+bool AppEventPublish( app_msg_id_t msg_id, app_events_task_t src, const void* data, uint32_t data_size );
+
 /**
  * @brief   Get data from event.
  * @param   [in] event - Event.
@@ -94,19 +248,82 @@ bool AppEventPrepareWithData( app_event_t* event, app_msg_id_t msg_id, app_event
 bool AppEventGetData( const app_event_t* event, void* data, uint32_t data_size );
 
 /**
- * @brief   Frees allocated memory in event.
+ * @brief   Releases slab pool block used by event, block is freed with the last reference.
  * @param   [in] event - Event.
  */
 void AppEventDelete( app_event_t* event );
 
 /**
- * @brief   Looks for specific event handler in given table, then executes it.
- * @param   [in] id - event id number.
- * @param   [in] handlers - table of event handlers.
- * @param   [in] handlers_length - length of the handler table.
- * @param   [in] data - pointer to event.
+ * @brief   Executes event handler from table indexed by message id.
+ * @param   [in] event - pointer to event.
+ * @param   [in] handlers - table of event handlers with MSG_ID_LAST items.
  * @return  true - if successful execute, otherwise false
  */
-bool AppEventSearchAndExecute( const app_event_t* event, const struct app_events_handler* handlers, const uint8_t handlers_length );
+bool AppEventDispatch( const app_event_t* event, const event_callback_t* handlers );
+
+/**
+ * @brief   Check if module has message in queue, which wasn't dispatched yet.
+ * @param   [in] task - Module id.
+ * @param   [in] msg_id - Message id.
+ * @return  true - if message is pending
+ */
+bool AppEventIsPending( app_events_task_t task, app_msg_id_t msg_id );
+
+/**
+ * @brief   Get statistics of event data slab pool.
+ * @param   [in] pool - Pool size class.
+ * @param   [out] stats - Pool statistics.
+ * @return  true - if successful gets statistics, otherwise false
+ */
+bool AppEventGetPoolStats( app_event_pool_t pool, app_event_pool_stats_t* stats );
+
+/**
+ * @brief   Get statistics of module events queue and dispatch latency.
+ * @param   [in] task - Module id.
+ * @param   [out] stats - Module statistics.
+ * @return  true - if successful gets statistics, otherwise false
+ */
+bool AppEventGetTaskStats( app_events_task_t task, app_event_task_stats_t* stats );
+
+/**
+ * @brief   Clears statistics of all modules.
+ */
+void AppEventResetStats( void );
+
+/**
+ * @brief   Get name of module.
+ * @param   [in] task - Module id.
+ * @return  module name, NULL if task is invalid
+ */
+const char* AppEventGetTaskName( app_events_task_t task );
+
+/**
+ * @brief   Copy records from dispatch trace ring.
+ * @param   [in/out] offset - Index of first record to read, moved forward if
+ *          record was already overwritten.
+ * @param   [out] records - Output records.
+ * @param   [in] count - Max records to read.
+ * @return  number of records copied
+ */
+uint32_t AppEventTraceRead( uint32_t* offset, app_event_trace_t* records, uint32_t count );
+
+/**
+ * @brief   Start or stop recording of dispatched events to trace ring. Recording
+ *          is off after boot, handler duration costs second clock read per dispatch.
+ * @param   [in] enable - true to record events.
+ */
+void AppEventTraceEnable( bool enable );
+
+/**
+ * @brief   Check if dispatched events are recorded to trace ring.
+ * @return  false when recording is stopped or trace is compiled out
+ */
+bool AppEventTraceIsEnabled( void );
+
+/**
+ * @brief   Get index of next trace record to be written.
+ * @return  number of records written since boot
+ */
+uint32_t AppEventTraceGetHead( void );
 
 #endif /* __APP_EVENTS_H__ */
@@ -0,0 +1,159 @@
+/**
+ *******************************************************************************
+ * @file    app_executor.c
+ * @author  Dmytro Shevchenko
+ * @brief   Shared executor for module state machines. Every worker waits on
+ *          queue set of its modules, so one task serves several modules and
+ *          one module is always served by the same worker.
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "app_executor.h"
+
+#include <stdio.h>
+
+#include "app_config.h"
+#include "freertos/task.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define MODULE_NAME "[Executor] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_APP_EVENT
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+/* Private types -------------------------------------------------------------*/
+struct executor_module
+{
+  QueueHandle_t queue;
+  app_executor_dispatch_t dispatch;
+  uint8_t worker;
+};
+
+struct executor_worker
+{
+  QueueSetHandle_t set;
+  UBaseType_t used_length;
+  TaskHandle_t task;
+};
+
+/* Private variables ---------------------------------------------------------*/
+static struct executor_module modules[APP_EVENT_LAST];
+static struct executor_worker workers[CONFIG_APP_EXECUTOR_WORKERS];
+
+/* Private functions ---------------------------------------------------------*/
+static struct executor_module* _get_module( uint8_t worker, QueueSetMemberHandle_t member )
+{
+  for ( app_events_task_t task = 0; task < APP_EVENT_LAST; task++ )
+  {
+    if ( modules[task].queue == member && modules[task].worker == worker )
+    {
+      return &modules[task];
+    }
+  }
+  return NULL;
+}
+
+static void _worker_task( void* pv )
+{
+  uint8_t worker = (uint8_t) (uintptr_t) pv;
+  while ( 1 )
+  {
+    AppExecutorRunOnce( worker, portMAX_DELAY );
+  }
+}
+
+/* Public functions -----------------------------------------------------------*/
+void AppExecutorInit( void )
+{
+  for ( uint8_t i = 0; i < CONFIG_APP_EXECUTOR_WORKERS; i++ )
+  {
+    if ( workers[i].set != NULL )
+    {
+      continue;
+    }
+
+    workers[i].set = xQueueCreateSet( CONFIG_APP_EXECUTOR_SET_LENGTH );
+    assert( workers[i].set );
+
+    char name[configMAX_TASK_NAME_LEN] = {};
+    snprintf( name, sizeof( name ), "executor_%u", i );
+    xTaskCreate( _worker_task, name, CONFIG_APP_EXECUTOR_STACK_SIZE, (void*) (uintptr_t) i, NORMALPRIOR, &workers[i].task );
+  }
+}
+
+bool AppExecutorRegister( app_events_task_t task, QueueHandle_t queue, app_executor_dispatch_t dispatch, uint8_t worker )
+{
+  assert( task < APP_EVENT_LAST );
+  assert( queue );
+  assert( dispatch );
+  assert( worker < CONFIG_APP_EXECUTOR_WORKERS );
+  assert( workers[worker].set );
+
+  struct executor_module* module = &modules[task];
+  if ( module->queue != NULL )
+  {
+    if ( xQueueRemoveFromSet( module->queue, workers[module->worker].set ) != pdPASS )
+    {
+      LOG( PRINT_ERROR, "%s: cannot remove old queue", AppEventGetTaskName( task ) );
+      return false;
+    }
+    workers[module->worker].used_length -= uxQueueSpacesAvailable( module->queue );
+    AppEventSetQueueInSet( task, false );
+    module->queue = NULL;
+  }
+
+  /* Queue set must hold handles of all events that can wait in member queues */
+  UBaseType_t length = uxQueueSpacesAvailable( queue );
+  if ( uxQueueMessagesWaiting( queue ) != 0 || workers[worker].used_length + length > CONFIG_APP_EXECUTOR_SET_LENGTH )
+  {
+    LOG( PRINT_ERROR, "%s: queue not empty or set full", AppEventGetTaskName( task ) );
+    return false;
+  }
+
+  if ( xQueueAddToSet( queue, workers[worker].set ) != pdPASS )
+  {
+    LOG( PRINT_ERROR, "%s: cannot add queue to set", AppEventGetTaskName( task ) );
+    return false;
+  }
+
+  workers[worker].used_length += length;
+  AppEventSetQueueInSet( task, true );
+  module->dispatch = dispatch;
+  module->worker = worker;
+  module->queue = queue;
+  return true;
+}
+
+bool AppExecutorRunOnce( uint8_t worker, TickType_t timeout )
+{
+  assert( worker < CONFIG_APP_EXECUTOR_WORKERS );
+
+  QueueSetMemberHandle_t member = xQueueSelectFromSet( workers[worker].set, timeout );
+  if ( member == NULL )
+  {
+    return false;
+  }
+
+  struct executor_module* module = _get_module( worker, member );
+  if ( module == NULL )
+  {
+    return false;
+  }
+
+  /* Event could be already taken by other receiver of the queue */
+  app_event_t event = { 0 };
+  if ( xQueueReceive( module->queue, &event, 0 ) != pdPASS )
+  {
+    return false;
+  }
+
+  module->dispatch( &event );
+  AppEventDelete( &event );
+  return true;
+}
@@ -0,0 +1,49 @@
+/**
+ *******************************************************************************
+ * @file    app_executor.h
+ * @author  Dmytro Shevchenko
+ * @brief   Shared executor for module state machines header
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __APP_EXECUTOR_H__
+#define __APP_EXECUTOR_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_events.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+/* Public types --------------------------------------------------------------*/
+typedef void ( *app_executor_dispatch_t )( const app_event_t* event );
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @brief   Create queue sets and start executor workers.
+ */
+void AppExecutorInit( void );
+
+/**
+ * @brief   Register module queue on executor worker. Queue must be empty and
+ *          only executor can receive from it, so messages to this module
+ *          cannot use drop oldest post policy, app_events rejects it.
+ * @param   [in] task - module.
+ * @param   [in] queue - module events queue.
+ * @param   [in] dispatch - module dispatch function called for every event.
+ * @param   [in] worker - worker index.
+ * @return  true - if success
+ */
+bool AppExecutorRegister( app_events_task_t task, QueueHandle_t queue, app_executor_dispatch_t dispatch, uint8_t worker );
+
+/**
+ * @brief   Wait for one event on worker queues and dispatch it.
+ * @param   [in] worker - worker index.
+ * @param   [in] timeout - wait time in ticks.
+ * @return  true - if event was dispatched
+ */
+bool AppExecutorRunOnce( uint8_t worker, TickType_t timeout );
+
+#endif /* __APP_EXECUTOR_H__ */
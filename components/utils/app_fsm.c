@@ -0,0 +1,131 @@
+/**
+ *******************************************************************************
+ * @file    app_fsm.c
+ * @author  Dmytro Shevchenko
+ * @brief   Module state machine framework. Replaces state table, state change,
+ *          internal events and task loop repeated in every module.
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "app_fsm.h"
+
+#include "app_config.h"
+#include "app_executor.h"
+#include "freertos/task.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define MODULE_NAME "[FSM] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_APP_FSM
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static app_fsm_t* fsms[APP_EVENT_LAST];
+
+/* Private functions ---------------------------------------------------------*/
+#if CONFIG_APP_EXECUTOR
+static void _executor_dispatch( const app_event_t* event )
+{
+  AppFsmDispatch( fsms[event->dst], event );
+}
+#endif
+
+static void _task( void* pv )
+{
+  app_fsm_t* fsm = pv;
+  while ( 1 )
+  {
+    AppFsmProcess( fsm, portMAX_DELAY );
+  }
+}
+
+/* Public functions -----------------------------------------------------------*/
+void AppFsmInit( app_fsm_t* fsm )
+{
+  assert( fsm );
+  assert( fsm->task < APP_EVENT_LAST );
+  assert( fsm->states && fsm->states_count > 0 );
+
+  fsm->state = 0;
+  fsm->queue = xQueueCreate( fsm->queue_length, sizeof( app_event_t ) );
+  assert( fsm->queue );
+  fsms[fsm->task] = fsm;
+  AppEventRegisterQueue( fsm->task, fsm->queue );
+}
+
+void AppFsmStart( app_fsm_t* fsm )
+{
+  assert( fsm && fsm->queue );
+#if CONFIG_APP_EXECUTOR
+  if ( fsm->worker != APP_FSM_OWN_TASK )
+  {
+    AppExecutorRegister( fsm->task, fsm->queue, _executor_dispatch, fsm->worker );
+    return;
+  }
+#endif
+  xTaskCreate( _task, fsm->name, fsm->stack_size, fsm, NORMALPRIOR, NULL );
+}
+
+bool AppFsmProcess( app_fsm_t* fsm, TickType_t timeout )
+{
+  app_event_t event = { 0 };
+  if ( xQueueReceive( fsm->queue, &event, timeout ) != pdPASS )
+  {
+    return false;
+  }
+
+  AppFsmDispatch( fsm, &event );
+  AppEventDelete( &event );
+  return true;
+}
+
+bool AppFsmDispatch( app_fsm_t* fsm, const app_event_t* event )
+{
+  return AppEventDispatch( event, fsm->states[fsm->state].handlers );
+}
+
+void AppFsmChangeState( app_fsm_t* fsm, uint8_t state )
+{
+  assert( state < fsm->states_count );
+  if ( state == fsm->state )
+  {
+    return;
+  }
+
+  LOG( PRINT_INFO, "%s: %s -> %s", fsm->name, fsm->states[fsm->state].name, fsm->states[state].name );
+  if ( fsm->states[fsm->state].exit != NULL )
+  {
+    fsm->states[fsm->state].exit();
+  }
+  fsm->state = state;
+  if ( fsm->states[state].entry != NULL )
+  {
+    fsm->states[state].entry();
+  }
+}
+
+bool AppFsmPostInternal( app_fsm_t* fsm, app_msg_id_t msg_id, const void* data, uint32_t data_size )
+{
+  app_event_t event = {};
+  if ( data_size == 0 )
+  {
+    AppEventPrepareNoData( &event, msg_id, fsm->task, fsm->task );
+  }
+  else
+  {
+    AppEventPrepareWithData( &event, msg_id, fsm->task, fsm->task, data, data_size );
+  }
+
+  return AppEventPost( &event );
+}
+
+const char* AppFsmGetStateName( const app_fsm_t* fsm )
+{
+  return fsm->states[fsm->state].name;
+}
@@ -0,0 +1,117 @@
+/**
+ *******************************************************************************
+ * @file    app_fsm.h
+ * @author  Dmytro Shevchenko
+ * @brief   Module state machine framework header
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __APP_FSM_H__
+#define __APP_FSM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_events.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+/* Public macro --------------------------------------------------------------*/
+/**
+ * @brief   Module lists states as STATE( _state, _handlers, _entry, _exit ) and
+ *          expands the list with these macros to state enum and state table.
+ *          First state of the list is initial state.
+ */
+#define APP_FSM_STATE_ENUM( _state, _handlers, _entry, _exit ) _state,
+
+#define APP_FSM_STATE_ITEM( _state, _handlers, _entry, _exit ) \
+  [_state] = { .name = #_state, .handlers = ( _handlers ), .entry = ( _entry ), .exit = ( _exit ) },
+
+/** @brief  Worker of module which blocks for long time and needs own task */
+#define APP_FSM_OWN_TASK UINT8_MAX
+
+/* Public types --------------------------------------------------------------*/
+typedef void ( *app_fsm_action_t )( void );
+
+typedef struct
+{
+  const char* name;
+  const event_callback_t* handlers;
+  app_fsm_action_t entry;
+  app_fsm_action_t exit;
+} app_fsm_state_t;
+
+typedef struct
+{
+  /* Configuration, set by module */
+  const char* name;
+  app_events_task_t task;
+  const app_fsm_state_t* states;
+  uint8_t states_count;
+  uint8_t queue_length;
+  uint8_t worker;
+  uint16_t stack_size;
+
+  /* Runtime */
+  uint8_t state;
+  QueueHandle_t queue;
+} app_fsm_t;
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @brief   Create module queue and register it for events.
+ * @param   [in] fsm - state machine.
+ */
+void AppFsmInit( app_fsm_t* fsm );
+
+/**
+ * @brief   Start processing events, on executor worker if CONFIG_APP_EXECUTOR
+ *          is set and worker is not APP_FSM_OWN_TASK, otherwise on own task.
+ * @param   [in] fsm - state machine.
+ */
+void AppFsmStart( app_fsm_t* fsm );
+
+/**
+ * @brief   Wait for one event of module and dispatch it. Used by own task and
+ *          to run state machine on host.
+ * @param   [in] fsm - state machine.
+ * @param   [in] timeout - wait time in ticks.
+ * @return  true - if event was received
+ */
+bool AppFsmProcess( app_fsm_t* fsm, TickType_t timeout );
+
+/**
+ * @brief   Dispatch event to handler of current state.
+ * @param   [in] fsm - state machine.
+ * @param   [in] event - event to dispatch.
+ * @return  true - if state has handler for event
+ */
+bool AppFsmDispatch( app_fsm_t* fsm, const app_event_t* event );
+
+/**
+ * @brief   Change state running exit action of current state and entry action
+ *          of new state. Change to current state does nothing.
+ * @param   [in] fsm - state machine.
+ * @param   [in] state - new state.
+ */
+void AppFsmChangeState( app_fsm_t* fsm, uint8_t state );
+
+/**
+ * @brief   Post event from module to itself.
+ * @param   [in] fsm - state machine.
+ * @param   [in] msg_id - message id.
+ * @param   [in] data - event data, can be NULL.
+ * @param   [in] data_size - event data size.
+ * @return  true - if event was posted
+ */
+bool AppFsmPostInternal( app_fsm_t* fsm, app_msg_id_t msg_id, const void* data, uint32_t data_size );
+
+/**
+ * @brief   Get name of current state.
+ * @param   [in] fsm - state machine.
+ * @return  state name
+ */
+const char* AppFsmGetStateName( const app_fsm_t* fsm );
+
+#endif /* __APP_FSM_H__ */
@@ -20,6 +20,7 @@
   MSG( APP_MANAGER_INIT_RES )                     \
   MSG( APP_MANAGER_TIMEOUT_INIT )                 \
   MSG( APP_MANAGER_TEMP_SENSORS_SCAN_RES )        \
+  MSG( APP_MANAGER_TEMP_BUS_FAILED )              \
   MSG( APP_MANAGER_TEMP_WPS_TEST )                \
                                                   \
   /* Network manager ids */                       \
@@ -28,6 +29,10 @@
   MSG( NETWORK_MANAGER_TCP_SERVER_CLIENT_STATUS ) \
   MSG( NETWORK_MANAGER_WIFI_CONNECT_STATUS )      \
                                                   \
+  /* Network manager published ids */             \
+  MSG( NETWORK_LINK_UP )                          \
+  MSG( NETWORK_LINK_DOWN )                        \
+                                                  \
   /* Wifi internal msg ids */                     \
   MSG( WIFI_UPDATE_WIFI_INFO )                    \
                                                   \
@@ -37,12 +42,16 @@
   MSG( TEMPERATURE_START_MEASURE )                \
   MSG( TEMPERATURE_STOP_MEASURE )                 \
                                                   \
+  /* Temperature published ids */                 \
+  MSG( TEMPERATURE_SENSOR_ADDED )                 \
+  MSG( TEMPERATURE_SENSOR_REMOVED )               \
+                                                  \
   /* Temperature internal msg ids */              \
   MSG( TEMPERATURE_MEASURE_REQ )                  \
+  MSG( TEMPERATURE_CONVERSION_DONE )              \
+  MSG( TEMPERATURE_BUS_FAILED )                   \
                                                   \
   /* TCP Server msg ids */                        \
-  MSG( TCP_SERVER_ETHERNET_CONNECTED )            \
-  MSG( TCP_SERVER_ETHERNET_DISCONNECTED )         \
   MSG( TCP_SERVER_SEND_DATA )                     \
                                                   \
   /* OTA */                                       \
@@ -50,13 +59,10 @@
   MSG( OTA_POST_CONFIG_DATA )                     \
   MSG( OTA_DOWNLOAD_IMAGE )                       \
   MSG( OTA_POST_OTA_RESULT )                      \
-  MSG( OTA_STOP_POLL_SERVER )                     \
                                                   \
   /* MQTT */                                      \
   MSG( MQTT_APP_CONNECT )                         \
   MSG( MQTT_APP_SUBSCRIBE )                       \
-  MSG( MQTT_ETH_CONNECTED )                       \
-  MSG( MQTT_ETH_DISCONNECTED )                    \
   MSG( MQTT_APP_UPDATE_CONFIG )                   \
   MSG( MQTT_APP_POST_DATA )                       \
   MSG( MQTT_APP_DISCONNECT )                      \
@@ -64,6 +70,7 @@
   /* Device Manager */                            \
   MSG( DEV_MANAGER_MEASURE )                      \
   MSG( DEV_MANAGER_POST )                         \
+  MSG( DEV_MANAGER_SET_FILTER )                   \
                                                   \
   /* TCP Server internal msg ids */               \
   MSG( TCP_SERVER_WAIT_CONNECTION )               \
@@ -78,6 +85,7 @@ typedef enum
 #define MSG( _enum_id ) MSG_ID_##_enum_id,
   MSG_IDS_LIST
 #undef MSG
+    MSG_ID_LAST
 } app_msg_id_t;
 
 #endif /* __MSG_IDS_H__ */
@@ -2,7 +2,10 @@
  *******************************************************************************
  * @file    app_timers.c
  * @author  Dmytro Shevchenko
- * @brief   App timers implementation
+ * @brief   App timers implementation. All module timers are kept in one
+ *          hierarchical timer wheel driven by esp_timer (tick task on host),
+ *          expired timer posts its message straight to module queue. Tick
+ *          runs only while timers are active and never blocks.
  *******************************************************************************
  */
 
@@ -14,6 +17,11 @@
 #include <stdlib.h>
 
 #include "app_config.h"
+#include "freertos/task.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#endif
 
 /* Private macros ------------------------------------------------------------*/
 #define MODULE_NAME "[AppTimer] "
@@ -26,28 +34,382 @@
 #define LOG( PRINT_INFO, ... )
 #endif
 
+#define TICK_MS      CONFIG_APP_TIMERS_TICK_MS
+#define WHEEL_BITS   CONFIG_APP_TIMERS_WHEEL_BITS
+#define WHEEL_LEVELS CONFIG_APP_TIMERS_WHEEL_LEVELS
+#define WHEEL_SLOTS  ( 1UL << WHEEL_BITS )
+#define WHEEL_MASK   ( WHEEL_SLOTS - 1 )
+
+/* Longest delay in ticks which fits into wheel, longer timers are cascaded again from top level */
+#define WHEEL_MAX_DELTA ( ( 1UL << ( WHEEL_BITS * WHEEL_LEVELS ) ) - 1 )
+
+_Static_assert( WHEEL_BITS * WHEEL_LEVELS < 32, "Timer wheel doesn't fit into 32-bit ticks" );
+
+/* Wheel is changed from tick, so it is guarded by critical section instead of mutex */
+#ifdef ESP_PLATFORM
+#define LOCK()   portENTER_CRITICAL( &lock )
+#define UNLOCK() portEXIT_CRITICAL( &lock )
+#else
+#define LOCK()   taskENTER_CRITICAL()
+#define UNLOCK() taskEXIT_CRITICAL()
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static struct
+{
+  app_timer_t* wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+  app_timer_t* expired;
+  uint32_t jiffies;
+  uint32_t time_ms;
+  uint32_t now_ms;
+  bool initialized;
+  bool ticking;
+#ifdef ESP_PLATFORM
+  esp_timer_handle_t tick_timer;
+#else
+  TaskHandle_t tick_task;
+#endif
+  app_timers_stats_t stats;
+} ctx;
+
+#ifdef ESP_PLATFORM
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+
+static void _list_add( app_timer_t** head, app_timer_t* timer )
+{
+  timer->next = *head;
+  if ( timer->next != NULL )
+  {
+    timer->next->pprev = &timer->next;
+  }
+  *head = timer;
+  timer->pprev = head;
+}
+
+static void _list_del( app_timer_t* timer )
+{
+  *timer->pprev = timer->next;
+  if ( timer->next != NULL )
+  {
+    timer->next->pprev = timer->pprev;
+  }
+  timer->next = NULL;
+  timer->pprev = NULL;
+}
+
+static void _wheel_add( app_timer_t* timer )
+{
+  uint32_t delta = timer->expires - ctx.jiffies;
+  uint32_t expires = timer->expires;
+
+  if ( delta > WHEEL_MAX_DELTA )
+  {
+    expires = ctx.jiffies + WHEEL_MAX_DELTA;
+    delta = WHEEL_MAX_DELTA;
+  }
+
+  uint32_t level = 0;
+  while ( level < WHEEL_LEVELS - 1 && delta >= ( 1UL << ( WHEEL_BITS * ( level + 1 ) ) ) )
+  {
+    level++;
+  }
+  _list_add( &ctx.wheel[level][( expires >> ( WHEEL_BITS * level ) ) & WHEEL_MASK], timer );
+}
+
+static void _wheel_tick( void )
+{
+  ctx.jiffies++;
+
+  /* Move timers of next upper level slot down when lower level wraps */
+  for ( uint32_t level = 1; level < WHEEL_LEVELS; level++ )
+  {
+    if ( ( ctx.jiffies & ( ( 1UL << ( WHEEL_BITS * level ) ) - 1 ) ) != 0 )
+    {
+      break;
+    }
+
+    app_timer_t** slot = &ctx.wheel[level][( ctx.jiffies >> ( WHEEL_BITS * level ) ) & WHEEL_MASK];
+    while ( *slot != NULL )
+    {
+      app_timer_t* timer = *slot;
+      _list_del( timer );
+      _wheel_add( timer );
+    }
+  }
+
+  app_timer_t** slot = &ctx.wheel[0][ctx.jiffies & WHEEL_MASK];
+  while ( *slot != NULL )
+  {
+    app_timer_t* timer = *slot;
+    _list_del( timer );
+    if ( timer->expires == ctx.jiffies )
+    {
+      _list_add( &ctx.expired, timer );
+    }
+    else
+    {
+      /* Clamped timer longer than wheel */
+      _wheel_add( timer );
+    }
+  }
+}
+
+static void _schedule( app_timer_t* timer )
+{
+  /* Wheel time lags current time up to one tick, rounded up so timer never fires early */
+  timer->expires = ctx.jiffies + ( timer->due_ms - ctx.time_ms + TICK_MS - 1 ) / TICK_MS;
+  if ( timer->expires == ctx.jiffies )
+  {
+    timer->expires++;
+  }
+  _wheel_add( timer );
+}
+
+static void _schedule_next_period( app_timer_t* timer )
+{
+  timer->due_ms += timer->timeout_ms;
+
+  /* Deadlines with already processed wheel tick are dropped instead of firing in burst */
+  if ( (int32_t) ( timer->due_ms - ctx.time_ms ) <= 0 )
+  {
+    uint32_t missed = ( ctx.time_ms - timer->due_ms ) / timer->timeout_ms + 1;
+    timer->due_ms += missed * timer->timeout_ms;
+    timer->skipped_count += missed;
+    ctx.stats.skipped_count += missed;
+  }
+  _schedule( timer );
+}
+
+static uint32_t _get_now_ms( void )
+{
+  uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+  /* Last processed time can be ahead of tick count only when processed by hand */
+  return (int32_t) ( now_ms - ctx.now_ms ) > 0 ? now_ms : ctx.now_ms;
+}
+
+static void _skip_idle_ticks( uint32_t now_ms )
+{
+  /* Wheel is empty while tick is stopped, so ticks missed meanwhile are skipped at once */
+  if ( (int32_t) ( now_ms - ctx.time_ms ) >= TICK_MS )
+  {
+    uint32_t ticks = ( now_ms - ctx.time_ms ) / TICK_MS;
+    ctx.time_ms += ticks * TICK_MS;
+    ctx.jiffies += ticks;
+  }
+}
+
+static void _arm_tick( void )
+{
+#ifdef ESP_PLATFORM
+  esp_timer_start_once( ctx.tick_timer, TICK_MS * 1000 );
+#else
+  xTaskNotifyGive( ctx.tick_task );
+#endif
+}
+
+static void _tick( void )
+{
+  AppTimersProcess( xTaskGetTickCount() * portTICK_PERIOD_MS );
+
+  /* Tick stops with last active timer, AppTimerStart arms it again */
+  LOCK();
+  ctx.ticking = ctx.stats.active_count > 0;
+  bool rearm = ctx.ticking;
+  UNLOCK();
+  if ( rearm )
+  {
+    _arm_tick();
+  }
+}
+
+#ifdef ESP_PLATFORM
+static void _tick_cb( void* arg )
+{
+  _tick();
+}
+#else
+/* No esp_timer on host, task sleeps one tick after each arm */
+static void _tick_task( void* arg )
+{
+  while ( 1 )
+  {
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+    vTaskDelay( pdMS_TO_TICKS( TICK_MS ) );
+    _tick();
+  }
+}
+#endif
+
 /* Public functions ----------------------------------------------------------*/
 
-void AppTimersInit( app_timer_t* timers, uint32_t timers_cnt )
+void AppTimersInit( app_events_task_t task, app_timer_t* timers, uint32_t timers_cnt )
 {
+  if ( !ctx.initialized )
+  {
+    ctx.initialized = true;
+    ctx.time_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    ctx.now_ms = ctx.time_ms;
+#ifdef ESP_PLATFORM
+    const esp_timer_create_args_t tick_args = {
+      .callback = _tick_cb,
+      .name = "AppTimers",
+    };
+    if ( esp_timer_create( &tick_args, &ctx.tick_timer ) != ESP_OK )
+    {
+      assert( 0 );
+    }
+#else
+    if ( xTaskCreate( _tick_task, "AppTimers", configMINIMAL_STACK_SIZE, NULL, configTIMER_TASK_PRIORITY, &ctx.tick_task ) != pdPASS )
+    {
+      assert( 0 );
+    }
+#endif
+  }
+
   for ( int i = 0; i < timers_cnt; i++ )
   {
-    timers[i].timer = xTimerCreate( timers[i].timer_name, pdMS_TO_TICKS( timers[i].timeout_ms ), pdFALSE, NULL, timers[i].callback );
+    assert( timers[i].msg_id < MSG_ID_LAST );
+    assert( !timers[i].periodic || timers[i].timeout_ms >= TICK_MS );
+    timers[i].task = task;
+    timers[i].next = NULL;
+    timers[i].pprev = NULL;
   }
 }
 
 void AppTimerStart( app_timer_t* timers, uint32_t id )
 {
-  if ( xTimerStart( timers[id].timer, 0 ) != pdPASS )
+  app_timer_t* timer = &timers[id];
+  uint32_t now_ms = _get_now_ms();
+
+  LOCK();
+  if ( timer->pprev != NULL )
+  {
+    _list_del( timer );
+  }
+  else
+  {
+    if ( ctx.stats.active_count == 0 )
+    {
+      _skip_idle_ticks( now_ms );
+    }
+    ctx.stats.active_count++;
+    if ( ctx.stats.active_count > ctx.stats.max_active_count )
+    {
+      ctx.stats.max_active_count = ctx.stats.active_count;
+    }
+  }
+
+  timer->due_ms = now_ms + timer->timeout_ms;
+  _schedule( timer );
+  bool arm = !ctx.ticking;
+  ctx.ticking = true;
+  UNLOCK();
+
+  if ( arm )
   {
-    assert( 0 );
+    _arm_tick();
   }
 }
 
 void AppTimerStop( app_timer_t* timers, uint32_t id )
 {
-  if ( xTimerStop( timers[id].timer, 0 ) != pdPASS )
+  app_timer_t* timer = &timers[id];
+
+  LOCK();
+  if ( timer->pprev != NULL )
   {
-    assert( 0 );
+    _list_del( timer );
+    ctx.stats.active_count--;
   }
+  UNLOCK();
+}
+
+void AppTimersProcess( uint32_t now_ms )
+{
+  LOCK();
+  ctx.now_ms = now_ms;
+  while ( (int32_t) ( now_ms - ctx.time_ms ) >= TICK_MS )
+  {
+    ctx.time_ms += TICK_MS;
+    _wheel_tick();
+  }
+  UNLOCK();
+
+  /* Posted one by one outside of lock and without waiting, full queue drops timer event */
+  while ( 1 )
+  {
+    LOCK();
+    app_timer_t* timer = ctx.expired;
+    if ( timer == NULL )
+    {
+      UNLOCK();
+      break;
+    }
+    _list_del( timer );
+
+    uint32_t lateness_ms = (int32_t) ( now_ms - timer->due_ms ) > 0 ? now_ms - timer->due_ms : 0;
+    ctx.stats.fired_count++;
+    ctx.stats.total_lateness_ms += lateness_ms;
+    if ( lateness_ms > TICK_MS )
+    {
+      ctx.stats.late_count++;
+    }
+    if ( lateness_ms > ctx.stats.max_lateness_ms )
+    {
+      ctx.stats.max_lateness_ms = lateness_ms;
+    }
+
+    bool post = true;
+    if ( timer->periodic )
+    {
+      if ( AppEventIsPending( timer->task, timer->msg_id ) )
+      {
+        timer->overrun_count++;
+        ctx.stats.overrun_count++;
+        post = false;
+      }
+      _schedule_next_period( timer );
+    }
+    else
+    {
+      ctx.stats.active_count--;
+    }
+
+    app_event_t event = {};
+    AppEventPrepareNoData( &event, timer->msg_id, timer->task, timer->task );
+    UNLOCK();
+
+    LOG( PRINT_DEBUG, "%s fired, late %lu ms", timer->timer_name, (unsigned long) lateness_ms );
+    if ( post )
+    {
+      AppEventTryPost( &event );
+    }
+  }
+}
+
+uint32_t AppTimersGetTime( void )
+{
+  return ctx.now_ms;
+}
+
+void AppTimersGetStats( app_timers_stats_t* stats )
+{
+  assert( stats );
+  LOCK();
+  *stats = ctx.stats;
+  UNLOCK();
+}
+
+void AppTimersResetStats( void )
+{
+  LOCK();
+  ctx.stats = (app_timers_stats_t) {
+    .active_count = ctx.stats.active_count,
+    .max_active_count = ctx.stats.active_count,
+  };
+  UNLOCK();
 }
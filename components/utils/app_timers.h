@@ -13,43 +13,101 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "app_events.h"
 #include "app_msg_id.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/timers.h"
 
 /* Public macro --------------------------------------------------------------*/
-#define TIMER_ITEM( _id, _callback, _timeout, _name ) \
-  [_id] = { .callback = ( _callback ), .timeout_ms = ( _timeout ), .timer_name = ( _name ) }
+/**
+ * @brief   Timer of module. On expiry _msg_id is posted to module queue.
+ */
+#define TIMER_ITEM( _id, _msg_id, _timeout, _name ) \
+  [_id] = { .msg_id = ( _msg_id ), .timeout_ms = ( _timeout ), .timer_name = ( _name ) }
+
+/**
+ * @brief   Periodic timer of module. Fires on absolute deadlines start + n * period,
+ *          so handler time doesn't add up. Period is skipped, if module didn't
+ *          handle previous event yet (overrun) or deadline already passed.
+ */
+#define PERIODIC_TIMER_ITEM( _id, _msg_id, _period, _name ) \
+  [_id] = { .msg_id = ( _msg_id ), .timeout_ms = ( _period ), .timer_name = ( _name ), .periodic = true }
 
 /* Public types --------------------------------------------------------------*/
-typedef struct
+typedef struct app_timer
 {
-  TimerHandle_t timer;
   const char* timer_name;
   uint32_t timeout_ms;
-  void ( *callback )( TimerHandle_t xTimer );
+  app_msg_id_t msg_id;
+  app_events_task_t task;
+  bool periodic;
+  uint32_t overrun_count;
+  uint32_t skipped_count;
+
+  /* Timer wheel */
+  uint32_t due_ms;
+  uint32_t expires;
+  struct app_timer* next;
+  struct app_timer** pprev;
 } app_timer_t;
 
+typedef struct
+{
+  uint32_t fired_count;
+  uint32_t late_count;
+  uint32_t max_lateness_ms;
+  uint32_t total_lateness_ms;
+  uint32_t overrun_count;
+  uint32_t skipped_count;
+  uint16_t active_count;
+  uint16_t max_active_count;
+} app_timers_stats_t;
+
 /* Public functions ----------------------------------------------------------*/
 /**
  * @brief   Init module timers.
+ * @param   [in] task - module, owner of timers.
  * @param   [in] timers - timers array.
  * @param   [in] timers_cnt - timers array size.
  */
-void AppTimersInit( app_timer_t* timers, uint32_t timers_cnt );
+void AppTimersInit( app_events_task_t task, app_timer_t* timers, uint32_t timers_cnt );
 
 /**
- * @brief   Start timer.
+ * @brief   Start timer. Running timer is restarted, periodic timer starts new
+ *          deadlines from now.
  * @param   [in] timers - timers array.
- * @param   [in] timers_cnt - timers array size.
+ * @param   [in] id - timer id.
  */
 void AppTimerStart( app_timer_t* timers, uint32_t id );
 
 /**
  * @brief   Stop timer.
  * @param   [in] timers - timers array.
- * @param   [in] timers_cnt - timers array size.
+ * @param   [in] id - timer id.
  */
 void AppTimerStop( app_timer_t* timers, uint32_t id );
 
+/**
+ * @brief   Advance timer wheel and post events of expired timers without
+ *          blocking. Called by tick, tests call it directly.
+ * @param   [in] now_ms - current time, may wrap.
+ */
+void AppTimersProcess( uint32_t now_ms );
+
+/**
+ * @brief   Get time of timer wheel.
+ * @return  time in ms passed to last AppTimersProcess
+ */
+uint32_t AppTimersGetTime( void );
+
+/**
+ * @brief   Get timers statistics.
+ * @param   [out] stats - timers statistics.
+ */
+void AppTimersGetStats( app_timers_stats_t* stats );
+
+/**
+ * @brief   Reset timers statistics, except active timers count.
+ */
+void AppTimersResetStats( void );
+
 #endif /* __APP_TIMERS_H__ */
@@ -0,0 +1,220 @@
+/**
+ *******************************************************************************
+ * @file    signal_filter.c
+ * @author  Dmytro Shevchenko
+ * @brief   Fixed point filter chain. Every stage keeps own state inside filter,
+ *          so filter needs no heap and sample costs the same however long
+ *          filter runs.
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "signal_filter.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* Private macros ------------------------------------------------------------*/
+#define EMA_SHIFT 16
+
+_Static_assert( SIGNAL_FILTER_EMA_ONE == ( 1 << EMA_SHIFT ), "EMA alpha must be Q16" );
+
+/* Private functions ---------------------------------------------------------*/
+
+static bool _is_stage_valid( const signal_filter_stage_t* stage )
+{
+  switch ( stage->type )
+  {
+    case SIGNAL_FILTER_MEDIAN:
+      return stage->param > 0 && stage->param <= SIGNAL_FILTER_MEDIAN_TAPS && ( stage->param & 1 );
+    case SIGNAL_FILTER_EMA:
+      return stage->param > 0 && stage->param <= SIGNAL_FILTER_EMA_ONE;
+    case SIGNAL_FILTER_SPIKE:
+      return stage->param > 0;
+    case SIGNAL_FILTER_SLOPE:
+      return stage->param >= 2 && stage->param <= SIGNAL_FILTER_SLOPE_TAPS;
+    default:
+      return false;
+  }
+}
+
+static int32_t _median_process( signal_filter_median_t* median, uint32_t taps, int32_t sample )
+{
+  int32_t sorted[SIGNAL_FILTER_MEDIAN_TAPS];
+
+  median->samples[median->next] = sample;
+  median->next = ( median->next + 1 ) % taps;
+  if ( median->count < taps )
+  {
+    median->count++;
+  }
+
+  /* Insertion sort of at most 5 samples */
+  for ( uint32_t i = 0; i < median->count; i++ )
+  {
+    uint32_t j = i;
+    for ( ; j > 0 && sorted[j - 1] > median->samples[i]; j-- )
+    {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = median->samples[i];
+  }
+  return sorted[( median->count - 1 ) / 2];
+}
+
+static int32_t _ema_process( signal_filter_ema_t* ema, int32_t alpha, int32_t sample )
+{
+  int64_t target = (int64_t) sample * SIGNAL_FILTER_EMA_ONE;
+  if ( !ema->valid )
+  {
+    ema->value = target;
+    ema->valid = true;
+  }
+  else
+  {
+    /* Split keeps product in 64 bits for full range of samples */
+    int64_t diff = target - ema->value;
+    ema->value += diff / SIGNAL_FILTER_EMA_ONE * alpha + diff % SIGNAL_FILTER_EMA_ONE * alpha / SIGNAL_FILTER_EMA_ONE;
+  }
+  return ( ema->value + SIGNAL_FILTER_EMA_ONE / 2 ) >> EMA_SHIFT;
+}
+
+static int32_t _spike_process( signal_filter_spike_t* spike, int32_t max_delta, int32_t sample, uint32_t* rejected )
+{
+  int64_t delta = (int64_t) sample - spike->last;
+  if ( spike->valid && ( delta > max_delta || delta < -max_delta ) && spike->rejected < SIGNAL_FILTER_SPIKE_HOLD )
+  {
+    /* Last passed sample is held, sustained step passes after SIGNAL_FILTER_SPIKE_HOLD samples */
+    spike->rejected++;
+    ( *rejected )++;
+    return spike->last;
+  }
+  spike->last = sample;
+  spike->rejected = 0;
+  spike->valid = true;
+  return sample;
+}
+
+static int32_t _slope_process( signal_filter_slope_t* slope, uint32_t taps, uint32_t time_ms, int32_t sample )
+{
+  /* Sums are moved to time of newest sample, so time stays small however long filter runs */
+  int64_t n = slope->count;
+  int64_t shift = n ? (int32_t) ( time_ms - slope->base_ms ) : 0;
+  slope->sum_tt += n * shift * shift - 2 * shift * slope->sum_t;
+  slope->sum_ty -= shift * slope->sum_y;
+  slope->sum_t -= n * shift;
+  slope->base_ms = time_ms;
+
+  if ( slope->count == taps )
+  {
+    int64_t t = (int32_t) ( slope->time_ms[slope->next] - time_ms );
+    int64_t y = slope->samples[slope->next];
+    slope->sum_t -= t;
+    slope->sum_tt -= t * t;
+    slope->sum_y -= y;
+    slope->sum_ty -= t * y;
+    slope->count--;
+  }
+
+  /* Newest sample is at time 0, only sum of samples changes */
+  slope->time_ms[slope->next] = time_ms;
+  slope->samples[slope->next] = sample;
+  slope->next = ( slope->next + 1 ) % taps;
+  slope->count++;
+  slope->sum_y += sample;
+
+  n = slope->count;
+  int64_t den = n * slope->sum_tt - slope->sum_t * slope->sum_t;
+  if ( n < 2 || den == 0 )
+  {
+    return 0;
+  }
+
+  /* Least squares slope per ms, scaled to per second without overflow */
+  int64_t num = n * slope->sum_ty - slope->sum_t * slope->sum_y;
+  int64_t per_s = num / den * 1000 + num % den * 1000 / den;
+  if ( per_s > INT32_MAX )
+  {
+    return INT32_MAX;
+  }
+  if ( per_s < INT32_MIN )
+  {
+    return INT32_MIN;
+  }
+  return per_s;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+bool SignalFilterIsValid( const signal_filter_stage_t* stages, size_t count )
+{
+  if ( count > SIGNAL_FILTER_MAX_STAGES || ( count > 0 && stages == NULL ) )
+  {
+    return false;
+  }
+  for ( size_t i = 0; i < count; i++ )
+  {
+    if ( !_is_stage_valid( &stages[i] ) )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SignalFilterInit( signal_filter_t* filter, const signal_filter_stage_t* stages, size_t count )
+{
+  assert( filter );
+  if ( !SignalFilterIsValid( stages, count ) )
+  {
+    return false;
+  }
+  memset( filter, 0, sizeof( *filter ) );
+  if ( count > 0 )
+  {
+    memcpy( filter->stages, stages, count * sizeof( stages[0] ) );
+  }
+  filter->stages_count = count;
+  return true;
+}
+
+void SignalFilterReset( signal_filter_t* filter )
+{
+  assert( filter );
+  memset( filter->state, 0, sizeof( filter->state ) );
+  filter->value = 0;
+  filter->slope = 0;
+  filter->rejected = 0;
+}
+
+int32_t SignalFilterProcess( signal_filter_t* filter, uint32_t time_ms, int32_t sample )
+{
+  assert( filter );
+  int32_t value = sample;
+
+  for ( size_t i = 0; i < filter->stages_count; i++ )
+  {
+    const signal_filter_stage_t* stage = &filter->stages[i];
+    switch ( stage->type )
+    {
+      case SIGNAL_FILTER_MEDIAN:
+        value = _median_process( &filter->state[i].median, stage->param, value );
+        break;
+      case SIGNAL_FILTER_EMA:
+        value = _ema_process( &filter->state[i].ema, stage->param, value );
+        break;
+      case SIGNAL_FILTER_SPIKE:
+        value = _spike_process( &filter->state[i].spike, stage->param, value, &filter->rejected );
+        break;
+      case SIGNAL_FILTER_SLOPE:
+        /* Value passes unchanged, slope is of value at this point of chain */
+        filter->slope = _slope_process( &filter->state[i].slope, stage->param, time_ms, value );
+        break;
+      default:
+        assert( 0 );
+        break;
+    }
+  }
+  filter->value = value;
+  return value;
+}
@@ -0,0 +1,129 @@
+/**
+ *******************************************************************************
+ * @file    signal_filter.h
+ * @author  Dmytro Shevchenko
+ * @brief   Fixed point filter chain for sensor samples
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+
+#ifndef _SIGNAL_FILTER_H_
+#define _SIGNAL_FILTER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Public macro --------------------------------------------------------------*/
+#define SIGNAL_FILTER_MAX_STAGES  4
+#define SIGNAL_FILTER_MEDIAN_TAPS 5
+#define SIGNAL_FILTER_SLOPE_TAPS  16
+
+/** @brief  EMA alpha is fraction of SIGNAL_FILTER_EMA_ONE */
+#define SIGNAL_FILTER_EMA_ONE 65536
+
+/** @brief  Spike gate passes level step after this many rejected samples */
+#define SIGNAL_FILTER_SPIKE_HOLD 3
+
+/* Public types --------------------------------------------------------------*/
+typedef enum
+{
+  SIGNAL_FILTER_MEDIAN, /* param - odd number of taps, up to SIGNAL_FILTER_MEDIAN_TAPS */
+  SIGNAL_FILTER_EMA,    /* param - alpha, 1..SIGNAL_FILTER_EMA_ONE */
+  SIGNAL_FILTER_SPIKE,  /* param - max difference from last passed sample */
+  SIGNAL_FILTER_SLOPE,  /* param - samples of least squares window, 2..SIGNAL_FILTER_SLOPE_TAPS */
+  SIGNAL_FILTER_LAST
+} signal_filter_type_t;
+
+typedef struct
+{
+  signal_filter_type_t type;
+  int32_t param;
+} signal_filter_stage_t;
+
+typedef struct
+{
+  int32_t samples[SIGNAL_FILTER_MEDIAN_TAPS];
+  uint32_t count;
+  uint32_t next;
+} signal_filter_median_t;
+
+typedef struct
+{
+  int64_t value; /* Q16 */
+  bool valid;
+} signal_filter_ema_t;
+
+typedef struct
+{
+  int32_t last;
+  uint32_t rejected;
+  bool valid;
+} signal_filter_spike_t;
+
+typedef struct
+{
+  uint32_t time_ms[SIGNAL_FILTER_SLOPE_TAPS];
+  int32_t samples[SIGNAL_FILTER_SLOPE_TAPS];
+  uint32_t count;
+  uint32_t next;
+  uint32_t base_ms;
+
+  /* Sums of window, time relative to base_ms */
+  int64_t sum_t;
+  int64_t sum_tt;
+  int64_t sum_y;
+  int64_t sum_ty;
+} signal_filter_slope_t;
+
+typedef struct
+{
+  signal_filter_stage_t stages[SIGNAL_FILTER_MAX_STAGES];
+  union
+  {
+    signal_filter_median_t median;
+    signal_filter_ema_t ema;
+    signal_filter_spike_t spike;
+    signal_filter_slope_t slope;
+  } state[SIGNAL_FILTER_MAX_STAGES];
+  size_t stages_count;
+
+  int32_t value;
+  int32_t slope; /* Per second, 0 without slope stage */
+  uint32_t rejected;
+} signal_filter_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief   Set stages of filter, samples are passed through stages in given order.
+ * @param   [out] filter - filter.
+ * @param   [in] stages - stages, NULL when count is 0.
+ * @param   [in] count - number of stages, 0 passes samples unchanged.
+ * @return  false - some stage has invalid type or param, filter is not changed
+ */
+bool SignalFilterInit( signal_filter_t* filter, const signal_filter_stage_t* stages, size_t count );
+
+/**
+ * @brief   Check stages before they are passed to other task.
+ * @return  true - stages are valid
+ */
+bool SignalFilterIsValid( const signal_filter_stage_t* stages, size_t count );
+
+/**
+ * @brief   Drop state of all stages, e.g. when sensor was replaced.
+ * @param   [in] filter - filter.
+ */
+void SignalFilterReset( signal_filter_t* filter );
+
+/**
+ * @brief   Pass sample through filter, constant work per sample.
+ * @param   [in] filter - filter.
+ * @param   [in] time_ms - time of sample, slope is computed against it.
+ * @param   [in] sample - sample in fixed point unit of channel.
+ * @return  filtered value, also kept in filter->value
+ */
+int32_t SignalFilterProcess( signal_filter_t* filter, uint32_t time_ms, int32_t sample );
+
+#endif
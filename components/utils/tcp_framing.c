@@ -0,0 +1,162 @@
+/**
+ *******************************************************************************
+ * @file    tcp_framing.c
+ * @author  Dmytro Shevchenko
+ * @brief   Reassembly of magic word framed messages from TCP stream. Buffer is
+ *          linear, so every frame is contiguous and parsed in place, only tail
+ *          of partial frame is moved to front after processing.
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "tcp_framing.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* Private macros ------------------------------------------------------------*/
+#define MAGIC_SIZE 4
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t magic[MAGIC_SIZE] = {
+  (uint8_t) TCP_FRAMING_MAGIC_WORD,
+  (uint8_t) ( TCP_FRAMING_MAGIC_WORD >> 8 ),
+  (uint8_t) ( TCP_FRAMING_MAGIC_WORD >> 16 ),
+  (uint8_t) ( TCP_FRAMING_MAGIC_WORD >> 24 ),
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint32_t _get_u32( const uint8_t* data )
+{
+  return (uint32_t) data[0] | ( (uint32_t) data[1] << 8 ) | ( (uint32_t) data[2] << 16 ) | ( (uint32_t) data[3] << 24 );
+}
+
+static size_t _find_magic( const uint8_t* data, size_t len )
+{
+  /* memchr skips to candidates, full compare only on first byte match */
+  size_t pos = 0;
+  while ( pos < len )
+  {
+    const uint8_t* candidate = memchr( &data[pos], magic[0], len - pos );
+    if ( candidate == NULL )
+    {
+      return len;
+    }
+    pos = candidate - data;
+    size_t available = len - pos < MAGIC_SIZE ? len - pos : MAGIC_SIZE;
+    if ( memcmp( candidate, magic, available ) == 0 )
+    {
+      /* Magic word or its beginning at end of data */
+      return pos;
+    }
+    pos++;
+  }
+  return len;
+}
+
+static size_t _process( tcp_framing_t* framing, tcp_framing_cb cb, void* user_data )
+{
+  size_t frames = 0;
+  size_t pos = 0;
+
+  while ( framing->len - pos >= TCP_FRAMING_HEADER_SIZE )
+  {
+    uint8_t* header = &framing->buffer[pos];
+    if ( memcmp( header, magic, MAGIC_SIZE ) != 0 )
+    {
+      size_t next = pos + 1 + _find_magic( header + 1, framing->len - pos - 1 );
+      framing->dropped_bytes += next - pos;
+      pos = next;
+      continue;
+    }
+
+    uint32_t frame_len = _get_u32( &header[MAGIC_SIZE] );
+    if ( frame_len > framing->max_frame )
+    {
+      /* Length can't be trusted, look for next magic word behind this one */
+      framing->oversized++;
+      framing->dropped_bytes += MAGIC_SIZE;
+      pos += MAGIC_SIZE;
+      continue;
+    }
+    if ( framing->len - pos - TCP_FRAMING_HEADER_SIZE < frame_len )
+    {
+      break;
+    }
+
+    /* Valid header, jump straight over frame */
+    cb( &header[TCP_FRAMING_HEADER_SIZE], frame_len, user_data );
+    pos += TCP_FRAMING_HEADER_SIZE + frame_len;
+    framing->frames++;
+    frames++;
+  }
+
+  /* Short tail is kept only from beginning of magic word */
+  if ( framing->len - pos < TCP_FRAMING_HEADER_SIZE )
+  {
+    size_t next = pos + _find_magic( &framing->buffer[pos], framing->len - pos );
+    framing->dropped_bytes += next - pos;
+    pos = next;
+  }
+
+  if ( pos > 0 )
+  {
+    framing->len -= pos;
+    memmove( framing->buffer, &framing->buffer[pos], framing->len );
+  }
+  return frames;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void TCPFraming_Init( tcp_framing_t* framing, uint8_t* buffer, size_t size, size_t max_frame )
+{
+  assert( framing );
+  assert( buffer );
+  assert( size >= TCP_FRAMING_HEADER_SIZE + max_frame );
+  memset( framing, 0, sizeof( *framing ) );
+  framing->buffer = buffer;
+  framing->size = size;
+  framing->max_frame = max_frame;
+}
+
+void TCPFraming_Reset( tcp_framing_t* framing )
+{
+  assert( framing );
+  framing->len = 0;
+}
+
+uint8_t* TCPFraming_GetWriteBuffer( tcp_framing_t* framing, size_t* space )
+{
+  assert( framing );
+  assert( space );
+  *space = framing->size - framing->len;
+  return &framing->buffer[framing->len];
+}
+
+size_t TCPFraming_Commit( tcp_framing_t* framing, size_t len, tcp_framing_cb cb, void* user_data )
+{
+  assert( framing );
+  assert( cb );
+  assert( len <= framing->size - framing->len );
+  framing->len += len;
+  return _process( framing, cb, user_data );
+}
+
+size_t TCPFraming_Push( tcp_framing_t* framing, const uint8_t* data, size_t len, tcp_framing_cb cb, void* user_data )
+{
+  assert( data || len == 0 );
+  size_t frames = 0;
+  while ( len > 0 )
+  {
+    size_t space = 0;
+    uint8_t* dst = TCPFraming_GetWriteBuffer( framing, &space );
+    size_t chunk = len < space ? len : space;
+    memcpy( dst, data, chunk );
+    frames += TCPFraming_Commit( framing, chunk, cb, user_data );
+    data += chunk;
+    len -= chunk;
+  }
+  return frames;
+}
@@ -0,0 +1,87 @@
+/**
+ *******************************************************************************
+ * @file    tcp_framing.h
+ * @author  Dmytro Shevchenko
+ * @brief   Reassembly of magic word framed messages from TCP stream
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+
+#ifndef _TCP_FRAMING_H_
+#define _TCP_FRAMING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Public macro --------------------------------------------------------------*/
+
+/** @brief  Frame is magic word and payload length, both 32 bits little endian, then payload */
+#define TCP_FRAMING_MAGIC_WORD  0xDEADBEAF
+#define TCP_FRAMING_HEADER_SIZE 8
+
+/* Public types --------------------------------------------------------------*/
+
+/**
+ * @brief   Called for every complete frame, payload points into buffer of framing
+ *          and is valid only during callback.
+ */
+typedef void ( *tcp_framing_cb )( const uint8_t* payload, size_t len, void* user_data );
+
+typedef struct
+{
+  uint8_t* buffer;
+  size_t size;
+  size_t len;
+  size_t max_frame;
+
+  /* Statistics */
+  uint32_t frames;
+  uint32_t oversized;
+  uint32_t dropped_bytes;
+} tcp_framing_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief   Init framing of one connection.
+ * @param   [out] framing - framing.
+ * @param   [in] buffer - reassembly buffer, frames are parsed in place.
+ * @param   [in] size - buffer size, at least TCP_FRAMING_HEADER_SIZE + max_frame.
+ * @param   [in] max_frame - longest accepted payload, longer frames are skipped.
+ */
+void TCPFraming_Init( tcp_framing_t* framing, uint8_t* buffer, size_t size, size_t max_frame );
+
+/**
+ * @brief   Drop partial frame, e.g. when new client connects.
+ */
+void TCPFraming_Reset( tcp_framing_t* framing );
+
+/**
+ * @brief   Get free space of buffer, socket reads straight into it.
+ * @param   [in] framing - framing.
+ * @param   [out] space - free bytes.
+ * @return  pointer to free space
+ */
+uint8_t* TCPFraming_GetWriteBuffer( tcp_framing_t* framing, size_t* space );
+
+/**
+ * @brief   Take bytes written to buffer from TCPFraming_GetWriteBuffer and pass
+ *          complete frames to callback. Partial frame waits for next bytes.
+ * @param   [in] framing - framing.
+ * @param   [in] len - bytes written.
+ * @param   [in] cb - frame callback.
+ * @param   [in] user_data - callback argument.
+ * @return  number of frames passed to callback
+ */
+size_t TCPFraming_Commit( tcp_framing_t* framing, size_t len, tcp_framing_cb cb, void* user_data );
+
+/**
+ * @brief   Copy data to buffer and process it, data longer than free space is
+ *          processed in parts.
+ * @return  number of frames passed to callback
+ */
+size_t TCPFraming_Push( tcp_framing_t* framing, const uint8_t* data, size_t len, tcp_framing_cb cb, void* user_data );
+
+#endif
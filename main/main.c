@@ -3,6 +3,7 @@
 
 #include "app_config.h"
 #include "app_events.h"
+#include "app_executor.h"
 #include "app_manager.h"
 #include "dev_config.h"
 #include "esp_err.h"
@@ -104,6 +105,7 @@ void app_init( void )
   nvs_flash_init();
   nvs_sync_create();
   fs_init();
+  OWUart_BoardInit();
   DevConfig_Init();
 }
 
@@ -112,6 +114,9 @@ void app_main( void )
   app_init();
 
   configInit();
+#if CONFIG_APP_EXECUTOR
+  AppExecutorInit();
+#endif
   wifiDrvInit( WIFI_TYPE_DEVICE );
   NetworkManagerInit();
   TemperatureInit();
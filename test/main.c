@@ -6,6 +6,16 @@
 static void RunAllTests( void )
 {
   RUN_TEST_GROUP(JsonParser);
+  RUN_TEST_GROUP(MqttJsonParser);
+  RUN_TEST_GROUP(AppEvents);
+  RUN_TEST_GROUP(AppExecutor);
+  RUN_TEST_GROUP(AppFsm);
+  RUN_TEST_GROUP(AppTimers);
+  RUN_TEST_GROUP(OneWire);
+  RUN_TEST_GROUP(TempHistory);
+  RUN_TEST_GROUP(SignalFilter);
+  RUN_TEST_GROUP(OneWireSim);
+  RUN_TEST_GROUP(TcpFraming);
 }
 
 int main( int argc, const char* argv[] )
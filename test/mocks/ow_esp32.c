@@ -19,6 +19,10 @@ typedef struct
 static ow_ctx_t ctx;
 
 /* Private functions ---------------------------------------------------------*/
+void OWUart_BoardInit( void )
+{
+}
+
 uint8_t OWUart_init( void* arg )
 {
   return 1;
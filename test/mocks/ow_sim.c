@@ -0,0 +1,513 @@
+/**
+ *******************************************************************************
+ * @file    ow_sim.c
+ * @author  Dmytro Shevchenko
+ * @brief   Simulated 1-Wire bus. UART bytes are decoded like on real wire:
+ *          reset pulse at 9600 baud, one time slot per byte at 115200 baud.
+ *          Bus is wired-AND of master and all present devices.
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ow_sim.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* Private macros ------------------------------------------------------------*/
+#define RESET_BAUDRATE    9600
+#define SLOT_BAUDRATE     115200
+#define PRESENCE_RESPONSE 0xE0
+#define UART_BYTE_BITS    10
+
+#define SCRATCHPAD_SIZE 9
+#define POWER_UP_TEMP   0x0550 /* 85 C */
+#define POWER_UP_TH     0x4B
+#define POWER_UP_TL     0x46
+#define POWER_UP_CONFIG 0x7F /* 12 bits */
+
+#define CONVERSION_9_BITS_NS 93750000ULL
+#define CONVERSION_S_NS      750000000ULL
+
+#define CMD_SEARCH_ROM  0xF0
+#define CMD_READ_ROM    0x33
+#define CMD_MATCH_ROM   0x55
+#define CMD_SKIP_ROM    0xCC
+#define CMD_ALARM       0xEC
+#define CMD_CONVERT     0x44
+#define CMD_WSCRATCHPAD 0x4E
+#define CMD_RSCRATCHPAD 0xBE
+#define CMD_CPYSCRATCH  0x48
+
+/* Private types -------------------------------------------------------------*/
+typedef enum
+{
+  SIM_IDLE,
+  SIM_ROM_CMD,
+  SIM_MATCH_ROM,
+  SIM_FUNCTION_CMD,
+  SIM_SEARCH,
+  SIM_READ_ROM,
+  SIM_READ_SCRATCHPAD,
+  SIM_WRITE_SCRATCHPAD,
+  SIM_CONVERTING,
+} sim_state_t;
+
+typedef struct
+{
+  ow_rom_t rom;
+  bool is_s;
+  bool present;
+  bool stuck_low;
+  int16_t temp; /* 1/16 C */
+
+  uint8_t scratchpad[SCRATCHPAD_SIZE];
+  bool alarm;
+  bool converting;
+  uint64_t conversion_end_ns;
+  uint32_t crc_faults;
+
+  /* Protocol state, bits are LSB first */
+  sim_state_t state;
+  uint8_t byte;
+  uint32_t bit;
+  uint8_t read_buf[SCRATCHPAD_SIZE];
+  uint32_t search_slot;
+} sim_device_t;
+
+typedef struct
+{
+  sim_device_t devices[OW_SIM_MAX_DEVICES];
+  size_t count;
+  uint32_t baudrate;
+  uint64_t time_ns;
+  uint32_t transfers_to_fault;
+  uint32_t transfer_faults;
+  ow_sim_stats_t stats;
+} sim_bus_t;
+
+/* Private variables ---------------------------------------------------------*/
+static sim_bus_t bus;
+
+/* Private functions ---------------------------------------------------------*/
+
+static sim_device_t* _get_device( int dev )
+{
+  assert( dev >= 0 && (size_t) dev < bus.count );
+  return &bus.devices[dev];
+}
+
+static void _set_scratchpad_temp( sim_device_t* device, int16_t temp )
+{
+  device->scratchpad[0] = (uint8_t) temp;
+  device->scratchpad[1] = (uint8_t) ( (uint16_t) temp >> 8 );
+}
+
+static void _finish_conversion( sim_device_t* device )
+{
+  if ( !device->converting || bus.time_ns < device->conversion_end_ns )
+  {
+    return;
+  }
+  device->converting = false;
+
+  int16_t whole;
+  if ( device->is_s )
+  {
+    /* 0.5 C steps, remainder goes to COUNT_REMAIN against whole degrees of TEMP_READ */
+    int16_t half = ( device->temp + 4 ) >> 3;
+    whole = half >> 1;
+    _set_scratchpad_temp( device, half );
+    device->scratchpad[6] = (uint8_t) ( 12 - ( device->temp - whole * 16 ) );
+    device->scratchpad[7] = 16;
+  }
+  else
+  {
+    /* Lower bits are undefined below 12 bits resolution, device clears them */
+    uint8_t resolution = ( ( device->scratchpad[4] >> 5 ) & 0x03 ) + 9;
+    int16_t temp = device->temp & ~( ( 1 << ( 12 - resolution ) ) - 1 );
+    whole = temp >> 4;
+    _set_scratchpad_temp( device, temp );
+  }
+  device->alarm = whole >= (int8_t) device->scratchpad[2] || whole <= (int8_t) device->scratchpad[3];
+}
+
+static void _start_conversion( sim_device_t* device )
+{
+  uint64_t duration_ns = CONVERSION_S_NS;
+  if ( !device->is_s )
+  {
+    duration_ns = CONVERSION_9_BITS_NS << ( ( device->scratchpad[4] >> 5 ) & 0x03 );
+  }
+  device->converting = true;
+  device->conversion_end_ns = bus.time_ns + duration_ns;
+  device->state = SIM_CONVERTING;
+  bus.stats.conversions++;
+}
+
+static void _start_read_scratchpad( sim_device_t* device )
+{
+  memcpy( device->read_buf, device->scratchpad, SCRATCHPAD_SIZE - 1 );
+  device->read_buf[SCRATCHPAD_SIZE - 1] = ow_crc( device->read_buf, SCRATCHPAD_SIZE - 1 );
+  if ( device->crc_faults > 0 )
+  {
+    device->read_buf[0] ^= 0x01;
+    device->crc_faults--;
+  }
+  device->state = SIM_READ_SCRATCHPAD;
+}
+
+static void _rom_command( sim_device_t* device, uint8_t cmd )
+{
+  switch ( cmd )
+  {
+    case CMD_SKIP_ROM:
+      device->state = SIM_FUNCTION_CMD;
+      break;
+    case CMD_MATCH_ROM:
+      device->state = SIM_MATCH_ROM;
+      break;
+    case CMD_READ_ROM:
+      device->state = SIM_READ_ROM;
+      break;
+    case CMD_SEARCH_ROM:
+      device->state = SIM_SEARCH;
+      break;
+    case CMD_ALARM:
+      device->state = device->alarm ? SIM_SEARCH : SIM_IDLE;
+      break;
+    default:
+      device->state = SIM_IDLE;
+      break;
+  }
+}
+
+static void _function_command( sim_device_t* device, uint8_t cmd )
+{
+  switch ( cmd )
+  {
+    case CMD_CONVERT:
+      _start_conversion( device );
+      break;
+    case CMD_RSCRATCHPAD:
+      _start_read_scratchpad( device );
+      break;
+    case CMD_WSCRATCHPAD:
+      device->state = SIM_WRITE_SCRATCHPAD;
+      break;
+    case CMD_CPYSCRATCH:
+      bus.stats.eeprom_writes++;
+      device->state = SIM_IDLE;
+      break;
+    default:
+      device->state = SIM_IDLE;
+      break;
+  }
+}
+
+static void _receive_byte( sim_device_t* device, uint8_t byte, uint32_t index )
+{
+  switch ( device->state )
+  {
+    case SIM_ROM_CMD:
+      _rom_command( device, byte );
+      break;
+    case SIM_MATCH_ROM:
+      if ( byte != device->rom.rom[index] )
+      {
+        device->state = SIM_IDLE;
+      }
+      else if ( index == sizeof( device->rom.rom ) - 1 )
+      {
+        device->state = SIM_FUNCTION_CMD;
+      }
+      break;
+    case SIM_FUNCTION_CMD:
+      _function_command( device, byte );
+      break;
+    case SIM_WRITE_SCRATCHPAD:
+      /* TH, TL and config of DS18B20, DS18S20 has no config */
+      device->scratchpad[2 + index] = byte;
+      if ( index == ( device->is_s ? 1 : 2 ) )
+      {
+        device->state = SIM_IDLE;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static bool _get_rom_bit( const sim_device_t* device, uint32_t bit )
+{
+  return ( device->rom.rom[bit / 8] >> ( bit % 8 ) ) & 0x01;
+}
+
+static uint8_t _search_slot( sim_device_t* device, bool master_bit )
+{
+  /* Each ROM bit takes 3 slots: bit, its complement and direction written by master */
+  uint32_t bit = device->search_slot / 3;
+  uint32_t phase = device->search_slot % 3;
+  bool rom_bit = _get_rom_bit( device, bit );
+  device->search_slot++;
+
+  if ( phase == 0 )
+  {
+    return rom_bit ? 0xFF : 0x00;
+  }
+  if ( phase == 1 )
+  {
+    return rom_bit ? 0x00 : 0xFF;
+  }
+  if ( master_bit != rom_bit )
+  {
+    device->state = SIM_IDLE;
+  }
+  else if ( bit == 63 )
+  {
+    device->state = SIM_FUNCTION_CMD;
+  }
+  return 0xFF;
+}
+
+static uint8_t _device_slot( sim_device_t* device, uint8_t tx )
+{
+  /* Write 1 and read slot look the same, device answers by holding line low */
+  bool master_bit = tx == 0xFF;
+  uint8_t rx = 0xFF;
+
+  switch ( device->state )
+  {
+    case SIM_ROM_CMD:
+    case SIM_MATCH_ROM:
+    case SIM_FUNCTION_CMD:
+    case SIM_WRITE_SCRATCHPAD:
+      device->byte |= master_bit << ( device->bit % 8 );
+      device->bit++;
+      if ( device->bit % 8 == 0 )
+      {
+        sim_state_t state = device->state;
+        uint8_t byte = device->byte;
+        device->byte = 0;
+        _receive_byte( device, byte, device->bit / 8 - 1 );
+        if ( device->state != state || state == SIM_ROM_CMD || state == SIM_FUNCTION_CMD )
+        {
+          /* Next command or data starts from its first byte */
+          device->bit = 0;
+        }
+      }
+      break;
+    case SIM_SEARCH:
+      rx = _search_slot( device, master_bit );
+      break;
+    case SIM_READ_ROM:
+      if ( device->bit < 64 )
+      {
+        rx = _get_rom_bit( device, device->bit ) ? 0xFF : 0x00;
+        if ( ++device->bit == 64 )
+        {
+          device->bit = 0;
+          device->state = SIM_FUNCTION_CMD;
+        }
+      }
+      break;
+    case SIM_READ_SCRATCHPAD:
+      if ( device->bit < SCRATCHPAD_SIZE * 8 )
+      {
+        rx = ( ( device->read_buf[device->bit / 8] >> ( device->bit % 8 ) ) & 0x01 ) ? 0xFF : 0x00;
+        device->bit++;
+      }
+      break;
+    case SIM_CONVERTING:
+      _finish_conversion( device );
+      rx = device->converting ? 0x00 : 0xFF;
+      break;
+    default:
+      break;
+  }
+  return rx;
+}
+
+static uint8_t _reset_pulse( uint8_t tx )
+{
+  bool presence = false;
+  bus.stats.resets++;
+  for ( size_t i = 0; i < bus.count; i++ )
+  {
+    sim_device_t* device = &bus.devices[i];
+    _finish_conversion( device );
+    if ( device->present )
+    {
+      device->state = SIM_ROM_CMD;
+      device->byte = 0;
+      device->bit = 0;
+      device->search_slot = 0;
+      presence = true;
+    }
+  }
+  return presence ? PRESENCE_RESPONSE : tx;
+}
+
+static uint8_t _sim_init( void* arg )
+{
+  bus.baudrate = SLOT_BAUDRATE;
+  return 1;
+}
+
+static uint8_t _sim_deinit( void* arg )
+{
+  return 1;
+}
+
+static uint8_t _sim_set_baudrate( uint32_t baud, void* arg )
+{
+  bus.baudrate = baud;
+  return 1;
+}
+
+static uint8_t _sim_transmit_receive( const uint8_t* tx, uint8_t* rx, size_t len, void* arg )
+{
+  bus.stats.tx_rx_calls++;
+  if ( bus.transfers_to_fault > 0 )
+  {
+    bus.transfers_to_fault--;
+  }
+  else if ( bus.transfer_faults > 0 )
+  {
+    bus.transfer_faults--;
+    return 0;
+  }
+  for ( size_t i = 0; i < len; i++ )
+  {
+    bus.time_ns += UART_BYTE_BITS * 1000000000ULL / bus.baudrate;
+    if ( bus.baudrate == RESET_BAUDRATE )
+    {
+      rx[i] = _reset_pulse( tx[i] );
+      continue;
+    }
+
+    bus.stats.slots++;
+    rx[i] = tx[i];
+    for ( size_t j = 0; j < bus.count; j++ )
+    {
+      if ( bus.devices[j].present )
+      {
+        rx[i] &= _device_slot( &bus.devices[j], tx[i] );
+        rx[i] &= bus.devices[j].stuck_low ? 0x00 : 0xFF;
+      }
+    }
+  }
+  return 1;
+}
+
+/* Public variables ----------------------------------------------------------*/
+
+const ow_ll_drv_t ow_sim_drv = {
+  .init = _sim_init,
+  .deinit = _sim_deinit,
+  .set_baudrate = _sim_set_baudrate,
+  .tx_rx = _sim_transmit_receive,
+};
+
+/* Public functions ----------------------------------------------------------*/
+
+void OWSim_Reset( void )
+{
+  memset( &bus, 0, sizeof( bus ) );
+  bus.baudrate = SLOT_BAUDRATE;
+}
+
+void OWSim_MakeRom( uint8_t family, uint64_t serial, ow_rom_t* rom )
+{
+  rom->rom[0] = family;
+  for ( size_t i = 1; i < 7; i++ )
+  {
+    rom->rom[i] = (uint8_t) ( serial >> ( 8 * ( i - 1 ) ) );
+  }
+  rom->rom[7] = ow_crc( rom->rom, 7 );
+}
+
+int OWSim_AddDevice( const ow_rom_t* rom, float temp )
+{
+  if ( bus.count == OW_SIM_MAX_DEVICES )
+  {
+    return -1;
+  }
+  sim_device_t* device = &bus.devices[bus.count];
+  memset( device, 0, sizeof( *device ) );
+  device->rom = *rom;
+  device->is_s = rom->rom[0] == OW_SIM_FAMILY_DS18S20;
+  device->present = true;
+  device->state = SIM_IDLE;
+
+  _set_scratchpad_temp( device, device->is_s ? POWER_UP_TEMP >> 3 : POWER_UP_TEMP );
+  device->scratchpad[2] = POWER_UP_TH;
+  device->scratchpad[3] = POWER_UP_TL;
+  device->scratchpad[4] = device->is_s ? 0xFF : POWER_UP_CONFIG;
+  device->scratchpad[5] = 0xFF;
+  device->scratchpad[6] = device->is_s ? 0x0C : 0x00;
+  device->scratchpad[7] = 0x10;
+  bus.count++;
+  OWSim_SetTemperature( bus.count - 1, temp );
+  return bus.count - 1;
+}
+
+void OWSim_SetTemperature( int dev, float temp )
+{
+  _get_device( dev )->temp = (int16_t) ( temp * 16 + ( temp < 0 ? -0.5f : 0.5f ) );
+}
+
+void OWSim_SetPresent( int dev, bool present )
+{
+  sim_device_t* device = _get_device( dev );
+  device->present = present;
+  device->state = SIM_IDLE;
+}
+
+void OWSim_InjectCrcFaults( int dev, uint32_t count )
+{
+  _get_device( dev )->crc_faults = count;
+}
+
+void OWSim_SetStuckLow( int dev, bool stuck )
+{
+  _get_device( dev )->stuck_low = stuck;
+}
+
+void OWSim_InjectTransferFaults( uint32_t after, uint32_t count )
+{
+  bus.transfers_to_fault = after;
+  bus.transfer_faults = count;
+}
+
+void OWSim_GetScratchpad( int dev, uint8_t* data )
+{
+  sim_device_t* device = _get_device( dev );
+  memcpy( data, device->scratchpad, SCRATCHPAD_SIZE - 1 );
+  data[SCRATCHPAD_SIZE - 1] = ow_crc( data, SCRATCHPAD_SIZE - 1 );
+}
+
+uint8_t OWSim_GetResolution( int dev )
+{
+  return ( ( _get_device( dev )->scratchpad[4] >> 5 ) & 0x03 ) + 9;
+}
+
+void OWSim_AdvanceTime( uint32_t time_ms )
+{
+  bus.time_ns += (uint64_t) time_ms * 1000000ULL;
+}
+
+uint64_t OWSim_GetTimeUs( void )
+{
+  return bus.time_ns / 1000;
+}
+
+const ow_sim_stats_t* OWSim_GetStats( void )
+{
+  return &bus.stats;
+}
+
+void OWSim_ClearStats( void )
+{
+  memset( &bus.stats, 0, sizeof( bus.stats ) );
+}
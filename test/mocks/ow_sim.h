@@ -0,0 +1,114 @@
+/**
+ *******************************************************************************
+ * @file    ow_sim.h
+ * @author  Dmytro Shevchenko
+ * @brief   Simulated 1-Wire bus with DS18B20/DS18S20 devices on UART level
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+
+#ifndef _OW_SIM_H_
+#define _OW_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ow/ow.h"
+
+/* Public macro --------------------------------------------------------------*/
+#define OW_SIM_MAX_DEVICES    64
+#define OW_SIM_FAMILY_DS18B20 0x28
+#define OW_SIM_FAMILY_DS18S20 0x10
+
+/* Public types --------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t tx_rx_calls;
+  uint32_t resets;
+  uint32_t slots;
+  uint32_t conversions;
+  uint32_t eeprom_writes;
+} ow_sim_stats_t;
+
+/* Public variables ----------------------------------------------------------*/
+
+/** @brief  Low level driver of simulated bus, arg is not used */
+extern const ow_ll_drv_t ow_sim_drv;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief   Remove all devices, clear statistics and time.
+ */
+void OWSim_Reset( void );
+
+/**
+ * @brief   Make valid ROM with CRC.
+ * @param   [in] family - family code.
+ * @param   [in] serial - 48 bits serial number.
+ * @param   [out] rom - ROM.
+ */
+void OWSim_MakeRom( uint8_t family, uint64_t serial, ow_rom_t* rom );
+
+/**
+ * @brief   Connect device to bus, it has power-up scratchpad of 85 C.
+ * @param   [in] rom - ROM, family code selects device model.
+ * @param   [in] temp - temperature measured by next conversion.
+ * @return  device index, -1 when bus is full
+ */
+int OWSim_AddDevice( const ow_rom_t* rom, float temp );
+
+void OWSim_SetTemperature( int dev, float temp );
+
+/**
+ * @brief   Disconnected device doesn't answer, but keeps its state.
+ */
+void OWSim_SetPresent( int dev, bool present );
+
+/**
+ * @brief   Corrupt next scratchpad reads of device, CRC of them fails.
+ * @param   [in] dev - device index.
+ * @param   [in] count - number of corrupted reads.
+ */
+void OWSim_InjectCrcFaults( int dev, uint32_t count );
+
+/**
+ * @brief   Device answers reset, but then holds line low in every slot.
+ */
+void OWSim_SetStuckLow( int dev, bool stuck );
+
+/**
+ * @brief   Fail UART transfers, driver returns error without exchange.
+ * @param   [in] after - number of transfers done before first failed one.
+ * @param   [in] count - number of failed transfers.
+ */
+void OWSim_InjectTransferFaults( uint32_t after, uint32_t count );
+
+/**
+ * @brief   Get scratchpad of device with valid CRC.
+ * @param   [in] dev - device index.
+ * @param   [out] data - 9 bytes of scratchpad.
+ */
+void OWSim_GetScratchpad( int dev, uint8_t* data );
+
+/**
+ * @brief   Get resolution set in scratchpad of device.
+ */
+uint8_t OWSim_GetResolution( int dev );
+
+/**
+ * @brief   Advance bus time without traffic, e.g. to wait for conversion.
+ */
+void OWSim_AdvanceTime( uint32_t time_ms );
+
+/**
+ * @brief   Get bus time, advanced by every UART byte at current baudrate.
+ */
+uint64_t OWSim_GetTimeUs( void );
+
+const ow_sim_stats_t* OWSim_GetStats( void );
+
+void OWSim_ClearStats( void );
+
+#endif
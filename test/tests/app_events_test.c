@@ -0,0 +1,571 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "app_config.h"
+#include "app_events.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define BENCHMARK_EVENTS   200000
+#define BENCHMARK_DISPATCH 1000000
+
+typedef struct
+{
+  uint32_t value;
+  uint8_t buffer[60];
+} large_payload_t;
+
+/* Previous implementation of handler array, searched linearly on every event */
+struct linear_events_handler
+{
+  uint32_t id;
+  event_callback_t callback;
+};
+
+static uint32_t callback_counter;
+
+TEST_GROUP( AppEvents );
+
+TEST_SETUP( AppEvents )
+{
+  callback_counter = 0;
+  AppEventResetStats();
+}
+
+TEST_TEAR_DOWN( AppEvents )
+{
+}
+
+static uint64_t _get_time_ns( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Previous implementation of event payload, every payload is copied to heap. Header
+ * is filled and stamped as in AppEventPrepareWithData, so only payload storage differs */
+static void _malloc_prepare_with_data( app_event_t* event, const void* data, uint32_t data_size )
+{
+  static uint32_t events_counter;
+  void* m_data = malloc( data_size );
+  TEST_ASSERT_NOT_NULL( m_data );
+  memcpy( m_data, data, data_size );
+  event->data_size = data_size;
+  event->data = m_data;
+  event->msg_id = MSG_ID_INIT_REQ;
+  event->src = APP_EVENT_APP_MANAGER;
+  event->dst = APP_EVENT_TEMP_DRV;
+  event->event_number = events_counter++;
+  event->timestamp_us = CONFIG_APP_EVENT_TIMING ? (uint32_t) ( _get_time_ns() / 1000 ) : 0;
+}
+
+static void _malloc_delete( app_event_t* event )
+{
+  free( event->data );
+  event->data = NULL;
+  event->data_size = 0;
+}
+
+static void _callback( const app_event_t* event )
+{
+  callback_counter++;
+}
+
+static bool _linear_search_and_execute( const app_event_t* event, const struct linear_events_handler* handlers, uint8_t handlers_length )
+{
+  for ( uint8_t i = 0; i < handlers_length; i++ )
+  {
+    if ( handlers[i].id == event->msg_id )
+    {
+      handlers[i].callback( event );
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* Linear search with the same completion timing as AppEventDispatch, so benchmark compares lookup only */
+static uint32_t linear_histogram[APP_EVENT_LATENCY_HISTOGRAM_SIZE];
+
+static bool _linear_dispatch( const app_event_t* event, const struct linear_events_handler* handlers, uint8_t handlers_length )
+{
+  bool handled = _linear_search_and_execute( event, handlers, handlers_length );
+  if ( CONFIG_APP_EVENT_TIMING )
+  {
+    uint32_t latency_us = (uint32_t) ( _get_time_ns() / 1000 ) - event->timestamp_us;
+    uint32_t bucket = latency_us < 2 ? 0 : 31 - __builtin_clz( latency_us );
+    linear_histogram[bucket < APP_EVENT_LATENCY_HISTOGRAM_SIZE ? bucket : APP_EVENT_LATENCY_HISTOGRAM_SIZE - 1]++;
+  }
+  return handled;
+}
+
+static uint32_t _events_per_second( uint64_t time_ns )
+{
+  return (uint32_t) ( (uint64_t) BENCHMARK_EVENTS * 1000000000ULL / ( time_ns ? time_ns : 1 ) );
+}
+
+static void _benchmark( const void* data, uint32_t data_size, const char* name )
+{
+  app_event_t event = {};
+  uint8_t out[sizeof( large_payload_t )];
+
+  uint64_t start = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_EVENTS; i++ )
+  {
+    _malloc_prepare_with_data( &event, data, data_size );
+    memcpy( out, event.data, data_size );
+    _malloc_delete( &event );
+  }
+  uint64_t malloc_time = _get_time_ns() - start;
+
+  start = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_EVENTS; i++ )
+  {
+    AppEventPrepareWithData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV, data, data_size );
+    AppEventGetData( &event, out, data_size );
+    AppEventDelete( &event );
+  }
+  uint64_t pool_time = _get_time_ns() - start;
+
+  printf( "\r\n%s payload %u bytes: malloc %u events/s, inline/pool %u events/s",
+          name, (unsigned) data_size, (unsigned) _events_per_second( malloc_time ), (unsigned) _events_per_second( pool_time ) );
+}
+
+TEST( AppEvents, AppEventsInlineData )
+{
+  app_event_t event = {};
+  uint32_t data = 0x12345678;
+  uint32_t result = 0;
+  app_event_pool_stats_t before = {};
+  app_event_pool_stats_t after = {};
+
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_32, &before ) );
+  TEST_ASSERT_TRUE( AppEventPrepareWithData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV, &data, sizeof( data ) ) );
+  data = 0;
+  TEST_ASSERT_TRUE( AppEventGetData( &event, &result, sizeof( result ) ) );
+  TEST_ASSERT_EQUAL_HEX32( 0x12345678, result );
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_32, &after ) );
+  TEST_ASSERT_EQUAL( before.alloc_count, after.alloc_count );
+  AppEventDelete( &event );
+  TEST_ASSERT_EQUAL( 0, event.data_size );
+}
+
+TEST( AppEvents, AppEventsInlineDataCopy )
+{
+  app_event_t event = {};
+  uint8_t data[APP_EVENT_INLINE_DATA_SIZE];
+  uint8_t result[APP_EVENT_INLINE_DATA_SIZE] = {};
+
+  for ( size_t i = 0; i < sizeof( data ); i++ )
+  {
+    data[i] = i;
+  }
+
+  TEST_ASSERT_TRUE( AppEventPrepareWithData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV, data, sizeof( data ) ) );
+
+  /* Events are copied by value to queues */
+  app_event_t copy = event;
+  memset( &event, 0, sizeof( event ) );
+  TEST_ASSERT_TRUE( AppEventGetData( &copy, result, sizeof( result ) ) );
+  TEST_ASSERT_EQUAL_UINT8_ARRAY( data, result, sizeof( data ) );
+  AppEventDelete( &copy );
+}
+
+TEST( AppEvents, AppEventsPoolData )
+{
+  app_event_t event = {};
+  large_payload_t data = { .value = 0xCAFE };
+  large_payload_t result = {};
+  app_event_pool_stats_t before = {};
+  app_event_pool_stats_t stats = {};
+
+  memset( data.buffer, 0xA5, sizeof( data.buffer ) );
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &before ) );
+  TEST_ASSERT_TRUE( AppEventPrepareWithData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV, &data, sizeof( data ) ) );
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &stats ) );
+  TEST_ASSERT_EQUAL( before.used + 1, stats.used );
+  TEST_ASSERT_EQUAL( before.alloc_count + 1, stats.alloc_count );
+
+  TEST_ASSERT_TRUE( AppEventGetData( &event, &result, sizeof( result ) ) );
+  TEST_ASSERT_EQUAL_MEMORY( &data, &result, sizeof( data ) );
+  AppEventDelete( &event );
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &stats ) );
+  TEST_ASSERT_EQUAL( before.used, stats.used );
+}
+
+TEST( AppEvents, AppEventsPoolHighWaterMark )
+{
+  app_event_t events[4] = {};
+  uint8_t data[100] = {};
+  app_event_pool_stats_t stats = {};
+
+  for ( size_t i = 0; i < ARRAY_SIZE( events ); i++ )
+  {
+    TEST_ASSERT_TRUE( AppEventPrepareWithData( &events[i], MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV, data, sizeof( data ) ) );
+  }
+
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_128, &stats ) );
+  TEST_ASSERT_EQUAL( 128, stats.block_size );
+  TEST_ASSERT_EQUAL( ARRAY_SIZE( events ), stats.used );
+  TEST_ASSERT_EQUAL( ARRAY_SIZE( events ), stats.high_water_mark );
+
+  for ( size_t i = 0; i < ARRAY_SIZE( events ); i++ )
+  {
+    /* Every event must have own block */
+    for ( size_t j = i + 1; j < ARRAY_SIZE( events ); j++ )
+    {
+      TEST_ASSERT_NOT_EQUAL( events[i].data, events[j].data );
+    }
+    AppEventDelete( &events[i] );
+  }
+
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_128, &stats ) );
+  TEST_ASSERT_EQUAL( 0, stats.used );
+  TEST_ASSERT_EQUAL( ARRAY_SIZE( events ), stats.high_water_mark );
+  TEST_ASSERT_FALSE( AppEventGetPoolStats( APP_EVENT_POOL_LAST, &stats ) );
+}
+
+TEST( AppEvents, AppEventsBenchmark )
+{
+  uint32_t small = 1;
+  large_payload_t large = {};
+
+  _benchmark( &small, sizeof( small ), "Small" );
+  _benchmark( &large, sizeof( large ), "Large" );
+}
+
+TEST( AppEvents, AppEventsDispatch )
+{
+  static const app_events_handler_table_t handlers =
+    {
+      EVENT_ITEM( MSG_ID_INIT_REQ, _callback ),
+      EVENT_ITEM( MSG_ID_TCP_SERVER_CLOSE_SOCKET, _callback ),
+    };
+  app_event_t event = {};
+
+  AppEventPrepareNoData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV );
+  TEST_ASSERT_TRUE( AppEventDispatch( &event, handlers ) );
+  AppEventPrepareNoData( &event, MSG_ID_TCP_SERVER_CLOSE_SOCKET, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV );
+  TEST_ASSERT_TRUE( AppEventDispatch( &event, handlers ) );
+  TEST_ASSERT_EQUAL( 2, callback_counter );
+
+  /* Unhandled message is reported to caller */
+  AppEventPrepareNoData( &event, MSG_ID_INIT_RES, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV );
+  TEST_ASSERT_FALSE( AppEventDispatch( &event, handlers ) );
+  TEST_ASSERT_EQUAL( 2, callback_counter );
+}
+
+TEST( AppEvents, AppEventsDispatchBenchmark )
+{
+  static const uint8_t handlers_count[] = { 1, 4, 8, 16, 32 };
+  struct linear_events_handler linear_handlers[32] = {};
+  event_callback_t handlers[MSG_ID_LAST] = {};
+  app_event_t event = {};
+
+  TEST_ASSERT_LESS_OR_EQUAL( MSG_ID_LAST, ARRAY_SIZE( linear_handlers ) );
+
+  for ( size_t i = 0; i < ARRAY_SIZE( handlers_count ); i++ )
+  {
+    uint8_t count = handlers_count[i];
+    for ( uint8_t j = 0; j < count; j++ )
+    {
+      linear_handlers[j].id = j;
+      linear_handlers[j].callback = _callback;
+      handlers[j] = _callback;
+    }
+
+    /* Worst case for linear search: handler is the last one in array */
+    AppEventPrepareNoData( &event, count - 1, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV );
+
+    uint64_t start = _get_time_ns();
+    for ( uint32_t j = 0; j < BENCHMARK_DISPATCH; j++ )
+    {
+      _linear_dispatch( &event, linear_handlers, count );
+    }
+    uint64_t linear_time = _get_time_ns() - start;
+
+    start = _get_time_ns();
+    for ( uint32_t j = 0; j < BENCHMARK_DISPATCH; j++ )
+    {
+      AppEventDispatch( &event, handlers );
+    }
+    uint64_t table_time = _get_time_ns() - start;
+
+    TEST_ASSERT_EQUAL( 2 * BENCHMARK_DISPATCH, callback_counter );
+    callback_counter = 0;
+
+    printf( "\r\nDispatch %2u handlers: linear %3u.%02u ns, table %3u.%02u ns",
+            (unsigned) count,
+            (unsigned) ( linear_time / BENCHMARK_DISPATCH ), (unsigned) ( linear_time * 100 / BENCHMARK_DISPATCH % 100 ),
+            (unsigned) ( table_time / BENCHMARK_DISPATCH ), (unsigned) ( table_time * 100 / BENCHMARK_DISPATCH % 100 ) );
+  }
+}
+
+TEST( AppEvents, AppEventsPostStats )
+{
+  QueueHandle_t queue = xQueueCreate( 2, sizeof( app_event_t ) );
+  app_event_t event = {};
+  app_event_task_stats_t stats = {};
+  app_event_pool_stats_t pool_before = {};
+  app_event_pool_stats_t pool_after = {};
+  uint8_t data[40] = {};
+
+  AppEventRegisterQueue( APP_EVENT_DEV_MANAGER, queue );
+  TEST_ASSERT_TRUE( AppEventGetTaskStats( APP_EVENT_DEV_MANAGER, &stats ) );
+  TEST_ASSERT_EQUAL( 2, stats.queue_length );
+
+  AppEventPrepareNoData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_DEV_MANAGER );
+  TEST_ASSERT_TRUE( AppEventPost( &event ) );
+  TEST_ASSERT_TRUE( AppEventPost( &event ) );
+
+  /* Queue is full, event is dropped and its pool block returned */
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &pool_before ) );
+  AppEventPrepareWithData( &event, MSG_ID_DEV_MANAGER_POST, APP_EVENT_APP_MANAGER, APP_EVENT_DEV_MANAGER, data, sizeof( data ) );
+  TEST_ASSERT_FALSE( AppEventPost( &event ) );
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &pool_after ) );
+  TEST_ASSERT_EQUAL( pool_before.used, pool_after.used );
+
+  TEST_ASSERT_TRUE( AppEventGetTaskStats( APP_EVENT_DEV_MANAGER, &stats ) );
+  TEST_ASSERT_EQUAL( 2, stats.enqueue_count );
+  TEST_ASSERT_EQUAL( 2, stats.max_depth );
+  TEST_ASSERT_EQUAL( 1, stats.overflow_count );
+
+  AppEventResetStats();
+  TEST_ASSERT_TRUE( AppEventGetTaskStats( APP_EVENT_DEV_MANAGER, &stats ) );
+  TEST_ASSERT_EQUAL( 0, stats.enqueue_count );
+  TEST_ASSERT_EQUAL( 2, stats.queue_length );
+  TEST_ASSERT_FALSE( AppEventGetTaskStats( APP_EVENT_LAST, &stats ) );
+
+  vQueueDelete( queue );
+}
+
+TEST( AppEvents, AppEventsLatencyHistogram )
+{
+  static const app_events_handler_table_t handlers =
+    {
+      EVENT_ITEM( MSG_ID_INIT_REQ, _callback ),
+    };
+  app_event_t event = {};
+  app_event_task_stats_t stats = {};
+
+  AppEventPrepareNoData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_OTA );
+  event.timestamp_us -= 1000;
+  TEST_ASSERT_TRUE( AppEventDispatch( &event, handlers ) );
+
+  AppEventPrepareNoData( &event, MSG_ID_INIT_RES, APP_EVENT_APP_MANAGER, APP_EVENT_OTA );
+  TEST_ASSERT_FALSE( AppEventDispatch( &event, handlers ) );
+
+  TEST_ASSERT_TRUE( AppEventGetTaskStats( APP_EVENT_OTA, &stats ) );
+  TEST_ASSERT_EQUAL( 1, stats.unhandled_count );
+  /* 1000 us waiting lands in [512, 1024) or [1024, 2048) bucket */
+  TEST_ASSERT_EQUAL( 1, stats.latency_histogram[9] + stats.latency_histogram[10] );
+  TEST_ASSERT_EQUAL_STRING( "OTA", AppEventGetTaskName( APP_EVENT_OTA ) );
+}
+
+TEST( AppEvents, AppEventsPublishSharedPayload )
+{
+  static const app_events_task_t receivers[] = { APP_EVENT_TCP_SERVER, APP_EVENT_OTA, APP_EVENT_MQTT_APP };
+  QueueHandle_t queues[ARRAY_SIZE( receivers )] = {};
+  large_payload_t data = { .value = 0xBEEF };
+  large_payload_t result = {};
+  app_event_pool_stats_t before = {};
+  app_event_pool_stats_t stats = {};
+  app_event_t events[ARRAY_SIZE( receivers )] = {};
+
+  for ( size_t i = 0; i < ARRAY_SIZE( receivers ); i++ )
+  {
+    queues[i] = xQueueCreate( 2, sizeof( app_event_t ) );
+    AppEventRegisterQueue( receivers[i], queues[i] );
+    TEST_ASSERT_TRUE( AppEventSubscribe( MSG_ID_NETWORK_LINK_UP, receivers[i] ) );
+  }
+
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &before ) );
+  TEST_ASSERT_TRUE( AppEventPublish( MSG_ID_NETWORK_LINK_UP, APP_EVENT_NETWORK_MANAGER, &data, sizeof( data ) ) );
+
+  /* One allocation shared by all subscribers */
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &stats ) );
+  TEST_ASSERT_EQUAL( before.alloc_count + 1, stats.alloc_count );
+  TEST_ASSERT_EQUAL( before.used + 1, stats.used );
+
+  for ( size_t i = 0; i < ARRAY_SIZE( receivers ); i++ )
+  {
+    TEST_ASSERT_EQUAL( pdPASS, xQueueReceive( queues[i], &events[i], 0 ) );
+    TEST_ASSERT_EQUAL( MSG_ID_NETWORK_LINK_UP, events[i].msg_id );
+    TEST_ASSERT_EQUAL( APP_EVENT_NETWORK_MANAGER, events[i].src );
+    TEST_ASSERT_EQUAL( receivers[i], events[i].dst );
+    TEST_ASSERT_EQUAL_PTR( events[0].data, events[i].data );
+    TEST_ASSERT_TRUE( AppEventGetData( &events[i], &result, sizeof( result ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( &data, &result, sizeof( data ) );
+  }
+
+  /* Block is released with the last receiver */
+  for ( size_t i = 0; i < ARRAY_SIZE( receivers ); i++ )
+  {
+    TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &stats ) );
+    TEST_ASSERT_EQUAL( before.used + 1, stats.used );
+    AppEventDelete( &events[i] );
+  }
+  TEST_ASSERT_TRUE( AppEventGetPoolStats( APP_EVENT_POOL_64, &stats ) );
+  TEST_ASSERT_EQUAL( before.used, stats.used );
+
+  /* Unsubscribed module doesn't receive message */
+  TEST_ASSERT_TRUE( AppEventUnsubscribe( MSG_ID_NETWORK_LINK_UP, APP_EVENT_OTA ) );
+  TEST_ASSERT_TRUE( AppEventPublish( MSG_ID_NETWORK_LINK_UP, APP_EVENT_NETWORK_MANAGER, NULL, 0 ) );
+  TEST_ASSERT_EQUAL( 1, uxQueueMessagesWaiting( queues[0] ) );
+  TEST_ASSERT_EQUAL( 0, uxQueueMessagesWaiting( queues[1] ) );
+  TEST_ASSERT_EQUAL( 1, uxQueueMessagesWaiting( queues[2] ) );
+
+  for ( size_t i = 0; i < ARRAY_SIZE( receivers ); i++ )
+  {
+    AppEventUnsubscribe( MSG_ID_NETWORK_LINK_UP, receivers[i] );
+    vQueueDelete( queues[i] );
+  }
+}
+
+TEST( AppEvents, AppEventsPostCoalesce )
+{
+  static const app_events_handler_table_t handlers =
+    {
+      EVENT_ITEM( MSG_ID_DEV_MANAGER_MEASURE, _callback ),
+    };
+  QueueHandle_t queue = xQueueCreate( 4, sizeof( app_event_t ) );
+  app_event_t event = {};
+  app_event_task_stats_t stats = {};
+
+  AppEventRegisterQueue( APP_EVENT_DEV_MANAGER, queue );
+
+  for ( int i = 0; i < 10; i++ )
+  {
+    AppEventPrepareNoData( &event, MSG_ID_DEV_MANAGER_MEASURE, APP_EVENT_DEV_MANAGER, APP_EVENT_DEV_MANAGER );
+    TEST_ASSERT_TRUE( AppEventPost( &event ) );
+  }
+  AppEventPrepareNoData( &event, MSG_ID_DEV_MANAGER_POST, APP_EVENT_DEV_MANAGER, APP_EVENT_DEV_MANAGER );
+  TEST_ASSERT_TRUE( AppEventPost( &event ) );
+
+  TEST_ASSERT_EQUAL( 2, uxQueueMessagesWaiting( queue ) );
+  TEST_ASSERT_TRUE( AppEventGetTaskStats( APP_EVENT_DEV_MANAGER, &stats ) );
+  TEST_ASSERT_EQUAL( 9, stats.coalesced_count );
+  TEST_ASSERT_EQUAL( 0, stats.overflow_count );
+
+  /* After dispatch message can be posted again, e.g. by its own handler */
+  TEST_ASSERT_EQUAL( pdPASS, xQueueReceive( queue, &event, 0 ) );
+  TEST_ASSERT_TRUE( AppEventDispatch( &event, handlers ) );
+  AppEventDelete( &event );
+  AppEventPrepareNoData( &event, MSG_ID_DEV_MANAGER_MEASURE, APP_EVENT_DEV_MANAGER, APP_EVENT_DEV_MANAGER );
+  TEST_ASSERT_TRUE( AppEventPost( &event ) );
+  TEST_ASSERT_EQUAL( 2, uxQueueMessagesWaiting( queue ) );
+
+  while ( xQueueReceive( queue, &event, 0 ) == pdPASS )
+  {
+    AppEventDispatch( &event, handlers );
+    AppEventDelete( &event );
+  }
+  vQueueDelete( queue );
+}
+
+TEST( AppEvents, AppEventsPostDropOldest )
+{
+  QueueHandle_t queue = xQueueCreate( 2, sizeof( app_event_t ) );
+  app_event_t event = {};
+  app_event_task_stats_t stats = {};
+  uint32_t value = 0;
+
+  AppEventRegisterQueue( APP_EVENT_MQTT_APP, queue );
+  TEST_ASSERT_TRUE( AppEventSetPostPolicy( MSG_ID_MQTT_APP_POST_DATA, APP_EVENT_POST_DROP_OLDEST, 0 ) );
+
+  for ( value = 0; value < 5; value++ )
+  {
+    AppEventPrepareWithData( &event, MSG_ID_MQTT_APP_POST_DATA, APP_EVENT_DEV_MANAGER, APP_EVENT_MQTT_APP, &value, sizeof( value ) );
+    TEST_ASSERT_TRUE( AppEventPost( &event ) );
+  }
+
+  TEST_ASSERT_TRUE( AppEventGetTaskStats( APP_EVENT_MQTT_APP, &stats ) );
+  TEST_ASSERT_EQUAL( 3, stats.overflow_count );
+
+  /* The newest events are kept */
+  for ( uint32_t expected = 3; expected < 5; expected++ )
+  {
+    TEST_ASSERT_EQUAL( pdPASS, xQueueReceive( queue, &event, 0 ) );
+    TEST_ASSERT_TRUE( AppEventGetData( &event, &value, sizeof( value ) ) );
+    TEST_ASSERT_EQUAL( expected, value );
+    AppEventDelete( &event );
+  }
+
+  TEST_ASSERT_TRUE( AppEventSetPostPolicy( MSG_ID_MQTT_APP_POST_DATA, APP_EVENT_POST_DEFAULT, 0 ) );
+  vQueueDelete( queue );
+}
+
+TEST( AppEvents, AppEventsTrace )
+{
+  static const app_events_handler_table_t handlers =
+    {
+      EVENT_ITEM( MSG_ID_INIT_REQ, _callback ),
+    };
+  app_event_trace_t records[CONFIG_APP_EVENT_TRACE_SIZE] = {};
+  app_event_t event = {};
+
+  /* Nothing is recorded until trace is enabled */
+  uint32_t head = AppEventTraceGetHead();
+  AppEventPrepareNoData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_OTA );
+  TEST_ASSERT_TRUE( AppEventDispatch( &event, handlers ) );
+  TEST_ASSERT_FALSE( AppEventTraceIsEnabled() );
+  TEST_ASSERT_EQUAL( head, AppEventTraceGetHead() );
+
+  AppEventTraceEnable( true );
+  TEST_ASSERT_TRUE( AppEventTraceIsEnabled() );
+  AppEventPrepareNoData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_OTA );
+  TEST_ASSERT_TRUE( AppEventDispatch( &event, handlers ) );
+  AppEventPrepareNoData( &event, MSG_ID_INIT_RES, APP_EVENT_OTA, APP_EVENT_TEMP_DRV );
+  TEST_ASSERT_FALSE( AppEventDispatch( &event, handlers ) );
+
+  uint32_t offset = head;
+  TEST_ASSERT_EQUAL( 2, AppEventTraceRead( &offset, records, ARRAY_SIZE( records ) ) );
+  TEST_ASSERT_EQUAL( head, offset );
+  TEST_ASSERT_EQUAL( APP_EVENT_APP_MANAGER, records[0].src );
+  TEST_ASSERT_EQUAL( APP_EVENT_OTA, records[0].dst );
+  TEST_ASSERT_EQUAL( MSG_ID_INIT_REQ, records[0].msg_id );
+  TEST_ASSERT_EQUAL( 0, records[0].flags );
+  TEST_ASSERT_EQUAL( event.event_number - 1, records[0].event_number );
+  TEST_ASSERT_EQUAL( MSG_ID_INIT_RES, records[1].msg_id );
+  TEST_ASSERT_EQUAL( APP_EVENT_TRACE_FLAG_UNHANDLED, records[1].flags );
+  TEST_ASSERT_EQUAL( event.event_number, records[1].event_number );
+
+  /* Overwritten records are skipped, reading starts from the oldest one */
+  for ( int i = 0; i < CONFIG_APP_EVENT_TRACE_SIZE; i++ )
+  {
+    AppEventPrepareNoData( &event, MSG_ID_INIT_REQ, APP_EVENT_APP_MANAGER, APP_EVENT_OTA );
+    AppEventDispatch( &event, handlers );
+  }
+  offset = head;
+  TEST_ASSERT_EQUAL( CONFIG_APP_EVENT_TRACE_SIZE, AppEventTraceRead( &offset, records, ARRAY_SIZE( records ) ) );
+  TEST_ASSERT_EQUAL( head + 2, offset );
+  TEST_ASSERT_EQUAL( event.event_number, records[CONFIG_APP_EVENT_TRACE_SIZE - 1].event_number );
+
+  offset = AppEventTraceGetHead();
+  TEST_ASSERT_EQUAL( 0, AppEventTraceRead( &offset, records, ARRAY_SIZE( records ) ) );
+
+  /* Stopped recording keeps ring for reading */
+  AppEventTraceEnable( false );
+  AppEventDispatch( &event, handlers );
+  TEST_ASSERT_EQUAL( offset, AppEventTraceGetHead() );
+}
+
+TEST_GROUP_RUNNER( AppEvents )
+{
+  RUN_TEST_CASE( AppEvents, AppEventsInlineData );
+  RUN_TEST_CASE( AppEvents, AppEventsInlineDataCopy );
+  RUN_TEST_CASE( AppEvents, AppEventsPoolData );
+  RUN_TEST_CASE( AppEvents, AppEventsPoolHighWaterMark );
+  RUN_TEST_CASE( AppEvents, AppEventsBenchmark );
+  RUN_TEST_CASE( AppEvents, AppEventsDispatch );
+  RUN_TEST_CASE( AppEvents, AppEventsDispatchBenchmark );
+  RUN_TEST_CASE( AppEvents, AppEventsPostStats );
+  RUN_TEST_CASE( AppEvents, AppEventsLatencyHistogram );
+  RUN_TEST_CASE( AppEvents, AppEventsPublishSharedPayload );
+  RUN_TEST_CASE( AppEvents, AppEventsPostCoalesce );
+  RUN_TEST_CASE( AppEvents, AppEventsPostDropOldest );
+  RUN_TEST_CASE( AppEvents, AppEventsTrace );
+}
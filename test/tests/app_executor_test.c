@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "app_config.h"
+#include "app_executor.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define QUEUE_LENGTH       8
+#define BENCHMARK_EVENTS   200000
+#define BENCHMARK_SENDERS  4
+
+static QueueHandle_t control_queue;
+static QueueHandle_t io_queue;
+static app_events_task_t dispatched[QUEUE_LENGTH * 2];
+static uint32_t dispatched_count;
+
+TEST_GROUP( AppExecutor );
+
+TEST_SETUP( AppExecutor )
+{
+  AppExecutorInit();
+  if ( control_queue == NULL )
+  {
+    control_queue = xQueueCreate( QUEUE_LENGTH, sizeof( app_event_t ) );
+    io_queue = xQueueCreate( QUEUE_LENGTH, sizeof( app_event_t ) );
+  }
+  dispatched_count = 0;
+  AppEventRegisterQueue( APP_EVENT_APP_MANAGER, control_queue );
+  AppEventRegisterQueue( APP_EVENT_TEMP_DRV, io_queue );
+}
+
+TEST_TEAR_DOWN( AppExecutor )
+{
+  while ( AppExecutorRunOnce( APP_EXECUTOR_WORKER_CONTROL, 0 ) )
+  {
+  }
+}
+
+static uint64_t _get_time_ns( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void _dispatch( const app_event_t* event )
+{
+  TEST_ASSERT_LESS_THAN( ARRAY_SIZE( dispatched ), dispatched_count );
+  dispatched[dispatched_count++] = event->dst;
+}
+
+static void _post( app_events_task_t dst )
+{
+  app_event_t event = {};
+  AppEventPrepareNoData( &event, MSG_ID_INIT_REQ, dst, dst );
+  TEST_ASSERT_TRUE( AppEventPost( &event ) );
+}
+
+TEST( AppExecutor, AppExecutorDispatchOrder )
+{
+  static const app_events_task_t order[] = {
+    APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV, APP_EVENT_TEMP_DRV, APP_EVENT_APP_MANAGER, APP_EVENT_TEMP_DRV };
+
+  TEST_ASSERT_TRUE( AppExecutorRegister( APP_EVENT_APP_MANAGER, control_queue, _dispatch, APP_EXECUTOR_WORKER_CONTROL ) );
+  TEST_ASSERT_TRUE( AppExecutorRegister( APP_EVENT_TEMP_DRV, io_queue, _dispatch, APP_EXECUTOR_WORKER_CONTROL ) );
+
+  for ( size_t i = 0; i < ARRAY_SIZE( order ); i++ )
+  {
+    _post( order[i] );
+  }
+
+  /* One worker serves both modules in posting order */
+  while ( AppExecutorRunOnce( APP_EXECUTOR_WORKER_CONTROL, 0 ) )
+  {
+  }
+  TEST_ASSERT_EQUAL( ARRAY_SIZE( order ), dispatched_count );
+  for ( size_t i = 0; i < ARRAY_SIZE( order ); i++ )
+  {
+    TEST_ASSERT_EQUAL( order[i], dispatched[i] );
+  }
+  TEST_ASSERT_FALSE( AppExecutorRunOnce( APP_EXECUTOR_WORKER_IO, 0 ) );
+}
+
+TEST( AppExecutor, AppExecutorMoveWorker )
+{
+  TEST_ASSERT_TRUE( AppExecutorRegister( APP_EVENT_TEMP_DRV, io_queue, _dispatch, APP_EXECUTOR_WORKER_CONTROL ) );
+  TEST_ASSERT_TRUE( AppExecutorRegister( APP_EVENT_TEMP_DRV, io_queue, _dispatch, APP_EXECUTOR_WORKER_IO ) );
+
+  _post( APP_EVENT_TEMP_DRV );
+  TEST_ASSERT_FALSE( AppExecutorRunOnce( APP_EXECUTOR_WORKER_CONTROL, 0 ) );
+  TEST_ASSERT_TRUE( AppExecutorRunOnce( APP_EXECUTOR_WORKER_IO, 0 ) );
+  TEST_ASSERT_EQUAL( 1, dispatched_count );
+  TEST_ASSERT_EQUAL( APP_EVENT_TEMP_DRV, dispatched[0] );
+
+  /* Queue with pending events cannot be added to set */
+  TEST_ASSERT_TRUE( AppExecutorRegister( APP_EVENT_TEMP_DRV, io_queue, _dispatch, APP_EXECUTOR_WORKER_CONTROL ) );
+  _post( APP_EVENT_TEMP_DRV );
+  TEST_ASSERT_FALSE( AppExecutorRegister( APP_EVENT_TEMP_DRV, io_queue, _dispatch, APP_EXECUTOR_WORKER_IO ) );
+}
+
+TEST( AppExecutor, AppExecutorSetLength )
+{
+  QueueHandle_t queue = xQueueCreate( CONFIG_APP_EXECUTOR_SET_LENGTH + 1, sizeof( app_event_t ) );
+  TEST_ASSERT_FALSE( AppExecutorRegister( APP_EVENT_OTA, queue, _dispatch, APP_EXECUTOR_WORKER_IO ) );
+  vQueueDelete( queue );
+}
+
+static void _benchmark_dispatch( const app_event_t* event )
+{
+  dispatched_count++;
+}
+
+TEST( AppExecutor, AppExecutorBenchmark )
+{
+  app_event_t event = {};
+  QueueHandle_t queues[BENCHMARK_SENDERS] = {};
+  for ( size_t i = 0; i < BENCHMARK_SENDERS; i++ )
+  {
+    queues[i] = xQueueCreate( QUEUE_LENGTH, sizeof( app_event_t ) );
+    AppEventRegisterQueue( APP_EVENT_OTA + i, queues[i] );
+  }
+
+  /* Dedicated task per module: receive directly from module queue */
+  uint64_t start = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_EVENTS; i++ )
+  {
+    app_events_task_t dst = APP_EVENT_OTA + i % BENCHMARK_SENDERS;
+    _post( dst );
+    TEST_ASSERT_EQUAL( pdPASS, xQueueReceive( queues[dst - APP_EVENT_OTA], &event, 0 ) );
+    _benchmark_dispatch( &event );
+    AppEventDelete( &event );
+  }
+  uint64_t direct_ns = _get_time_ns() - start;
+
+  for ( size_t i = 0; i < BENCHMARK_SENDERS; i++ )
+  {
+    TEST_ASSERT_TRUE( AppExecutorRegister( APP_EVENT_OTA + i, queues[i], _benchmark_dispatch, APP_EXECUTOR_WORKER_IO ) );
+  }
+
+  /* Shared worker: select from queue set first */
+  dispatched_count = 0;
+  start = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_EVENTS; i++ )
+  {
+    _post( APP_EVENT_OTA + i % BENCHMARK_SENDERS );
+    AppExecutorRunOnce( APP_EXECUTOR_WORKER_IO, 0 );
+  }
+  uint64_t executor_ns = _get_time_ns() - start;
+  TEST_ASSERT_EQUAL( BENCHMARK_EVENTS, dispatched_count );
+
+  printf( "\nExecutor %u events: own queue %llu ns/event, queue set %llu ns/event\n", BENCHMARK_EVENTS,
+          (unsigned long long) ( direct_ns / BENCHMARK_EVENTS ), (unsigned long long) ( executor_ns / BENCHMARK_EVENTS ) );
+}
+
+TEST_GROUP_RUNNER( AppExecutor )
+{
+  RUN_TEST_CASE( AppExecutor, AppExecutorDispatchOrder );
+  RUN_TEST_CASE( AppExecutor, AppExecutorMoveWorker );
+  RUN_TEST_CASE( AppExecutor, AppExecutorSetLength );
+  RUN_TEST_CASE( AppExecutor, AppExecutorBenchmark );
+}
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "app_config.h"
+#include "app_fsm.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define BENCHMARK_EVENTS 200000
+
+#define STATE_HANDLER_ARRAY                                                    \
+  STATE( DISABLED, _disabled_state_handler_array, NULL, NULL )                 \
+  STATE( WORKING, _working_state_handler_array, _working_entry, _working_exit )
+
+typedef enum
+{
+#define STATE APP_FSM_STATE_ENUM
+  STATE_HANDLER_ARRAY
+#undef STATE
+    STATE_TOP,
+} test_state_t;
+
+static void _working_entry( void );
+static void _working_exit( void );
+static void _disabled_init_req( const app_event_t* event );
+static void _working_init_res( const app_event_t* event );
+static void _working_deinit_req( const app_event_t* event );
+
+static const app_events_handler_table_t _disabled_state_handler_array =
+  {
+    EVENT_ITEM( MSG_ID_INIT_REQ, _disabled_init_req ),
+};
+
+static const app_events_handler_table_t _working_state_handler_array =
+  {
+    EVENT_ITEM( MSG_ID_INIT_RES, _working_init_res ),
+    EVENT_ITEM( MSG_ID_DEINIT_REQ, _working_deinit_req ),
+};
+
+static const app_fsm_state_t test_states[STATE_TOP] =
+  {
+#define STATE APP_FSM_STATE_ITEM
+    STATE_HANDLER_ARRAY
+#undef STATE
+};
+
+static app_fsm_t fsm =
+  {
+    .name = "test_fsm",
+    .task = APP_EVENT_OTA,
+    .states = test_states,
+    .states_count = STATE_TOP,
+    .queue_length = 8,
+};
+
+static uint32_t entry_count;
+static uint32_t exit_count;
+static uint32_t handled_count;
+
+TEST_GROUP( AppFsm );
+
+TEST_SETUP( AppFsm )
+{
+  if ( fsm.queue == NULL )
+  {
+    AppFsmInit( &fsm );
+  }
+  AppEventRegisterQueue( fsm.task, fsm.queue );
+  fsm.state = DISABLED;
+  entry_count = 0;
+  exit_count = 0;
+  handled_count = 0;
+}
+
+TEST_TEAR_DOWN( AppFsm )
+{
+  while ( AppFsmProcess( &fsm, 0 ) )
+  {
+  }
+}
+
+static uint64_t _get_time_ns( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void _working_entry( void )
+{
+  entry_count++;
+}
+
+static void _working_exit( void )
+{
+  exit_count++;
+}
+
+static void _disabled_init_req( const app_event_t* event )
+{
+  handled_count++;
+  AppFsmChangeState( &fsm, WORKING );
+  AppFsmPostInternal( &fsm, MSG_ID_INIT_RES, NULL, 0 );
+}
+
+static void _working_init_res( const app_event_t* event )
+{
+  handled_count++;
+}
+
+static void _working_deinit_req( const app_event_t* event )
+{
+  handled_count++;
+  AppFsmChangeState( &fsm, DISABLED );
+}
+
+TEST( AppFsm, AppFsmEntryExit )
+{
+  TEST_ASSERT_EQUAL_STRING( "DISABLED", AppFsmGetStateName( &fsm ) );
+  TEST_ASSERT_TRUE( AppFsmPostInternal( &fsm, MSG_ID_INIT_REQ, NULL, 0 ) );
+
+  /* INIT_REQ changes state and posts INIT_RES to itself */
+  TEST_ASSERT_TRUE( AppFsmProcess( &fsm, 0 ) );
+  TEST_ASSERT_EQUAL( WORKING, fsm.state );
+  TEST_ASSERT_EQUAL( 1, entry_count );
+  TEST_ASSERT_EQUAL( 0, exit_count );
+  TEST_ASSERT_TRUE( AppFsmProcess( &fsm, 0 ) );
+  TEST_ASSERT_EQUAL( 2, handled_count );
+  TEST_ASSERT_FALSE( AppFsmProcess( &fsm, 0 ) );
+
+  /* Change to current state doesn't run actions */
+  AppFsmChangeState( &fsm, WORKING );
+  TEST_ASSERT_EQUAL( 1, entry_count );
+  TEST_ASSERT_EQUAL( 0, exit_count );
+
+  TEST_ASSERT_TRUE( AppFsmPostInternal( &fsm, MSG_ID_DEINIT_REQ, NULL, 0 ) );
+  TEST_ASSERT_TRUE( AppFsmProcess( &fsm, 0 ) );
+  TEST_ASSERT_EQUAL_STRING( "DISABLED", AppFsmGetStateName( &fsm ) );
+  TEST_ASSERT_EQUAL( 1, exit_count );
+}
+
+TEST( AppFsm, AppFsmReplay )
+{
+  /* Recorded events with state after each of them, unhandled ones keep state */
+  static const struct
+  {
+    app_msg_id_t msg_id;
+    test_state_t state;
+    bool handled;
+  } replay[] = {
+    {MSG_ID_INIT_RES,    DISABLED, false},
+    { MSG_ID_INIT_REQ,   WORKING,  true },
+    { MSG_ID_INIT_REQ,   WORKING,  false},
+    { MSG_ID_INIT_RES,   WORKING,  true },
+    { MSG_ID_DEINIT_REQ, DISABLED, true },
+    { MSG_ID_DEINIT_REQ, DISABLED, false},
+    { MSG_ID_INIT_REQ,   WORKING,  true },
+  };
+  app_event_t event = {};
+
+  for ( size_t i = 0; i < ARRAY_SIZE( replay ); i++ )
+  {
+    AppEventPrepareNoData( &event, replay[i].msg_id, APP_EVENT_APP_MANAGER, fsm.task );
+    TEST_ASSERT_EQUAL( replay[i].handled, AppFsmDispatch( &fsm, &event ) );
+    TEST_ASSERT_EQUAL( replay[i].state, fsm.state );
+  }
+  TEST_ASSERT_EQUAL( 2, entry_count );
+  TEST_ASSERT_EQUAL( 1, exit_count );
+}
+
+TEST( AppFsm, AppFsmBenchmark )
+{
+  uint64_t start = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_EVENTS; i++ )
+  {
+    AppFsmPostInternal( &fsm, i % 2 ? MSG_ID_DEINIT_REQ : MSG_ID_INIT_REQ, NULL, 0 );
+    while ( AppFsmProcess( &fsm, 0 ) )
+    {
+    }
+  }
+  uint64_t time_ns = _get_time_ns() - start;
+
+  /* Every INIT_REQ is followed by internal INIT_RES */
+  TEST_ASSERT_EQUAL( BENCHMARK_EVENTS + BENCHMARK_EVENTS / 2, handled_count );
+  TEST_ASSERT_EQUAL( BENCHMARK_EVENTS / 2, entry_count );
+  printf( "\nFSM %u events: %llu ns/event\n", (unsigned) handled_count, (unsigned long long) ( time_ns / handled_count ) );
+}
+
+TEST_GROUP_RUNNER( AppFsm )
+{
+  RUN_TEST_CASE( AppFsm, AppFsmEntryExit );
+  RUN_TEST_CASE( AppFsm, AppFsmReplay );
+  RUN_TEST_CASE( AppFsm, AppFsmBenchmark );
+}
@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "app_config.h"
+#include "app_timers.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define QUEUE_LENGTH      16
+#define TEST_TASK         APP_EVENT_MQTT_APP
+#define BENCHMARK_TIMERS  64
+#define BENCHMARK_TICKS   100000
+#define NOT_FIRED         UINT32_MAX
+#define PERIOD_MS         1000
+#define JITTER_PERIODS    100
+#define PROCESSING_MAX_MS 300
+
+/* Level boundaries of wheel, first and last slots and timer longer than wheel */
+static app_timer_t timers[] =
+  {
+    TIMER_ITEM( 0, MSG_ID_INIT_REQ, 10, "t10" ),
+    TIMER_ITEM( 1, MSG_ID_INIT_RES, 35, "t35" ),
+    TIMER_ITEM( 2, MSG_ID_DEINIT_REQ, 160, "t160" ),
+    TIMER_ITEM( 3, MSG_ID_APP_MANAGER_INIT_REQ, 2560, "t2560" ),
+    TIMER_ITEM( 4, MSG_ID_APP_MANAGER_INIT_RES, 40950, "t40950" ),
+    TIMER_ITEM( 5, MSG_ID_APP_MANAGER_TIMEOUT_INIT, 700000, "t700000" ),
+};
+
+static app_timer_t periodic_timers[] =
+  {
+    PERIODIC_TIMER_ITEM( 0, MSG_ID_DEV_MANAGER_MEASURE, PERIOD_MS, "periodic" ),
+    TIMER_ITEM( 1, MSG_ID_DEV_MANAGER_POST, PERIOD_MS, "restarted" ),
+};
+
+static app_timer_t benchmark_timers[BENCHMARK_TIMERS];
+static QueueHandle_t queue;
+static uint32_t fired_at[MSG_ID_LAST];
+static uint32_t handled_count;
+
+static void _handler( const app_event_t* event )
+{
+  handled_count++;
+}
+
+static const app_events_handler_table_t handlers =
+  {
+    EVENT_ITEM( MSG_ID_DEV_MANAGER_MEASURE, _handler ),
+    EVENT_ITEM( MSG_ID_DEV_MANAGER_POST, _handler ),
+};
+
+TEST_GROUP( AppTimers );
+
+TEST_SETUP( AppTimers )
+{
+  if ( queue == NULL )
+  {
+    queue = xQueueCreate( QUEUE_LENGTH, sizeof( app_event_t ) );
+  }
+  AppEventRegisterQueue( TEST_TASK, queue );
+  AppTimersInit( TEST_TASK, timers, ARRAY_SIZE( timers ) );
+  AppTimersInit( TEST_TASK, periodic_timers, ARRAY_SIZE( periodic_timers ) );
+  handled_count = 0;
+  for ( size_t i = 0; i < ARRAY_SIZE( fired_at ); i++ )
+  {
+    fired_at[i] = NOT_FIRED;
+  }
+}
+
+TEST_TEAR_DOWN( AppTimers )
+{
+  for ( size_t i = 0; i < ARRAY_SIZE( timers ); i++ )
+  {
+    AppTimerStop( timers, i );
+  }
+  for ( size_t i = 0; i < ARRAY_SIZE( periodic_timers ); i++ )
+  {
+    AppTimerStop( periodic_timers, i );
+  }
+  xQueueReset( queue );
+}
+
+static uint64_t _get_time_ns( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t _process( uint32_t now_ms )
+{
+  uint32_t count = 0;
+  app_event_t event = {};
+
+  AppTimersProcess( now_ms );
+  while ( xQueueReceive( queue, &event, 0 ) == pdPASS )
+  {
+    TEST_ASSERT_EQUAL( TEST_TASK, event.dst );
+    TEST_ASSERT_EQUAL( NOT_FIRED, fired_at[event.msg_id] );
+    fired_at[event.msg_id] = now_ms;
+    AppEventDispatch( &event, handlers );
+    AppEventDelete( &event );
+    count++;
+  }
+  return count;
+}
+
+/* Wheel time starts from zero tick count on host, so ticks are on multiples of tick period */
+static uint32_t _get_aligned_start( void )
+{
+  uint32_t start = AppTimersGetTime() + CONFIG_APP_TIMERS_TICK_MS - 1;
+  start -= start % CONFIG_APP_TIMERS_TICK_MS;
+  _process( start );
+  return start;
+}
+
+TEST( AppTimers, AppTimersFireTime )
+{
+  /* Start between wheel ticks, timers must not fire early and at most one tick late */
+  uint32_t start = AppTimersGetTime() + 7;
+  _process( start );
+  for ( size_t i = 0; i < ARRAY_SIZE( timers ); i++ )
+  {
+    AppTimerStart( timers, i );
+  }
+
+  uint32_t fired = 0;
+  for ( uint32_t now = start; fired < ARRAY_SIZE( timers ) && now - start < 800000; now++ )
+  {
+    fired += _process( now );
+  }
+
+  for ( size_t i = 0; i < ARRAY_SIZE( timers ); i++ )
+  {
+    uint32_t due = start + timers[i].timeout_ms;
+    TEST_ASSERT_NOT_EQUAL( NOT_FIRED, fired_at[timers[i].msg_id] );
+    TEST_ASSERT_GREATER_OR_EQUAL( due, fired_at[timers[i].msg_id] );
+    TEST_ASSERT_LESS_OR_EQUAL( due + CONFIG_APP_TIMERS_TICK_MS, fired_at[timers[i].msg_id] );
+  }
+}
+
+TEST( AppTimers, AppTimersStopRestart )
+{
+  uint32_t start = AppTimersGetTime();
+  AppTimerStart( timers, 2 );
+  AppTimerStart( timers, 3 );
+  AppTimerStop( timers, 2 );
+
+  /* Restart moves expiry */
+  _process( start + 1000 );
+  AppTimerStart( timers, 3 );
+  _process( start + 2560 );
+  TEST_ASSERT_EQUAL( NOT_FIRED, fired_at[timers[3].msg_id] );
+  _process( start + 3560 );
+  TEST_ASSERT_EQUAL( start + 3560, fired_at[timers[3].msg_id] );
+  TEST_ASSERT_EQUAL( NOT_FIRED, fired_at[timers[2].msg_id] );
+
+  app_timers_stats_t stats = {};
+  AppTimersGetStats( &stats );
+  TEST_ASSERT_EQUAL( 0, stats.active_count );
+}
+
+TEST( AppTimers, AppTimersLateness )
+{
+  AppTimersResetStats();
+  uint32_t start = AppTimersGetTime();
+  AppTimerStart( timers, 0 );
+  AppTimerStart( timers, 1 );
+
+  /* Tick source delayed by 50 ms */
+  _process( start + 60 );
+
+  app_timers_stats_t stats = {};
+  AppTimersGetStats( &stats );
+  TEST_ASSERT_EQUAL( 2, stats.fired_count );
+  TEST_ASSERT_EQUAL( 2, stats.late_count );
+  TEST_ASSERT_EQUAL( 50, stats.max_lateness_ms );
+  TEST_ASSERT_EQUAL( 75, stats.total_lateness_ms );
+  TEST_ASSERT_EQUAL( 2, stats.max_active_count );
+}
+
+/* Runs tick source every tick and module worker which is busy for given time after each event */
+static uint32_t _run_worker( uint32_t now, uint32_t until, uint32_t ( *get_delay )( void ), app_timer_t* restart )
+{
+  uint32_t busy_until = now;
+  app_event_t event = {};
+
+  for ( ; (int32_t) ( until - now ) > 0; now++ )
+  {
+    AppTimersProcess( now );
+    TEST_ASSERT_LESS_OR_EQUAL( 1, uxQueueMessagesWaiting( queue ) );
+    if ( (int32_t) ( now - busy_until ) >= 0 && xQueueReceive( queue, &event, 0 ) == pdPASS )
+    {
+      TEST_ASSERT_TRUE( AppEventDispatch( &event, handlers ) );
+      if ( fired_at[event.msg_id] == NOT_FIRED )
+      {
+        fired_at[event.msg_id] = now;
+      }
+      busy_until = now + get_delay();
+      if ( restart != NULL )
+      {
+        /* One-shot timer restarted after processing, as loops did before */
+        AppTimersProcess( busy_until );
+        AppTimerStart( restart, 1 );
+        now = busy_until;
+      }
+      AppEventDelete( &event );
+    }
+  }
+  return now;
+}
+
+static uint32_t _random_delay( void )
+{
+  return rand() % PROCESSING_MAX_MS;
+}
+
+static uint32_t _long_delay( void )
+{
+  return PERIOD_MS * 5 / 2;
+}
+
+TEST( AppTimers, AppTimersPeriodicJitter )
+{
+  AppTimersResetStats();
+  uint32_t start = _get_aligned_start();
+  AppTimerStart( periodic_timers, 0 );
+  uint32_t end = _run_worker( start, start + JITTER_PERIODS * PERIOD_MS + 1, _random_delay, NULL );
+
+  app_timers_stats_t stats = {};
+  AppTimersGetStats( &stats );
+  TEST_ASSERT_EQUAL( JITTER_PERIODS, handled_count );
+  TEST_ASSERT_EQUAL( JITTER_PERIODS, stats.fired_count );
+  TEST_ASSERT_LESS_OR_EQUAL( CONFIG_APP_TIMERS_TICK_MS, stats.max_lateness_ms );
+  TEST_ASSERT_EQUAL( 0, stats.overrun_count );
+  TEST_ASSERT_EQUAL( 0, stats.skipped_count );
+  uint32_t periodic_jitter = stats.max_lateness_ms;
+  AppTimerStop( periodic_timers, 0 );
+
+  /* Same load on one-shot timer restarted by handler drifts by processing time */
+  handled_count = 0;
+  AppTimerStart( periodic_timers, 1 );
+  _run_worker( end, end + JITTER_PERIODS * PERIOD_MS + 1, _random_delay, periodic_timers );
+  TEST_ASSERT_LESS_THAN( JITTER_PERIODS, handled_count );
+
+  printf( "\nPeriodic %u x %u ms with 0-%u ms processing: max late %lu ms, one-shot restart: %u periods\n",
+          JITTER_PERIODS, PERIOD_MS, PROCESSING_MAX_MS, (unsigned long) periodic_jitter, (unsigned) handled_count );
+}
+
+TEST( AppTimers, AppTimersPeriodicOverrun )
+{
+  AppTimersResetStats();
+  uint32_t start = _get_aligned_start();
+  AppTimerStart( periodic_timers, 0 );
+
+  /* Handler takes 2.5 periods, at most one event waits in queue */
+  _run_worker( start, start + 10 * PERIOD_MS + 1, _long_delay, NULL );
+
+  app_timers_stats_t stats = {};
+  AppTimersGetStats( &stats );
+  TEST_ASSERT_EQUAL( 10, stats.fired_count );
+  TEST_ASSERT_EQUAL( 4, handled_count );
+  TEST_ASSERT_EQUAL( 5, periodic_timers[0].overrun_count );
+  TEST_ASSERT_EQUAL( 5, stats.overrun_count );
+  TEST_ASSERT_EQUAL( 0, stats.skipped_count );
+}
+
+TEST( AppTimers, AppTimersPeriodicSkip )
+{
+  AppTimersResetStats();
+  uint32_t start = _get_aligned_start();
+  AppTimerStart( periodic_timers, 0 );
+
+  /* Tick source stalls for 3.5 periods, missed deadlines are dropped */
+  _process( start + PERIOD_MS * 7 / 2 );
+  TEST_ASSERT_EQUAL( start + PERIOD_MS * 7 / 2, fired_at[MSG_ID_DEV_MANAGER_MEASURE] );
+  TEST_ASSERT_EQUAL( 2, periodic_timers[0].skipped_count );
+
+  /* Deadlines stay on start + n * period */
+  fired_at[MSG_ID_DEV_MANAGER_MEASURE] = NOT_FIRED;
+  _process( start + PERIOD_MS * 4 - 1 );
+  TEST_ASSERT_EQUAL( NOT_FIRED, fired_at[MSG_ID_DEV_MANAGER_MEASURE] );
+  _process( start + PERIOD_MS * 4 );
+  TEST_ASSERT_EQUAL( start + PERIOD_MS * 4, fired_at[MSG_ID_DEV_MANAGER_MEASURE] );
+
+  app_timers_stats_t stats = {};
+  AppTimersGetStats( &stats );
+  TEST_ASSERT_EQUAL( 2, stats.skipped_count );
+  TEST_ASSERT_EQUAL( PERIOD_MS * 5 / 2, stats.max_lateness_ms );
+}
+
+TEST( AppTimers, AppTimersBenchmark )
+{
+  for ( size_t i = 0; i < BENCHMARK_TIMERS; i++ )
+  {
+    benchmark_timers[i].msg_id = MSG_ID_INIT_REQ;
+    benchmark_timers[i].timeout_ms = 10 + rand() % 60000;
+  }
+  AppTimersInit( TEST_TASK, benchmark_timers, BENCHMARK_TIMERS );
+
+  uint64_t start_ns = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_TICKS; i++ )
+  {
+    AppTimerStart( benchmark_timers, i % BENCHMARK_TIMERS );
+  }
+  uint64_t start_time_ns = _get_time_ns() - start_ns;
+
+  /* Benchmark measures wheel only, events are dropped every tick */
+  uint32_t now = AppTimersGetTime();
+  start_ns = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_TICKS; i++ )
+  {
+    now += CONFIG_APP_TIMERS_TICK_MS;
+    AppTimersProcess( now );
+    xQueueReset( queue );
+  }
+  uint64_t tick_time_ns = _get_time_ns() - start_ns;
+
+  app_timers_stats_t stats = {};
+  AppTimersGetStats( &stats );
+  TEST_ASSERT_EQUAL( 0, stats.active_count );
+  printf( "\nTimers %u starts: %llu ns/start, %u ticks: %llu ns/tick\n", BENCHMARK_TICKS,
+          (unsigned long long) ( start_time_ns / BENCHMARK_TICKS ), BENCHMARK_TICKS, (unsigned long long) ( tick_time_ns / BENCHMARK_TICKS ) );
+}
+
+TEST_GROUP_RUNNER( AppTimers )
+{
+  RUN_TEST_CASE( AppTimers, AppTimersFireTime );
+  RUN_TEST_CASE( AppTimers, AppTimersStopRestart );
+  RUN_TEST_CASE( AppTimers, AppTimersLateness );
+  RUN_TEST_CASE( AppTimers, AppTimersPeriodicJitter );
+  RUN_TEST_CASE( AppTimers, AppTimersPeriodicOverrun );
+  RUN_TEST_CASE( AppTimers, AppTimersPeriodicSkip );
+  RUN_TEST_CASE( AppTimers, AppTimersBenchmark );
+}
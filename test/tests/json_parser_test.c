@@ -1,17 +1,28 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "app_config.h"
 #include "json_parser.h"
 #include "unity.h"
 #include "unity_fixture.h"
 
-#define OK_RESPONSE "{\"param1\":1}"
+#define OK_RESPONSE          "{\"param1\":1}"
+#define BENCHMARK_KEYS       50
+#define BENCHMARK_ITERATIONS 20000
+#define ARENA_TOKENS         16
 
 static bool init_is_running;
 static bool test_bool;
 static int test_int;
+static int64_t test_int64;
 static double test_double;
 static char test_string[128];
 static size_t test_string_len;
 static bool test_null;
 static uint32_t test_iterator_value;
+static int test_int_calls;
+static error_code_t nested_results[2];
+static bool nested_small_arena;
 
 TEST_GROUP( JsonParser );
 
@@ -20,11 +31,13 @@ TEST_SETUP( JsonParser )
   JSONParser_Init();
   test_bool = false;
   test_int = 0;
+  test_int64 = 0;
   test_double = 0;
   memset( test_string, 0, sizeof( test_string ) );
   test_string_len = 0;
   test_null = false;
   init_is_running = false;
+  test_int_calls = 0;
 }
 
 TEST_TEAR_DOWN( JsonParser )
@@ -40,6 +53,13 @@ static void _bool_cb( bool value, uint32_t iterator )
 static void _int_cb( int value, uint32_t iterator )
 {
   test_int = value;
+  test_int_calls++;
+  TEST_ASSERT_EQUAL( test_iterator_value, iterator );
+}
+
+static void _int64_cb( int64_t value, uint32_t iterator )
+{
+  test_int64 = value;
   TEST_ASSERT_EQUAL( test_iterator_value, iterator );
 }
 
@@ -72,7 +92,7 @@ static error_code_t response_ok_cb( char* response, size_t responseLen )
   return ERROR_CODE_OK;
 }
 
-static error_code_t response_fail_cb( void )
+static error_code_t response_fail_cb( char* response, size_t responseLen )
 {
   return ERROR_CODE_FAIL;
 }
@@ -105,6 +125,29 @@ TEST( JsonParser, JsonParserParseString )
   TEST_ASSERT_EQUAL( true, init_is_running );
 }
 
+TEST( JsonParser, JsonParserParseInt64 )
+{
+  json_parse_token_t token[] = {
+    {.int64_cb = _int64_cb,
+     .name = "from"},
+    { .int_cb = _int_cb,
+     .name = "step"},
+  };
+  char request[128];
+  char response[256] = { 0 };
+  uint32_t iterator = 0;
+  test_iterator_value = 5;
+
+  /* Time since boot in ms past INT32_MAX (24.8 days), as sent back from "next" of history page */
+  const int64_t next_ms = (int64_t) INT32_MAX * 3 + 7;
+  snprintf( request, sizeof( request ), "{\"method\":\"history\",\"data\":{\"from\":%lld,\"step\":1000}, \"i\":5}", (long long) next_ms );
+  TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( token, sizeof( token ) / sizeof( token[0] ), "history", NULL, response_ok_cb ) );
+  TEST_ASSERT_EQUAL( ERROR_CODE_OK, JSONParse( request, strlen( request ), &iterator, response, sizeof( response ) ) );
+  TEST_ASSERT_TRUE( test_int64 == next_ms );
+  TEST_ASSERT_EQUAL( 1000, test_int );
+  TEST_ASSERT_EQUAL( 1, test_int_calls );
+}
+
 TEST( JsonParser, JsonParserParseTestResultFail )
 {
   json_parse_token_t token[] = {
@@ -121,8 +164,194 @@ TEST( JsonParser, JsonParserParseTestResultFail )
   TEST_ASSERT_EQUAL( true, init_is_running );
 }
 
+TEST( JsonParser, JsonParserMethodExactName )
+{
+  json_parse_token_t token[] = {
+    {.int_cb = _int_cb,
+     .name = "int"}
+  };
+  char response[256] = { 0 };
+  uint32_t iterator = 0;
+  test_iterator_value = 0;
+  const char* test_string = "{\"method\":\"get\",\"data\":{\"int\":5}}";
+  TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( token, sizeof( token ) / sizeof( token[0] ), "getHistory", NULL, response_fail_cb ) );
+  TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( token, sizeof( token ) / sizeof( token[0] ), "get", init_cb, response_ok_cb ) );
+  TEST_ASSERT_EQUAL( ERROR_CODE_OK, JSONParse( test_string, strlen( test_string ), &iterator, response, sizeof( response ) ) );
+  TEST_ASSERT_EQUAL( 5, test_int );
+  TEST_ASSERT_EQUAL( true, init_is_running );
+}
+
+TEST( JsonParser, JsonParserTokenExactName )
+{
+  json_parse_token_t token[] = {
+    {.int_cb = _int_cb,
+     .name = "int"}
+  };
+  char response[256] = { 0 };
+  uint32_t iterator = 0;
+  test_iterator_value = 7;
+  /* Method isn't first key and keys only sharing prefix with token are ignored */
+  const char* test_string = "{\"i\":7,\"data\":{\"in\":1,\"integer\":2,\"int\":3},\"method\":\"set\"}";
+  TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( token, sizeof( token ) / sizeof( token[0] ), "set", init_cb, response_ok_cb ) );
+  TEST_ASSERT_EQUAL( ERROR_CODE_OK, JSONParse( test_string, strlen( test_string ), &iterator, response, sizeof( response ) ) );
+  TEST_ASSERT_EQUAL( 7, iterator );
+  TEST_ASSERT_EQUAL( 1, test_int_calls );
+  TEST_ASSERT_EQUAL( 3, test_int );
+
+  test_string = "{\"method\":\"se\",\"data\":{\"int\":4}}";
+  TEST_ASSERT_EQUAL( ERROR_CODE_ERROR_PARSING, JSONParse( test_string, strlen( test_string ), &iterator, response, sizeof( response ) ) );
+  TEST_ASSERT_EQUAL( 1, test_int_calls );
+}
+
+TEST( JsonParser, JsonParserBenchmark )
+{
+  static char names[BENCHMARK_KEYS][8];
+  static json_parse_token_t tokens[BENCHMARK_KEYS];
+  static char request[BENCHMARK_KEYS * 16 + 64];
+  char response[256] = { 0 };
+  uint32_t iterator = 0;
+  int len = sprintf( request, "{\"method\":\"setMany\",\"i\":1,\"data\":{" );
+
+  for ( size_t i = 0; i < BENCHMARK_KEYS; i++ )
+  {
+    sprintf( names[i], "key%zu", i );
+    tokens[i] = (json_parse_token_t) { .name = names[i], .int_cb = _int_cb };
+    len += sprintf( &request[len], "%s\"%s\":%zu", i ? "," : "", names[i], i );
+  }
+  len += sprintf( &request[len], "}}" );
+
+  const char* other_methods[] = { "getA", "getB", "getC", "getD", "getE", "getF", "getG", "getH", "getI", "getJ", "getK" };
+  for ( size_t i = 0; i < sizeof( other_methods ) / sizeof( other_methods[0] ); i++ )
+  {
+    TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( NULL, 0, other_methods[i], NULL, NULL ) );
+  }
+  TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( tokens, BENCHMARK_KEYS, "setMany", NULL, response_ok_cb ) );
+
+  test_iterator_value = 1;
+  struct timespec start, end;
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  for ( size_t i = 0; i < BENCHMARK_ITERATIONS; i++ )
+  {
+    TEST_ASSERT_EQUAL( ERROR_CODE_OK, JSONParse( request, len, &iterator, response, sizeof( response ) ) );
+  }
+  clock_gettime( CLOCK_MONOTONIC, &end );
+
+  TEST_ASSERT_EQUAL( BENCHMARK_KEYS * BENCHMARK_ITERATIONS, test_int_calls );
+  TEST_ASSERT_EQUAL( BENCHMARK_KEYS - 1, test_int );
+  uint64_t elapsed_ns = (uint64_t) ( end.tv_sec - start.tv_sec ) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+  printf( "\r\nJSON parser: %d keys request in %llu ns\r\n", BENCHMARK_KEYS, (unsigned long long) ( elapsed_ns / BENCHMARK_ITERATIONS ) );
+}
+
+TEST( JsonParser, JsonParserOwnArena )
+{
+  json_parse_token_t token[] = {
+    {.int_cb = _int_cb,
+     .name = "int"}
+  };
+  lwjson_token_t tokens[ARENA_TOKENS];
+  json_arena_t arena;
+  char response[256] = { 0 };
+  uint32_t iterator = 0;
+  test_iterator_value = 0;
+  const char* test_string = "{\"method\":\"set\",\"data\":{\"int\":42}}";
+  TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( token, sizeof( token ) / sizeof( token[0] ), "set", NULL, response_ok_cb ) );
+
+  /* Top object is in lwjson, request needs 3 more tokens for method, data and int */
+  JSONArena_Init( &arena, tokens, 2 );
+  TEST_ASSERT_EQUAL( ERROR_CODE_ERROR_PARSING, JSONParser_Parse( &arena, test_string, strlen( test_string ), &iterator, response, sizeof( response ) ) );
+  TEST_ASSERT_EQUAL( 0, test_int_calls );
+
+  JSONArena_Init( &arena, tokens, ARENA_TOKENS );
+  TEST_ASSERT_EQUAL( ERROR_CODE_OK, JSONParser_Parse( &arena, test_string, strlen( test_string ), &iterator, response, sizeof( response ) ) );
+  TEST_ASSERT_EQUAL( 42, test_int );
+}
+
+static void _nested_cb( int value, uint32_t iterator )
+{
+  /* Parse inside of parse, as second task would do, needs another arena of pool */
+  char response[64];
+  uint32_t nested_iterator = 0;
+  char request[64];
+  int len = sprintf( request, "{\"method\":\"nest\",\"data\":{\"depth\":%d}}", value + 1 );
+  nested_results[value] = JSONParse( request, len, &nested_iterator, response, sizeof( response ) );
+
+  json_arena_t* arena = JSONArena_Take( CONFIG_MQTT_JSON_PARSER_TOKENS );
+  nested_small_arena = arena != NULL;
+  if ( arena != NULL )
+  {
+    JSONArena_Give( arena );
+  }
+}
+
+TEST( JsonParser, JsonParserNestedParse )
+{
+  json_parse_token_t token[] = {
+    {.int_cb = _nested_cb,
+     .name = "depth"}
+  };
+  char response[256] = { 0 };
+  uint32_t iterator = 0;
+  const char* test_string = "{\"method\":\"nest\",\"data\":{\"depth\":0}}";
+  TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( token, sizeof( token ) / sizeof( token[0] ), "nest", NULL, response_ok_cb ) );
+  JSONParser_Seal();
+  TEST_ASSERT_EQUAL( false, JSONParser_RegisterMethod( token, sizeof( token ) / sizeof( token[0] ), "late", NULL, response_ok_cb ) );
+
+  /* Depth 0 holds only arena big enough for TCP request, MQTT sized arena is still free */
+  memset( nested_results, 0xFF, sizeof( nested_results ) );
+  nested_small_arena = false;
+  TEST_ASSERT_EQUAL( ERROR_CODE_OK, JSONParse( test_string, strlen( test_string ), &iterator, response, sizeof( response ) ) );
+  TEST_ASSERT_EQUAL( ERROR_CODE_BUSY, nested_results[0] );
+  TEST_ASSERT_EQUAL( true, nested_small_arena );
+
+  /* Arenas are returned */
+  TEST_ASSERT_EQUAL( ERROR_CODE_OK, JSONParse( test_string, strlen( test_string ), &iterator, response, sizeof( response ) ) );
+}
+
+TEST( JsonParser, JsonParserTokensLimit )
+{
+  static char names[CONFIG_JSON_PARSER_TOKENS][8];
+  static json_parse_token_t tokens[CONFIG_JSON_PARSER_TOKENS];
+  static char request[CONFIG_JSON_PARSER_TOKENS * 16 + 64];
+  char response[256] = { 0 };
+  uint32_t iterator = 0;
+  test_iterator_value = 0;
+
+  /* Method and data take 2 tokens of limit, rest are values of data */
+  for ( size_t keys = CONFIG_JSON_PARSER_TOKENS - 2; keys <= CONFIG_JSON_PARSER_TOKENS - 1; keys++ )
+  {
+    int len = sprintf( request, "{\"method\":\"setMany\",\"data\":{" );
+    for ( size_t i = 0; i < keys; i++ )
+    {
+      sprintf( names[i], "key%zu", i );
+      tokens[i] = (json_parse_token_t) { .name = names[i], .int_cb = _int_cb };
+      len += sprintf( &request[len], "%s\"%s\":%zu", i ? "," : "", names[i], i );
+    }
+    len += sprintf( &request[len], "}}" );
+    TEST_ASSERT_LESS_OR_EQUAL( CONFIG_TCP_SERVER_MAX_FRAME, len );
+    if ( keys == CONFIG_JSON_PARSER_TOKENS - 2 )
+    {
+      TEST_ASSERT_EQUAL( true, JSONParser_RegisterMethod( tokens, keys, "setMany", NULL, response_ok_cb ) );
+      TEST_ASSERT_EQUAL( ERROR_CODE_OK, JSONParse( request, len, &iterator, response, sizeof( response ) ) );
+      TEST_ASSERT_EQUAL( keys, test_int_calls );
+    }
+    else
+    {
+      /* Request over limit is dropped before any value is passed */
+      TEST_ASSERT_EQUAL( ERROR_CODE_ERROR_PARSING, JSONParse( request, len, &iterator, response, sizeof( response ) ) );
+      TEST_ASSERT_EQUAL( CONFIG_JSON_PARSER_TOKENS - 2, test_int_calls );
+    }
+  }
+}
+
 TEST_GROUP_RUNNER( JsonParser )
 {
   RUN_TEST_CASE( JsonParser, JsonParserParseString );
+  RUN_TEST_CASE( JsonParser, JsonParserParseInt64 );
   RUN_TEST_CASE( JsonParser, JsonParserParseTestResultFail );
+  RUN_TEST_CASE( JsonParser, JsonParserMethodExactName );
+  RUN_TEST_CASE( JsonParser, JsonParserTokenExactName );
+  RUN_TEST_CASE( JsonParser, JsonParserBenchmark );
+  RUN_TEST_CASE( JsonParser, JsonParserOwnArena );
+  RUN_TEST_CASE( JsonParser, JsonParserNestedParse );
+  RUN_TEST_CASE( JsonParser, JsonParserTokensLimit );
 }
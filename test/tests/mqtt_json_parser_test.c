@@ -0,0 +1,104 @@
+#include <string.h>
+
+#include "mqtt_json_parser.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define ARENA_TOKENS 16
+
+typedef struct
+{
+  int value;
+  int calls;
+  bool state;
+  int state_calls;
+} test_device_t;
+
+static test_device_t devices[2];
+
+TEST_GROUP( MqttJsonParser );
+
+TEST_SETUP( MqttJsonParser )
+{
+  MQTTJsonParser_Init();
+  memset( devices, 0, sizeof( devices ) );
+}
+
+TEST_TEAR_DOWN( MqttJsonParser )
+{
+}
+
+static void _int_cb( void* user_data, int value )
+{
+  test_device_t* dev = user_data;
+  dev->value = value;
+  dev->calls++;
+}
+
+static void _bool_cb( void* user_data, bool value )
+{
+  test_device_t* dev = user_data;
+  dev->state = value;
+  dev->state_calls++;
+}
+
+static json_parse_token_t tokens[] = {
+  {.int_cb = _int_cb,
+   .name = "value"},
+  { .bool_cb = _bool_cb,
+   .name = "state"},
+};
+
+static error_code_t _parse( const char* topic, const char* json )
+{
+  return MQTTJsonParse( topic, strlen( topic ), json, strlen( json ), NULL, 0 );
+}
+
+TEST( MqttJsonParser, EveryTokenOnce )
+{
+  TEST_ASSERT_EQUAL( true, MQTTJsonParser_RegisterMethod( tokens, 2, MQTT_TOPIC_TYPE_CONTROL, "valve1", &devices[0], NULL, NULL ) );
+  TEST_ASSERT_EQUAL( true, MQTTJsonParser_RegisterMethod( tokens, 2, MQTT_TOPIC_TYPE_CONTROL, "valve2", &devices[1], NULL, NULL ) );
+
+  /* Keys only sharing prefix with token are ignored */
+  TEST_ASSERT_EQUAL( ERROR_CODE_OK, _parse( "ctl/valve2", "{\"state\":true,\"val\":1,\"values\":2,\"value\":3}" ) );
+  TEST_ASSERT_EQUAL( 1, devices[1].calls );
+  TEST_ASSERT_EQUAL( 3, devices[1].value );
+  TEST_ASSERT_EQUAL( 1, devices[1].state_calls );
+  TEST_ASSERT_EQUAL( true, devices[1].state );
+  TEST_ASSERT_EQUAL( 0, devices[0].calls );
+}
+
+TEST( MqttJsonParser, UnknownTopic )
+{
+  TEST_ASSERT_EQUAL( true, MQTTJsonParser_RegisterMethod( tokens, 2, MQTT_TOPIC_TYPE_CONTROL, "valve1", &devices[0], NULL, NULL ) );
+
+  TEST_ASSERT_EQUAL( ERROR_CODE_UNKNOWN_MQTT_TOPIC_TYPE, _parse( "xyz/valve1", "{\"value\":1}" ) );
+  /* Free slots of registry are not compared with topic */
+  TEST_ASSERT_EQUAL( ERROR_CODE_ERROR_PARSING, _parse( "set/valve1", "{\"value\":1}" ) );
+  TEST_ASSERT_EQUAL( ERROR_CODE_ERROR_PARSING, _parse( "ctl/valve", "{\"value\":1}" ) );
+  TEST_ASSERT_EQUAL( 0, devices[0].calls );
+}
+
+TEST( MqttJsonParser, OwnArenaAndSeal )
+{
+  lwjson_token_t arena_tokens[ARENA_TOKENS];
+  json_arena_t arena;
+  const char* topic = "ctl/valve1";
+  const char* json = "{\"value\":7}";
+
+  TEST_ASSERT_EQUAL( true, MQTTJsonParser_RegisterMethod( tokens, 2, MQTT_TOPIC_TYPE_CONTROL, "valve1", &devices[0], NULL, NULL ) );
+  MQTTJsonParser_Seal();
+  TEST_ASSERT_EQUAL( false, MQTTJsonParser_RegisterMethod( tokens, 2, MQTT_TOPIC_TYPE_CONTROL, "valve2", &devices[1], NULL, NULL ) );
+
+  JSONArena_Init( &arena, arena_tokens, ARENA_TOKENS );
+  TEST_ASSERT_EQUAL( ERROR_CODE_OK, MQTTJsonParser_Parse( &arena, topic, strlen( topic ), json, strlen( json ), NULL, 0 ) );
+  TEST_ASSERT_EQUAL( 7, devices[0].value );
+  TEST_ASSERT_EQUAL( ERROR_CODE_ERROR_PARSING, _parse( "ctl/valve2", json ) );
+}
+
+TEST_GROUP_RUNNER( MqttJsonParser )
+{
+  RUN_TEST_CASE( MqttJsonParser, EveryTokenOnce );
+  RUN_TEST_CASE( MqttJsonParser, UnknownTopic );
+  RUN_TEST_CASE( MqttJsonParser, OwnArenaAndSeal );
+}
@@ -0,0 +1,266 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_config.h"
+#include "mocks/ow_sim.h"
+#include "ow/devices/ow_device_ds18x20.h"
+#include "ow/ow.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define BENCHMARK_READS       10000
+#define SCRATCHPAD_SIZE       9
+#define CONVERSION_12_BITS_MS 750
+
+/* Single DS18B20 on simulated bus, converted to 25.0625 C */
+static ow_rom_t rom;
+static int dev;
+static ow_t ow;
+
+static uint64_t _get_time_ns( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Scratchpad read as it was done byte by byte before multi-byte transfers */
+static void _read_scratchpad_by_byte( uint8_t* data )
+{
+  ow_read_bit_raw( &ow );
+  ow_reset_raw( &ow );
+  ow_write_byte_raw( &ow, OW_CMD_MATCHROM );
+  for ( size_t i = 0; i < sizeof( rom.rom ); i++ )
+  {
+    ow_write_byte_raw( &ow, rom.rom[i] );
+  }
+  ow_write_byte_raw( &ow, OW_CMD_RSCRATCHPAD );
+  for ( size_t i = 0; i < SCRATCHPAD_SIZE; i++ )
+  {
+    data[i] = ow_read_byte_raw( &ow );
+  }
+}
+
+TEST_GROUP( OneWire );
+
+TEST_SETUP( OneWire )
+{
+  OWSim_Reset();
+  TEST_ASSERT_EQUAL( owOK, ow_init( &ow, &ow_sim_drv, NULL ) );
+  OWSim_MakeRom( OW_SIM_FAMILY_DS18B20, 0x7C3C126461ULL, &rom );
+  dev = OWSim_AddDevice( &rom, 25.0625f );
+  TEST_ASSERT_EQUAL( 1, ow_ds18x20_start_raw( &ow, NULL ) );
+  OWSim_AdvanceTime( CONVERSION_12_BITS_MS );
+  OWSim_ClearStats();
+}
+
+TEST_TEAR_DOWN( OneWire )
+{
+  ow_deinit( &ow );
+}
+
+TEST( OneWire, OneWireWriteBytesSingleTransfer )
+{
+  /* Write scratchpad with TH, TL and configuration, split by chunk limit */
+  const uint8_t data[] = { OW_CMD_SKIPROM, OW_CMD_WSCRATCHPAD, 0x1E, 0x0A, 0x3F };
+  uint8_t scratchpad[SCRATCHPAD_SIZE];
+  _Static_assert( sizeof( data ) <= OW_CFG_MAX_BYTES_PER_TRANSFER, "Data must fit one transfer" );
+
+  ow_reset_raw( &ow );
+  OWSim_ClearStats();
+  TEST_ASSERT_EQUAL( owOK, ow_write_bytes_raw( &ow, data, sizeof( data ) ) );
+  TEST_ASSERT_EQUAL( 1, OWSim_GetStats()->tx_rx_calls );
+  TEST_ASSERT_EQUAL( 8 * sizeof( data ), OWSim_GetStats()->slots );
+  OWSim_GetScratchpad( dev, scratchpad );
+  TEST_ASSERT_EQUAL_HEX8_ARRAY( &data[2], &scratchpad[2], 3 );
+
+  /* Longer data is split into chunks */
+  uint8_t long_data[OW_CFG_MAX_BYTES_PER_TRANSFER + 2] = { OW_CMD_MATCHROM };
+  memcpy( &long_data[1], rom.rom, sizeof( rom.rom ) );
+  memcpy( &long_data[1 + sizeof( rom.rom )], &data[1], sizeof( long_data ) - 1 - sizeof( rom.rom ) );
+  ow_reset_raw( &ow );
+  OWSim_ClearStats();
+  TEST_ASSERT_EQUAL( owOK, ow_write_bytes_raw( &ow, long_data, sizeof( long_data ) ) );
+  TEST_ASSERT_EQUAL( 2, OWSim_GetStats()->tx_rx_calls );
+  TEST_ASSERT_EQUAL( 8 * sizeof( long_data ), OWSim_GetStats()->slots );
+  OWSim_GetScratchpad( dev, scratchpad );
+  TEST_ASSERT_EQUAL_HEX8_ARRAY( &long_data[1 + sizeof( rom.rom ) + 1], &scratchpad[2], sizeof( long_data ) - 2 - sizeof( rom.rom ) );
+
+  /* Failed transfer stops at first chunk */
+  OWSim_ClearStats();
+  OWSim_InjectTransferFaults( 0, 1 );
+  TEST_ASSERT_EQUAL( owERR, ow_write_bytes_raw( &ow, long_data, sizeof( long_data ) ) );
+  TEST_ASSERT_EQUAL( 1, OWSim_GetStats()->tx_rx_calls );
+  OWSim_InjectTransferFaults( 0, 1 );
+  TEST_ASSERT_EQUAL( 0, ow_match_rom_raw( &ow, &rom ) );
+}
+
+TEST( OneWire, OneWireMatchRomSingleTransfer )
+{
+  uint8_t data[SCRATCHPAD_SIZE];
+  uint8_t scratchpad[SCRATCHPAD_SIZE];
+
+  ow_reset_raw( &ow );
+  OWSim_ClearStats();
+  TEST_ASSERT_EQUAL( 1, ow_match_rom_raw( &ow, &rom ) );
+  TEST_ASSERT_EQUAL( 1, OWSim_GetStats()->tx_rx_calls );
+  TEST_ASSERT_EQUAL( 8 * ( 1 + sizeof( rom.rom ) ), OWSim_GetStats()->slots );
+
+  /* Device is selected, so it answers function command */
+  ow_write_byte_raw( &ow, OW_CMD_RSCRATCHPAD );
+  TEST_ASSERT_EQUAL( owOK, ow_read_bytes_raw( &ow, data, sizeof( data ) ) );
+  OWSim_GetScratchpad( dev, scratchpad );
+  TEST_ASSERT_EQUAL_HEX8_ARRAY( scratchpad, data, sizeof( data ) );
+}
+
+TEST( OneWire, OneWireReadScratchpad )
+{
+  float temp = 0;
+  uint8_t data[SCRATCHPAD_SIZE] = {};
+  uint8_t scratchpad[SCRATCHPAD_SIZE];
+
+  /* Ready bit, reset, match ROM with command and 9 bytes of scratchpad */
+  TEST_ASSERT_EQUAL( 1, ow_ds18x20_read_raw( &ow, &rom, &temp ) );
+  TEST_ASSERT_EQUAL( 4, OWSim_GetStats()->tx_rx_calls );
+  TEST_ASSERT_EQUAL_FLOAT( 25.0625f, temp );
+  TEST_ASSERT_EQUAL( 12, ow_ds18x20_get_resolution_raw( &ow, &rom ) );
+
+  ow_reset_raw( &ow );
+  ow_match_rom_raw( &ow, &rom );
+  ow_write_byte_raw( &ow, OW_CMD_RSCRATCHPAD );
+  TEST_ASSERT_EQUAL( owOK, ow_read_bytes_raw( &ow, data, sizeof( data ) ) );
+  OWSim_GetScratchpad( dev, scratchpad );
+  TEST_ASSERT_EQUAL_HEX8_ARRAY( scratchpad, data, sizeof( data ) );
+
+  OWSim_InjectTransferFaults( 0, 1 );
+  TEST_ASSERT_EQUAL( owERR, ow_read_bytes_raw( &ow, data, sizeof( data ) ) );
+
+  /* Failed select after ready bit and reset is error, not device answer */
+  OWSim_InjectTransferFaults( 2, 1 );
+  TEST_ASSERT_EQUAL( owERR, ow_ds18x20_read_ex_raw( &ow, &rom, &temp ) );
+}
+
+TEST( OneWire, OneWireStartAllDevices )
+{
+  TEST_ASSERT_EQUAL( 1, ow_ds18x20_start_raw( &ow, NULL ) );
+  TEST_ASSERT_EQUAL( 1, OWSim_GetStats()->conversions );
+  TEST_ASSERT_EQUAL( 2, OWSim_GetStats()->tx_rx_calls );
+  TEST_ASSERT_EQUAL( 8 * 2, OWSim_GetStats()->slots );
+
+  /* Conversion is not started when command after reset can't be sent */
+  OWSim_AdvanceTime( CONVERSION_12_BITS_MS );
+  OWSim_ClearStats();
+  OWSim_InjectTransferFaults( 1, 1 );
+  TEST_ASSERT_EQUAL( 0, ow_ds18x20_start_raw( &ow, NULL ) );
+  TEST_ASSERT_EQUAL( 0, OWSim_GetStats()->conversions );
+}
+
+TEST( OneWire, OneWireResolution )
+{
+  uint8_t scratchpad[SCRATCHPAD_SIZE];
+
+  /* Adaptive resolution is written to scratchpad only */
+  TEST_ASSERT_EQUAL( 1, ow_ds18x20_write_resolution_raw( &ow, &rom, 9 ) );
+  OWSim_GetScratchpad( dev, scratchpad );
+  TEST_ASSERT_EQUAL_HEX8( 0x1F, scratchpad[4] );
+  TEST_ASSERT_EQUAL_HEX8( 0x4B, scratchpad[2] );
+  TEST_ASSERT_EQUAL_HEX8( 0x46, scratchpad[3] );
+  TEST_ASSERT_EQUAL( 0, OWSim_GetStats()->eeprom_writes );
+  TEST_ASSERT_EQUAL( 9, ow_ds18x20_get_resolution_raw( &ow, &rom ) );
+
+  TEST_ASSERT_EQUAL( 1, ow_ds18x20_set_resolution_raw( &ow, &rom, 10 ) );
+  TEST_ASSERT_EQUAL( 1, OWSim_GetStats()->eeprom_writes );
+  TEST_ASSERT_EQUAL( 10, ow_ds18x20_get_resolution_raw( &ow, &rom ) );
+
+  /* All devices with skip ROM */
+  TEST_ASSERT_EQUAL( 1, ow_ds18x20_write_resolution_raw( &ow, NULL, 11 ) );
+  TEST_ASSERT_EQUAL( 11, ow_ds18x20_get_resolution_raw( &ow, &rom ) );
+}
+
+TEST( OneWire, OneWireWriteCorruptedScratchpad )
+{
+  uint8_t scratchpad[SCRATCHPAD_SIZE];
+
+  /* Read-modify-write must not store alarm levels or configuration from bad read */
+  OWSim_InjectCrcFaults( dev, 4 );
+  TEST_ASSERT_EQUAL( 0, ow_ds18x20_write_resolution_raw( &ow, &rom, 9 ) );
+  TEST_ASSERT_EQUAL( 0, ow_ds18x20_set_resolution_raw( &ow, &rom, 10 ) );
+  TEST_ASSERT_EQUAL( 0, ow_ds18x20_write_alarm_temp_raw( &ow, &rom, 24, 26 ) );
+  TEST_ASSERT_EQUAL( 0, ow_ds18x20_get_resolution_raw( &ow, &rom ) );
+
+  OWSim_GetScratchpad( dev, scratchpad );
+  TEST_ASSERT_EQUAL_HEX8( 0x4B, scratchpad[2] );
+  TEST_ASSERT_EQUAL_HEX8( 0x46, scratchpad[3] );
+  TEST_ASSERT_EQUAL_HEX8( 0x7F, scratchpad[4] );
+  TEST_ASSERT_EQUAL( 0, OWSim_GetStats()->eeprom_writes );
+
+  /* Write succeeds once scratchpad reads clean again */
+  TEST_ASSERT_EQUAL( 1, ow_ds18x20_write_resolution_raw( &ow, &rom, 9 ) );
+  TEST_ASSERT_EQUAL( 9, OWSim_GetResolution( dev ) );
+}
+
+TEST( OneWire, OneWireVerify )
+{
+  ow_rom_t other;
+  float temp = 0;
+  OWSim_MakeRom( OW_SIM_FAMILY_DS18B20, 0x7C3C126462ULL, &other );
+
+  /* Reset, match ROM with command and 9 bytes of scratchpad */
+  TEST_ASSERT_EQUAL( 1, ow_ds18x20_verify_raw( &ow, &rom ) );
+  TEST_ASSERT_EQUAL( 3, OWSim_GetStats()->tx_rx_calls );
+
+  /* Not selected device doesn't answer */
+  TEST_ASSERT_EQUAL( 0, ow_ds18x20_verify_raw( &ow, &other ) );
+  TEST_ASSERT_EQUAL( owERRPRESENCE, ow_ds18x20_read_ex_raw( &ow, &other, &temp ) );
+
+  /* Line held low reads zeros with valid CRC */
+  OWSim_SetStuckLow( dev, true );
+  TEST_ASSERT_EQUAL( 0, ow_ds18x20_verify_raw( &ow, &rom ) );
+  TEST_ASSERT_EQUAL( owERR, ow_ds18x20_read_ex_raw( &ow, &rom, &temp ) );
+}
+
+TEST( OneWire, OneWireBenchmark )
+{
+  float temp = 0;
+  uint8_t data[SCRATCHPAD_SIZE] = {};
+  uint8_t scratchpad[SCRATCHPAD_SIZE];
+
+  uint64_t start_ns = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_READS; i++ )
+  {
+    _read_scratchpad_by_byte( data );
+  }
+  uint64_t by_byte_ns = _get_time_ns() - start_ns;
+  uint32_t by_byte_calls = OWSim_GetStats()->tx_rx_calls / BENCHMARK_READS;
+  OWSim_GetScratchpad( dev, scratchpad );
+  TEST_ASSERT_EQUAL_HEX8_ARRAY( scratchpad, data, sizeof( data ) );
+
+  OWSim_ClearStats();
+  start_ns = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_READS; i++ )
+  {
+    TEST_ASSERT_EQUAL( 1, ow_ds18x20_read_raw( &ow, &rom, &temp ) );
+  }
+  uint64_t multi_byte_ns = _get_time_ns() - start_ns;
+  uint32_t multi_byte_calls = OWSim_GetStats()->tx_rx_calls / BENCHMARK_READS;
+
+  TEST_ASSERT_EQUAL( 21, by_byte_calls );
+  TEST_ASSERT_EQUAL( 4, multi_byte_calls );
+  printf( "\nScratchpad read: by byte %u tx_rx calls %llu ns, multi-byte %u tx_rx calls %llu ns\n",
+          by_byte_calls, (unsigned long long) ( by_byte_ns / BENCHMARK_READS ),
+          multi_byte_calls, (unsigned long long) ( multi_byte_ns / BENCHMARK_READS ) );
+}
+
+TEST_GROUP_RUNNER( OneWire )
+{
+  RUN_TEST_CASE( OneWire, OneWireWriteBytesSingleTransfer );
+  RUN_TEST_CASE( OneWire, OneWireMatchRomSingleTransfer );
+  RUN_TEST_CASE( OneWire, OneWireReadScratchpad );
+  RUN_TEST_CASE( OneWire, OneWireStartAllDevices );
+  RUN_TEST_CASE( OneWire, OneWireResolution );
+  RUN_TEST_CASE( OneWire, OneWireWriteCorruptedScratchpad );
+  RUN_TEST_CASE( OneWire, OneWireVerify );
+  RUN_TEST_CASE( OneWire, OneWireBenchmark );
+}
@@ -0,0 +1,379 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "mocks/ow_sim.h"
+#include "ow/devices/ow_device_ds18x20.h"
+#include "ow/ow.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define CONVERSION_12_BITS_MS 750
+#define CONVERSION_9_BITS_MS  94
+#define CRC_BENCHMARK_BYTES   1000000
+
+static ow_t ow;
+static ow_rom_t roms[OW_SIM_MAX_DEVICES];
+static uint64_t serial_seed;
+
+static uint64_t _get_time_ns( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void _add_devices( size_t count, uint8_t family, float temp )
+{
+  /* Random serials make search tree of real bus, not counting pattern */
+  for ( size_t i = 0; i < count; i++ )
+  {
+    serial_seed = serial_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    OWSim_MakeRom( family, serial_seed >> 16, &roms[i] );
+    TEST_ASSERT_EQUAL( i, OWSim_AddDevice( &roms[i], temp ) );
+  }
+}
+
+static bool _is_rom_in( const ow_rom_t* rom, const ow_rom_t* arr, size_t len )
+{
+  for ( size_t i = 0; i < len; i++ )
+  {
+    if ( memcmp( rom, &arr[i], sizeof( *rom ) ) == 0 )
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+static size_t _search_all( ow_rom_t* found_roms )
+{
+  size_t found = 0;
+  ow_search_devices( &ow, found_roms, OW_SIM_MAX_DEVICES, &found );
+  return found;
+}
+
+static size_t _read_all( size_t count, float* temps )
+{
+  size_t read = 0;
+  for ( size_t i = 0; i < count; i++ )
+  {
+    read += ow_ds18x20_read( &ow, &roms[i], &temps[i] );
+  }
+  return read;
+}
+
+static uint8_t _crc_bitwise( const uint8_t* data, size_t len )
+{
+  uint8_t crc = 0;
+  for ( size_t i = 0; i < len; i++ )
+  {
+    uint8_t byte = data[i];
+    for ( uint32_t bit = 0; bit < 8; bit++ )
+    {
+      uint8_t mix = ( crc ^ byte ) & 0x01;
+      crc >>= 1;
+      crc ^= mix ? 0x8C : 0;
+      byte >>= 1;
+    }
+  }
+  return crc;
+}
+
+TEST_GROUP( OneWireSim );
+
+TEST_SETUP( OneWireSim )
+{
+  OWSim_Reset();
+  serial_seed = 1;
+  TEST_ASSERT_EQUAL( owOK, ow_init( &ow, &ow_sim_drv, NULL ) );
+}
+
+TEST_TEAR_DOWN( OneWireSim )
+{
+  ow_deinit( &ow );
+}
+
+TEST( OneWireSim, SearchEmptyBus )
+{
+  ow_rom_t found_roms[OW_SIM_MAX_DEVICES];
+  TEST_ASSERT_EQUAL( 0, _search_all( found_roms ) );
+  TEST_ASSERT_EQUAL( owERRPRESENCE, ow_reset( &ow ) );
+}
+
+TEST( OneWireSim, SearchFindsAll )
+{
+  const size_t counts[] = { 1, 2, 7, OW_SIM_MAX_DEVICES };
+  ow_rom_t found_roms[OW_SIM_MAX_DEVICES];
+
+  for ( size_t c = 0; c < sizeof( counts ) / sizeof( counts[0] ); c++ )
+  {
+    OWSim_Reset();
+    _add_devices( counts[c], OW_SIM_FAMILY_DS18B20, 20.0f );
+    TEST_ASSERT_EQUAL( counts[c], _search_all( found_roms ) );
+    for ( size_t i = 0; i < counts[c]; i++ )
+    {
+      TEST_ASSERT_TRUE( _is_rom_in( &found_roms[i], roms, counts[c] ) );
+      TEST_ASSERT_EQUAL( 0, ow_crc( &found_roms[i], sizeof( found_roms[i] ) ) );
+    }
+  }
+
+  /* Disconnected device is not found */
+  OWSim_SetPresent( 3, false );
+  TEST_ASSERT_EQUAL( OW_SIM_MAX_DEVICES - 1, _search_all( found_roms ) );
+  TEST_ASSERT_FALSE( _is_rom_in( &roms[3], found_roms, OW_SIM_MAX_DEVICES - 1 ) );
+  TEST_ASSERT_FALSE( ow_ds18x20_verify( &ow, &roms[3] ) );
+  TEST_ASSERT_TRUE( ow_ds18x20_verify( &ow, &roms[4] ) );
+}
+
+TEST( OneWireSim, ConversionTime )
+{
+  float temps[2];
+  _add_devices( 2, OW_SIM_FAMILY_DS18B20, 25.0625f );
+
+  /* Power-up scratchpad */
+  TEST_ASSERT_EQUAL( 2, _read_all( 2, temps ) );
+  TEST_ASSERT_EQUAL_FLOAT( 85.0f, temps[0] );
+
+  TEST_ASSERT_TRUE( ow_ds18x20_start( &ow, NULL ) );
+  OWSim_AdvanceTime( CONVERSION_12_BITS_MS - 1 );
+  TEST_ASSERT_EQUAL( 0, _read_all( 1, temps ) );
+  OWSim_AdvanceTime( 1 );
+  TEST_ASSERT_EQUAL( 2, _read_all( 2, temps ) );
+  TEST_ASSERT_EQUAL_FLOAT( 25.0625f, temps[0] );
+  TEST_ASSERT_EQUAL_FLOAT( 25.0625f, temps[1] );
+  TEST_ASSERT_EQUAL( 1, OWSim_GetStats()->conversions / 2 );
+}
+
+TEST( OneWireSim, Resolution )
+{
+  float temp;
+  _add_devices( 1, OW_SIM_FAMILY_DS18B20, -10.4375f );
+
+  TEST_ASSERT_TRUE( ow_ds18x20_set_resolution( &ow, &roms[0], 9 ) );
+  TEST_ASSERT_EQUAL( 9, OWSim_GetResolution( 0 ) );
+  TEST_ASSERT_EQUAL( 9, ow_ds18x20_get_resolution( &ow, &roms[0] ) );
+  TEST_ASSERT_EQUAL( 1, OWSim_GetStats()->eeprom_writes );
+
+  TEST_ASSERT_TRUE( ow_ds18x20_start( &ow, &roms[0] ) );
+  OWSim_AdvanceTime( CONVERSION_9_BITS_MS );
+  TEST_ASSERT_TRUE( ow_ds18x20_read( &ow, &roms[0], &temp ) );
+  TEST_ASSERT_EQUAL_FLOAT( -10.5f, temp );
+
+  /* Resolution in scratchpad only doesn't wear EEPROM */
+  TEST_ASSERT_TRUE( ow_ds18x20_write_resolution( &ow, &roms[0], 12 ) );
+  TEST_ASSERT_EQUAL( 12, OWSim_GetResolution( 0 ) );
+  TEST_ASSERT_EQUAL( 1, OWSim_GetStats()->eeprom_writes );
+}
+
+TEST( OneWireSim, DS18S20 )
+{
+  const float temps[] = { 25.0625f, 25.5f, 25.875f, -10.125f, 0.0f };
+  float temp;
+  _add_devices( 1, OW_SIM_FAMILY_DS18S20, 0.0f );
+
+  for ( size_t i = 0; i < sizeof( temps ) / sizeof( temps[0] ); i++ )
+  {
+    OWSim_SetTemperature( 0, temps[i] );
+    TEST_ASSERT_TRUE( ow_ds18x20_start( &ow, &roms[0] ) );
+    OWSim_AdvanceTime( CONVERSION_12_BITS_MS );
+    TEST_ASSERT_TRUE( ow_ds18x20_read( &ow, &roms[0], &temp ) );
+    TEST_ASSERT_EQUAL_FLOAT( temps[i], temp );
+  }
+}
+
+TEST( OneWireSim, CrcFault )
+{
+  float temp;
+  _add_devices( 1, OW_SIM_FAMILY_DS18B20, 21.5f );
+  TEST_ASSERT_TRUE( ow_ds18x20_start( &ow, NULL ) );
+  OWSim_AdvanceTime( CONVERSION_12_BITS_MS );
+
+  OWSim_InjectCrcFaults( 0, 2 );
+  TEST_ASSERT_FALSE( ow_ds18x20_read( &ow, &roms[0], &temp ) );
+  TEST_ASSERT_FALSE( ow_ds18x20_verify( &ow, &roms[0] ) );
+  TEST_ASSERT_TRUE( ow_ds18x20_read( &ow, &roms[0], &temp ) );
+  TEST_ASSERT_EQUAL_FLOAT( 21.5f, temp );
+}
+
+TEST( OneWireSim, ReadErrors )
+{
+  float temp;
+  _add_devices( 2, OW_SIM_FAMILY_DS18B20, 30.0f );
+
+  TEST_ASSERT_TRUE( ow_ds18x20_start( &ow, NULL ) );
+  TEST_ASSERT_EQUAL( owERR, ow_ds18x20_read_ex( &ow, &roms[0], &temp ) );
+  OWSim_AdvanceTime( CONVERSION_12_BITS_MS );
+
+  OWSim_InjectCrcFaults( 0, 1 );
+  TEST_ASSERT_EQUAL( owERRCRC, ow_ds18x20_read_ex( &ow, &roms[0], &temp ) );
+  TEST_ASSERT_EQUAL( owOK, ow_ds18x20_read_ex( &ow, &roms[0], &temp ) );
+  TEST_ASSERT_EQUAL_FLOAT( 30.0f, temp );
+
+  /* Missing device doesn't pull line low after match ROM */
+  OWSim_SetPresent( 1, false );
+  TEST_ASSERT_EQUAL( owERRPRESENCE, ow_ds18x20_read_ex( &ow, &roms[1], &temp ) );
+  OWSim_SetPresent( 0, false );
+  TEST_ASSERT_EQUAL( owERRPRESENCE, ow_ds18x20_read_ex( &ow, &roms[0], &temp ) );
+}
+
+TEST( OneWireSim, CrcTable )
+{
+  static uint8_t data[CRC_BENCHMARK_BYTES];
+  for ( size_t i = 0; i < sizeof( data ); i++ )
+  {
+    serial_seed = serial_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    data[i] = serial_seed >> 56;
+  }
+  for ( size_t len = 1; len < 64; len++ )
+  {
+    TEST_ASSERT_EQUAL_HEX8( _crc_bitwise( &data[len], len ), ow_crc( &data[len], len ) );
+  }
+
+  uint64_t start_ns = _get_time_ns();
+  uint8_t crc = ow_crc( data, sizeof( data ) );
+  uint64_t table_ns = _get_time_ns() - start_ns;
+  start_ns = _get_time_ns();
+  TEST_ASSERT_EQUAL_HEX8( _crc_bitwise( data, sizeof( data ) ), crc );
+  uint64_t bitwise_ns = _get_time_ns() - start_ns;
+  printf( "\nCRC-8 of %d bytes: table %d %llu us, bitwise %llu us\n", CRC_BENCHMARK_BYTES, OW_CFG_CRC_TABLE,
+          (unsigned long long) ( table_ns / 1000 ), (unsigned long long) ( bitwise_ns / 1000 ) );
+}
+
+TEST( OneWireSim, AlarmSearch )
+{
+  ow_rom_t rom_id;
+  size_t found = 0;
+  _add_devices( 8, OW_SIM_FAMILY_DS18B20, 20.0f );
+  for ( size_t i = 0; i < 8; i++ )
+  {
+    TEST_ASSERT_TRUE( ow_ds18x20_write_alarm_temp( &ow, &roms[i], 19, 21 ) );
+  }
+
+  /* Nobody answers on quiet bus, search ends after first bit */
+  TEST_ASSERT_TRUE( ow_ds18x20_start( &ow, NULL ) );
+  OWSim_AdvanceTime( CONVERSION_12_BITS_MS );
+  ow_search_reset( &ow );
+  OWSim_ClearStats();
+  TEST_ASSERT_EQUAL( owERRNODEV, ow_ds18x20_search_alarm( &ow, &rom_id ) );
+  TEST_ASSERT_LESS_THAN( 10, OWSim_GetStats()->tx_rx_calls );
+
+  OWSim_SetTemperature( 2, 22.0f );
+  OWSim_SetTemperature( 5, 18.5f );
+  TEST_ASSERT_TRUE( ow_ds18x20_start( &ow, NULL ) );
+  OWSim_AdvanceTime( CONVERSION_12_BITS_MS );
+
+  ow_search_reset( &ow );
+  while ( ow_ds18x20_search_alarm( &ow, &rom_id ) == owOK )
+  {
+    TEST_ASSERT_TRUE( memcmp( &rom_id, &roms[2], sizeof( rom_id ) ) == 0 || memcmp( &rom_id, &roms[5], sizeof( rom_id ) ) == 0 );
+    found++;
+  }
+  TEST_ASSERT_EQUAL( 2, found );
+}
+
+static size_t _walk( ow_rom_t* walk_rom, uint8_t* walk_disrepancy, ow_rom_t* found_roms )
+{
+  /* One search step per cycle with alarm search in between, like temperature driver does */
+  size_t found = 0;
+  ow_rom_t rom_id;
+  for ( size_t step = 0; step <= OW_SIM_MAX_DEVICES; step++ )
+  {
+    ow.rom = *walk_rom;
+    ow.disrepancy = *walk_disrepancy;
+    owr_t res = ow_search( &ow, &rom_id );
+    if ( res == owOK )
+    {
+      found_roms[found++] = rom_id;
+    }
+    else
+    {
+      ow_search_reset( &ow );
+    }
+    *walk_rom = ow.rom;
+    *walk_disrepancy = ow.disrepancy;
+    if ( res != owOK )
+    {
+      break;
+    }
+
+    ow_search_reset( &ow );
+    while ( ow_ds18x20_search_alarm( &ow, &rom_id ) == owOK )
+    {
+    }
+  }
+  return found;
+}
+
+TEST( OneWireSim, IncrementalWalk )
+{
+  ow_rom_t found_roms[OW_SIM_MAX_DEVICES];
+  ow_rom_t walk_rom = {};
+  uint8_t walk_disrepancy;
+  _add_devices( 8, OW_SIM_FAMILY_DS18B20, 20.0f );
+  ow_search_reset( &ow );
+  walk_disrepancy = ow.disrepancy;
+
+  TEST_ASSERT_EQUAL( 8, _walk( &walk_rom, &walk_disrepancy, found_roms ) );
+  for ( size_t i = 0; i < 8; i++ )
+  {
+    TEST_ASSERT_TRUE( _is_rom_in( &roms[i], found_roms, 8 ) );
+  }
+
+  /* Plugged and unplugged devices show up in next walk */
+  ow_rom_t rom_id;
+  OWSim_MakeRom( OW_SIM_FAMILY_DS18B20, 0xABCDEF, &rom_id );
+  OWSim_AddDevice( &rom_id, 20.0f );
+  OWSim_SetPresent( 0, false );
+  TEST_ASSERT_EQUAL( 8, _walk( &walk_rom, &walk_disrepancy, found_roms ) );
+  TEST_ASSERT_TRUE( _is_rom_in( &rom_id, found_roms, 8 ) );
+  TEST_ASSERT_FALSE( _is_rom_in( &roms[0], found_roms, 8 ) );
+}
+
+TEST( OneWireSim, Benchmark )
+{
+  ow_rom_t found_roms[OW_SIM_MAX_DEVICES];
+  float temps[OW_SIM_MAX_DEVICES];
+
+  printf( "\n%8s %14s %14s %14s %14s\n", "devices", "search ns", "search bus ms", "sweep ns", "sweep bus ms" );
+  for ( size_t count = 1; count <= OW_SIM_MAX_DEVICES; count *= 2 )
+  {
+    OWSim_Reset();
+    _add_devices( count, OW_SIM_FAMILY_DS18B20, 23.0f );
+
+    uint64_t start_us = OWSim_GetTimeUs();
+    uint64_t start_ns = _get_time_ns();
+    TEST_ASSERT_EQUAL( count, _search_all( found_roms ) );
+    uint64_t search_ns = _get_time_ns() - start_ns;
+    uint64_t search_us = OWSim_GetTimeUs() - start_us;
+
+    /* Full sweep: one conversion of all devices and read of every scratchpad */
+    TEST_ASSERT_TRUE( ow_ds18x20_start( &ow, NULL ) );
+    OWSim_AdvanceTime( CONVERSION_12_BITS_MS );
+    start_us = OWSim_GetTimeUs();
+    start_ns = _get_time_ns();
+    TEST_ASSERT_EQUAL( count, _read_all( count, temps ) );
+    uint64_t sweep_ns = _get_time_ns() - start_ns;
+    uint64_t sweep_us = OWSim_GetTimeUs() - start_us;
+
+    printf( "%8lu %14llu %11llu.%02llu %14llu %11llu.%02llu\n", (unsigned long) count,
+            (unsigned long long) search_ns, (unsigned long long) ( search_us / 1000 ), (unsigned long long) ( search_us % 1000 / 10 ),
+            (unsigned long long) sweep_ns, (unsigned long long) ( sweep_us / 1000 ), (unsigned long long) ( sweep_us % 1000 / 10 ) );
+  }
+}
+
+TEST_GROUP_RUNNER( OneWireSim )
+{
+  RUN_TEST_CASE( OneWireSim, SearchEmptyBus );
+  RUN_TEST_CASE( OneWireSim, SearchFindsAll );
+  RUN_TEST_CASE( OneWireSim, ConversionTime );
+  RUN_TEST_CASE( OneWireSim, Resolution );
+  RUN_TEST_CASE( OneWireSim, DS18S20 );
+  RUN_TEST_CASE( OneWireSim, CrcFault );
+  RUN_TEST_CASE( OneWireSim, ReadErrors );
+  RUN_TEST_CASE( OneWireSim, CrcTable );
+  RUN_TEST_CASE( OneWireSim, AlarmSearch );
+  RUN_TEST_CASE( OneWireSim, IncrementalWalk );
+  RUN_TEST_CASE( OneWireSim, Benchmark );
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "signal_filter.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define BENCHMARK_SAMPLES 1000000
+
+static signal_filter_t filter;
+
+static uint64_t _get_time_ns( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void _init_stage( signal_filter_type_t type, int32_t param )
+{
+  signal_filter_stage_t stage = { .type = type, .param = param };
+  TEST_ASSERT_TRUE( SignalFilterInit( &filter, &stage, 1 ) );
+}
+
+TEST_GROUP( SignalFilter );
+
+TEST_SETUP( SignalFilter )
+{
+  memset( &filter, 0, sizeof( filter ) );
+}
+
+TEST_TEAR_DOWN( SignalFilter )
+{
+}
+
+TEST( SignalFilter, InvalidStages )
+{
+  signal_filter_stage_t stages[SIGNAL_FILTER_MAX_STAGES + 1] = {};
+
+  TEST_ASSERT_TRUE( SignalFilterInit( &filter, NULL, 0 ) );
+  TEST_ASSERT_EQUAL( 1234, SignalFilterProcess( &filter, 0, 1234 ) );
+
+  stages[0] = (signal_filter_stage_t) { SIGNAL_FILTER_MEDIAN, 4 };
+  TEST_ASSERT_FALSE( SignalFilterInit( &filter, stages, 1 ) );
+  stages[0] = (signal_filter_stage_t) { SIGNAL_FILTER_EMA, SIGNAL_FILTER_EMA_ONE + 1 };
+  TEST_ASSERT_FALSE( SignalFilterInit( &filter, stages, 1 ) );
+  stages[0] = (signal_filter_stage_t) { SIGNAL_FILTER_SPIKE, 0 };
+  TEST_ASSERT_FALSE( SignalFilterInit( &filter, stages, 1 ) );
+  stages[0] = (signal_filter_stage_t) { SIGNAL_FILTER_SLOPE, SIGNAL_FILTER_SLOPE_TAPS + 1 };
+  TEST_ASSERT_FALSE( SignalFilterInit( &filter, stages, 1 ) );
+  stages[0] = (signal_filter_stage_t) { SIGNAL_FILTER_LAST, 1 };
+  TEST_ASSERT_FALSE( SignalFilterInit( &filter, stages, 1 ) );
+
+  for ( size_t i = 0; i < SIGNAL_FILTER_MAX_STAGES + 1; i++ )
+  {
+    stages[i] = (signal_filter_stage_t) { SIGNAL_FILTER_EMA, 1 };
+  }
+  TEST_ASSERT_FALSE( SignalFilterInit( &filter, stages, SIGNAL_FILTER_MAX_STAGES + 1 ) );
+  TEST_ASSERT_TRUE( SignalFilterInit( &filter, stages, SIGNAL_FILTER_MAX_STAGES ) );
+}
+
+TEST( SignalFilter, Median )
+{
+  const int32_t samples[] = { 10, 12, 400, 11, 13, -300, 12, 12 };
+  const int32_t expected[] = { 10, 10, 12, 11, 12, 12, 12, 12 };
+
+  _init_stage( SIGNAL_FILTER_MEDIAN, 5 );
+  for ( size_t i = 0; i < sizeof( samples ) / sizeof( samples[0] ); i++ )
+  {
+    TEST_ASSERT_EQUAL( expected[i], SignalFilterProcess( &filter, i * 1000, samples[i] ) );
+  }
+}
+
+TEST( SignalFilter, Ema )
+{
+  _init_stage( SIGNAL_FILTER_EMA, SIGNAL_FILTER_EMA_ONE / 2 );
+  TEST_ASSERT_EQUAL( 0, SignalFilterProcess( &filter, 0, 0 ) );
+  TEST_ASSERT_EQUAL( 50, SignalFilterProcess( &filter, 1000, 100 ) );
+  TEST_ASSERT_EQUAL( 75, SignalFilterProcess( &filter, 2000, 100 ) );
+  TEST_ASSERT_EQUAL( 13, SignalFilterProcess( &filter, 3000, -50 ) );
+
+  /* Full range without overflow */
+  _init_stage( SIGNAL_FILTER_EMA, SIGNAL_FILTER_EMA_ONE );
+  TEST_ASSERT_EQUAL( INT32_MIN, SignalFilterProcess( &filter, 0, INT32_MIN ) );
+  TEST_ASSERT_EQUAL( INT32_MAX, SignalFilterProcess( &filter, 1000, INT32_MAX ) );
+  TEST_ASSERT_EQUAL( INT32_MIN, SignalFilterProcess( &filter, 2000, INT32_MIN ) );
+
+  /* Small alpha converges to constant input */
+  _init_stage( SIGNAL_FILTER_EMA, 1000 );
+  SignalFilterProcess( &filter, 0, 0 );
+  for ( uint32_t i = 1; i < 2000; i++ )
+  {
+    SignalFilterProcess( &filter, i * 1000, 25000 );
+  }
+  TEST_ASSERT_INT_WITHIN( 1, 25000, filter.value );
+}
+
+TEST( SignalFilter, Spike )
+{
+  _init_stage( SIGNAL_FILTER_SPIKE, 50 );
+  TEST_ASSERT_EQUAL( 0, SignalFilterProcess( &filter, 0, 0 ) );
+  TEST_ASSERT_EQUAL( 0, SignalFilterProcess( &filter, 1000, 500 ) );
+  TEST_ASSERT_EQUAL( 40, SignalFilterProcess( &filter, 2000, 40 ) );
+  TEST_ASSERT_EQUAL( 1, filter.rejected );
+
+  /* Sustained step passes after hold */
+  for ( uint32_t i = 0; i < SIGNAL_FILTER_SPIKE_HOLD; i++ )
+  {
+    TEST_ASSERT_EQUAL( 40, SignalFilterProcess( &filter, 3000 + i * 1000, 1000 ) );
+  }
+  TEST_ASSERT_EQUAL( 1000, SignalFilterProcess( &filter, 9000, 1000 ) );
+  TEST_ASSERT_EQUAL( 1 + SIGNAL_FILTER_SPIKE_HOLD, filter.rejected );
+}
+
+TEST( SignalFilter, Slope )
+{
+  /* 2 units per ms sampled with uneven period, across time wrap */
+  const uint32_t start_ms = UINT32_MAX - 5000;
+  uint32_t time_ms = start_ms;
+
+  _init_stage( SIGNAL_FILTER_SLOPE, 8 );
+  SignalFilterProcess( &filter, time_ms, 0 );
+  TEST_ASSERT_EQUAL( 0, filter.slope );
+  for ( uint32_t i = 1; i < 100; i++ )
+  {
+    time_ms += 750 + ( i % 3 ) * 125;
+    SignalFilterProcess( &filter, time_ms, (int32_t) ( time_ms - start_ms ) * 2 );
+    TEST_ASSERT_EQUAL( 2000, filter.slope );
+  }
+  TEST_ASSERT_EQUAL( 8, filter.state[0].slope.count );
+
+  /* Falling ramp replaces window */
+  for ( uint32_t i = 0; i < 8; i++ )
+  {
+    time_ms += 1000;
+    SignalFilterProcess( &filter, time_ms, -(int32_t) i * 5 );
+  }
+  TEST_ASSERT_EQUAL( -5, filter.slope );
+  TEST_ASSERT_EQUAL( -35, filter.value );
+}
+
+TEST( SignalFilter, Chain )
+{
+  const signal_filter_stage_t stages[] = {
+    { SIGNAL_FILTER_MEDIAN, 3 },
+    { SIGNAL_FILTER_SPIKE, 1000 },
+    { SIGNAL_FILTER_EMA, SIGNAL_FILTER_EMA_ONE / 4 },
+    { SIGNAL_FILTER_SLOPE, 4 },
+  };
+  TEST_ASSERT_TRUE( SignalFilterInit( &filter, stages, 4 ) );
+
+  /* Glitch removed by median doesn't reach EMA */
+  SignalFilterProcess( &filter, 0, 20000 );
+  SignalFilterProcess( &filter, 1000, 20000 );
+  TEST_ASSERT_EQUAL( 20000, SignalFilterProcess( &filter, 2000, 85000 ) );
+  TEST_ASSERT_EQUAL( 0, filter.slope );
+  TEST_ASSERT_EQUAL( 0, filter.rejected );
+
+  SignalFilterReset( &filter );
+  TEST_ASSERT_EQUAL( 30000, SignalFilterProcess( &filter, 3000, 30000 ) );
+}
+
+TEST( SignalFilter, Benchmark )
+{
+  const signal_filter_stage_t stages[] = {
+    { SIGNAL_FILTER_MEDIAN, 5 },
+    { SIGNAL_FILTER_SPIKE, 1000 },
+    { SIGNAL_FILTER_EMA, SIGNAL_FILTER_EMA_ONE / 8 },
+    { SIGNAL_FILTER_SLOPE, SIGNAL_FILTER_SLOPE_TAPS },
+  };
+  TEST_ASSERT_TRUE( SignalFilterInit( &filter, stages, 4 ) );
+
+  uint64_t start_ns = _get_time_ns();
+  for ( uint32_t i = 0; i < BENCHMARK_SAMPLES; i++ )
+  {
+    SignalFilterProcess( &filter, i * 750, 20000 + (int32_t) ( i % 64 ) );
+  }
+  uint64_t elapsed_ns = _get_time_ns() - start_ns;
+  printf( "\nFilter chain of %d stages: %llu ns/sample\n", 4, (unsigned long long) ( elapsed_ns / BENCHMARK_SAMPLES ) );
+  TEST_ASSERT_INT_WITHIN( 64, 20032, filter.value );
+}
+
+TEST_GROUP_RUNNER( SignalFilter )
+{
+  RUN_TEST_CASE( SignalFilter, InvalidStages );
+  RUN_TEST_CASE( SignalFilter, Median );
+  RUN_TEST_CASE( SignalFilter, Ema );
+  RUN_TEST_CASE( SignalFilter, Spike );
+  RUN_TEST_CASE( SignalFilter, Slope );
+  RUN_TEST_CASE( SignalFilter, Chain );
+  RUN_TEST_CASE( SignalFilter, Benchmark );
+}
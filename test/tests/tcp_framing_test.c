@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tcp_framing.h"
+#include "tcp_transport.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define MAX_FRAME         2048
+#define BUFFER_SIZE       ( TCP_FRAMING_HEADER_SIZE + MAX_FRAME )
+#define MAX_FRAMES        64
+#define BENCHMARK_FRAMES  20000
+#define BENCHMARK_PAYLOAD 200
+
+typedef struct
+{
+  size_t count;
+  size_t len[MAX_FRAMES];
+  uint32_t hash[MAX_FRAMES];
+} received_t;
+
+static uint8_t buffer[BUFFER_SIZE];
+static tcp_framing_t framing;
+static received_t received;
+
+static uint64_t _get_time_ns( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t _hash( const uint8_t* data, size_t len )
+{
+  uint32_t hash = 2166136261u;
+  for ( size_t i = 0; i < len; i++ )
+  {
+    hash = ( hash ^ data[i] ) * 16777619u;
+  }
+  return hash;
+}
+
+static void _on_frame( const uint8_t* payload, size_t len, void* user_data )
+{
+  received_t* rx = user_data;
+  if ( rx->count < MAX_FRAMES )
+  {
+    rx->len[rx->count] = len;
+    rx->hash[rx->count] = _hash( payload, len );
+  }
+  rx->count++;
+}
+
+static void _on_frame_count( const uint8_t* payload, size_t len, void* user_data )
+{
+  ( *(size_t*) user_data )++;
+}
+
+static size_t _put_u32( uint8_t* dst, uint32_t value )
+{
+  dst[0] = (uint8_t) value;
+  dst[1] = (uint8_t) ( value >> 8 );
+  dst[2] = (uint8_t) ( value >> 16 );
+  dst[3] = (uint8_t) ( value >> 24 );
+  return 4;
+}
+
+static size_t _make_frame( uint8_t* dst, const uint8_t* payload, size_t len )
+{
+  size_t pos = _put_u32( dst, TCP_FRAMING_MAGIC_WORD );
+  pos += _put_u32( &dst[pos], len );
+  memcpy( &dst[pos], payload, len );
+  return pos + len;
+}
+
+static void _fill_payload( uint8_t* payload, size_t len, uint32_t seed )
+{
+  for ( size_t i = 0; i < len; i++ )
+  {
+    payload[i] = (uint8_t) ( 'a' + ( seed + i ) % 26 );
+  }
+}
+
+TEST_GROUP( TcpFraming );
+
+TEST_SETUP( TcpFraming )
+{
+  memset( &received, 0, sizeof( received ) );
+  TCPFraming_Init( &framing, buffer, sizeof( buffer ), MAX_FRAME );
+}
+
+TEST_TEAR_DOWN( TcpFraming )
+{
+}
+
+TEST( TcpFraming, SplitAtEveryByte )
+{
+  const char* json = "{\"method\":\"getVersion\"}";
+  uint8_t stream[64];
+  size_t len = _make_frame( stream, (const uint8_t*) json, strlen( json ) );
+
+  for ( size_t split = 0; split <= len; split++ )
+  {
+    memset( &received, 0, sizeof( received ) );
+    TCPFraming_Reset( &framing );
+    TEST_ASSERT_EQUAL( split == len, TCPFraming_Push( &framing, stream, split, _on_frame, &received ) );
+    TCPFraming_Push( &framing, &stream[split], len - split, _on_frame, &received );
+    TEST_ASSERT_EQUAL( 1, received.count );
+    TEST_ASSERT_EQUAL( strlen( json ), received.len[0] );
+    TEST_ASSERT_EQUAL_HEX32( _hash( (const uint8_t*) json, strlen( json ) ), received.hash[0] );
+    TEST_ASSERT_EQUAL( 0, framing.len );
+  }
+  TEST_ASSERT_EQUAL( 0, framing.dropped_bytes );
+}
+
+TEST( TcpFraming, FrameLongerThanRead )
+{
+  /* Old parser lost every frame not fitting into one 1 kB read */
+  static uint8_t payload[1800];
+  static uint8_t stream[sizeof( payload ) + TCP_FRAMING_HEADER_SIZE];
+  _fill_payload( payload, sizeof( payload ), 3 );
+  size_t len = _make_frame( stream, payload, sizeof( payload ) );
+
+  for ( size_t pos = 0; pos < len; pos += 1024 )
+  {
+    size_t chunk = len - pos < 1024 ? len - pos : 1024;
+    TCPFraming_Push( &framing, &stream[pos], chunk, _on_frame, &received );
+  }
+  TEST_ASSERT_EQUAL( 1, received.count );
+  TEST_ASSERT_EQUAL( sizeof( payload ), received.len[0] );
+  TEST_ASSERT_EQUAL_HEX32( _hash( payload, sizeof( payload ) ), received.hash[0] );
+}
+
+TEST( TcpFraming, GarbageBetweenFrames )
+{
+  uint8_t stream[256];
+  size_t len = 0;
+  const uint8_t garbage[] = { 0x00, 0xAF, 0xBE, 0x12, 0xAF, 0xBE, 0xAD };
+
+  memcpy( &stream[len], garbage, sizeof( garbage ) );
+  len += sizeof( garbage );
+  len += _make_frame( &stream[len], (const uint8_t*) "{}", 2 );
+  memcpy( &stream[len], "xyz", 3 );
+  len += 3;
+  len += _make_frame( &stream[len], (const uint8_t*) "[1]", 3 );
+  /* Beginning of magic word at end of read must wait for rest of it */
+  memcpy( &stream[len], garbage, 3 );
+  len += 3;
+
+  TEST_ASSERT_EQUAL( 2, TCPFraming_Push( &framing, stream, len, _on_frame, &received ) );
+  TEST_ASSERT_EQUAL( 2, received.len[0] );
+  TEST_ASSERT_EQUAL( 3, received.len[1] );
+  TEST_ASSERT_EQUAL( 2, framing.len );
+  TEST_ASSERT_EQUAL( sizeof( garbage ) + 3 + 1, framing.dropped_bytes );
+
+  len = _make_frame( stream, (const uint8_t*) "{\"a\":1}", 7 );
+  TEST_ASSERT_EQUAL( 1, TCPFraming_Push( &framing, &stream[2], len - 2, _on_frame, &received ) );
+  TEST_ASSERT_EQUAL( 7, received.len[2] );
+  TEST_ASSERT_EQUAL( 0, framing.len );
+}
+
+TEST( TcpFraming, OversizedLengthSkipped )
+{
+  uint8_t stream[64];
+  size_t len = _put_u32( stream, TCP_FRAMING_MAGIC_WORD );
+  len += _put_u32( &stream[len], MAX_FRAME + 1 );
+  len += _make_frame( &stream[len], (const uint8_t*) "{}", 2 );
+
+  TEST_ASSERT_EQUAL( 1, TCPFraming_Push( &framing, stream, len, _on_frame, &received ) );
+  TEST_ASSERT_EQUAL( 1, framing.oversized );
+  TEST_ASSERT_EQUAL( 8, framing.dropped_bytes );
+  TEST_ASSERT_EQUAL( 2, received.len[0] );
+
+  /* Frame of maximal size still passes */
+  static uint8_t payload[MAX_FRAME];
+  static uint8_t big[MAX_FRAME + TCP_FRAMING_HEADER_SIZE];
+  _fill_payload( payload, sizeof( payload ), 0 );
+  len = _make_frame( big, payload, sizeof( payload ) );
+  TEST_ASSERT_EQUAL( 1, TCPFraming_Push( &framing, big, len, _on_frame, &received ) );
+  TEST_ASSERT_EQUAL( MAX_FRAME, received.len[1] );
+}
+
+static size_t _add_garbage( uint8_t* dst, size_t count )
+{
+  static const uint8_t magic[] = { 0xAF, 0xBE, 0xAD, 0xDE };
+  size_t len = 0;
+  while ( len < count )
+  {
+    if ( rand() % 4 == 0 )
+    {
+      /* Beginning of magic word, resync has to skip it */
+      size_t part = 1 + rand() % 3;
+      memcpy( &dst[len], magic, part );
+      len += part;
+    }
+    else
+    {
+      dst[len++] = (uint8_t) rand();
+    }
+    /* Only whole magic word can't appear outside of frame */
+    if ( len >= sizeof( magic ) && memcmp( &dst[len - sizeof( magic )], magic, sizeof( magic ) ) == 0 )
+    {
+      len--;
+    }
+  }
+  return len;
+}
+
+TEST( TcpFraming, RandomChunksAndGarbage )
+{
+  static uint8_t stream[MAX_FRAMES * 600];
+  uint8_t payload[512];
+  uint32_t expected[MAX_FRAMES];
+  size_t expected_len[MAX_FRAMES];
+
+  for ( unsigned seed = 0; seed < 32; seed++ )
+  {
+    size_t len = 0;
+    size_t garbage = 0;
+    srand( seed );
+    memset( &received, 0, sizeof( received ) );
+    TCPFraming_Init( &framing, buffer, sizeof( buffer ), MAX_FRAME );
+
+    for ( size_t i = 0; i < MAX_FRAMES; i++ )
+    {
+      size_t count = _add_garbage( &stream[len], rand() % 16 );
+      garbage += count;
+      len += count;
+      expected_len[i] = rand() % sizeof( payload );
+      _fill_payload( payload, expected_len[i], rand() );
+      expected[i] = _hash( payload, expected_len[i] );
+      len += _make_frame( &stream[len], payload, expected_len[i] );
+    }
+
+    for ( size_t pos = 0; pos < len; )
+    {
+      size_t chunk = 1 + rand() % 700;
+      chunk = chunk > len - pos ? len - pos : chunk;
+      TCPFraming_Push( &framing, &stream[pos], chunk, _on_frame, &received );
+      pos += chunk;
+    }
+
+    TEST_ASSERT_EQUAL( MAX_FRAMES, received.count );
+    for ( size_t i = 0; i < MAX_FRAMES; i++ )
+    {
+      TEST_ASSERT_EQUAL( expected_len[i], received.len[i] );
+      TEST_ASSERT_EQUAL_HEX32( expected[i], received.hash[i] );
+    }
+    TEST_ASSERT_EQUAL( 0, framing.oversized );
+    TEST_ASSERT_EQUAL( garbage, framing.dropped_bytes );
+    TEST_ASSERT_EQUAL( 0, framing.len );
+  }
+}
+
+TEST( TcpFraming, SocketReadIntoBuffer )
+{
+  int fds[2];
+  TEST_ASSERT_EQUAL( 0, socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) );
+
+  static uint8_t payload[1500];
+  static uint8_t stream[2 * ( sizeof( payload ) + TCP_FRAMING_HEADER_SIZE )];
+  _fill_payload( payload, sizeof( payload ), 7 );
+  size_t len = _make_frame( stream, payload, sizeof( payload ) );
+  len += _make_frame( &stream[len], payload, 10 );
+
+  /* Writer splits stream like TCP segments */
+  for ( size_t pos = 0; pos < len; pos += 536 )
+  {
+    size_t chunk = len - pos < 536 ? len - pos : 536;
+    TEST_ASSERT_EQUAL( chunk, write( fds[1], &stream[pos], chunk ) );
+  }
+  close( fds[1] );
+
+  int ret;
+  do
+  {
+    size_t space = 0;
+    uint8_t* rx = TCPFraming_GetWriteBuffer( &framing, &space );
+    ret = TCPTransport_Read( fds[0], rx, space );
+    if ( ret > 0 )
+    {
+      TCPFraming_Commit( &framing, ret, _on_frame, &received );
+    }
+  } while ( ret > 0 );
+  close( fds[0] );
+
+  TEST_ASSERT_EQUAL( 2, received.count );
+  TEST_ASSERT_EQUAL_HEX32( _hash( payload, sizeof( payload ) ), received.hash[0] );
+  TEST_ASSERT_EQUAL_HEX32( _hash( payload, 10 ), received.hash[1] );
+}
+
+TEST( TcpFraming, Benchmark )
+{
+  static uint8_t stream[BENCHMARK_FRAMES * ( BENCHMARK_PAYLOAD + TCP_FRAMING_HEADER_SIZE + 3 )];
+  uint8_t payload[BENCHMARK_PAYLOAD];
+  size_t len = 0;
+  size_t frames = 0;
+
+  _fill_payload( payload, sizeof( payload ), 0 );
+  for ( size_t i = 0; i < BENCHMARK_FRAMES; i++ )
+  {
+    memcpy( &stream[len], "\r\n ", 3 );
+    len += 3;
+    len += _make_frame( &stream[len], payload, sizeof( payload ) );
+  }
+
+  uint64_t start = _get_time_ns();
+  for ( size_t pos = 0; pos < len; pos += 1460 )
+  {
+    size_t chunk = len - pos < 1460 ? len - pos : 1460;
+    TCPFraming_Push( &framing, &stream[pos], chunk, _on_frame_count, &frames );
+  }
+  uint64_t elapsed = _get_time_ns() - start;
+
+  TEST_ASSERT_EQUAL( BENCHMARK_FRAMES, frames );
+  printf( "\r\nTCP framing: %zu bytes in %llu us, %llu MB/s\r\n", len, (unsigned long long) ( elapsed / 1000 ),
+          (unsigned long long) ( elapsed ? (uint64_t) len * 1000 / elapsed : 0 ) );
+}
+
+TEST_GROUP_RUNNER( TcpFraming )
+{
+  RUN_TEST_CASE( TcpFraming, SplitAtEveryByte );
+  RUN_TEST_CASE( TcpFraming, FrameLongerThanRead );
+  RUN_TEST_CASE( TcpFraming, GarbageBetweenFrames );
+  RUN_TEST_CASE( TcpFraming, OversizedLengthSkipped );
+  RUN_TEST_CASE( TcpFraming, RandomChunksAndGarbage );
+  RUN_TEST_CASE( TcpFraming, SocketReadIntoBuffer );
+  RUN_TEST_CASE( TcpFraming, Benchmark );
+}
@@ -0,0 +1,190 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "temperature_history.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define SENSOR         1
+#define PERIOD_US      100000
+#define CONCURRENT_ADD 200000
+
+typedef struct
+{
+  temp_history_sample_t samples[TEMP_HISTORY_SIZE];
+  uint32_t count;
+  uint32_t limit;
+  uint32_t torn;
+  int64_t last_us;
+} read_result_t;
+
+static read_result_t result;
+static volatile bool writer_done;
+
+/* Temperature follows time, so torn sample is detected */
+static int16_t _temp_at( int64_t time_us )
+{
+  return (int16_t) ( ( time_us / PERIOD_US ) & 0x7FFF );
+}
+
+static void _add_samples( uint32_t first, uint32_t count )
+{
+  for ( uint32_t i = first; i < first + count; i++ )
+  {
+    TempHistoryAdd( SENSOR, (int64_t) i * PERIOD_US, _temp_at( (int64_t) i * PERIOD_US ) );
+  }
+}
+
+static bool _read_cb( const temp_history_sample_t* sample, void* user_data )
+{
+  read_result_t* res = user_data;
+  if ( res->count == res->limit )
+  {
+    return false;
+  }
+  if ( res->count < TEMP_HISTORY_SIZE )
+  {
+    res->samples[res->count] = *sample;
+  }
+  if ( sample->temp != _temp_at( sample->time_us ) || sample->time_us <= res->last_us )
+  {
+    res->torn++;
+  }
+  res->last_us = sample->time_us;
+  res->count++;
+  return true;
+}
+
+static void _reset_result( void )
+{
+  memset( &result, 0, sizeof( result ) );
+  result.limit = UINT32_MAX;
+  result.last_us = -1;
+}
+
+static void* _writer_thread( void* arg )
+{
+  _add_samples( 0, CONCURRENT_ADD );
+  writer_done = true;
+  return NULL;
+}
+
+TEST_GROUP( TempHistory );
+
+TEST_SETUP( TempHistory )
+{
+  TempHistoryInit();
+  _reset_result();
+}
+
+TEST_TEAR_DOWN( TempHistory )
+{
+}
+
+TEST( TempHistory, ReadRange )
+{
+  _add_samples( 0, 10 );
+  TEST_ASSERT_EQUAL( 10, TempHistoryGetCount( SENSOR ) );
+  TEST_ASSERT_EQUAL( 0, TempHistoryGetCount( 0 ) );
+
+  TEST_ASSERT_EQUAL( 4, TempHistoryRead( SENSOR, 2 * PERIOD_US, 5 * PERIOD_US, 0, _read_cb, &result ) );
+  TEST_ASSERT_EQUAL( 4, result.count );
+  TEST_ASSERT_EQUAL( 2 * PERIOD_US, result.samples[0].time_us );
+  TEST_ASSERT_EQUAL( 5 * PERIOD_US, result.samples[3].time_us );
+  TEST_ASSERT_EQUAL( 0, result.torn );
+
+  /* Range between samples and past last one */
+  _reset_result();
+  TEST_ASSERT_EQUAL( 0, TempHistoryRead( SENSOR, 2 * PERIOD_US + 1, 3 * PERIOD_US - 1, 0, _read_cb, &result ) );
+  TEST_ASSERT_EQUAL( 0, TempHistoryRead( SENSOR, 10 * PERIOD_US, INT64_MAX, 0, _read_cb, &result ) );
+}
+
+TEST( TempHistory, FixedPoint )
+{
+  TEST_ASSERT_EQUAL( 400, TEMP_HISTORY_FROM_C( 25.0f ) );
+  TEST_ASSERT_EQUAL( 401, TEMP_HISTORY_FROM_C( 25.0625f ) );
+  TEST_ASSERT_EQUAL( -2, TEMP_HISTORY_FROM_C( -0.125f ) );
+  TEST_ASSERT_EQUAL( -880, TEMP_HISTORY_FROM_C( -55.0f ) );
+  TEST_ASSERT_EQUAL( 2000, TEMP_HISTORY_FROM_C( 125.0f ) );
+  TEST_ASSERT_EQUAL_FLOAT( 25.0625f, TEMP_HISTORY_TO_C( 401 ) );
+}
+
+TEST( TempHistory, ReadStep )
+{
+  _add_samples( 0, 20 );
+
+  /* First sample of every 250 ms: 0, 300, 500, 800, ... 1800 ms */
+  TEST_ASSERT_EQUAL( 8, TempHistoryRead( SENSOR, 0, INT64_MAX, 250000, _read_cb, &result ) );
+  TEST_ASSERT_EQUAL( 0, result.samples[0].time_us );
+  TEST_ASSERT_EQUAL( 3 * PERIOD_US, result.samples[1].time_us );
+  TEST_ASSERT_EQUAL( 5 * PERIOD_US, result.samples[2].time_us );
+  TEST_ASSERT_EQUAL( 18 * PERIOD_US, result.samples[7].time_us );
+}
+
+TEST( TempHistory, Overwrite )
+{
+  _add_samples( 0, TEMP_HISTORY_SIZE + 10 );
+  TEST_ASSERT_EQUAL( TEMP_HISTORY_SIZE, TempHistoryGetCount( SENSOR ) );
+
+  TEST_ASSERT_EQUAL( TEMP_HISTORY_SIZE, TempHistoryRead( SENSOR, 0, INT64_MAX, 0, _read_cb, &result ) );
+  TEST_ASSERT_EQUAL( 10 * PERIOD_US, result.samples[0].time_us );
+  TEST_ASSERT_EQUAL( 0, result.torn );
+}
+
+TEST( TempHistory, Clear )
+{
+  _add_samples( 0, 10 );
+  TempHistoryClear( SENSOR );
+  TEST_ASSERT_EQUAL( 0, TempHistoryGetCount( SENSOR ) );
+  TEST_ASSERT_EQUAL( 0, TempHistoryRead( SENSOR, 0, INT64_MAX, 0, _read_cb, &result ) );
+
+  _add_samples( 10, 3 );
+  TEST_ASSERT_EQUAL( 3, TempHistoryRead( SENSOR, 0, INT64_MAX, 0, _read_cb, &result ) );
+  TEST_ASSERT_EQUAL( 10 * PERIOD_US, result.samples[0].time_us );
+}
+
+TEST( TempHistory, StopReading )
+{
+  _add_samples( 0, 10 );
+  result.limit = 3;
+
+  /* Sample refused by callback is not counted, next page starts from it */
+  TEST_ASSERT_EQUAL( 3, TempHistoryRead( SENSOR, 0, INT64_MAX, 0, _read_cb, &result ) );
+  _reset_result();
+  TEST_ASSERT_EQUAL( 7, TempHistoryRead( SENSOR, 3 * PERIOD_US, INT64_MAX, 0, _read_cb, &result ) );
+}
+
+TEST( TempHistory, ConcurrentWriter )
+{
+  pthread_t writer;
+  uint32_t reads = 0;
+  uint32_t torn = 0;
+
+  writer_done = false;
+  TEST_ASSERT_EQUAL( 0, pthread_create( &writer, NULL, _writer_thread, NULL ) );
+  while ( !writer_done )
+  {
+    _reset_result();
+    TempHistoryRead( SENSOR, 0, INT64_MAX, 0, _read_cb, &result );
+    torn += result.torn;
+    reads++;
+  }
+  pthread_join( writer, NULL );
+
+  printf( "\r\nHistory reads during %d writes: %lu\r\n", CONCURRENT_ADD, (unsigned long) reads );
+  TEST_ASSERT_EQUAL( 0, torn );
+  TEST_ASSERT_EQUAL( TEMP_HISTORY_SIZE, TempHistoryGetCount( SENSOR ) );
+}
+
+TEST_GROUP_RUNNER( TempHistory )
+{
+  RUN_TEST_CASE( TempHistory, ReadRange );
+  RUN_TEST_CASE( TempHistory, FixedPoint );
+  RUN_TEST_CASE( TempHistory, ReadStep );
+  RUN_TEST_CASE( TempHistory, Overwrite );
+  RUN_TEST_CASE( TempHistory, Clear );
+  RUN_TEST_CASE( TempHistory, StopReading );
+  RUN_TEST_CASE( TempHistory, ConcurrentWriter );
+}
@@ -0,0 +1,212 @@
+"""Decode application event trace dumped by getEventTrace TCP method.
+
+Usage:
+    python event_trace.py --host 192.168.4.1 --record on
+    python event_trace.py --host 192.168.4.1 [--chrome trace.json]
+    python event_trace.py dump.txt [--chrome trace.json]
+
+Dump file can contain getEventTrace responses (one JSON per line) or plain
+hex records. Recording is off after boot, it is started and stopped with
+--record. Message and module names are read from firmware headers, so the
+decoder must be run from the same revision as the firmware.
+"""
+
+import argparse
+import json
+import os
+import re
+import socket
+import struct
+import sys
+
+ROOT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+MSG_ID_HEADER = os.path.join(ROOT_DIR, "components", "utils", "app_msg_id.h")
+EVENTS_HEADER = os.path.join(ROOT_DIR, "components", "utils", "app_events.h")
+
+TCP_PORT = 1234
+MAGIC_WORD = 0xDEADBEAF
+HEADER = struct.Struct("<II")
+
+# app_event_trace_t
+RECORD = struct.Struct("<IIIBBBB")
+FLAG_UNHANDLED = 0x01
+
+
+def read_names(path, list_name, macro):
+    """Names in order of X-macro list, same as enum values in firmware."""
+    with open(path) as f:
+        text = f.read()
+    match = re.search(r"#define\s+" + list_name + r"\b((?:.*\\\r?\n)*.*)", text)
+    if match is None:
+        raise ValueError("%s not found in %s" % (list_name, path))
+    body = re.sub(r"/\*.*?\*/", "", match.group(1), flags=re.S)
+    return re.findall(r"\b" + macro + r"\(\s*(\w+)\s*\)", body)
+
+
+def recv_exact(sock, size):
+    data = b""
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed")
+        data += chunk
+    return data
+
+
+def request(sock, method, data, iterator):
+    payload = json.dumps({"method": method, "i": iterator, "data": data}).encode()
+    sock.sendall(HEADER.pack(MAGIC_WORD, len(payload)) + payload)
+    magic, length = HEADER.unpack(recv_exact(sock, HEADER.size))
+    if magic != MAGIC_WORD:
+        raise ValueError("bad magic word 0x%08x" % magic)
+    return json.loads(recv_exact(sock, length))
+
+
+def connect(host):
+    address, _, port = host.partition(":")
+    return socket.create_connection((address, int(port or TCP_PORT)), timeout=5)
+
+
+def record(host, enable):
+    sock = connect(host)
+    response = request(sock, "getEventTrace", {"enable": enable}, 1)
+    sock.close()
+    if response["error"] != 0:
+        raise RuntimeError(response)
+
+
+def fetch(host):
+    sock = connect(host)
+    chunks = []
+    offset = 0
+    iterator = 1
+    while True:
+        response = request(sock, "getEventTrace", {"offset": offset}, iterator)
+        if response["error"] != 0:
+            raise RuntimeError(response)
+        msg = response["msg"]
+        chunks.append(msg)
+        offset = msg["offset"] + msg["count"]
+        iterator += 1
+        if msg["count"] == 0 or offset == msg["head"]:
+            break
+    sock.close()
+    return chunks
+
+
+def load(path):
+    chunks = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith("{"):
+                msg = json.loads(line)
+                chunks.append(msg.get("msg", msg))
+            else:
+                chunks.append({"offset": None, "data": line})
+    return chunks
+
+
+def decode(chunks):
+    records = {}
+    for chunk in chunks:
+        data = bytes.fromhex(chunk["data"])
+        for i in range(len(data) // RECORD.size):
+            record = RECORD.unpack_from(data, i * RECORD.size)
+            # Overlapping chunks are merged by record index
+            index = chunk["offset"] + i if chunk["offset"] is not None else len(records)
+            records[index] = record
+    return [records[i] for i in sorted(records)]
+
+
+def unwrap_timestamps(records):
+    """Timestamp is 32-bit microseconds and wraps after ~71 minutes."""
+    result = []
+    high = 0
+    previous = None
+    for record in records:
+        timestamp = record[0]
+        if previous is not None and timestamp < previous and previous - timestamp > 0x80000000:
+            high += 1 << 32
+        previous = timestamp
+        result.append((high + timestamp,) + record[1:])
+    return result
+
+
+def name(names, index):
+    return names[index] if index < len(names) else "UNKNOWN_%d" % index
+
+
+def print_text(records, msg_names, task_names, out):
+    if not records:
+        return
+    start = records[0][0]
+    for timestamp, number, duration, src, dst, msg_id, flags in records:
+        out.write(
+            "%12.3f ms #%-8u %-16s -> %-16s %-40s %s\n"
+            % (
+                (timestamp - start) / 1000.0,
+                number,
+                name(task_names, src),
+                name(task_names, dst),
+                name(msg_names, msg_id),
+                "UNHANDLED" if flags & FLAG_UNHANDLED else "%u us" % duration,
+            )
+        )
+
+
+def chrome_trace(records, msg_names, task_names):
+    events = []
+    for index, task in enumerate(task_names):
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": index, "args": {"name": task}})
+    for timestamp, number, duration, src, dst, msg_id, flags in records:
+        events.append(
+            {
+                "name": name(msg_names, msg_id),
+                "cat": "unhandled" if flags & FLAG_UNHANDLED else "event",
+                "ph": "X",
+                "ts": timestamp,
+                "dur": duration,
+                "pid": 0,
+                "tid": dst,
+                "args": {"src": name(task_names, src), "event_number": number},
+            }
+        )
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode application event trace")
+    parser.add_argument("dump", nargs="?", help="file with getEventTrace responses or hex records")
+    parser.add_argument("--host", help="device address[:port] to read trace from")
+    parser.add_argument("--chrome", help="write Chrome trace JSON (chrome://tracing, Perfetto)")
+    parser.add_argument("--record", choices=("on", "off"), help="start or stop recording on device given by --host")
+    args = parser.parse_args()
+
+    if args.record:
+        if not args.host:
+            parser.error("--record requires --host")
+        record(args.host, args.record == "on")
+        return
+
+    if args.host:
+        chunks = fetch(args.host)
+    elif args.dump:
+        chunks = load(args.dump)
+    else:
+        parser.error("dump file or --host is required")
+
+    msg_names = read_names(MSG_ID_HEADER, "MSG_IDS_LIST", "MSG")
+    task_names = read_names(EVENTS_HEADER, "EVENTS_TASK_LIST", "EVENT_TASK")
+    records = unwrap_timestamps(decode(chunks))
+
+    print_text(records, msg_names, task_names, sys.stdout)
+    if args.chrome:
+        with open(args.chrome, "w") as f:
+            json.dump(chrome_trace(records, msg_names, task_names), f)
+
+
+if __name__ == "__main__":
+    main()